@@ -52,6 +52,10 @@ lutil_HASHFinal LDAP_P((
 	unsigned char digest[LUTIL_HASH_BYTES],
 	lutil_HASH_CTX *context));
 
+LDAP_LUTIL_F( ber_uint_t )
+lutil_HASHValue LDAP_P((
+	lutil_HASH_CTX *context));
+
 #ifdef HAVE_LONG_LONG
 
 #define LUTIL_HASH64_BYTES	8
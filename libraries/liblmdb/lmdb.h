@@ -705,6 +705,56 @@ int  mdb_env_copy2(MDB_env *env, const char *path, unsigned int flags);
 	 */
 int  mdb_env_copyfd2(MDB_env *env, mdb_filehandle_t fd, unsigned int flags);
 
+	/** @brief Write an incremental copy of an LMDB environment.
+	 *
+	 * Only the pages that changed since the previous increment are
+	 * written, so that a backup copy can be brought up to date with
+	 * I/O proportional to the amount of data written since then.
+	 * Changed pages are detected by comparing page hashes against the
+	 * signature file \b sigfd, which is updated to describe the copy
+	 * as it will be after the increment is applied. An empty signature
+	 * file yields a full copy. The increment must be applied to the
+	 * copy with #mdb_env_incr_apply(); if it is lost, start a new chain
+	 * of increments with an empty signature file.
+	 * @note The whole map is still read from the source environment.
+	 * This call can trigger significant file size growth if run in
+	 * parallel with write transactions, because it employs a read-only
+	 * transaction. See long-lived transactions under @ref caveats_sec.
+	 * @param[in] env An environment handle returned by #mdb_env_create(). It
+	 * must have already been opened successfully.
+	 * @param[in] fd The filedescriptor to write the increment to. It must
+	 * have already been opened for Write access.
+	 * @param[in] sigfd The filedescriptor of the signature file. It must
+	 * have been opened for Read and Write access, positioned at its start.
+	 * @return A non-zero error value on failure and 0 on success. Some
+	 * possible errors are:
+	 * <ul>
+	 *	<li>#MDB_INVALID - the signature file is not valid.
+	 *	<li>#MDB_VERSION_MISMATCH - the signature file was written with a
+	 *		different format or page size.
+	 * </ul>
+	 */
+int  mdb_env_copyfd_incr(MDB_env *env, mdb_filehandle_t fd, mdb_filehandle_t sigfd);
+
+	/** @brief Apply an incremental copy to a backup copy.
+	 *
+	 * The increment must have been written by #mdb_env_copyfd_incr().
+	 * Meta pages are written last, so if this call fails the same
+	 * increment can simply be applied again.
+	 * @param[in] datafd The filedescriptor of the data file of the copy,
+	 * opened for Write access. It may be empty, if the increment was
+	 * made with an empty signature file.
+	 * @param[in] fd The filedescriptor to read the increment from.
+	 * @return A non-zero error value on failure and 0 on success. Some
+	 * possible errors are:
+	 * <ul>
+	 *	<li>#MDB_INVALID - the input is not an increment, is truncated,
+	 *		or its page size does not match the copy.
+	 *	<li>#MDB_CORRUPTED - the increment is damaged.
+	 * </ul>
+	 */
+int  mdb_env_incr_apply(mdb_filehandle_t datafd, mdb_filehandle_t fd);
+
 	/** @brief Return statistics about the LMDB environment.
 	 *
 	 * @param[in] env An environment handle returned by #mdb_env_create()
@@ -898,12 +948,40 @@ int  mdb_env_set_maxdbs(MDB_env *env, MDB_dbi dbs);
 	/** @brief Get the maximum size of keys and #MDB_DUPSORT data we can write.
 	 *
 	 * Depends on the compile-time constant #MDB_MAXKEYSIZE. Default 511.
+	 * Environments whose page size is larger than 4096 bytes use the
+	 * largest size that fits on a page instead, but only if that page
+	 * size was requested with #mdb_env_set_pagesize() and differs from
+	 * the OS default. The result is only final once the environment is open.
 	 * See @ref MDB_val.
 	 * @param[in] env An environment handle returned by #mdb_env_create()
 	 * @return The maximum size of a key we can write
 	 */
 int  mdb_env_get_maxkeysize(MDB_env *env);
 
+	/** @brief Set the page size of a new environment.
+	 *
+	 * By default a new environment uses the OS page size. Bigger pages
+	 * make for shallower trees and fewer overflow pages with large
+	 * records, and raise the maximum key size when the same size is
+	 * requested each time the environment is opened; see
+	 * #mdb_env_get_maxkeysize().
+	 * The page size is stored in the meta pages, so this setting is
+	 * ignored when opening an existing environment.
+	 * Environments with a page size above 4096 bytes and large keys cannot
+	 * be reliably modified by versions of LMDB that lack this function.
+	 * This function may only be called after #mdb_env_create() and before
+	 * #mdb_env_open().
+	 * @param[in] env An environment handle returned by #mdb_env_create()
+	 * @param[in] size The page size in bytes. It must be a power of two
+	 * between 512 and 32768.
+	 * @return A non-zero error value on failure and 0 on success. Some possible
+	 * errors are:
+	 * <ul>
+	 *	<li>EINVAL - an invalid parameter was specified, or the environment is already open.
+	 * </ul>
+	 */
+int  mdb_env_set_pagesize(MDB_env *env, unsigned int size);
+
 	/** @brief Set application information associated with the #MDB_env.
 	 *
 	 * @param[in] env An environment handle returned by #mdb_env_create()
@@ -0,0 +1,573 @@
+/* mbench.c - memory-mapped database benchmark */
+/*
+ * Copyright 2011-2021 Howard Chu, Symas Corp.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in the file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+
+/* Replay the access patterns of back-mdb against a database laid out
+ * the way back-mdb lays out its own:
+ *
+ *	id2e	MDB_INTEGERKEY; entry ID -> entry blob
+ *	dn2i	MDB_DUPSORT; parent ID -> one record per child
+ *	idx	MDB_DUPSORT|MDB_DUPFIXED|MDB_INTEGERDUP; index key -> entry IDs
+ *
+ * and measure the latency of each kind of operation:
+ *
+ *	get	id2entry point read of one entry
+ *	walk	dn2id walk over all children of one parent
+ *	idl	fetch of one index slot with MDB_GET_MULTIPLE
+ *	put	write txn modifying one entry and moving it in the index
+ *
+ * Without -f the operations are picked at random in the ratio given
+ * by -m. With -f a trace is replayed instead, one operation per line:
+ * "get <id>", "walk <id>", "idl <key>" or "put <id>". The trace lines
+ * are dealt out to the threads round-robin and each is replayed once.
+ *
+ * Results are printed per operation as throughput plus a log-linear
+ * latency histogram summary; -H also prints the histograms themselves.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "lmdb.h"
+
+#define E(expr) CHECK((rc = (expr)) == MDB_SUCCESS, #expr)
+#define RES(err, expr) ((rc = expr) == (err) || (CHECK(!rc, #expr), 0))
+#define CHECK(test, msg) ((test) ? (void)0 : ((void)fprintf(stderr, \
+	"%s:%d: %s: %s\n", __FILE__, __LINE__, msg, mdb_strerror(rc)), abort()))
+
+#ifdef	_WIN32
+#define	Z	"I"
+#else
+#define	Z	"z"
+#endif
+
+enum { OP_GET, OP_WALK, OP_IDL, OP_PUT, NOPS };
+static const char *opnames[NOPS] = { "get", "walk", "idl", "put" };
+
+/* Latency histogram: 4 linear sub-buckets per power of two of ns */
+#define HSUB	2
+#define HBUCKETS	(64 << HSUB)
+
+typedef struct hist {
+	size_t h_count;
+	unsigned long long h_sum;
+	unsigned long long h_max;
+	size_t h_bucket[HBUCKETS];
+} hist;
+
+static int
+hbucket(unsigned long long ns)
+{
+	int b = 0;
+
+	if (ns < (1 << HSUB))
+		return ns;
+	while (ns >> (b + 1))
+		b++;
+	return ((b - HSUB + 1) << HSUB) + ((ns >> (b - HSUB)) & ((1 << HSUB) - 1));
+}
+
+/* Smallest value that does not fit in bucket i */
+static unsigned long long
+hbound(int i)
+{
+	int b = i >> HSUB, s = i & ((1 << HSUB) - 1);
+
+	if (b == 0)
+		return s + 1;
+	b += HSUB - 1;
+	return (1ULL << b) + ((unsigned long long)(s + 1) << (b - HSUB));
+}
+
+static void
+hadd(hist *h, unsigned long long ns)
+{
+	h->h_count++;
+	h->h_sum += ns;
+	if (ns > h->h_max)
+		h->h_max = ns;
+	h->h_bucket[hbucket(ns)]++;
+}
+
+static void
+hmerge(hist *dst, hist *src)
+{
+	int i;
+
+	dst->h_count += src->h_count;
+	dst->h_sum += src->h_sum;
+	if (src->h_max > dst->h_max)
+		dst->h_max = src->h_max;
+	for (i = 0; i < HBUCKETS; i++)
+		dst->h_bucket[i] += src->h_bucket[i];
+}
+
+static double
+hpct(hist *h, double pct)
+{
+	size_t want = h->h_count * pct / 100.0, seen = 0;
+	int i;
+
+	for (i = 0; i < HBUCKETS; i++) {
+		seen += h->h_bucket[i];
+		if (seen > want)
+			break;
+	}
+	if (i == HBUCKETS || hbound(i) > h->h_max)
+		return h->h_max / 1000.0;
+	return hbound(i) / 1000.0;
+}
+
+static void
+hprint(hist *h)
+{
+	int i, lo, hi, j;
+	size_t top = 0;
+
+	for (lo = 0; lo < HBUCKETS && !h->h_bucket[lo]; lo++) ;
+	for (hi = HBUCKETS; hi > lo && !h->h_bucket[hi-1]; hi--) ;
+	for (i = lo; i < hi; i++)
+		if (h->h_bucket[i] > top)
+			top = h->h_bucket[i];
+	for (i = lo; i < hi; i++) {
+		printf("  < %12.3f us %10"Z"u ", hbound(i) / 1000.0, h->h_bucket[i]);
+		for (j = 0; j < (int)(h->h_bucket[i] * 50 / top); j++)
+			putchar('#');
+		putchar('\n');
+	}
+}
+
+static unsigned long long
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+typedef struct op {
+	int o_type;
+	size_t o_arg;
+} op;
+
+static MDB_env *env;
+static MDB_dbi id2e, dn2i, idx;
+static size_t nentries = 100000, nkeys = 1000, esize = 1024;
+static unsigned fanout = 100, nthreads = 1, seconds = 10, perwtxn = 1;
+static unsigned mix[NOPS] = { 80, 5, 10, 5 };
+static op *trace;
+static size_t ntrace;
+static volatile int running = 1;
+
+typedef struct worker {
+	pthread_t w_thr;
+	unsigned w_num;
+	unsigned long long w_seed;
+	hist w_hist[NOPS];
+	size_t w_found;
+	char *w_buf;
+} worker;
+
+static size_t
+rnd(worker *w)
+{
+	/* xorshift64* */
+	w->w_seed ^= w->w_seed >> 12;
+	w->w_seed ^= w->w_seed << 25;
+	w->w_seed ^= w->w_seed >> 27;
+	return (size_t)((w->w_seed * 2685821657736338717ULL) >> 16);
+}
+
+/* The parent of entry id; entry 1 is the suffix */
+#define PARENT(id)	(((id) - 2) / fanout + 1)
+#define IDXKEY(id, gen)	((unsigned)(((id) * 7 + (gen)) % nkeys))
+
+typedef struct dnrec {
+	size_t d_id;
+	char d_rdn[24];
+} dnrec;
+
+static void
+mkentry(worker *w, MDB_val *data, size_t id)
+{
+	data->mv_size = esize / 2 + rnd(w) % (esize + 1);
+	data->mv_data = w->w_buf;
+	memset(w->w_buf, 'a' + id % 26, data->mv_size);
+	memcpy(w->w_buf, &id, sizeof(id));
+}
+
+static void
+populate(void)
+{
+	int rc;
+	MDB_txn *txn;
+	MDB_val key, data;
+	MDB_stat st;
+	size_t id;
+	unsigned k;
+	dnrec dr;
+	worker w;
+
+	w.w_seed = 1;
+	w.w_buf = malloc(esize * 2);
+	E(mdb_txn_begin(env, NULL, 0, &txn));
+	E(mdb_dbi_open(txn, "id2e", MDB_CREATE|MDB_INTEGERKEY, &id2e));
+	E(mdb_dbi_open(txn, "dn2i", MDB_CREATE|MDB_DUPSORT, &dn2i));
+	E(mdb_dbi_open(txn, "idx", MDB_CREATE|MDB_DUPSORT|MDB_DUPFIXED|MDB_INTEGERDUP, &idx));
+	E(mdb_stat(txn, id2e, &st));
+	if (st.ms_entries) {
+		nentries = st.ms_entries;
+		E(mdb_txn_commit(txn));
+		free(w.w_buf);
+		printf("Using existing database with %"Z"u entries\n", nentries);
+		return;
+	}
+	for (id = 1; id <= nentries; id++) {
+		key.mv_size = sizeof(id);
+		key.mv_data = &id;
+		mkentry(&w, &data, id);
+		E(mdb_put(txn, id2e, &key, &data, MDB_APPEND));
+		if (id > 1) {
+			size_t parent = PARENT(id);
+			memset(&dr, 0, sizeof(dr));
+			dr.d_id = id;
+			sprintf(dr.d_rdn, "cn=%"Z"u", id);
+			key.mv_data = &parent;
+			data.mv_size = sizeof(dr);
+			data.mv_data = &dr;
+			E(mdb_put(txn, dn2i, &key, &data, 0));
+		}
+		k = IDXKEY(id, 0);
+		key.mv_size = sizeof(k);
+		key.mv_data = &k;
+		data.mv_size = sizeof(id);
+		data.mv_data = &id;
+		E(mdb_put(txn, idx, &key, &data, 0));
+		if (id % 10000 == 0) {
+			E(mdb_txn_commit(txn));
+			E(mdb_txn_begin(env, NULL, 0, &txn));
+		}
+	}
+	E(mdb_txn_commit(txn));
+	free(w.w_buf);
+}
+
+static void
+doread(worker *w, MDB_txn *txn, MDB_cursor **curs, int type, size_t arg)
+{
+	int rc;
+	MDB_val key, data;
+	unsigned k;
+
+	switch (type) {
+	case OP_GET:
+		key.mv_size = sizeof(arg);
+		key.mv_data = &arg;
+		if (RES(MDB_NOTFOUND, mdb_get(txn, id2e, &key, &data)) == 0)
+			w->w_found++;
+		break;
+	case OP_WALK:
+		key.mv_size = sizeof(arg);
+		key.mv_data = &arg;
+		if (RES(MDB_NOTFOUND, mdb_cursor_get(curs[0], &key, &data, MDB_SET)))
+			break;
+		do {
+			w->w_found++;
+		} while (RES(MDB_NOTFOUND, mdb_cursor_get(curs[0], &key, &data, MDB_NEXT_DUP)) == 0);
+		break;
+	case OP_IDL:
+		k = arg;
+		key.mv_size = sizeof(k);
+		key.mv_data = &k;
+		if (RES(MDB_NOTFOUND, mdb_cursor_get(curs[1], &key, &data, MDB_SET)))
+			break;
+		E(mdb_cursor_get(curs[1], &key, &data, MDB_GET_MULTIPLE));
+		do {
+			w->w_found += data.mv_size / sizeof(size_t);
+		} while (RES(MDB_NOTFOUND, mdb_cursor_get(curs[1], &key, &data, MDB_NEXT_MULTIPLE)) == 0);
+		break;
+	}
+}
+
+static void
+dowrite(worker *w, MDB_txn *txn, size_t id)
+{
+	int rc;
+	MDB_val key, data;
+	unsigned k;
+	size_t gen = rnd(w);
+
+	key.mv_size = sizeof(id);
+	key.mv_data = &id;
+	if (RES(MDB_NOTFOUND, mdb_get(txn, id2e, &key, &data)))
+		return;
+	mkentry(w, &data, id);
+	E(mdb_put(txn, id2e, &key, &data, 0));
+	/* move the entry from one index slot to another */
+	k = IDXKEY(id, gen % 4);
+	key.mv_size = sizeof(k);
+	key.mv_data = &k;
+	data.mv_size = sizeof(id);
+	data.mv_data = &id;
+	RES(MDB_NOTFOUND, mdb_del(txn, idx, &key, &data));
+	k = IDXKEY(id, (gen + 1) % 4);
+	E(mdb_put(txn, idx, &key, &data, 0));
+	w->w_found++;
+}
+
+static void
+pick(worker *w, size_t n, int *type, size_t *arg)
+{
+	unsigned r;
+	int t;
+
+	if (trace) {
+		*type = trace[n].o_type;
+		*arg = trace[n].o_arg;
+		return;
+	}
+	r = rnd(w) % 100;
+	for (t = 0; t < NOPS - 1 && r >= mix[t]; t++)
+		r -= mix[t];
+	*type = t;
+	switch (t) {
+	case OP_WALK:
+		*arg = 1 + rnd(w) % PARENT(nentries);
+		break;
+	case OP_IDL:
+		*arg = rnd(w) % nkeys;
+		break;
+	default:
+		*arg = 1 + rnd(w) % nentries;
+	}
+}
+
+static void *
+runner(void *arg)
+{
+	worker *w = arg;
+	int rc, type;
+	MDB_txn *rtxn, *wtxn;
+	MDB_cursor *curs[2];
+	size_t n, oparg;
+	unsigned long long t0, t1;
+	unsigned i;
+
+	w->w_buf = malloc(esize * 2);
+	E(mdb_txn_begin(env, NULL, MDB_RDONLY, &rtxn));
+	E(mdb_cursor_open(rtxn, dn2i, &curs[0]));
+	E(mdb_cursor_open(rtxn, idx, &curs[1]));
+	mdb_txn_reset(rtxn);
+	for (n = w->w_num; trace ? n < ntrace : running; n += nthreads) {
+		pick(w, n, &type, &oparg);
+		t0 = now();
+		if (type == OP_PUT) {
+			E(mdb_txn_begin(env, NULL, 0, &wtxn));
+			dowrite(w, wtxn, oparg);
+			for (i = 1; i < perwtxn && !trace; i++)
+				dowrite(w, wtxn, 1 + rnd(w) % nentries);
+			E(mdb_txn_commit(wtxn));
+		} else {
+			/* One read txn per operation, as slapd does */
+			E(mdb_txn_renew(rtxn));
+			E(mdb_cursor_renew(rtxn, curs[0]));
+			E(mdb_cursor_renew(rtxn, curs[1]));
+			doread(w, rtxn, curs, type, oparg);
+			mdb_txn_reset(rtxn);
+		}
+		t1 = now();
+		hadd(&w->w_hist[type], t1 - t0);
+	}
+	mdb_cursor_close(curs[0]);
+	mdb_cursor_close(curs[1]);
+	mdb_txn_abort(rtxn);
+	free(w->w_buf);
+	return NULL;
+}
+
+static void
+readtrace(const char *name)
+{
+	FILE *f = strcmp(name, "-") ? fopen(name, "r") : stdin;
+	char line[256], opname[16];
+	size_t arg, alloc = 0;
+	int t;
+
+	if (!f) {
+		perror(name);
+		exit(EXIT_FAILURE);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || sscanf(line, "%15s %"Z"u", opname, &arg) != 2)
+			continue;
+		for (t = 0; t < NOPS && strcmp(opname, opnames[t]); t++) ;
+		if (t == NOPS) {
+			fprintf(stderr, "%s: unknown operation \"%s\"\n", name, opname);
+			exit(EXIT_FAILURE);
+		}
+		if (ntrace == alloc) {
+			alloc = alloc ? alloc * 2 : 1024;
+			trace = realloc(trace, alloc * sizeof(op));
+			if (!trace) {
+				perror("realloc");
+				exit(EXIT_FAILURE);
+			}
+		}
+		trace[ntrace].o_type = t;
+		trace[ntrace++].o_arg = arg;
+	}
+	if (f != stdin)
+		fclose(f);
+}
+
+static void
+usage(char *prog)
+{
+	fprintf(stderr, "usage: %s [-n entries] [-F fanout] [-k idxkeys] [-e entrysize]"
+		" [-t threads] [-s seconds] [-m get,walk,idl,put] [-w puts/txn]"
+		" [-p pagesize] [-N] [-W] [-H] [-f tracefile] dbpath\n", prog);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+	int i, rc, hists = 0;
+	unsigned flags = 0, psize = 0;
+	char *prog = argv[0], *tracefile = NULL;
+	worker *ws;
+	hist total[NOPS];
+	unsigned long long t0, elapsed;
+	MDB_envinfo info;
+
+	while ((i = getopt(argc, argv, "e:f:F:Hk:m:n:Np:s:t:w:W")) != EOF) {
+		switch(i) {
+		case 'e':
+			esize = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			tracefile = optarg;
+			break;
+		case 'F':
+			fanout = strtoul(optarg, NULL, 0);
+			break;
+		case 'H':
+			hists = 1;
+			break;
+		case 'k':
+			nkeys = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			if (sscanf(optarg, "%u,%u,%u,%u", &mix[0], &mix[1], &mix[2], &mix[3]) != 4 ||
+				mix[0] + mix[1] + mix[2] + mix[3] != 100) {
+				fprintf(stderr, "%s: -m ratios must add up to 100\n", prog);
+				usage(prog);
+			}
+			break;
+		case 'n':
+			nentries = strtoul(optarg, NULL, 0);
+			break;
+		case 'N':
+			flags |= MDB_NOSYNC;
+			break;
+		case 'p':
+			psize = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			seconds = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			nthreads = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			perwtxn = strtoul(optarg, NULL, 0);
+			break;
+		case 'W':
+			flags |= MDB_WRITEMAP;
+			break;
+		default:
+			usage(prog);
+		}
+	}
+	if (optind != argc - 1 || !nentries || !nkeys || !esize ||
+		fanout < 2 || !nthreads || !perwtxn)
+		usage(prog);
+	if (tracefile)
+		readtrace(tracefile);
+
+	E(mdb_env_create(&env));
+	E(mdb_env_set_maxdbs(env, 4));
+	E(mdb_env_set_maxreaders(env, nthreads + 8));
+	E(mdb_env_set_mapsize(env, (size_t)1 << (sizeof(size_t) > 4 ? 36 : 30)));
+	if (psize)
+		E(mdb_env_set_pagesize(env, psize));
+	E(mdb_env_open(env, argv[optind], flags, 0664));
+
+	t0 = now();
+	populate();
+	elapsed = now() - t0;
+	if (elapsed > 1000000)
+		printf("Loaded %"Z"u entries in %.3f s\n", nentries, elapsed / 1e9);
+
+	ws = calloc(nthreads, sizeof(worker));
+	t0 = now();
+	for (i = 0; i < (int)nthreads; i++) {
+		ws[i].w_num = i;
+		ws[i].w_seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+		rc = pthread_create(&ws[i].w_thr, NULL, runner, &ws[i]);
+		CHECK(rc == 0, "pthread_create");
+	}
+	if (!trace) {
+		sleep(seconds);
+		running = 0;
+	}
+	for (i = 0; i < (int)nthreads; i++)
+		pthread_join(ws[i].w_thr, NULL);
+	elapsed = now() - t0;
+
+	memset(total, 0, sizeof(total));
+	for (i = 0; i < (int)nthreads; i++) {
+		int t;
+		for (t = 0; t < NOPS; t++)
+			hmerge(&total[t], &ws[i].w_hist[t]);
+	}
+	E(mdb_env_info(env, &info));
+	printf("%u threads, %.3f s, %"Z"u pages in use\n", nthreads,
+		elapsed / 1e9, info.me_last_pgno + 1);
+	printf("%-5s %10s %10s %9s %9s %9s %9s %9s %10s\n", "op", "count", "ops/s",
+		"avg(us)", "p50", "p90", "p99", "p99.9", "max");
+	for (i = 0; i < NOPS; i++) {
+		hist *h = &total[i];
+		if (!h->h_count)
+			continue;
+		printf("%-5s %10"Z"u %10.0f %9.3f %9.3f %9.3f %9.3f %9.3f %10.3f\n",
+			opnames[i], h->h_count, h->h_count / (elapsed / 1e9),
+			h->h_sum / 1000.0 / h->h_count, hpct(h, 50), hpct(h, 90),
+			hpct(h, 99), hpct(h, 99.9), h->h_max / 1000.0);
+	}
+	if (hists) {
+		for (i = 0; i < NOPS; i++) {
+			if (!total[i].h_count)
+				continue;
+			printf("\n%s latency:\n", opnames[i]);
+			hprint(&total[i]);
+		}
+	}
+
+	free(ws);
+	free(trace);
+	mdb_env_close(env);
+	return 0;
+}
@@ -561,12 +561,23 @@ static txnid_t mdb_debug_start;
 #define MDB_MAXKEYSIZE	 ((MDB_DEVEL) ? 0 : 511)
 #endif
 
+	/**	@brief The largest page size that still uses #MDB_MAXKEYSIZE.
+	 *
+	 *	An environment with bigger pages uses the computed max key size
+	 *	only when the application asked for its page size with
+	 *	#mdb_env_set_pagesize() and that size is not the OS default.
+	 *	Environments that merely got big pages from the host keep the
+	 *	fixed limit, so older versions of LMDB can still modify them.
+	 */
+#ifndef MDB_MAXKEY_PAGESIZE
+#define MDB_MAXKEY_PAGESIZE	 4096
+#endif
+
+	/**	The smallest page size #mdb_env_set_pagesize() accepts. */
+#define MIN_PAGESIZE	 512
+
 	/**	The maximum size of a key we can write to the environment. */
-#if MDB_MAXKEYSIZE
-#define ENV_MAXKEY(env)	(MDB_MAXKEYSIZE)
-#else
 #define ENV_MAXKEY(env)	((env)->me_maxkey)
-#endif
 
 	/**	@brief The maximum size of a data item.
 	 *
@@ -654,6 +665,13 @@ typedef uint16_t	 indx_t;
  *	the longer we delay reclaiming old pages, the more likely it is that a
  *	string of contiguous pages can be found after coalescing old pages from
  *	many old transactions together.
+ *
+ *	A new reader claims a free slot with a compare-and-swap on #mr_pid,
+ *	without #mti_rmutex. The scan starts at the slot its env claimed
+ *	last. The mutex is only taken to grow the table, or when the table
+ *	is full, to reap at most #MDB_RSLOT_SWEEP slots of dead processes.
+ *	Builds without compare-and-swap claim every slot under the mutex,
+ *	and use another #MDB_LOCK_FORMAT so the two never share a table.
  *	@{
  */
 	/**	Number of slots in the reader table.
@@ -708,6 +726,41 @@ typedef struct MDB_reader {
 	} mru;
 } MDB_reader;
 
+	/** @def MDB_CAS32(p, o, n)
+	 *	Atomically set the 32-bit value at \b p to \b n if it is \b o.
+	 *	Returns true on success. Left undefined when the compiler has no
+	 *	suitable builtin; reader slots are then claimed under #mti_rmutex.
+	 */
+	/** @def MDB_MEMBAR()
+	 *	Full memory barrier, used along with #MDB_CAS32().
+	 */
+#if defined(_WIN32)
+#define MDB_CAS32(p, o, n)	\
+	(InterlockedCompareExchange((LONG volatile *)(p), \
+		(LONG)(n), (LONG)(o)) == (LONG)(o))
+#define MDB_MEMBAR()	MemoryBarrier()
+#elif (__GNUC__ * 100 + __GNUC_MINOR__ >= 401) || defined(__clang__)
+#define MDB_CAS32(p, o, n)	__sync_bool_compare_and_swap(p, o, n)
+#define MDB_MEMBAR()	__sync_synchronize()
+#else
+#define MDB_MEMBAR()
+#endif
+
+	/** For MDB_LOCK_FORMAT: True if free reader slots are claimed lock-free */
+#ifdef MDB_CAS32
+#define MDB_RSLOT_CAS	1
+#else
+#define MDB_RSLOT_CAS	0
+#endif
+
+	/**	Number of slots a reader checks for dead owners when the table
+	 *	is full. Each check may cost a system call, so a full table is
+	 *	reaped a few slots at a time; #mdb_reader_check() reaps it all.
+	 */
+#ifndef MDB_RSLOT_SWEEP
+#define MDB_RSLOT_SWEEP	8
+#endif
+
 	/** The header for the reader table.
 	 *	The table resides in a memory-mapped file. (This is a different file
 	 *	than is used for the main database.)
@@ -778,7 +831,8 @@ typedef struct MDB_txninfo {
 	((uint32_t) \
 	 ((MDB_LOCK_VERSION) \
 	  /* Flags which describe functionality */ \
-	  + (((MDB_PIDLOCK) != 0) << 16)))
+	  + (((MDB_PIDLOCK) != 0) << 16) \
+	  + (((MDB_RSLOT_CAS) != 0) << 17)))
 /** @} */
 
 /** Common header for all page types. The page type depends on #mp_flags.
@@ -1266,7 +1320,8 @@ struct MDB_env {
 	/** fdatasync is unreliable */
 #define	MDB_FSYNCONLY	0x08000000U
 	uint32_t 	me_flags;		/**< @ref mdb_env */
-	unsigned int	me_psize;	/**< DB page size, inited from me_os_psize */
+	unsigned int	me_psize;	/**< DB page size, inited from me_os_psize
+						 *	or #mdb_env_set_pagesize() */
 	unsigned int	me_os_psize;	/**< OS page size, from #GET_PAGESIZE */
 	unsigned int	me_maxreaders;	/**< size of the reader table */
 	/** Max #MDB_txninfo.%mti_numreaders of interest to #mdb_env_close() */
@@ -1301,10 +1356,11 @@ struct MDB_env {
 	int			me_maxfree_1pg;
 	/** Max size of a node on a page */
 	unsigned int	me_nodemax;
-#if !(MDB_MAXKEYSIZE)
 	unsigned int	me_maxkey;	/**< max size of a key */
-#endif
 	int		me_live_reader;		/**< have liveness lock in reader table */
+	/** Reader slot this env claimed last, where #mdb_rslot_get() starts */
+	volatile unsigned int	me_rslot_hint;
+	unsigned int	me_rsweep;	/**< next slot for #mdb_rslot_reclaim() */
 #ifdef _WIN32
 	int		me_pidquery;		/**< Used in OpenProcess */
 #endif
@@ -2669,6 +2725,84 @@ mdb_reader_pid(MDB_env *env, enum Pidlock_op op, MDB_PID_T pid)
 #endif
 }
 
+#ifdef MDB_CAS32
+/** Claim a free reader slot without locking.
+ * @param[in] env the environment
+ * @return the slot index, or #me_maxreaders if no published slot is free.
+ */
+static unsigned int
+mdb_rslot_get(MDB_env *env)
+{
+	MDB_reader *mr = env->me_txns->mti_readers;
+	unsigned int i, j, nr = env->me_txns->mti_numreaders;
+
+	if ((i = env->me_rslot_hint) >= nr)
+		i = 0;
+	for (j=0; j<nr; j++) {
+		if (mr[i].mr_pid == 0 && MDB_CAS32(&mr[i].mr_pid, 0, env->me_pid))
+			return i;
+		if (++i == nr)
+			i = 0;
+	}
+	return env->me_maxreaders;
+}
+#endif
+
+/** Record a reader slot this env has claimed.
+ * Makes sure #mdb_env_close() looks at the slot.
+ * @param[in] env the environment
+ * @param[in] slot index of the slot in the reader table
+ */
+static void
+mdb_rslot_own(MDB_env *env, unsigned int slot)
+{
+	int n;
+
+#ifdef MDB_CAS32
+	while ((n = env->me_close_readers) <= (int)slot &&
+		!MDB_CAS32(&env->me_close_readers, n, (int)slot+1))
+		;
+	env->me_rslot_hint = slot;
+#else
+	/* All claims hold the reader mutex */
+	if ((n = env->me_close_readers) <= (int)slot)
+		env->me_close_readers = slot+1;
+#endif
+}
+
+/** Take over a slot of a dead process when the reader table is full.
+ * The caller must hold #me_rmutex. Checks at most #MDB_RSLOT_SWEEP
+ * slots, starting where the previous call of this env stopped.
+ * @param[in] env the environment
+ * @return the slot index, now owned by this process, or
+ *	#me_maxreaders if none was found.
+ */
+static unsigned int
+mdb_rslot_reclaim(MDB_env *env)
+{
+	MDB_reader *mr = env->me_txns->mti_readers;
+	unsigned int i, j, nr = env->me_txns->mti_numreaders;
+	MDB_PID_T pid;
+
+	for (j=0; j<MDB_RSLOT_SWEEP && j<nr; j++) {
+		i = env->me_rsweep++ % nr;
+		pid = mr[i].mr_pid;
+		if (pid && pid != env->me_pid &&
+			!mdb_reader_pid(env, Pidcheck, pid)) {
+#ifdef MDB_CAS32
+			if (!MDB_CAS32(&mr[i].mr_pid, pid, env->me_pid))
+				continue;
+#else
+			mr[i].mr_pid = env->me_pid;
+#endif
+			DPRINTF(("reclaim stale reader pid %u txn %"Z"d",
+				(unsigned) pid, mr[i].mr_txnid));
+			return i;
+		}
+	}
+	return env->me_maxreaders;
+}
+
 /** Common code for #mdb_txn_begin() and #mdb_txn_renew().
  * @param[in] txn the transaction handle to initialize
  * @return 0 on success, non-zero on failure.
@@ -2706,31 +2840,51 @@ mdb_txn_renew0(MDB_txn *txn)
 					env->me_live_reader = 1;
 				}
 
-				if (LOCK_MUTEX(rc, env, rmutex))
-					return rc;
-				nr = ti->mti_numreaders;
-				for (i=0; i<nr; i++)
-					if (ti->mti_readers[i].mr_pid == 0)
-						break;
-				if (i == env->me_maxreaders) {
+#ifdef MDB_CAS32
+				if ((i = mdb_rslot_get(env)) < env->me_maxreaders) {
+					r = &ti->mti_readers[i];
+					r->mr_txnid = (txnid_t)-1;
+					r->mr_tid = tid;
+					mdb_rslot_own(env, i);
+				} else
+#endif
+				{
+					if (LOCK_MUTEX(rc, env, rmutex))
+						return rc;
+					nr = ti->mti_numreaders;
+#ifdef MDB_CAS32
+					/* Retry, a slot may have been freed meanwhile */
+					if ((i = mdb_rslot_get(env)) == env->me_maxreaders)
+						i = nr;
+#else
+					for (i=0; i<nr; i++)
+						if (ti->mti_readers[i].mr_pid == 0)
+							break;
+#endif
+					if (i == env->me_maxreaders &&
+						(i = mdb_rslot_reclaim(env)) == env->me_maxreaders) {
+						UNLOCK_MUTEX(rmutex);
+						return MDB_READERS_FULL;
+					}
+					r = &ti->mti_readers[i];
+					/* Claim the reader slot, carefully since other code
+					 * uses the reader table un-mutexed: First reset a
+					 * new slot, next claim it, and only then publish it
+					 * in mti_numreaders where lock-free claims see it.
+					 * A reused slot is free (pid 0) or already ours.
+					 */
+					if (i == nr)
+						r->mr_pid = 0;
+					r->mr_txnid = (txnid_t)-1;
+					r->mr_tid = tid;
+					r->mr_pid = pid;
+					if (i == nr) {
+						MDB_MEMBAR();
+						ti->mti_numreaders = ++nr;
+					}
+					mdb_rslot_own(env, i);
 					UNLOCK_MUTEX(rmutex);
-					return MDB_READERS_FULL;
 				}
-				r = &ti->mti_readers[i];
-				/* Claim the reader slot, carefully since other code
-				 * uses the reader table un-mutexed: First reset the
-				 * slot, next publish it in mti_numreaders.  After
-				 * that, it is safe for mdb_env_close() to touch it.
-				 * When it will be closed, we can finally claim it.
-				 */
-				r->mr_pid = 0;
-				r->mr_txnid = (txnid_t)-1;
-				r->mr_tid = tid;
-				if (i == nr)
-					ti->mti_numreaders = ++nr;
-				env->me_close_readers = nr;
-				r->mr_pid = pid;
-				UNLOCK_MUTEX(rmutex);
 
 				new_notls = (env->me_flags & MDB_NOTLS);
 				if (!new_notls && (rc=pthread_setspecific(env->me_txkey, r))) {
@@ -3964,6 +4118,9 @@ mdb_env_create(MDB_env **env)
 #endif
 	e->me_pid = getpid();
 	GET_PAGESIZE(e->me_os_psize);
+#if MDB_MAXKEYSIZE
+	e->me_maxkey = MDB_MAXKEYSIZE;
+#endif
 	VGMEMP_CREATE(e,0,0);
 	*env = e;
 	return MDB_SUCCESS;
@@ -4334,6 +4491,9 @@ static int ESECT
 mdb_env_open2(MDB_env *env)
 {
 	unsigned int flags = env->me_flags;
+#if MDB_MAXKEYSIZE
+	unsigned int req_psize = env->me_psize, def_psize;
+#endif
 	int i, newenv = 0, rc;
 	MDB_meta meta;
 
@@ -4399,9 +4559,11 @@ mdb_env_open2(MDB_env *env)
 			return i;
 		DPUTS("new mdbenv");
 		newenv = 1;
-		env->me_psize = env->me_os_psize;
-		if (env->me_psize > MAX_PAGESIZE)
-			env->me_psize = MAX_PAGESIZE;
+		if (!env->me_psize) {
+			env->me_psize = env->me_os_psize;
+			if (env->me_psize > MAX_PAGESIZE)
+				env->me_psize = MAX_PAGESIZE;
+		}
 		memset(&meta, 0, sizeof(meta));
 		mdb_env_init_meta0(env, &meta);
 		meta.mm_mapsize = DEFAULT_MAPSIZE;
@@ -4453,9 +4615,16 @@ mdb_env_open2(MDB_env *env)
 	env->me_maxfree_1pg = (env->me_psize - PAGEHDRSZ) / sizeof(pgno_t) - 1;
 	env->me_nodemax = (((env->me_psize - PAGEHDRSZ) / MDB_MINKEYS) & -2)
 		- sizeof(indx_t);
-#if !(MDB_MAXKEYSIZE)
-	env->me_maxkey = env->me_nodemax - (NODESIZE + sizeof(MDB_db));
+#if MDB_MAXKEYSIZE
+	def_psize = env->me_os_psize;
+	if (def_psize > MAX_PAGESIZE)
+		def_psize = MAX_PAGESIZE;
+	if (env->me_psize <= MDB_MAXKEY_PAGESIZE ||
+		env->me_psize != req_psize || req_psize == def_psize)
+		env->me_maxkey = MDB_MAXKEYSIZE;
+	else
 #endif
+		env->me_maxkey = env->me_nodemax - (NODESIZE + sizeof(MDB_db));
 	env->me_maxpg = env->me_mapsize / env->me_psize;
 
 #if MDB_DEBUG
@@ -9602,6 +9771,394 @@ mdb_env_copy(MDB_env *env, const char *path)
 	return mdb_env_copy2(env, path, 0);
 }
 
+/** @defgroup incr	Incremental copies
+ *	@ingroup internal
+ *
+ *	This version of LMDB doesn't record in each page the txn that
+ *	wrote it, so an incremental copy can't simply select pages by
+ *	txnid. Instead a signature file remembers a hash of every page
+ *	as last written to the backup. An increment holds only the pages
+ *	whose current hash differs, so the I/O on the backup side is
+ *	proportional to the churn, while the source map is only read.
+ *
+ *	An increment is a #MDB_incrhdr, followed by (pgno, page) records
+ *	in ascending page order, then the meta pages, then a record with
+ *	pgno #P_INVALID. Since the meta pages come last, applying an
+ *	increment again after a failure is always safe.
+ *	@{
+ */
+#define MDB_INCR_MAGIC	0xBEEFC0DF
+#define MDB_INCR_VERSION	1
+
+	/** Header of an incremental copy stream and of a signature file */
+typedef struct MDB_incrhdr {
+	uint32_t	mi_magic;		/**< #MDB_INCR_MAGIC */
+	uint32_t	mi_version;		/**< #MDB_INCR_VERSION */
+	uint32_t	mi_psize;		/**< page size of the environment */
+	uint32_t	mi_pad;
+	pgno_t		mi_npages;		/**< pages in the environment */
+	txnid_t		mi_txnid;		/**< txn the increment brings the copy to */
+} MDB_incrhdr;
+
+typedef unsigned long long	mdb_pgsig_t;
+
+	/** Hash a page a word at a time. Each step is a bijection,
+	 *	so a change in a single word always changes the result.
+	 */
+static mdb_pgsig_t
+mdb_page_sig(const char *ptr, unsigned int psize)
+{
+	mdb_pgsig_t h = 0xcbf29ce484222325ULL, w;
+	const char *end = ptr + psize;
+
+	for (; ptr < end; ptr += sizeof(w)) {
+		memcpy(&w, ptr, sizeof(w));
+		h = (h ^ w) * 0x100000001b3ULL;
+		h ^= h >> 29;
+	}
+	return h;
+}
+
+#ifdef _WIN32
+#define DO_WRITE(rc, fd, ptr, w2, len)	rc = WriteFile(fd, ptr, w2, &len, NULL)
+#define DO_READ(rc, fd, ptr, w2, len)	rc = ReadFile(fd, ptr, w2, &len, NULL)
+#else
+#define DO_WRITE(rc, fd, ptr, w2, len)	len = write(fd, ptr, w2); rc = (len >= 0)
+#define DO_READ(rc, fd, ptr, w2, len)	len = read(fd, ptr, w2); rc = (len >= 0)
+#endif
+
+	/** Write a whole buffer to a file handle */
+static int ESECT
+mdb_fd_write(HANDLE fd, const char *ptr, size_t size)
+{
+	int rc = MDB_SUCCESS;
+#ifdef _WIN32
+	DWORD len, w2;
+#else
+	ssize_t len;
+	size_t w2;
+#endif
+
+	while (size > 0) {
+		w2 = size > MAX_WRITE ? MAX_WRITE : size;
+		DO_WRITE(rc, fd, ptr, w2, len);
+		if (!rc) {
+			rc = ErrCode();
+			break;
+		} else if (len > 0) {
+			rc = MDB_SUCCESS;
+			ptr += len;
+			size -= len;
+		} else {
+			/* Non-blocking or async handles are not supported */
+			rc = EIO;
+			break;
+		}
+	}
+	return rc;
+}
+
+	/** Read a whole buffer from a file handle.
+	 *	@return #MDB_INVALID if the input ends first.
+	 */
+static int ESECT
+mdb_fd_read(HANDLE fd, char *ptr, size_t size)
+{
+	int rc = MDB_SUCCESS;
+#ifdef _WIN32
+	DWORD len, w2;
+#else
+	ssize_t len;
+	size_t w2;
+#endif
+
+	while (size > 0) {
+		w2 = size > MAX_WRITE ? MAX_WRITE : size;
+		DO_READ(rc, fd, ptr, w2, len);
+		if (!rc) {
+			rc = ErrCode();
+			break;
+		} else if (len > 0) {
+			rc = MDB_SUCCESS;
+			ptr += len;
+			size -= len;
+		} else {
+			rc = MDB_INVALID;
+			break;
+		}
+	}
+	return rc;
+}
+#undef DO_WRITE
+#undef DO_READ
+
+	/** Write to a file handle at the given offset */
+static int ESECT
+mdb_fd_pwrite(HANDLE fd, const char *ptr, size_t size, size_t off)
+{
+#ifdef _WIN32
+	DWORD len;
+	OVERLAPPED ov;
+	memset(&ov, 0, sizeof(ov));
+	ov.Offset = off & 0xffffffff;
+	ov.OffsetHigh = off >> 16 >> 16;
+	if (!WriteFile(fd, ptr, size, &len, &ov))
+		return ErrCode();
+#else
+	ssize_t len = pwrite(fd, ptr, size, off);
+	if (len < 0)
+		return ErrCode();
+#endif
+	return (size_t)len == size ? MDB_SUCCESS : EIO;
+}
+
+	/** Write a (pgno, page) record of an increment to the write buffer,
+	 *	flushing it to \b fd when full.
+	 */
+static int ESECT
+mdb_incr_put(HANDLE fd, char *wbuf, size_t *wlen, pgno_t pgno,
+	const char *page, unsigned int psize)
+{
+	size_t rlen = sizeof(pgno_t) + psize;
+	int rc;
+
+	if (*wlen + rlen > MDB_WBUF) {
+		rc = mdb_fd_write(fd, wbuf, *wlen);
+		if (rc)
+			return rc;
+		*wlen = 0;
+	}
+	memcpy(wbuf + *wlen, &pgno, sizeof(pgno_t));
+	if (page)
+		memcpy(wbuf + *wlen + sizeof(pgno_t), page, psize);
+	*wlen += page ? rlen : sizeof(pgno_t);
+	return MDB_SUCCESS;
+}
+
+int ESECT
+mdb_env_copyfd_incr(MDB_env *env, HANDLE fd, HANDLE sigfd)
+{
+	MDB_txn *txn = NULL;
+	mdb_mutexref_t wmutex = NULL;
+	MDB_incrhdr hdr;
+	mdb_pgsig_t *sigs = NULL, sig;
+	char *metas = NULL, *wbuf = NULL, *page;
+	size_t fsize = 0, wlen = 0, nsigs = 0;
+	unsigned int psize = env->me_psize;
+	pgno_t pg, npages;
+	int rc;
+
+	if (!(env->me_flags & MDB_ENV_ACTIVE))
+		return EINVAL;
+
+	/* Load the signatures of the previous copy, if any */
+	rc = mdb_fsize(sigfd, &fsize);
+	if (rc)
+		return rc;
+	if (fsize) {
+		rc = mdb_fd_read(sigfd, (char *)&hdr, sizeof(hdr));
+		if (rc)
+			return rc;
+		if (hdr.mi_magic != MDB_INCR_MAGIC)
+			return MDB_INVALID;
+		if (hdr.mi_version != MDB_INCR_VERSION || hdr.mi_psize != psize)
+			return MDB_VERSION_MISMATCH;
+		nsigs = hdr.mi_npages;
+		if (fsize < sizeof(hdr) + nsigs * sizeof(mdb_pgsig_t))
+			return MDB_INVALID;
+	}
+
+	metas = malloc(psize * NUM_METAS + MDB_WBUF);
+	if (!metas)
+		return ENOMEM;
+	wbuf = metas + psize * NUM_METAS;
+
+	/* Same snapshot dance as mdb_env_copyfd0() */
+	rc = mdb_txn_begin(env, NULL, MDB_RDONLY, &txn);
+	if (rc)
+		goto leave;
+
+	if (env->me_txns) {
+		mdb_txn_end(txn, MDB_END_RESET_TMP);
+
+		wmutex = env->me_wmutex;
+		if (LOCK_MUTEX(rc, env, wmutex))
+			goto leave;
+
+		rc = mdb_txn_renew0(txn);
+		if (rc) {
+			UNLOCK_MUTEX(wmutex);
+			goto leave;
+		}
+	}
+	memcpy(metas, env->me_map, psize * NUM_METAS);
+	if (wmutex)
+		UNLOCK_MUTEX(wmutex);
+
+	npages = txn->mt_next_pgno;
+	if ((rc = mdb_fsize(env->me_fd, &fsize)))
+		goto leave;
+	if (npages > fsize / psize)
+		npages = fsize / psize;
+
+	sigs = malloc(npages * sizeof(mdb_pgsig_t));
+	if (!sigs) {
+		rc = ENOMEM;
+		goto leave;
+	}
+	if (nsigs > npages)
+		nsigs = npages;
+	if (nsigs) {
+		rc = mdb_fd_read(sigfd, (char *)sigs, nsigs * sizeof(mdb_pgsig_t));
+		if (rc)
+			goto leave;
+	}
+
+	hdr.mi_magic = MDB_INCR_MAGIC;
+	hdr.mi_version = MDB_INCR_VERSION;
+	hdr.mi_psize = psize;
+	hdr.mi_pad = 0;
+	hdr.mi_npages = npages;
+	hdr.mi_txnid = txn->mt_txnid;
+	memcpy(wbuf, &hdr, sizeof(hdr));
+	wlen = sizeof(hdr);
+
+	/* Pages outside the snapshot may change while we look at them,
+	 * so hash exactly the bytes that get written out.
+	 */
+	page = malloc(psize);
+	if (!page) {
+		rc = ENOMEM;
+		goto leave;
+	}
+	for (pg = NUM_METAS; pg < npages; pg++) {
+		memcpy(page, env->me_map + pg * psize, psize);
+		sig = mdb_page_sig(page, psize);
+		if (pg < nsigs && sigs[pg] == sig)
+			continue;
+		sigs[pg] = sig;
+		rc = mdb_incr_put(fd, wbuf, &wlen, pg, page, psize);
+		if (rc)
+			break;
+	}
+	free(page);
+	if (rc)
+		goto leave;
+
+	for (pg = 0; pg < NUM_METAS; pg++) {
+		sigs[pg] = mdb_page_sig(metas + pg * psize, psize);
+		rc = mdb_incr_put(fd, wbuf, &wlen, pg, metas + pg * psize, psize);
+		if (rc)
+			goto leave;
+	}
+	rc = mdb_incr_put(fd, wbuf, &wlen, P_INVALID, NULL, psize);
+	if (!rc)
+		rc = mdb_fd_write(fd, wbuf, wlen);
+	if (rc)
+		goto leave;
+
+	/* Only now that the increment is out, record its signatures */
+	rc = mdb_fd_pwrite(sigfd, (char *)&hdr, sizeof(hdr), 0);
+	if (!rc)
+		rc = mdb_fd_pwrite(sigfd, (char *)sigs,
+			npages * sizeof(mdb_pgsig_t), sizeof(hdr));
+
+leave:
+	mdb_txn_abort(txn);
+	free(sigs);
+	free(metas);
+	return rc;
+}
+
+	/** Get the page size of the copy an increment is applied to.
+	 *	@return 0 in \b psize if the copy is still empty.
+	 */
+static int ESECT
+mdb_incr_target_psize(HANDLE datafd, unsigned int *psize)
+{
+	MDB_metabuf	pbuf;
+	MDB_page	*p;
+	MDB_meta	*m;
+	int			rc;
+	enum { Size = sizeof(pbuf) };
+
+#ifdef _WIN32
+	DWORD len;
+	OVERLAPPED ov;
+	memset(&ov, 0, sizeof(ov));
+	rc = ReadFile(datafd, &pbuf, Size, &len, &ov) ? (int)len : -1;
+	if (rc == -1 && ErrCode() == ERROR_HANDLE_EOF)
+		rc = 0;
+#else
+	rc = pread(datafd, &pbuf, Size, 0);
+#endif
+	if (rc == 0) {
+		*psize = 0;
+		return MDB_SUCCESS;
+	}
+	if (rc != Size)
+		return rc < 0 ? (int) ErrCode() : MDB_INVALID;
+
+	p = (MDB_page *)&pbuf;
+	m = METADATA(p);
+	if (!F_ISSET(p->mp_flags, P_META) || m->mm_magic != MDB_MAGIC)
+		return MDB_INVALID;
+	*psize = m->mm_psize;
+	return MDB_SUCCESS;
+}
+
+int ESECT
+mdb_env_incr_apply(HANDLE datafd, HANDLE fd)
+{
+	MDB_incrhdr hdr;
+	pgno_t pg;
+	char *page;
+	unsigned int psize = 0;
+	int rc;
+
+	rc = mdb_fd_read(fd, (char *)&hdr, sizeof(hdr));
+	if (rc)
+		return rc;
+	if (hdr.mi_magic != MDB_INCR_MAGIC)
+		return MDB_INVALID;
+	if (hdr.mi_version != MDB_INCR_VERSION)
+		return MDB_VERSION_MISMATCH;
+	if (hdr.mi_psize < MIN_PAGESIZE || hdr.mi_psize > MAX_PAGESIZE ||
+		(hdr.mi_psize & (hdr.mi_psize - 1)))
+		return MDB_INVALID;
+
+	/* The pages must land where the copy expects them */
+	rc = mdb_incr_target_psize(datafd, &psize);
+	if (rc)
+		return rc;
+	if (psize && psize != hdr.mi_psize)
+		return MDB_INVALID;
+
+	page = malloc(hdr.mi_psize);
+	if (!page)
+		return ENOMEM;
+	for (;;) {
+		rc = mdb_fd_read(fd, (char *)&pg, sizeof(pg));
+		if (rc || pg == P_INVALID)
+			break;
+		if (pg >= hdr.mi_npages) {
+			rc = MDB_CORRUPTED;
+			break;
+		}
+		rc = mdb_fd_read(fd, page, hdr.mi_psize);
+		if (!rc)
+			rc = mdb_fd_pwrite(datafd, page, hdr.mi_psize,
+				(size_t)pg * hdr.mi_psize);
+		if (rc)
+			break;
+	}
+	free(page);
+	if (!rc && MDB_FDATASYNC(datafd))
+		rc = ErrCode();
+	return rc;
+}
+/** @} */
+
 int ESECT
 mdb_env_set_flags(MDB_env *env, unsigned int flag, int onoff)
 {
@@ -10098,6 +10655,16 @@ mdb_env_get_maxkeysize(MDB_env *env)
 	return ENV_MAXKEY(env);
 }
 
+int ESECT
+mdb_env_set_pagesize(MDB_env *env, unsigned int size)
+{
+	if (env->me_map || size < MIN_PAGESIZE || size > MAX_PAGESIZE ||
+		(size & (size - 1)))
+		return EINVAL;
+	env->me_psize = size;
+	return MDB_SUCCESS;
+}
+
 int ESECT
 mdb_reader_list(MDB_env *env, MDB_msg_func *func, void *ctx)
 {
@@ -10224,7 +10791,13 @@ mdb_reader_check0(MDB_env *env, int rlocked, int *dead)
 							if (mr[j].mr_pid == pid) {
 								DPRINTF(("clear stale reader pid %u txn %"Z"d",
 									(unsigned) pid, mr[j].mr_txnid));
+#ifdef MDB_CAS32
+								/* Lost a race with mdb_rslot_reclaim() */
+								if (!MDB_CAS32(&mr[j].mr_pid, pid, 0))
+									continue;
+#else
 								mr[j].mr_pid = 0;
+#endif
 								count++;
 							}
 					if (rmutex)
@@ -13,15 +13,78 @@
  */
 #ifdef _WIN32
 #include <windows.h>
+#define	MDB_STDIN	GetStdHandle(STD_INPUT_HANDLE)
 #define	MDB_STDOUT	GetStdHandle(STD_OUTPUT_HANDLE)
 #else
+#include <fcntl.h>
+#include <unistd.h>
+#define	MDB_STDIN	0
 #define	MDB_STDOUT	1
 #endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <signal.h>
 #include "lmdb.h"
 
+/* Open a file for the incremental copy options */
+static int
+incr_open(const char *path, int write, mdb_filehandle_t *fd)
+{
+#ifdef _WIN32
+	*fd = CreateFileA(path, write ? GENERIC_READ|GENERIC_WRITE : GENERIC_READ,
+		FILE_SHARE_READ, NULL, write ? OPEN_ALWAYS : OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, NULL);
+	return *fd == INVALID_HANDLE_VALUE ? (int)GetLastError() : 0;
+#else
+	*fd = open(path, write ? O_RDWR|O_CREAT : O_RDONLY, 0600);
+	return *fd < 0 ? errno : 0;
+#endif
+}
+
+static void
+incr_close(mdb_filehandle_t fd)
+{
+#ifdef _WIN32
+	CloseHandle(fd);
+#else
+	close(fd);
+#endif
+}
+
+/* Apply an increment onto the copy at path */
+static int
+incr_apply(const char *path, const char *incr, unsigned flags)
+{
+	mdb_filehandle_t fd, datafd;
+	char *dname;
+	int rc;
+
+	dname = malloc(strlen(path) + sizeof("/data.mdb"));
+	if (!dname)
+		return ENOMEM;
+	strcpy(dname, path);
+	if (!(flags & MDB_NOSUBDIR))
+		strcat(dname, "/data.mdb");
+	rc = incr_open(dname, 1, &datafd);
+	free(dname);
+	if (rc)
+		return rc;
+	if (strcmp(incr, "-")) {
+		rc = incr_open(incr, 0, &fd);
+	} else {
+		fd = MDB_STDIN;
+	}
+	if (!rc) {
+		rc = mdb_env_incr_apply(datafd, fd);
+		if (fd != MDB_STDIN)
+			incr_close(fd);
+	}
+	incr_close(datafd);
+	return rc;
+}
+
 static void
 sighandle(int sig)
 {
@@ -32,6 +95,7 @@ int main(int argc,char * argv[])
 	int rc;
 	MDB_env *env;
 	const char *progname = argv[0], *act;
+	const char *signame = NULL, *incrname = NULL;
 	unsigned flags = MDB_RDONLY;
 	unsigned cpflags = 0;
 
@@ -40,6 +104,13 @@ int main(int argc,char * argv[])
 			flags |= MDB_NOSUBDIR;
 		else if (argv[1][1] == 'c' && argv[1][2] == '\0')
 			cpflags |= MDB_CP_COMPACT;
+		else if (argv[1][1] == 'i' && argv[1][2] == '\0' && argc > 2) {
+			signame = argv[2];
+			argc--, argv++;
+		} else if (argv[1][1] == 'a' && argv[1][2] == '\0' && argc > 2) {
+			incrname = argv[2];
+			argc--, argv++;
+		}
 		else if (argv[1][1] == 'V' && argv[1][2] == '\0') {
 			printf("%s\n", MDB_VERSION_STRING);
 			exit(0);
@@ -47,11 +118,23 @@ int main(int argc,char * argv[])
 			argc = 0;
 	}
 
-	if (argc<2 || argc>3) {
-		fprintf(stderr, "usage: %s [-V] [-c] [-n] srcpath [dstpath]\n", progname);
+	if (argc<2 || argc>3 || (signame && (cpflags || incrname)) ||
+		(incrname && (cpflags || argc != 2))) {
+		fprintf(stderr, "usage: %s [-V] [-c] [-n] srcpath [dstpath]\n"
+			"       %s [-n] -i sigfile srcpath [incrfile]\n"
+			"       %s [-n] -a incrfile dstpath\n",
+			progname, progname, progname);
 		exit(EXIT_FAILURE);
 	}
 
+	if (incrname) {
+		rc = incr_apply(argv[1], incrname, flags);
+		if (rc)
+			fprintf(stderr, "%s: applying increment failed, error %d (%s)\n",
+				progname, rc, mdb_strerror(rc));
+		return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
 #ifdef SIGPIPE
 	signal(SIGPIPE, sighandle);
 #endif
@@ -68,7 +151,33 @@ int main(int argc,char * argv[])
 	}
 	if (rc == MDB_SUCCESS) {
 		act = "copying";
-		if (argc == 2)
+		if (signame) {
+			mdb_filehandle_t sigfd, fd = MDB_STDOUT;
+			act = "opening signature file";
+			rc = incr_open(signame, 1, &sigfd);
+			if (rc == MDB_SUCCESS && argc == 3) {
+				act = "opening increment file";
+#ifdef _WIN32
+				fd = CreateFileA(argv[2], GENERIC_WRITE, 0, NULL,
+					CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+				if (fd == INVALID_HANDLE_VALUE)
+					rc = GetLastError();
+#else
+				fd = open(argv[2], O_WRONLY|O_CREAT|O_EXCL, 0600);
+				if (fd < 0)
+					rc = errno;
+#endif
+				if (rc)
+					incr_close(sigfd);
+			}
+			if (rc == MDB_SUCCESS) {
+				act = "copying";
+				rc = mdb_env_copyfd_incr(env, fd, sigfd);
+				if (fd != MDB_STDOUT)
+					incr_close(fd);
+				incr_close(sigfd);
+			}
+		} else if (argc == 2)
 			rc = mdb_env_copyfd2(env, MDB_STDOUT, cpflags);
 		else
 			rc = mdb_env_copy2(env, argv[2], cpflags);
@@ -18,6 +18,9 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <signal.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 #include "lmdb.h"
 
 #ifdef _WIN32
@@ -53,48 +56,48 @@ static void dumpsig( int sig )
 
 static const char hexc[] = "0123456789abcdef";
 
-static void hex(unsigned char c)
+static void hex(FILE *out, unsigned char c)
 {
-	putchar(hexc[c >> 4]);
-	putchar(hexc[c & 0xf]);
+	putc(hexc[c >> 4], out);
+	putc(hexc[c & 0xf], out);
 }
 
-static void text(MDB_val *v)
+static void text(FILE *out, MDB_val *v)
 {
 	unsigned char *c, *end;
 
-	putchar(' ');
+	putc(' ', out);
 	c = v->mv_data;
 	end = c + v->mv_size;
 	while (c < end) {
 		if (isprint(*c)) {
 			if (*c == '\\')
-				putchar('\\');
-			putchar(*c);
+				putc('\\', out);
+			putc(*c, out);
 		} else {
-			putchar('\\');
-			hex(*c);
+			putc('\\', out);
+			hex(out, *c);
 		}
 		c++;
 	}
-	putchar('\n');
+	putc('\n', out);
 }
 
-static void byte(MDB_val *v)
+static void byte(FILE *out, MDB_val *v)
 {
 	unsigned char *c, *end;
 
-	putchar(' ');
+	putc(' ', out);
 	c = v->mv_data;
 	end = c + v->mv_size;
 	while (c < end) {
-		hex(*c++);
+		hex(out, *c++);
 	}
-	putchar('\n');
+	putc('\n', out);
 }
 
 /* Dump in BDB-compatible format */
-static int dumpit(MDB_txn *txn, MDB_dbi dbi, char *name)
+static int dumpit(FILE *out, MDB_txn *txn, MDB_dbi dbi, char *name)
 {
 	MDB_cursor *mc;
 	MDB_stat ms;
@@ -112,25 +115,25 @@ static int dumpit(MDB_txn *txn, MDB_dbi dbi, char *name)
 	rc = mdb_env_info(mdb_txn_env(txn), &info);
 	if (rc) return rc;
 
-	printf("VERSION=3\n");
-	printf("format=%s\n", mode & PRINT ? "print" : "bytevalue");
+	fprintf(out, "VERSION=3\n");
+	fprintf(out, "format=%s\n", mode & PRINT ? "print" : "bytevalue");
 	if (name)
-		printf("database=%s\n", name);
-	printf("type=btree\n");
-	printf("mapsize=%" Z "u\n", info.me_mapsize);
+		fprintf(out, "database=%s\n", name);
+	fprintf(out, "type=btree\n");
+	fprintf(out, "mapsize=%" Z "u\n", info.me_mapsize);
 	if (info.me_mapaddr)
-		printf("mapaddr=%p\n", info.me_mapaddr);
-	printf("maxreaders=%u\n", info.me_maxreaders);
+		fprintf(out, "mapaddr=%p\n", info.me_mapaddr);
+	fprintf(out, "maxreaders=%u\n", info.me_maxreaders);
 
 	if (flags & MDB_DUPSORT)
-		printf("duplicates=1\n");
+		fprintf(out, "duplicates=1\n");
 
 	for (i=0; dbflags[i].bit; i++)
 		if (flags & dbflags[i].bit)
-			printf("%s=1\n", dbflags[i].name);
+			fprintf(out, "%s=1\n", dbflags[i].name);
 
-	printf("db_pagesize=%d\n", ms.ms_psize);
-	printf("HEADER=END\n");
+	fprintf(out, "db_pagesize=%d\n", ms.ms_psize);
+	fprintf(out, "HEADER=END\n");
 
 	rc = mdb_cursor_open(txn, dbi, &mc);
 	if (rc) return rc;
@@ -141,23 +144,280 @@ static int dumpit(MDB_txn *txn, MDB_dbi dbi, char *name)
 			break;
 		}
 		if (mode & PRINT) {
-			text(&key);
-			text(&data);
+			text(out, &key);
+			text(out, &data);
 		} else {
-			byte(&key);
-			byte(&data);
+			byte(out, &key);
+			byte(out, &data);
 		}
 	}
-	printf("DATA=END\n");
+	fprintf(out, "DATA=END\n");
 	if (rc == MDB_NOTFOUND)
 		rc = MDB_SUCCESS;
 
+	mdb_cursor_close(mc);
+	return rc;
+}
+
+/* max subDBs handled by a parallel dump */
+#define MAXDBS_PARALLEL	1024
+
+#ifndef _WIN32
+/* Parallel dump: every subDB goes to its own output file, dumped by a
+ * pool of worker threads. LMDB read txns can't be shared between threads,
+ * so each worker starts its own and the main thread checks that they all
+ * got the snapshot the subDB list was taken from. If a writer committed
+ * in between, everything is retried.
+ */
+#define MAX_SNAP_TRIES	100
+
+typedef struct dumpjob {
+	MDB_env *env;
+	char *prefix;
+	char **names;
+	MDB_dbi *dbis;
+	int ndbs;
+	int next;		/* next subDB to hand out */
+	int nthreads;
+	int ready;		/* workers that have started their txn */
+	int go;			/* 1: snapshot agreed, -1: give up */
+	int rc;
+	size_t snapshot;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+} dumpjob;
+
+/* Build an output file name from the prefix and subDB name, escaping
+ * anything that isn't safe in a file name.
+ */
+static char *dumpname(char *prefix, char *name)
+{
+	size_t len = strlen(prefix);
+	char *ptr, *ret;
+	unsigned char *c;
+
+	ret = malloc(len + 1 + strlen(name) * 3 + 1);
+	if (!ret)
+		return NULL;
+	memcpy(ret, prefix, len);
+	ptr = ret + len;
+	*ptr++ = '.';
+	for (c = (unsigned char *)name; *c; c++) {
+		if (isalnum(*c) || *c == '-' || *c == '_' || *c == '.') {
+			*ptr++ = *c;
+		} else {
+			*ptr++ = '%';
+			*ptr++ = hexc[*c >> 4];
+			*ptr++ = hexc[*c & 0xf];
+		}
+	}
+	*ptr = '\0';
+	return ret;
+}
+
+static void *dumpthread(void *arg)
+{
+	dumpjob *job = arg;
+	MDB_txn *txn = NULL;
+	int i, rc;
+
+	rc = mdb_txn_begin(job->env, NULL, MDB_RDONLY, &txn);
+	pthread_mutex_lock(&job->mutex);
+	if (rc) {
+		txn = NULL;
+		if (!job->rc)
+			job->rc = rc;
+	} else if (mdb_txn_id(txn) != job->snapshot) {
+		job->go = -1;
+	}
+	job->ready++;
+	pthread_cond_broadcast(&job->cond);
+	while (!job->go)
+		pthread_cond_wait(&job->cond, &job->mutex);
+	pthread_mutex_unlock(&job->mutex);
+
+	while (txn && job->go > 0) {
+		FILE *out;
+		char *fname;
+
+		pthread_mutex_lock(&job->mutex);
+		i = job->rc ? job->ndbs : job->next++;
+		pthread_mutex_unlock(&job->mutex);
+		if (i >= job->ndbs)
+			break;
+
+		fname = dumpname(job->prefix, job->names[i]);
+		if (!fname) {
+			rc = ENOMEM;
+		} else if ((out = fopen(fname, "w")) == NULL) {
+			rc = errno;
+		} else {
+			rc = dumpit(out, txn, job->dbis[i], job->names[i]);
+			if (fclose(out) && !rc)
+				rc = errno;
+		}
+		if (rc) {
+			fprintf(stderr, "%s: %s\n", fname ? fname : job->names[i],
+				mdb_strerror(rc));
+			pthread_mutex_lock(&job->mutex);
+			if (!job->rc)
+				job->rc = rc;
+			pthread_mutex_unlock(&job->mutex);
+		}
+		free(fname);
+	}
+	if (txn)
+		mdb_txn_abort(txn);
+	return NULL;
+}
+
+/* Dump the given subDBs using nthreads workers. Returns EAGAIN if the
+ * workers couldn't all see the given snapshot.
+ */
+static int dumpall(MDB_env *env, char *prefix, char **names, MDB_dbi *dbis,
+	int ndbs, size_t snapshot, int nthreads)
+{
+	dumpjob job;
+	pthread_t *tids;
+	int i, rc;
+
+	if (nthreads > ndbs)
+		nthreads = ndbs;
+
+	memset(&job, 0, sizeof(job));
+	job.env = env;
+	job.prefix = prefix;
+	job.names = names;
+	job.dbis = dbis;
+	job.ndbs = ndbs;
+	job.snapshot = snapshot;
+	tids = calloc(nthreads, sizeof(pthread_t));
+	if (!tids)
+		return ENOMEM;
+	pthread_mutex_init(&job.mutex, NULL);
+	pthread_cond_init(&job.cond, NULL);
+
+	for (i=0; i<nthreads; i++) {
+		rc = pthread_create(&tids[i], NULL, dumpthread, &job);
+		if (rc) {
+			pthread_mutex_lock(&job.mutex);
+			job.rc = rc;
+			pthread_mutex_unlock(&job.mutex);
+			break;
+		}
+	}
+	job.nthreads = i;
+
+	pthread_mutex_lock(&job.mutex);
+	while (job.ready < job.nthreads && job.go >= 0)
+		pthread_cond_wait(&job.cond, &job.mutex);
+	if (!job.go)
+		job.go = job.rc ? -1 : 1;
+	pthread_cond_broadcast(&job.cond);
+	pthread_mutex_unlock(&job.mutex);
+
+	for (i=0; i<job.nthreads; i++)
+		pthread_join(tids[i], NULL);
+
+	rc = job.rc;
+	if (!rc && job.go < 0)
+		rc = EAGAIN;
+	pthread_cond_destroy(&job.cond);
+	pthread_mutex_destroy(&job.mutex);
+	free(tids);
+	return rc;
+}
+
+/* Dump every subDB of the environment to its own file */
+static int dumppar(MDB_env *env, char *prefix, int nthreads, int *count)
+{
+	MDB_txn *txn;
+	MDB_cursor *cursor;
+	MDB_dbi dbi, *dbis = NULL;
+	MDB_val key;
+	char **names = NULL;
+	size_t snapshot;
+	int i, ndbs = 0, tries, rc;
+
+	for (tries=0; tries<MAX_SNAP_TRIES; tries++) {
+		for (i=0; i<ndbs; i++)
+			free(names[i]);
+		ndbs = 0;
+
+		rc = mdb_txn_begin(env, NULL, MDB_RDONLY, &txn);
+		if (rc)
+			break;
+		snapshot = mdb_txn_id(txn);
+		rc = mdb_open(txn, NULL, 0, &dbi);
+		if (!rc)
+			rc = mdb_cursor_open(txn, dbi, &cursor);
+		if (rc) {
+			mdb_txn_abort(txn);
+			break;
+		}
+		while ((rc = mdb_cursor_get(cursor, &key, NULL, MDB_NEXT_NODUP)) == 0) {
+			char *str;
+			MDB_dbi db2;
+			if (memchr(key.mv_data, '\0', key.mv_size))
+				continue;
+			if (!(ndbs & (ndbs-1))) {
+				void *p1 = realloc(names, (ndbs ? ndbs*2 : 1) * sizeof(char *));
+				void *p2 = p1 ? realloc(dbis, (ndbs ? ndbs*2 : 1) * sizeof(MDB_dbi)) : NULL;
+				if (p1) names = p1;
+				if (p2) dbis = p2;
+				if (!p2) {
+					rc = ENOMEM;
+					break;
+				}
+			}
+			str = malloc(key.mv_size+1);
+			if (!str) {
+				rc = ENOMEM;
+				break;
+			}
+			memcpy(str, key.mv_data, key.mv_size);
+			str[key.mv_size] = '\0';
+			rc = mdb_open(txn, str, 0, &db2);
+			if (rc == MDB_SUCCESS) {
+				names[ndbs] = str;
+				dbis[ndbs++] = db2;
+			} else {
+				free(str);
+				if (rc == MDB_DBS_FULL)
+					break;
+			}
+		}
+		mdb_cursor_close(cursor);
+		if (rc != MDB_NOTFOUND) {
+			mdb_txn_abort(txn);
+			break;
+		}
+		/* commit so the new DBI handles are visible to the workers */
+		rc = mdb_txn_commit(txn);
+		if (rc || !ndbs)
+			break;
+
+		rc = dumpall(env, prefix, names, dbis, ndbs, snapshot, nthreads);
+		if (rc != EAGAIN)
+			break;
+	}
+	if (rc == EAGAIN)
+		rc = MDB_BAD_TXN;
+
+	for (i=0; i<ndbs; i++) {
+		mdb_close(env, dbis[i]);
+		free(names[i]);
+	}
+	free(names);
+	free(dbis);
+	*count = ndbs;
 	return rc;
 }
+#endif /* !_WIN32 */
 
 static void usage(char *prog)
 {
-	fprintf(stderr, "usage: %s [-V] [-f output] [-l] [-n] [-p] [-a|-s subdb] dbpath\n", prog);
+	fprintf(stderr, "usage: %s [-V] [-f output] [-j threads] [-l] [-n] [-p] [-a|-s subdb] dbpath\n", prog);
 	exit(EXIT_FAILURE);
 }
 
@@ -169,8 +429,8 @@ int main(int argc, char *argv[])
 	MDB_dbi dbi;
 	char *prog = argv[0];
 	char *envname;
-	char *subname = NULL;
-	int alldbs = 0, envflags = 0, list = 0;
+	char *subname = NULL, *outname = NULL;
+	int alldbs = 0, envflags = 0, list = 0, nthreads = 1;
 
 	if (argc < 2) {
 		usage(prog);
@@ -181,10 +441,11 @@ int main(int argc, char *argv[])
 	 * -n: use NOSUBDIR flag on env_open
 	 * -p: use printable characters
 	 * -f: write to file instead of stdout
+	 * -j: dump subDBs in parallel, each to its own file
 	 * -V: print version and exit
 	 * (default) dump only the main DB
 	 */
-	while ((i = getopt(argc, argv, "af:lnps:V")) != EOF) {
+	while ((i = getopt(argc, argv, "af:j:lnps:V")) != EOF) {
 		switch(i) {
 		case 'V':
 			printf("%s\n", MDB_VERSION_STRING);
@@ -199,11 +460,12 @@ int main(int argc, char *argv[])
 			alldbs++;
 			break;
 		case 'f':
-			if (freopen(optarg, "w", stdout) == NULL) {
-				fprintf(stderr, "%s: %s: reopen: %s\n",
-					prog, optarg, strerror(errno));
-				exit(EXIT_FAILURE);
-			}
+			outname = optarg;
+			break;
+		case 'j':
+			nthreads = atoi(optarg);
+			if (nthreads < 1)
+				usage(prog);
 			break;
 		case 'n':
 			envflags |= MDB_NOSUBDIR;
@@ -224,6 +486,24 @@ int main(int argc, char *argv[])
 	if (optind != argc - 1)
 		usage(prog);
 
+	if (nthreads > 1 && !list) {
+#ifdef _WIN32
+		fprintf(stderr, "%s: -j is not supported on this platform\n", prog);
+		exit(EXIT_FAILURE);
+#else
+		/* each subDB gets its own file, named after outname */
+		if (!alldbs || !outname)
+			usage(prog);
+#endif
+	} else {
+		nthreads = 1;
+		if (outname && freopen(outname, "w", stdout) == NULL) {
+			fprintf(stderr, "%s: %s: reopen: %s\n",
+				prog, outname, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+
 #ifdef SIGPIPE
 	signal(SIGPIPE, dumpsig);
 #endif
@@ -240,7 +520,9 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	if (alldbs || subname) {
+	if (nthreads > 1) {
+		mdb_env_set_maxdbs(env, MAXDBS_PARALLEL);
+	} else if (alldbs || subname) {
 		mdb_env_set_maxdbs(env, 2);
 	}
 
@@ -250,6 +532,20 @@ int main(int argc, char *argv[])
 		goto env_close;
 	}
 
+#ifndef _WIN32
+	if (nthreads > 1) {
+		int count;
+		rc = dumppar(env, outname, nthreads, &count);
+		if (!rc && !count) {
+			fprintf(stderr, "%s: %s does not contain multiple databases\n", prog, envname);
+			rc = MDB_NOTFOUND;
+		} else if (rc) {
+			fprintf(stderr, "%s: %s: %s\n", prog, envname, mdb_strerror(rc));
+		}
+		goto env_close;
+	}
+#endif
+
 	rc = mdb_txn_begin(env, NULL, MDB_RDONLY, &txn);
 	if (rc) {
 		fprintf(stderr, "mdb_txn_begin failed, error %d %s\n", rc, mdb_strerror(rc));
@@ -287,7 +583,7 @@ int main(int argc, char *argv[])
 					printf("%s\n", str);
 					list++;
 				} else {
-					rc = dumpit(txn, db2, str);
+					rc = dumpit(stdout, txn, db2, str);
 					if (rc)
 						break;
 				}
@@ -304,7 +600,7 @@ int main(int argc, char *argv[])
 			rc = MDB_SUCCESS;
 		}
 	} else {
-		rc = dumpit(txn, dbi, subname);
+		rc = dumpit(stdout, txn, dbi, subname);
 	}
 	if (rc && rc != MDB_NOTFOUND)
 		fprintf(stderr, "%s: %s: %s\n", prog, envname, mdb_strerror(rc));
@@ -17,6 +17,9 @@
 #include <string.h>
 #include <ctype.h>
 #include <unistd.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 #include "lmdb.h"
 
 #define PRINT	1
@@ -25,19 +28,35 @@ static int mode;
 
 static char *subname = NULL;
 
-static size_t lineno;
-static int version;
-
-static int flags;
-
 static char *prog;
 
-static int Eof;
-
 static MDB_envinfo info;
 
-static MDB_val kbuf, dbuf;
-static MDB_val k0buf;
+/* Per-input state, so that several inputs can be loaded concurrently */
+typedef struct loadctx {
+	FILE *in;
+	char *label;		/* name used in diagnostics */
+	char *subname;
+	size_t lineno;
+	int version;
+	int flags;
+	int mode;
+	int Eof;
+	MDB_val kbuf, dbuf;
+	MDB_envinfo info;
+	unsigned int psize;	/* db_pagesize from the header */
+	MDB_val prevk;		/* last key, for MDB_APPENDDUP */
+	size_t prevksize;	/* allocated size of prevk */
+	char *batch;		/* decoded records awaiting a txn */
+	size_t bsize, blen;
+	int nrecs;
+} loadctx;
+
+/* Records decoded ahead of each write txn */
+#define BATCH_RECS	100
+
+/* max subDBs handled by a parallel load */
+#define MAXDBS_PARALLEL	1024
 
 #ifdef _WIN32
 #define Z	"I"
@@ -65,100 +84,110 @@ flagbit dbflags[] = {
 	{ 0, NULL, 0 }
 };
 
-static void readhdr(void)
+static void readhdr(loadctx *lc)
 {
 	char *ptr;
 
-	flags = 0;
-	while (fgets(dbuf.mv_data, dbuf.mv_size, stdin) != NULL) {
-		lineno++;
-		if (!strncmp(dbuf.mv_data, "VERSION=", STRLENOF("VERSION="))) {
-			version=atoi((char *)dbuf.mv_data+STRLENOF("VERSION="));
-			if (version > 3) {
+	lc->flags = 0;
+	while (fgets(lc->dbuf.mv_data, lc->dbuf.mv_size, lc->in) != NULL) {
+		lc->lineno++;
+		if (!strncmp(lc->dbuf.mv_data, "VERSION=", STRLENOF("VERSION="))) {
+			lc->version = atoi((char *)lc->dbuf.mv_data+STRLENOF("VERSION="));
+			if (lc->version > 3) {
 				fprintf(stderr, "%s: line %" Z "d: unsupported VERSION %d\n",
-					prog, lineno, version);
+					lc->label, lc->lineno, lc->version);
 				exit(EXIT_FAILURE);
 			}
-		} else if (!strncmp(dbuf.mv_data, "HEADER=END", STRLENOF("HEADER=END"))) {
+		} else if (!strncmp(lc->dbuf.mv_data, "HEADER=END", STRLENOF("HEADER=END"))) {
 			break;
-		} else if (!strncmp(dbuf.mv_data, "format=", STRLENOF("format="))) {
-			if (!strncmp((char *)dbuf.mv_data+STRLENOF("FORMAT="), "print", STRLENOF("print")))
-				mode |= PRINT;
-			else if (strncmp((char *)dbuf.mv_data+STRLENOF("FORMAT="), "bytevalue", STRLENOF("bytevalue"))) {
+		} else if (!strncmp(lc->dbuf.mv_data, "format=", STRLENOF("format="))) {
+			if (!strncmp((char *)lc->dbuf.mv_data+STRLENOF("FORMAT="), "print", STRLENOF("print")))
+				lc->mode |= PRINT;
+			else if (strncmp((char *)lc->dbuf.mv_data+STRLENOF("FORMAT="), "bytevalue", STRLENOF("bytevalue"))) {
 				fprintf(stderr, "%s: line %" Z "d: unsupported FORMAT %s\n",
-					prog, lineno, (char *)dbuf.mv_data+STRLENOF("FORMAT="));
+					lc->label, lc->lineno, (char *)lc->dbuf.mv_data+STRLENOF("FORMAT="));
 				exit(EXIT_FAILURE);
 			}
-		} else if (!strncmp(dbuf.mv_data, "database=", STRLENOF("database="))) {
-			ptr = memchr(dbuf.mv_data, '\n', dbuf.mv_size);
+		} else if (!strncmp(lc->dbuf.mv_data, "database=", STRLENOF("database="))) {
+			ptr = memchr(lc->dbuf.mv_data, '\n', lc->dbuf.mv_size);
 			if (ptr) *ptr = '\0';
-			if (subname) free(subname);
-			subname = strdup((char *)dbuf.mv_data+STRLENOF("database="));
-		} else if (!strncmp(dbuf.mv_data, "type=", STRLENOF("type="))) {
-			if (strncmp((char *)dbuf.mv_data+STRLENOF("type="), "btree", STRLENOF("btree")))  {
+			if (lc->subname) free(lc->subname);
+			lc->subname = strdup((char *)lc->dbuf.mv_data+STRLENOF("database="));
+		} else if (!strncmp(lc->dbuf.mv_data, "type=", STRLENOF("type="))) {
+			if (strncmp((char *)lc->dbuf.mv_data+STRLENOF("type="), "btree", STRLENOF("btree")))  {
 				fprintf(stderr, "%s: line %" Z "d: unsupported type %s\n",
-					prog, lineno, (char *)dbuf.mv_data+STRLENOF("type="));
+					lc->label, lc->lineno, (char *)lc->dbuf.mv_data+STRLENOF("type="));
 				exit(EXIT_FAILURE);
 			}
-		} else if (!strncmp(dbuf.mv_data, "mapaddr=", STRLENOF("mapaddr="))) {
+		} else if (!strncmp(lc->dbuf.mv_data, "mapaddr=", STRLENOF("mapaddr="))) {
 			int i;
-			ptr = memchr(dbuf.mv_data, '\n', dbuf.mv_size);
+			ptr = memchr(lc->dbuf.mv_data, '\n', lc->dbuf.mv_size);
 			if (ptr) *ptr = '\0';
-			i = sscanf((char *)dbuf.mv_data+STRLENOF("mapaddr="), "%p", &info.me_mapaddr);
+			i = sscanf((char *)lc->dbuf.mv_data+STRLENOF("mapaddr="), "%p", &lc->info.me_mapaddr);
 			if (i != 1) {
 				fprintf(stderr, "%s: line %" Z "d: invalid mapaddr %s\n",
-					prog, lineno, (char *)dbuf.mv_data+STRLENOF("mapaddr="));
+					lc->label, lc->lineno, (char *)lc->dbuf.mv_data+STRLENOF("mapaddr="));
 				exit(EXIT_FAILURE);
 			}
-		} else if (!strncmp(dbuf.mv_data, "mapsize=", STRLENOF("mapsize="))) {
+		} else if (!strncmp(lc->dbuf.mv_data, "mapsize=", STRLENOF("mapsize="))) {
 			int i;
-			ptr = memchr(dbuf.mv_data, '\n', dbuf.mv_size);
+			ptr = memchr(lc->dbuf.mv_data, '\n', lc->dbuf.mv_size);
 			if (ptr) *ptr = '\0';
-			i = sscanf((char *)dbuf.mv_data+STRLENOF("mapsize="), "%" Z "u", &info.me_mapsize);
+			i = sscanf((char *)lc->dbuf.mv_data+STRLENOF("mapsize="), "%" Z "u", &lc->info.me_mapsize);
 			if (i != 1) {
 				fprintf(stderr, "%s: line %" Z "d: invalid mapsize %s\n",
-					prog, lineno, (char *)dbuf.mv_data+STRLENOF("mapsize="));
+					lc->label, lc->lineno, (char *)lc->dbuf.mv_data+STRLENOF("mapsize="));
 				exit(EXIT_FAILURE);
 			}
-		} else if (!strncmp(dbuf.mv_data, "maxreaders=", STRLENOF("maxreaders="))) {
+		} else if (!strncmp(lc->dbuf.mv_data, "db_pagesize=", STRLENOF("db_pagesize="))) {
 			int i;
-			ptr = memchr(dbuf.mv_data, '\n', dbuf.mv_size);
+			ptr = memchr(lc->dbuf.mv_data, '\n', lc->dbuf.mv_size);
 			if (ptr) *ptr = '\0';
-			i = sscanf((char *)dbuf.mv_data+STRLENOF("maxreaders="), "%u", &info.me_maxreaders);
+			i = sscanf((char *)lc->dbuf.mv_data+STRLENOF("db_pagesize="), "%u", &lc->psize);
+			if (i != 1) {
+				fprintf(stderr, "%s: line %" Z "d: invalid db_pagesize %s\n",
+					lc->label, lc->lineno, (char *)lc->dbuf.mv_data+STRLENOF("db_pagesize="));
+				exit(EXIT_FAILURE);
+			}
+		} else if (!strncmp(lc->dbuf.mv_data, "maxreaders=", STRLENOF("maxreaders="))) {
+			int i;
+			ptr = memchr(lc->dbuf.mv_data, '\n', lc->dbuf.mv_size);
+			if (ptr) *ptr = '\0';
+			i = sscanf((char *)lc->dbuf.mv_data+STRLENOF("maxreaders="), "%u", &lc->info.me_maxreaders);
 			if (i != 1) {
 				fprintf(stderr, "%s: line %" Z "d: invalid maxreaders %s\n",
-					prog, lineno, (char *)dbuf.mv_data+STRLENOF("maxreaders="));
+					lc->label, lc->lineno, (char *)lc->dbuf.mv_data+STRLENOF("maxreaders="));
 				exit(EXIT_FAILURE);
 			}
 		} else {
 			int i;
 			for (i=0; dbflags[i].bit; i++) {
-				if (!strncmp(dbuf.mv_data, dbflags[i].name, dbflags[i].len) &&
-					((char *)dbuf.mv_data)[dbflags[i].len] == '=') {
-					flags |= dbflags[i].bit;
+				if (!strncmp(lc->dbuf.mv_data, dbflags[i].name, dbflags[i].len) &&
+					((char *)lc->dbuf.mv_data)[dbflags[i].len] == '=') {
+					lc->flags |= dbflags[i].bit;
 					break;
 				}
 			}
 			if (!dbflags[i].bit) {
-				ptr = memchr(dbuf.mv_data, '=', dbuf.mv_size);
+				ptr = memchr(lc->dbuf.mv_data, '=', lc->dbuf.mv_size);
 				if (!ptr) {
 					fprintf(stderr, "%s: line %" Z "d: unexpected format\n",
-						prog, lineno);
+						lc->label, lc->lineno);
 					exit(EXIT_FAILURE);
 				} else {
 					*ptr = '\0';
 					fprintf(stderr, "%s: line %" Z "d: unrecognized keyword ignored: %s\n",
-						prog, lineno, (char *)dbuf.mv_data);
+						lc->label, lc->lineno, (char *)lc->dbuf.mv_data);
 				}
 			}
 		}
 	}
 }
 
-static void badend(void)
+static void badend(loadctx *lc)
 {
 	fprintf(stderr, "%s: line %" Z "d: unexpected end of input\n",
-		prog, lineno);
+		lc->label, lc->lineno);
 }
 
 static int unhex(unsigned char *c2)
@@ -175,24 +204,24 @@ static int unhex(unsigned char *c2)
 	return c;
 }
 
-static int readline(MDB_val *out, MDB_val *buf)
+static int readline(loadctx *lc, MDB_val *out, MDB_val *buf)
 {
 	unsigned char *c1, *c2, *end;
 	size_t len, l2;
 	int c;
 
-	if (!(mode & NOHDR)) {
-		c = fgetc(stdin);
+	if (!(lc->mode & NOHDR)) {
+		c = fgetc(lc->in);
 		if (c == EOF) {
-			Eof = 1;
+			lc->Eof = 1;
 			return EOF;
 		}
 		if (c != ' ') {
-			lineno++;
-			if (fgets(buf->mv_data, buf->mv_size, stdin) == NULL) {
+			lc->lineno++;
+			if (fgets(buf->mv_data, buf->mv_size, lc->in) == NULL) {
 badend:
-				Eof = 1;
-				badend();
+				lc->Eof = 1;
+				badend(lc);
 				return EOF;
 			}
 			if (c == 'D' && !strncmp(buf->mv_data, "ATA=END", STRLENOF("ATA=END")))
@@ -200,11 +229,11 @@ badend:
 			goto badend;
 		}
 	}
-	if (fgets(buf->mv_data, buf->mv_size, stdin) == NULL) {
-		Eof = 1;
+	if (fgets(buf->mv_data, buf->mv_size, lc->in) == NULL) {
+		lc->Eof = 1;
 		return EOF;
 	}
-	lineno++;
+	lc->lineno++;
 
 	c1 = buf->mv_data;
 	len = strlen((char *)c1);
@@ -214,16 +243,16 @@ badend:
 	while (c1[len-1] != '\n') {
 		buf->mv_data = realloc(buf->mv_data, buf->mv_size*2);
 		if (!buf->mv_data) {
-			Eof = 1;
+			lc->Eof = 1;
 			fprintf(stderr, "%s: line %" Z "d: out of memory, line too long\n",
-				prog, lineno);
+				lc->label, lc->lineno);
 			return EOF;
 		}
 		c1 = buf->mv_data;
 		c1 += l2;
-		if (fgets((char *)c1, buf->mv_size+1, stdin) == NULL) {
-			Eof = 1;
-			badend();
+		if (fgets((char *)c1, buf->mv_size+1, lc->in) == NULL) {
+			lc->Eof = 1;
+			badend(lc);
 			return EOF;
 		}
 		buf->mv_size *= 2;
@@ -235,15 +264,15 @@ badend:
 	c1[--len] = '\0';
 	end = c1 + len;
 
-	if (mode & PRINT) {
+	if (lc->mode & PRINT) {
 		while (c2 < end) {
 			if (*c2 == '\\') {
 				if (c2[1] == '\\') {
 					*c1++ = *c2;
 				} else {
 					if (c2+3 > end || !isxdigit(c2[1]) || !isxdigit(c2[2])) {
-						Eof = 1;
-						badend();
+						lc->Eof = 1;
+						badend(lc);
 						return EOF;
 					}
 					*c1++ = unhex(++c2);
@@ -257,14 +286,14 @@ badend:
 	} else {
 		/* odd length not allowed */
 		if (len & 1) {
-			Eof = 1;
-			badend();
+			lc->Eof = 1;
+			badend(lc);
 			return EOF;
 		}
 		while (c2 < end) {
 			if (!isxdigit(*c2) || !isxdigit(c2[1])) {
-				Eof = 1;
-				badend();
+				lc->Eof = 1;
+				badend(lc);
 				return EOF;
 			}
 			*c1++ = unhex(c2);
@@ -279,7 +308,7 @@ badend:
 
 static void usage(void)
 {
-	fprintf(stderr, "usage: %s [-V] [-a] [-f input] [-n] [-s name] [-N] [-T] dbpath\n", prog);
+	fprintf(stderr, "usage: %s [-V] [-a] [-f input] [-j threads] [-n] [-s name] [-N] [-T] dbpath [input ...]\n", prog);
 	exit(EXIT_FAILURE);
 }
 
@@ -288,17 +317,267 @@ static int greater(const MDB_val *a, const MDB_val *b)
 	return 1;
 }
 
-int main(int argc, char *argv[])
+static int putflags, append, nthreads = 1;
+
+/* Decode up to BATCH_RECS records into lc->batch, so that the
+ * write txn isn't held while parsing the input.
+ */
+static int readbatch(loadctx *lc, int *done)
+{
+	MDB_val key, data;
+	size_t need;
+	char *ptr;
+
+	lc->blen = 0;
+	lc->nrecs = 0;
+	while (lc->nrecs < BATCH_RECS) {
+		if (readline(lc, &key, &lc->kbuf)) {	/* EOF */
+			*done = 1;
+			break;
+		}
+		if (readline(lc, &data, &lc->dbuf)) {
+			fprintf(stderr, "%s: line %" Z "d: failed to read key value\n",
+				lc->label, lc->lineno);
+			return EOF;
+		}
+		need = lc->blen + 2 * sizeof(size_t) + key.mv_size + data.mv_size;
+		if (need > lc->bsize) {
+			size_t bsize = lc->bsize ? lc->bsize : 65536;
+			while (bsize < need)
+				bsize *= 2;
+			ptr = realloc(lc->batch, bsize);
+			if (!ptr) {
+				fprintf(stderr, "%s: line %" Z "d: out of memory\n",
+					lc->label, lc->lineno);
+				return ENOMEM;
+			}
+			lc->batch = ptr;
+			lc->bsize = bsize;
+		}
+		ptr = lc->batch + lc->blen;
+		memcpy(ptr, &key.mv_size, sizeof(size_t));
+		ptr += sizeof(size_t);
+		memcpy(ptr, &data.mv_size, sizeof(size_t));
+		ptr += sizeof(size_t);
+		memcpy(ptr, key.mv_data, key.mv_size);
+		ptr += key.mv_size;
+		memcpy(ptr, data.mv_data, data.mv_size);
+		lc->blen = need;
+		lc->nrecs++;
+	}
+	return MDB_SUCCESS;
+}
+
+/* Load the records of one database from the input */
+static int loaddb(MDB_env *env, loadctx *lc)
 {
-	int i, rc;
-	MDB_env *env;
 	MDB_txn *txn;
 	MDB_cursor *mc;
 	MDB_dbi dbi;
-	char *envname;
-	int envflags = MDB_NOSYNC, putflags = 0;
-	int dohdr = 0, append = 0;
-	MDB_val prevk;
+	MDB_val key, data;
+	char *ptr;
+	int i, rc, appflag, opened = 0, done = 0;
+
+	lc->prevk.mv_size = 0;
+	do {
+		rc = readbatch(lc, &done);
+		if (rc)
+			return rc;
+
+		rc = mdb_txn_begin(env, NULL, 0, &txn);
+		if (rc) {
+			fprintf(stderr, "mdb_txn_begin failed, error %d %s\n", rc, mdb_strerror(rc));
+			return rc;
+		}
+
+		if (!opened) {
+			rc = mdb_open(txn, lc->subname, lc->flags|MDB_CREATE, &dbi);
+			if (rc) {
+				fprintf(stderr, "mdb_open failed, error %d %s\n", rc, mdb_strerror(rc));
+				goto txn_abort;
+			}
+			if (append) {
+				mdb_set_compare(txn, dbi, greater);
+				if (lc->flags & MDB_DUPSORT)
+					mdb_set_dupsort(txn, dbi, greater);
+			}
+			opened = 1;
+		}
+
+		rc = mdb_cursor_open(txn, dbi, &mc);
+		if (rc) {
+			fprintf(stderr, "mdb_cursor_open failed, error %d %s\n", rc, mdb_strerror(rc));
+			goto txn_abort;
+		}
+		if (append && (lc->flags & MDB_DUPSORT) && lc->prevk.mv_size) {
+			MDB_val k, d;
+			mdb_cursor_get(mc, &k, &d, MDB_LAST);
+		}
+
+		ptr = lc->batch;
+		for (i=0; i<lc->nrecs; i++) {
+			memcpy(&key.mv_size, ptr, sizeof(size_t));
+			ptr += sizeof(size_t);
+			memcpy(&data.mv_size, ptr, sizeof(size_t));
+			ptr += sizeof(size_t);
+			key.mv_data = ptr;
+			ptr += key.mv_size;
+			data.mv_data = ptr;
+			ptr += data.mv_size;
+
+			if (append) {
+				appflag = MDB_APPEND;
+				if (lc->flags & MDB_DUPSORT) {
+					if (lc->prevk.mv_size == key.mv_size && !memcmp(lc->prevk.mv_data, key.mv_data, key.mv_size))
+						appflag = MDB_CURRENT|MDB_APPENDDUP;
+					else {
+						if (key.mv_size > lc->prevksize) {
+							void *p = realloc(lc->prevk.mv_data, key.mv_size);
+							if (!p) {
+								rc = ENOMEM;
+								fprintf(stderr, "%s: out of memory\n", lc->label);
+								goto txn_abort;
+							}
+							lc->prevk.mv_data = p;
+							lc->prevksize = key.mv_size;
+						}
+						memcpy(lc->prevk.mv_data, key.mv_data, key.mv_size);
+						lc->prevk.mv_size = key.mv_size;
+					}
+				}
+			} else {
+				appflag = 0;
+			}
+			rc = mdb_cursor_put(mc, &key, &data, putflags|appflag);
+			if (rc == MDB_KEYEXIST && putflags)
+				continue;
+			if (rc) {
+				fprintf(stderr, "mdb_cursor_put failed, error %d %s\n", rc, mdb_strerror(rc));
+				goto txn_abort;
+			}
+		}
+		rc = mdb_txn_commit(txn);
+		if (rc) {
+			fprintf(stderr, "%s: line %" Z "d: txn_commit: %s\n",
+				lc->label, lc->lineno, mdb_strerror(rc));
+			return rc;
+		}
+	} while (!done);
+
+	/* Another thread may be opening DBIs concurrently, so
+	 * handles are only closed when loading single-threaded.
+	 */
+	if (nthreads == 1)
+		mdb_dbi_close(env, dbi);
+	return MDB_SUCCESS;
+
+txn_abort:
+	mdb_txn_abort(txn);
+	return rc;
+}
+
+/* Load every database in one input. The first header
+ * has already been read.
+ */
+static int loadit(MDB_env *env, loadctx *lc)
+{
+	int rc, first = 1;
+
+	while (!lc->Eof) {
+		if (!first && !(lc->mode & NOHDR)) {
+			readhdr(lc);
+			if (feof(lc->in))
+				break;
+		}
+		first = 0;
+		rc = loaddb(env, lc);
+		if (rc)
+			return rc;
+	}
+	return MDB_SUCCESS;
+}
+
+#ifndef _WIN32
+/* Parallel load: each input is loaded by one of nthreads workers.
+ * LMDB still serializes the write txns, but decoding the input
+ * overlaps with the other workers' commits.
+ */
+typedef struct loadjob {
+	MDB_env *env;
+	loadctx *lcs;
+	int nlcs;
+	int next;
+	int rc;
+	pthread_mutex_t mutex;
+} loadjob;
+
+static void *loadthread(void *arg)
+{
+	loadjob *job = arg;
+	int i, rc;
+
+	for (;;) {
+		pthread_mutex_lock(&job->mutex);
+		i = job->rc ? job->nlcs : job->next++;
+		pthread_mutex_unlock(&job->mutex);
+		if (i >= job->nlcs)
+			break;
+		rc = loadit(job->env, &job->lcs[i]);
+		if (rc) {
+			pthread_mutex_lock(&job->mutex);
+			if (!job->rc)
+				job->rc = rc;
+			pthread_mutex_unlock(&job->mutex);
+		}
+	}
+	return NULL;
+}
+
+static int loadall(MDB_env *env, loadctx *lcs, int nlcs)
+{
+	loadjob job;
+	pthread_t *tids;
+	int i, n, rc = 0;
+
+	n = nthreads < nlcs ? nthreads : nlcs;
+	tids = calloc(n, sizeof(pthread_t));
+	if (!tids)
+		return ENOMEM;
+
+	memset(&job, 0, sizeof(job));
+	job.env = env;
+	job.lcs = lcs;
+	job.nlcs = nlcs;
+	pthread_mutex_init(&job.mutex, NULL);
+
+	for (i=0; i<n; i++) {
+		rc = pthread_create(&tids[i], NULL, loadthread, &job);
+		if (rc)
+			break;
+	}
+	if (!i)
+		loadthread(&job);
+	n = i;
+	for (i=0; i<n; i++)
+		pthread_join(tids[i], NULL);
+
+	if (job.rc)
+		rc = job.rc;
+	pthread_mutex_destroy(&job.mutex);
+	free(tids);
+	return rc;
+}
+#endif /* !_WIN32 */
+
+int main(int argc, char *argv[])
+{
+	int i, rc;
+	MDB_env *env;
+	loadctx *lcs;
+	char *envname, *inname = NULL;
+	int envflags = MDB_NOSYNC;
+	int nlcs;
+	unsigned int psize = 0;
 
 	prog = argv[0];
 
@@ -308,13 +587,14 @@ int main(int argc, char *argv[])
 
 	/* -a: append records in input order
 	 * -f: load file instead of stdin
+	 * -j: load several inputs in parallel
 	 * -n: use NOSUBDIR flag on env_open
 	 * -s: load into named subDB
 	 * -N: use NOOVERWRITE on puts
 	 * -T: read plaintext
 	 * -V: print version and exit
 	 */
-	while ((i = getopt(argc, argv, "af:ns:NTV")) != EOF) {
+	while ((i = getopt(argc, argv, "af:j:ns:NTV")) != EOF) {
 		switch(i) {
 		case 'V':
 			printf("%s\n", MDB_VERSION_STRING);
@@ -324,11 +604,12 @@ int main(int argc, char *argv[])
 			append = 1;
 			break;
 		case 'f':
-			if (freopen(optarg, "r", stdin) == NULL) {
-				fprintf(stderr, "%s: %s: reopen: %s\n",
-					prog, optarg, strerror(errno));
-				exit(EXIT_FAILURE);
-			}
+			inname = optarg;
+			break;
+		case 'j':
+			nthreads = atoi(optarg);
+			if (nthreads < 1)
+				usage();
 			break;
 		case 'n':
 			envflags |= MDB_NOSUBDIR;
@@ -347,23 +628,81 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	if (optind != argc - 1)
+	if (optind >= argc)
 		usage();
 
-	dbuf.mv_size = 4096;
-	dbuf.mv_data = malloc(dbuf.mv_size);
+	envname = argv[optind++];
+	nlcs = argc - optind;
+	if (nlcs) {
+		/* Multiple inputs must each say which subDB they hold */
+		if (inname || subname || (mode & NOHDR))
+			usage();
+	} else {
+		nlcs = 1;
+	}
+#ifdef _WIN32
+	if (nthreads > 1) {
+		fprintf(stderr, "%s: -j is not supported on this platform\n", prog);
+		exit(EXIT_FAILURE);
+	}
+#else
+	if (nthreads > nlcs)
+		nthreads = nlcs;
+#endif
 
-	if (!(mode & NOHDR))
-		readhdr();
+	lcs = calloc(nlcs, sizeof(loadctx));
+	if (!lcs) {
+		fprintf(stderr, "%s: out of memory\n", prog);
+		exit(EXIT_FAILURE);
+	}
+	for (i=0; i<nlcs; i++) {
+		loadctx *lc = &lcs[i];
+		if (optind < argc) {
+			lc->label = argv[optind + i];
+			lc->in = fopen(lc->label, "r");
+		} else if (inname) {
+			lc->label = prog;
+			lc->in = freopen(inname, "r", stdin);
+		} else {
+			lc->label = prog;
+			lc->in = stdin;
+		}
+		if (lc->in == NULL) {
+			fprintf(stderr, "%s: %s: %s: %s\n", prog,
+				optind < argc ? lc->label : inname,
+				optind < argc ? "open" : "reopen", strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+		lc->mode = mode;
+		if (subname)
+			lc->subname = strdup(subname);
+		lc->dbuf.mv_size = 4096;
+		lc->dbuf.mv_data = malloc(lc->dbuf.mv_size);
+
+		if (!(mode & NOHDR))
+			readhdr(lc);
+
+		/* The env must be able to hold the largest input */
+		if (lc->info.me_mapsize > info.me_mapsize)
+			info.me_mapsize = lc->info.me_mapsize;
+		if (lc->info.me_maxreaders > info.me_maxreaders)
+			info.me_maxreaders = lc->info.me_maxreaders;
+		if (lc->info.me_mapaddr)
+			info.me_mapaddr = lc->info.me_mapaddr;
+		if (lc->psize > psize)
+			psize = lc->psize;
+	}
 
-	envname = argv[optind];
 	rc = mdb_env_create(&env);
 	if (rc) {
 		fprintf(stderr, "mdb_env_create failed, error %d %s\n", rc, mdb_strerror(rc));
 		return EXIT_FAILURE;
 	}
 
-	mdb_env_set_maxdbs(env, 2);
+	if (nthreads > 1)
+		mdb_env_set_maxdbs(env, nlcs > MAXDBS_PARALLEL ? nlcs : MAXDBS_PARALLEL);
+	else
+		mdb_env_set_maxdbs(env, 2);
 
 	if (info.me_maxreaders)
 		mdb_env_set_maxreaders(env, info.me_maxreaders);
@@ -374,123 +713,48 @@ int main(int argc, char *argv[])
 	if (info.me_mapaddr)
 		envflags |= MDB_FIXEDMAP;
 
+	/* Only matters if the env gets created, and the dumped
+	 * page size may be unsupported on this system.
+	 */
+	if (psize)
+		mdb_env_set_pagesize(env, psize);
+
 	rc = mdb_env_open(env, envname, envflags, 0664);
 	if (rc) {
 		fprintf(stderr, "mdb_env_open failed, error %d %s\n", rc, mdb_strerror(rc));
 		goto env_close;
 	}
 
-	kbuf.mv_size = mdb_env_get_maxkeysize(env) * 2 + 2;
-	kbuf.mv_data = malloc(kbuf.mv_size * 2);
-	k0buf.mv_size = kbuf.mv_size;
-	k0buf.mv_data = (char *)kbuf.mv_data + kbuf.mv_size;
-	prevk.mv_data = k0buf.mv_data;
-
-	while(!Eof) {
-		MDB_val key, data;
-		int batch = 0;
-		flags = 0;
-		int appflag;
-
-		if (!dohdr) {
-			dohdr = 1;
-		} else if (!(mode & NOHDR))
-			readhdr();
-		
-		rc = mdb_txn_begin(env, NULL, 0, &txn);
-		if (rc) {
-			fprintf(stderr, "mdb_txn_begin failed, error %d %s\n", rc, mdb_strerror(rc));
-			goto env_close;
-		}
-
-		rc = mdb_open(txn, subname, flags|MDB_CREATE, &dbi);
-		if (rc) {
-			fprintf(stderr, "mdb_open failed, error %d %s\n", rc, mdb_strerror(rc));
-			goto txn_abort;
-		}
-		prevk.mv_size = 0;
-		if (append) {
-			mdb_set_compare(txn, dbi, greater);
-			if (flags & MDB_DUPSORT)
-				mdb_set_dupsort(txn, dbi, greater);
-		}
-
-		rc = mdb_cursor_open(txn, dbi, &mc);
-		if (rc) {
-			fprintf(stderr, "mdb_cursor_open failed, error %d %s\n", rc, mdb_strerror(rc));
-			goto txn_abort;
-		}
+	for (i=0; i<nlcs; i++) {
+		lcs[i].kbuf.mv_size = mdb_env_get_maxkeysize(env) * 2 + 2;
+		lcs[i].kbuf.mv_data = malloc(lcs[i].kbuf.mv_size);
+	}
 
-		while(1) {
-			rc = readline(&key, &kbuf);
-			if (rc)  /* rc == EOF */
+#ifndef _WIN32
+	if (nthreads > 1) {
+		rc = loadall(env, lcs, nlcs);
+	} else
+#endif
+	{
+		for (i=0; i<nlcs; i++) {
+			rc = loadit(env, &lcs[i]);
+			if (rc)
 				break;
-
-			rc = readline(&data, &dbuf);
-			if (rc) {
-				fprintf(stderr, "%s: line %" Z "d: failed to read key value\n", prog, lineno);
-				goto txn_abort;
-			}
-
-			if (append) {
-				appflag = MDB_APPEND;
-				if (flags & MDB_DUPSORT) {
-					if (prevk.mv_size == key.mv_size && !memcmp(prevk.mv_data, key.mv_data, key.mv_size))
-						appflag = MDB_CURRENT|MDB_APPENDDUP;
-					else {
-						memcpy(prevk.mv_data, key.mv_data, key.mv_size);
-						prevk.mv_size = key.mv_size;
-					}
-				}
-			} else {
-				appflag = 0;
-			}
-			rc = mdb_cursor_put(mc, &key, &data, putflags|appflag);
-			if (rc == MDB_KEYEXIST && putflags)
-				continue;
-			if (rc) {
-				fprintf(stderr, "mdb_cursor_put failed, error %d %s\n", rc, mdb_strerror(rc));
-				goto txn_abort;
-			}
-			batch++;
-			if (batch == 100) {
-				rc = mdb_txn_commit(txn);
-				if (rc) {
-					fprintf(stderr, "%s: line %" Z "d: txn_commit: %s\n",
-						prog, lineno, mdb_strerror(rc));
-					goto env_close;
-				}
-				rc = mdb_txn_begin(env, NULL, 0, &txn);
-				if (rc) {
-					fprintf(stderr, "mdb_txn_begin failed, error %d %s\n", rc, mdb_strerror(rc));
-					goto env_close;
-				}
-				rc = mdb_cursor_open(txn, dbi, &mc);
-				if (rc) {
-					fprintf(stderr, "mdb_cursor_open failed, error %d %s\n", rc, mdb_strerror(rc));
-					goto txn_abort;
-				}
-				if (appflag & MDB_APPENDDUP) {
-					MDB_val k, d;
-					mdb_cursor_get(mc, &k, &d, MDB_LAST);
-				}
-				batch = 0;
-			}
-		}
-		rc = mdb_txn_commit(txn);
-		txn = NULL;
-		if (rc) {
-			fprintf(stderr, "%s: line %" Z "d: txn_commit: %s\n",
-				prog, lineno, mdb_strerror(rc));
-			goto env_close;
 		}
-		mdb_dbi_close(env, dbi);
 	}
 
-txn_abort:
-	mdb_txn_abort(txn);
 env_close:
 	mdb_env_close(env);
+	for (i=0; i<nlcs; i++) {
+		if (lcs[i].in != stdin)
+			fclose(lcs[i].in);
+		free(lcs[i].subname);
+		free(lcs[i].kbuf.mv_data);
+		free(lcs[i].dbuf.mv_data);
+		free(lcs[i].prevk.mv_data);
+		free(lcs[i].batch);
+	}
+	free(lcs);
 
 	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
 }
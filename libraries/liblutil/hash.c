@@ -76,6 +76,15 @@ lutil_HASHFinal( unsigned char *digest, lutil_HASH_CTX *ctx )
 	digest[3] = (h>>24) & 0xffU;
 }
 
+/*
+ * Return hash as an integer, e.g. to pick a hash table bucket
+ */
+ber_uint_t
+lutil_HASHValue( lutil_HASH_CTX *ctx )
+{
+	return ctx->hash;
+}
+
 #ifdef HAVE_LONG_LONG
 
 /* 64 bit Fowler/Noll/Vo-O FNV-1a hash code */
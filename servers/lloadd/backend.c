@@ -316,7 +316,7 @@ try_upstream(
             LDAP_CIRCLEQ_MAKE_TAIL( head, c, c_next );
         }
 
-        b->b_n_ops_executing++;
+        __atomic_add_fetch( &b->b_n_ops_executing, 1, __ATOMIC_RELAXED );
         if ( op->o_tag == LDAP_REQ_BIND ) {
             b->b_counters[LLOAD_STATS_OPS_BIND].lc_ops_received++;
         } else {
@@ -347,15 +347,6 @@ backend_select(
     LloadConnection *c;
 
     assert_locked( &b->b_mutex );
-    if ( b->b_max_pending && b->b_n_ops_executing >= b->b_max_pending ) {
-        Debug( LDAP_DEBUG_CONNS, "backend_select: "
-                "backend %s too busy\n",
-                b->b_uri.bv_val );
-        *res = LDAP_BUSY;
-        *message = "server busy";
-        return 1;
-    }
-
     if ( op->o_tag == LDAP_REQ_BIND
 #ifdef LDAP_API_FEATURE_VERIFY_CREDENTIALS
             && !(lload_features & LLOAD_FEATURE_VC)
@@ -366,6 +357,15 @@ backend_select(
         head = &b->b_conns;
     }
 
+    if ( b->b_max_pending && b->b_n_ops_executing >= b->b_max_pending ) {
+        Debug( LDAP_DEBUG_CONNS, "backend_select: "
+                "backend %s too busy\n",
+                b->b_uri.bv_val );
+        *res = LDAP_BUSY;
+        *message = "server busy";
+        goto busy;
+    }
+
     if ( LDAP_CIRCLEQ_EMPTY( head ) ) {
         return 0;
     }
@@ -382,6 +382,13 @@ backend_select(
         }
     }
 
+busy:
+    /* Every upstream is saturated, let backend_pool_update know */
+    if ( head == &b->b_bindconns ) {
+        b->b_bindconns_busy++;
+    } else {
+        b->b_conns_busy++;
+    }
     return 1;
 }
 
@@ -405,6 +412,34 @@ upstream_select(
     return finished;
 }
 
+static int
+backend_pool_wanted( int min, int max, int target )
+{
+    /* min == 0 means we're being torn down */
+    if ( !min || max <= min || target <= min ) {
+        return min;
+    }
+    return ( target < max ) ? target : max;
+}
+
+/*
+ * How many regular/bind connections we want to maintain right now. Unless
+ * max-numconns/max-bindconns is set, this is just numconns/bindconns.
+ */
+int
+backend_numconns( LloadBackend *b )
+{
+    return backend_pool_wanted(
+            b->b_numconns, b->b_max_numconns, b->b_conns_target );
+}
+
+int
+backend_numbindconns( LloadBackend *b )
+{
+    return backend_pool_wanted(
+            b->b_numbindconns, b->b_max_numbindconns, b->b_bindconns_target );
+}
+
 /*
  * Will schedule a connection attempt if there is a need for it. Need exclusive
  * access to backend, its b_mutex is not touched here, though.
@@ -421,12 +456,12 @@ backend_retry( LloadBackend *b )
     }
     assert_locked( &b->b_mutex );
 
-    requested = b->b_numconns;
+    requested = backend_numconns( b );
 #ifdef LDAP_API_FEATURE_VERIFY_CREDENTIALS
     if ( !(lload_features & LLOAD_FEATURE_VC) )
 #endif /* LDAP_API_FEATURE_VERIFY_CREDENTIALS */
     {
-        requested += b->b_numbindconns;
+        requested += backend_numbindconns( b );
     }
 
     if ( b->b_active + b->b_bindavail + b->b_opening >= requested ) {
@@ -699,6 +734,156 @@ backend_reset( LloadBackend *b, int gentle )
     assert_locked( &b->b_mutex );
 }
 
+/*
+ * Adaptive pool sizing, run every second for each backend.
+ *
+ * A pool grows when selections found all of its upstreams saturated or when
+ * there are more than LLOAD_POOL_HIGH operations in flight per connection
+ * (three quarters of conn-max-pending if that is set). We hold off while the
+ * average response time is over twice what we're used to, more connections
+ * won't help a server that is struggling already.
+ *
+ * To shrink, the pool has to stay under a quarter of that load, even with one
+ * connection less, for LLOAD_POOL_CALM intervals in a row. Then one
+ * connection per interval is closed, gently.
+ */
+#define LLOAD_POOL_HIGH 8
+#define LLOAD_POOL_CALM 30
+
+static long
+backend_pool_inflight( lload_c_head *head )
+{
+    LloadConnection *c;
+    long ops = 0;
+
+    /* Without the connection locks this is only an estimate, good enough */
+    LDAP_CIRCLEQ_FOREACH ( c, head, c_next ) {
+        ops += __atomic_load_n( &c->c_n_ops_executing, __ATOMIC_RELAXED );
+    }
+    return ops;
+}
+
+/*
+ * Work out the new size for one pool, returns the connection to close if it
+ * should shrink.
+ */
+static LloadConnection *
+backend_pool_adjust(
+        LloadBackend *b,
+        lload_c_head *head,
+        LloadConnection *last,
+        int current,
+        int min,
+        int max,
+        int *target,
+        int *busy,
+        int *calm,
+        int saturated )
+{
+    int size, high, busy_count = *busy;
+    long ops;
+
+    *busy = 0;
+    if ( max <= min ) {
+        return NULL;
+    }
+
+    size = backend_pool_wanted( min, max, *target );
+    high = b->b_max_conn_pending ? ( 3 * b->b_max_conn_pending + 3 ) / 4 :
+                                   LLOAD_POOL_HIGH;
+    ops = backend_pool_inflight( head );
+
+    if ( busy_count || ops > (long)high * current ) {
+        *calm = 0;
+        /* Wait until the connections we asked for last time are up */
+        if ( !saturated && current >= size && size < max ) {
+            size += ( size + 3 ) / 4;
+            *target = ( size < max ) ? size : max;
+            Debug( LDAP_DEBUG_CONNS, "backend_pool_adjust: "
+                    "growing %spool to %d connections for backend uri='%s'\n",
+                    head == &b->b_bindconns ? "bind " : "", *target,
+                    b->b_uri.bv_val );
+        }
+        return NULL;
+    }
+
+    if ( size <= min || ops * 4 >= (long)high * ( size - 1 ) ) {
+        *calm = 0;
+        return NULL;
+    }
+
+    /* Also wait for the last connection we've closed to go away */
+    if ( ++*calm < LLOAD_POOL_CALM || current > size ) {
+        return NULL;
+    }
+
+    *target = size - 1;
+    Debug( LDAP_DEBUG_CONNS, "backend_pool_adjust: "
+            "shrinking %spool to %d connections for backend uri='%s'\n",
+            head == &b->b_bindconns ? "bind " : "", *target,
+            b->b_uri.bv_val );
+    return last;
+}
+
+void
+backend_pool_update( LloadBackend *b )
+{
+    LloadConnection *c, *close[2] = { NULL, NULL };
+    uintptr_t count, diff, latency;
+    int i, gentle = 1, saturated = 0;
+    epoch_t epoch;
+
+    epoch = epoch_join();
+
+    count = __atomic_exchange_n( &b->b_pool_count, 0, __ATOMIC_RELAXED );
+    diff = __atomic_exchange_n( &b->b_pool_time, 0, __ATOMIC_RELAXED );
+
+    checked_lock( &b->b_mutex );
+    if ( count ) {
+        latency = diff / count;
+        if ( b->b_pool_latency && latency > 2 * b->b_pool_latency ) {
+            saturated = 1;
+        }
+        /* Slow to follow so that only a sustained change becomes the norm */
+        if ( b->b_pool_latency ) {
+            b->b_pool_latency = ( 7 * b->b_pool_latency + latency ) / 8;
+        } else {
+            b->b_pool_latency = latency;
+        }
+    }
+
+    close[0] = backend_pool_adjust( b, &b->b_conns, b->b_last_conn,
+            b->b_active, b->b_numconns, b->b_max_numconns,
+            &b->b_conns_target, &b->b_conns_busy, &b->b_conns_calm,
+            saturated );
+#ifdef LDAP_API_FEATURE_VERIFY_CREDENTIALS
+    if ( !(lload_features & LLOAD_FEATURE_VC) )
+#endif /* LDAP_API_FEATURE_VERIFY_CREDENTIALS */
+    {
+        close[1] = backend_pool_adjust( b, &b->b_bindconns,
+                b->b_last_bindconn, b->b_bindavail, b->b_numbindconns,
+                b->b_max_numbindconns, &b->b_bindconns_target,
+                &b->b_bindconns_busy, &b->b_bindconns_calm, saturated );
+    }
+
+    for ( i = 0; i < 2; i++ ) {
+        if ( close[i] && !acquire_ref( &close[i]->c_refcnt ) ) {
+            close[i] = NULL;
+        }
+    }
+    backend_retry( b );
+    checked_unlock( &b->b_mutex );
+
+    for ( i = 0; i < 2; i++ ) {
+        if ( (c = close[i]) ) {
+            lload_connection_close( c, &gentle );
+            RELEASE_REF( c, c_refcnt, c->c_destroy );
+        }
+    }
+
+    epoch_leave( epoch );
+}
+
 LloadBackend *
 lload_backend_new( void )
 {
@@ -26,6 +26,275 @@
 
 struct berval mech_external = BER_BVC("EXTERNAL");
 
+/*
+ * Simple binds carrying the same name and credentials that arrive close
+ * together share the result of the first one we forward (the leader), the
+ * others wait for its response instead of being forwarded on their own. A bind
+ * only joins a flight that started less than lload_bind_coalesce milliseconds
+ * ago and only if the request matches the leader's byte for byte, the request
+ * is the key so nothing else is retained. Should the leader go away without a
+ * response, its followers are rejected.
+ */
+struct LloadBindFlight {
+    LloadOperation *bf_leader;
+    struct timeval bf_start;
+    int bf_intree;
+
+    int bf_nwaiters;
+    LloadOperation **bf_waiters;
+};
+
+unsigned int lload_bind_coalesce = 0;
+
+static ldap_pvt_thread_mutex_t bind_flight_mutex;
+static TAvlnode *bind_flights;
+
+static int
+bind_flight_cmp( const void *left, const void *right )
+{
+    const LloadBindFlight *l = left, *r = right;
+
+    return ber_bvcmp( &l->bf_leader->o_request, &r->bf_leader->o_request );
+}
+
+void
+bind_flight_init( void )
+{
+    ldap_pvt_thread_mutex_init( &bind_flight_mutex );
+}
+
+/*
+ * Returns 1 if op has joined a flight and will be answered once the leader
+ * is, otherwise op is now leading a new one.
+ */
+static int
+bind_flight_join( LloadOperation *op )
+{
+    LloadBindFlight *bf, needle = { .bf_leader = op };
+    struct timeval now, window, expire;
+    int rc;
+
+    gettimeofday( &now, NULL );
+    window.tv_sec = lload_bind_coalesce / 1000;
+    window.tv_usec = ( lload_bind_coalesce % 1000 ) * 1000;
+
+    checked_lock( &bind_flight_mutex );
+    /* Pairs with operation_unlink, which always checks in after dropping the
+     * reference */
+    if ( !IS_ALIVE( op, o_refcnt ) ) {
+        checked_unlock( &bind_flight_mutex );
+        return 0;
+    }
+
+    bf = ldap_tavl_find( bind_flights, &needle, bind_flight_cmp );
+    if ( bf ) {
+        timeradd( &bf->bf_start, &window, &expire );
+        if ( timercmp( &now, &expire, < ) ) {
+            bf->bf_waiters = ch_realloc( bf->bf_waiters,
+                    ( bf->bf_nwaiters + 1 ) * sizeof(LloadOperation *) );
+            bf->bf_waiters[bf->bf_nwaiters++] = op;
+            op->o_flight = bf;
+            checked_unlock( &bind_flight_mutex );
+
+            Debug( LDAP_DEBUG_STATS, "bind_flight_join: "
+                    "connid=%lu msgid=%d waiting on bind from connid=%lu "
+                    "msgid=%d\n",
+                    op->o_client_connid, op->o_client_msgid,
+                    bf->bf_leader->o_client_connid,
+                    bf->bf_leader->o_client_msgid );
+            return 1;
+        }
+
+        /* Too old to join, it still belongs to its leader */
+        ldap_tavl_delete( &bind_flights, bf, bind_flight_cmp );
+        bf->bf_intree = 0;
+    }
+
+    bf = ch_calloc( 1, sizeof(LloadBindFlight) );
+    bf->bf_leader = op;
+    bf->bf_start = now;
+    bf->bf_intree = 1;
+
+    rc = ldap_tavl_insert(
+            &bind_flights, bf, bind_flight_cmp, ldap_avl_dup_error );
+    assert( rc == LDAP_SUCCESS );
+    op->o_flight = bf;
+    checked_unlock( &bind_flight_mutex );
+
+    return 0;
+}
+
+/*
+ * Detach op from its flight. If op is the leader, the flight is returned and
+ * the caller is responsible for its followers.
+ */
+static LloadBindFlight *
+bind_flight_detach( LloadOperation *op )
+{
+    LloadBindFlight *bf;
+    int i;
+
+    checked_lock( &bind_flight_mutex );
+    bf = op->o_flight;
+    if ( !bf ) {
+        checked_unlock( &bind_flight_mutex );
+        return NULL;
+    }
+    op->o_flight = NULL;
+
+    if ( bf->bf_leader != op ) {
+        for ( i = 0; i < bf->bf_nwaiters; i++ ) {
+            if ( bf->bf_waiters[i] == op ) {
+                bf->bf_waiters[i] = bf->bf_waiters[--bf->bf_nwaiters];
+                break;
+            }
+        }
+        checked_unlock( &bind_flight_mutex );
+        return NULL;
+    }
+
+    if ( bf->bf_intree ) {
+        ldap_tavl_delete( &bind_flights, bf, bind_flight_cmp );
+    }
+    for ( i = 0; i < bf->bf_nwaiters; i++ ) {
+        bf->bf_waiters[i]->o_flight = NULL;
+    }
+    checked_unlock( &bind_flight_mutex );
+
+    return bf;
+}
+
+static void
+bind_flight_free( LloadBindFlight *bf )
+{
+    ch_free( bf->bf_waiters );
+    ch_free( bf );
+}
+
+/*
+ * Hand a copy of the leader's response to a follower, this mirrors what
+ * handle_bind_response does for a simple bind.
+ */
+static void
+bind_flight_answer(
+        LloadOperation *op,
+        ber_int_t result,
+        struct berval *response,
+        struct berval *controls )
+{
+    LloadConnection *c;
+    LloadOperation *removed;
+    BerElement *output;
+
+    checked_lock( &op->o_link_mutex );
+    c = op->o_client;
+    checked_unlock( &op->o_link_mutex );
+    if ( !c || !IS_ALIVE( c, c_live ) ) {
+        goto done;
+    }
+
+    CONNECTION_LOCK(c);
+    removed = ldap_tavl_delete( &c->c_ops, op, operation_client_cmp );
+    if ( !removed ) {
+        /* Abandoned in the meantime */
+        CONNECTION_UNLOCK(c);
+        goto done;
+    }
+    assert( op == removed );
+    c->c_n_ops_executing--;
+
+    if ( c->c_state == LLOAD_C_BINDING ) {
+        c->c_state = LLOAD_C_READY;
+        c->c_type = LLOAD_C_OPEN;
+        if ( !BER_BVISNULL( &c->c_auth ) ) {
+            if ( result != LDAP_SUCCESS ) {
+                ber_memfree( c->c_auth.bv_val );
+                BER_BVZERO( &c->c_auth );
+            } else if ( !ber_bvstrcasecmp( &c->c_auth, &lloadd_identity ) ) {
+                c->c_type = LLOAD_C_PRIVILEGED;
+            }
+        }
+    }
+    CONNECTION_UNLOCK(c);
+
+    Debug( LDAP_DEBUG_STATS, "bind_flight_answer: "
+            "connid=%lu msgid=%d answered with coalesced result=%d\n",
+            op->o_client_connid, op->o_client_msgid, result );
+
+    checked_lock( &c->c_io_mutex );
+    output = c->c_pendingber;
+    if ( output == NULL && (output = ber_alloc()) == NULL ) {
+        checked_unlock( &c->c_io_mutex );
+        CONNECTION_LOCK_DESTROY(c);
+        goto done;
+    }
+    c->c_pendingber = output;
+
+    ber_printf( output, "t{titOtO}", LDAP_TAG_MESSAGE,
+            LDAP_TAG_MSGID, op->o_client_msgid,
+            LDAP_RES_BIND, response,
+            LDAP_TAG_CONTROLS, BER_BV_OPTIONAL( controls ) );
+    checked_unlock( &c->c_io_mutex );
+
+    connection_write_cb( -1, 0, c );
+
+done:
+    op->o_res = LLOAD_OP_COMPLETED;
+    operation_unlink( op );
+}
+
+/*
+ * The leader's response is being forwarded, pass it on to everyone waiting
+ * for it.
+ */
+void
+bind_flight_finish(
+        LloadOperation *op,
+        struct berval *response,
+        struct berval *controls )
+{
+    LloadBindFlight *bf;
+    BerElementBuffer berbuf;
+    BerElement *ber = (BerElement *)&berbuf;
+    ber_int_t result;
+    int i;
+
+    if ( !(bf = bind_flight_detach( op )) ) {
+        return;
+    }
+
+    ber_init2( ber, response, 0 );
+    if ( ber_get_enum( ber, &result ) == LBER_ERROR ) {
+        result = LDAP_OTHER;
+    }
+
+    for ( i = 0; i < bf->bf_nwaiters; i++ ) {
+        bind_flight_answer( bf->bf_waiters[i], result, response, controls );
+    }
+    bind_flight_free( bf );
+}
+
+/*
+ * Operation is going away, if it was leading a flight, nobody is going to
+ * answer the followers.
+ */
+void
+bind_flight_release( LloadOperation *op )
+{
+    LloadBindFlight *bf;
+    int i;
+
+    if ( !(bf = bind_flight_detach( op )) ) {
+        return;
+    }
+
+    for ( i = 0; i < bf->bf_nwaiters; i++ ) {
+        operation_send_reject( bf->bf_waiters[i], LDAP_UNAVAILABLE,
+                "coalesced bind request did not complete", 0 );
+    }
+    bind_flight_free( bf );
+}
+
 int
 bind_mech_external(
         LloadConnection *client,
@@ -361,6 +630,13 @@ request_bind( LloadConnection *client, LloadOperation *op )
     if ( upstream ) {
         /* No need to do anything */
     } else if ( !pin && client_restricted != LLOAD_OP_RESTRICTED_ISOLATE ) {
+        if ( lload_bind_coalesce && tag == LDAP_AUTH_SIMPLE &&
+                !(lload_features & LLOAD_FEATURE_VC) &&
+                BER_BVISNULL( &op->o_ctrls ) && !BER_BVISEMPTY( &binddn ) &&
+                !BER_BVISEMPTY( &auth ) && bind_flight_join( op ) ) {
+            /* Answered when the leader is */
+            goto done;
+        }
         upstream_select( op, &upstream, &res, &message );
     } else {
         Debug( LDAP_DEBUG_STATS, "request_bind: "
@@ -400,7 +676,7 @@ request_bind( LloadConnection *client, LloadOperation *op )
             CONNECTION_UNLOCK(upstream);
 
             checked_lock( &b->b_mutex );
-            b->b_n_ops_executing--;
+            __atomic_sub_fetch( &b->b_n_ops_executing, 1, __ATOMIC_RELAXED );
             operation_update_backend_counters( op, b );
             checked_unlock( &b->b_mutex );
         } else {
@@ -422,7 +698,7 @@ request_bind( LloadConnection *client, LloadOperation *op )
     }
 
     if ( pin ) {
-        ldap_tavl_delete( &upstream->c_ops, op, operation_upstream_cmp );
+        operation_upstream_remove( upstream, op );
         if ( tag == LDAP_AUTH_SIMPLE ) {
             pin = op->o_pin_id = 0;
         }
@@ -451,7 +727,7 @@ request_bind( LloadConnection *client, LloadOperation *op )
         CONNECTION_UNLOCK(upstream);
 
         checked_lock( &b->b_mutex );
-        b->b_n_ops_executing--;
+        __atomic_sub_fetch( &b->b_n_ops_executing, 1, __ATOMIC_RELAXED );
         checked_unlock( &b->b_mutex );
 
         assert( !IS_ALIVE( client, c_live ) );
@@ -477,8 +753,7 @@ request_bind( LloadConnection *client, LloadOperation *op )
             "added bind from client connid=%lu to upstream connid=%lu "
             "as msgid=%d\n",
             op->o_client_connid, op->o_upstream_connid, op->o_upstream_msgid );
-    if ( ldap_tavl_insert( &upstream->c_ops, op, operation_upstream_cmp,
-                 ldap_avl_dup_error ) ) {
+    if ( operation_upstream_insert( upstream, op ) ) {
         assert(0);
     }
     upstream->c_state = LLOAD_C_BINDING;
@@ -536,7 +811,7 @@ finish_sasl_bind(
     int rc;
 
     CONNECTION_ASSERT_LOCKED(upstream);
-    removed = ldap_tavl_delete( &upstream->c_ops, op, operation_upstream_cmp );
+    removed = operation_upstream_remove( upstream, op );
     if ( !removed ) {
         assert( upstream->c_state != LLOAD_C_BINDING );
         /* FIXME: has client replaced this bind since? */
@@ -572,8 +847,7 @@ finish_sasl_bind(
     op->o_ber = ber;
 
     /* Could we have been unlinked in the meantime? */
-    rc = ldap_tavl_insert(
-            &upstream->c_ops, op, operation_upstream_cmp, ldap_avl_dup_error );
+    rc = operation_upstream_insert( upstream, op );
     assert( rc == LDAP_SUCCESS );
 
     CONNECTION_UNLOCK(upstream);
@@ -667,10 +941,9 @@ handle_bind_response(
         op->o_pin_id = 0;
 
     } else if ( result == LDAP_SASL_BIND_IN_PROGRESS ) {
-        ldap_tavl_delete( &upstream->c_ops, op, operation_upstream_cmp );
+        operation_upstream_remove( upstream, op );
         op->o_upstream_msgid = 0;
-        rc = ldap_tavl_insert(
-                &upstream->c_ops, op, operation_upstream_cmp, ldap_avl_dup_error );
+        rc = operation_upstream_insert( upstream, op );
         assert( rc == LDAP_SUCCESS );
     } else {
         int sasl_finished = 0;
@@ -0,0 +1,384 @@
+/* cache.c - search response cache */
+/* $OpenLDAP$ */
+/* This work is part of OpenLDAP Software <http://www.openldap.org/>.
+ *
+ * Copyright 1998-2022 The OpenLDAP Foundation.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in the file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+
+#include "portable.h"
+
+#include <ac/string.h>
+#include <ac/time.h>
+
+#include "lutil.h"
+#include "lload.h"
+
+/*
+ * Responses to searches that match one of the configured rules are kept in
+ * memory and replayed to clients sending the exact same request under the same
+ * identity. Only requests without controls qualify and only complete,
+ * successful result sets are stored.
+ *
+ * Entries expire after the rule's TTL, every write operation we forward bumps
+ * lload_cache_generation which makes everything cached before it stale, once
+ * when forwarded and again when its result comes back. Writes that do not pass
+ * through us are only covered by the TTL.
+ *
+ * The whole cache is bounded by lload_cache_size bytes, least recently used
+ * entries are evicted first. Responses still being collected are kept
+ * separately and are bounded by the same amount in total.
+ *
+ * Entries are reference counted, the tree holds one reference and a request
+ * answered from the cache holds another while it encodes the responses, so
+ * that happens without lload_cache_mutex.
+ */
+
+struct LloadCacheEntry {
+    struct berval ce_key;
+    /* The responses as a sequence of "tO[tO]" (response and its controls) */
+    struct berval ce_data;
+    BerElement *ce_ber; /* while being collected */
+    ber_len_t ce_collected; /* what ce_ber is charged to lload_cache_collected */
+    time_t ce_expire;
+    int ce_refcnt;
+    uintptr_t ce_generation;
+
+    LDAP_TAILQ_ENTRY(LloadCacheEntry) ce_lru;
+};
+
+ber_len_t lload_cache_size = 0;
+time_t lload_cache_ttl[LDAP_SCOPE_SUBORDINATE + 1];
+
+static uintptr_t lload_cache_generation;
+
+static ldap_pvt_thread_mutex_t lload_cache_mutex;
+static TAvlnode *lload_cache_tree;
+static LDAP_TAILQ_HEAD(CacheLRU, LloadCacheEntry) lload_cache_lru =
+        LDAP_TAILQ_HEAD_INITIALIZER( lload_cache_lru );
+static ber_len_t lload_cache_used;
+static ber_len_t lload_cache_collected; /* responses not stored yet */
+
+static int
+lload_cache_cmp( const void *left, const void *right )
+{
+    const LloadCacheEntry *l = left, *r = right;
+
+    return ber_bvcmp( &l->ce_key, &r->ce_key );
+}
+
+static ber_len_t
+lload_cache_entry_size( LloadCacheEntry *ce )
+{
+    return sizeof(LloadCacheEntry) + ce->ce_key.bv_len + ce->ce_data.bv_len;
+}
+
+void
+lload_cache_entry_free( LloadCacheEntry *ce )
+{
+    if ( ce->ce_collected ) {
+        __atomic_sub_fetch(
+                &lload_cache_collected, ce->ce_collected, __ATOMIC_RELAXED );
+    }
+    if ( ce->ce_ber ) {
+        ber_free( ce->ce_ber, 1 );
+    }
+    ch_free( ce->ce_key.bv_val );
+    ch_free( ce->ce_data.bv_val );
+    ch_free( ce );
+}
+
+static void
+lload_cache_entry_release( LloadCacheEntry *ce )
+{
+    if ( !__atomic_sub_fetch( &ce->ce_refcnt, 1, __ATOMIC_ACQ_REL ) ) {
+        lload_cache_entry_free( ce );
+    }
+}
+
+static void
+lload_cache_remove( LloadCacheEntry *ce )
+{
+    LloadCacheEntry *removed;
+
+    assert_locked( &lload_cache_mutex );
+
+    removed = ldap_tavl_delete( &lload_cache_tree, ce, lload_cache_cmp );
+    assert( removed == ce );
+    LDAP_TAILQ_REMOVE( &lload_cache_lru, ce, ce_lru );
+    lload_cache_used -= lload_cache_entry_size( ce );
+
+    lload_cache_entry_release( ce );
+}
+
+/*
+ * Evict entries until we're within limit, lload_cache_size == 0 empties the
+ * cache completely.
+ */
+void
+lload_cache_trim( void )
+{
+    LloadCacheEntry *ce;
+
+    checked_lock( &lload_cache_mutex );
+    while ( lload_cache_used > lload_cache_size &&
+            ( ce = LDAP_TAILQ_LAST( &lload_cache_lru, CacheLRU ) ) ) {
+        lload_cache_remove( ce );
+    }
+    checked_unlock( &lload_cache_mutex );
+}
+
+void
+lload_cache_init( void )
+{
+    ldap_pvt_thread_mutex_init( &lload_cache_mutex );
+}
+
+void
+lload_cache_destroy( void )
+{
+    ber_len_t size = lload_cache_size;
+
+    lload_cache_size = 0;
+    lload_cache_trim();
+    lload_cache_size = size;
+
+    assert( lload_cache_tree == NULL );
+}
+
+/*
+ * A write is being forwarded or has just completed, anything cached so far
+ * might not reflect it.
+ */
+void
+lload_cache_invalidate( void )
+{
+    __atomic_add_fetch( &lload_cache_generation, 1, __ATOMIC_RELEASE );
+}
+
+static int
+lload_cache_search_scope( LloadOperation *op )
+{
+    BerElementBuffer copy_berbuf;
+    BerElement *copy = (BerElement *)&copy_berbuf;
+    struct berval base;
+    ber_int_t scope;
+
+    ber_init2( copy, &op->o_request, 0 );
+    if ( ber_skip_element( copy, &base ) == LBER_ERROR ||
+            ber_get_enum( copy, &scope ) == LBER_ERROR ||
+            scope < LDAP_SCOPE_BASE || scope > LDAP_SCOPE_SUBORDINATE ) {
+        return -1;
+    }
+    return scope;
+}
+
+/*
+ * Try to answer a search from the cache. If we can't but the request is
+ * cacheable, attach a new entry to op so the responses can be collected on
+ * their way back.
+ *
+ * Returns 1 if op has been answered and unlinked.
+ */
+int
+lload_cache_request( LloadConnection *client, LloadOperation *op )
+{
+    LloadCacheEntry *ce, needle;
+    BerElementBuffer berbuf;
+    BerElement *ber = (BerElement *)&berbuf;
+    BerElement *output;
+    struct berval key, response, controls;
+    ber_tag_t tag;
+    ber_len_t len;
+    ber_int_t msgid = op->o_client_msgid;
+    time_t ttl, now;
+    int scope;
+
+    if ( op->o_restricted != LLOAD_OP_NOT_RESTRICTED ||
+            !BER_BVISNULL( &op->o_ctrls ) ) {
+        return 0;
+    }
+
+    scope = lload_cache_search_scope( op );
+    if ( scope < 0 || !( ttl = lload_cache_ttl[scope] ) ) {
+        return 0;
+    }
+
+    /* The key is the identity followed by the request itself */
+    CONNECTION_LOCK(client);
+    key.bv_len = sizeof(ber_len_t) + client->c_auth.bv_len +
+            op->o_request.bv_len;
+    key.bv_val = ch_malloc( key.bv_len );
+    AC_MEMCPY( key.bv_val, &client->c_auth.bv_len, sizeof(ber_len_t) );
+    AC_MEMCPY( key.bv_val + sizeof(ber_len_t), client->c_auth.bv_val,
+            client->c_auth.bv_len );
+    CONNECTION_UNLOCK(client);
+    AC_MEMCPY( key.bv_val + key.bv_len - op->o_request.bv_len,
+            op->o_request.bv_val, op->o_request.bv_len );
+
+    now = slap_get_time();
+    needle.ce_key = key;
+
+    checked_lock( &lload_cache_mutex );
+    ce = ldap_tavl_find( lload_cache_tree, &needle, lload_cache_cmp );
+    if ( ce && ( ce->ce_expire <= now ||
+                 ce->ce_generation != __atomic_load_n(
+                         &lload_cache_generation, __ATOMIC_ACQUIRE ) ) ) {
+        lload_cache_remove( ce );
+        ce = NULL;
+    }
+    if ( !ce ) {
+        checked_unlock( &lload_cache_mutex );
+
+        ce = ch_calloc( 1, sizeof(LloadCacheEntry) );
+        ce->ce_key = key;
+        ce->ce_expire = now + ttl;
+        ce->ce_generation =
+                __atomic_load_n( &lload_cache_generation, __ATOMIC_ACQUIRE );
+        op->o_cache = ce;
+        return 0;
+    }
+    ch_free( key.bv_val );
+
+    LDAP_TAILQ_REMOVE( &lload_cache_lru, ce, ce_lru );
+    LDAP_TAILQ_INSERT_HEAD( &lload_cache_lru, ce, ce_lru );
+
+    /* ce_data never changes, it stays valid until we let go of it */
+    __atomic_add_fetch( &ce->ce_refcnt, 1, __ATOMIC_RELAXED );
+    checked_unlock( &lload_cache_mutex );
+
+    Debug( LDAP_DEBUG_STATS, "lload_cache_request: "
+            "connid=%lu msgid=%d answered from cache\n",
+            op->o_client_connid, msgid );
+
+    checked_lock( &client->c_io_mutex );
+    output = client->c_pendingber;
+    if ( output == NULL && (output = ber_alloc()) == NULL ) {
+        checked_unlock( &client->c_io_mutex );
+        lload_cache_entry_release( ce );
+        return 0;
+    }
+    client->c_pendingber = output;
+
+    ber_init2( ber, &ce->ce_data, 0 );
+    while ( (tag = ber_skip_element( ber, &response )) != LBER_DEFAULT ) {
+        BER_BVZERO( &controls );
+        if ( ber_peek_tag( ber, &len ) == LDAP_TAG_CONTROLS ) {
+            ber_skip_element( ber, &controls );
+        }
+
+        ber_printf( output, "t{titOtO}", LDAP_TAG_MESSAGE,
+                LDAP_TAG_MSGID, msgid,
+                tag, &response,
+                LDAP_TAG_CONTROLS, BER_BV_OPTIONAL( &controls ) );
+    }
+    checked_unlock( &client->c_io_mutex );
+    lload_cache_entry_release( ce );
+
+    connection_write_cb( -1, 0, client );
+
+    op->o_res = LLOAD_OP_COMPLETED;
+    operation_unlink( op );
+    return 1;
+}
+
+/*
+ * Record a response to an operation we're collecting a cache entry for. Once
+ * the final response is in and it's a success, the entry is stored.
+ */
+void
+lload_cache_response(
+        LloadOperation *op,
+        ber_tag_t tag,
+        struct berval *response,
+        struct berval *controls )
+{
+    LloadCacheEntry *ce = op->o_cache, *old;
+    BerElementBuffer berbuf;
+    BerElement *ber = (BerElement *)&berbuf;
+    ber_int_t result;
+    ber_len_t size;
+
+    assert( ce );
+
+    if ( !ce->ce_ber && (ce->ce_ber = ber_alloc()) == NULL ) {
+        goto drop;
+    }
+    if ( ber_printf( ce->ce_ber, "tOtO", tag, response,
+                 LDAP_TAG_CONTROLS, BER_BV_OPTIONAL( controls ) ) < 0 ) {
+        goto drop;
+    }
+
+    if ( tag != LDAP_RES_SEARCH_RESULT ) {
+        ber_len_t collected;
+
+        ber_get_option( ce->ce_ber, LBER_OPT_BYTES_TO_WRITE, &size );
+        collected = __atomic_add_fetch( &lload_cache_collected,
+                size - ce->ce_collected, __ATOMIC_RELAXED );
+        ce->ce_collected = size;
+        if ( size > lload_cache_size || collected > lload_cache_size ) {
+            goto drop;
+        }
+        return;
+    }
+
+    ber_init2( ber, response, 0 );
+    if ( ber_get_enum( ber, &result ) == LBER_ERROR ||
+            result != LDAP_SUCCESS ) {
+        goto drop;
+    }
+
+    if ( ber_flatten2( ce->ce_ber, &ce->ce_data, 1 ) ) {
+        goto drop;
+    }
+    ber_free( ce->ce_ber, 1 );
+    ce->ce_ber = NULL;
+    if ( ce->ce_collected ) {
+        __atomic_sub_fetch(
+                &lload_cache_collected, ce->ce_collected, __ATOMIC_RELAXED );
+        ce->ce_collected = 0;
+    }
+
+    size = lload_cache_entry_size( ce );
+
+    checked_lock( &lload_cache_mutex );
+    if ( size > lload_cache_size ||
+            ce->ce_generation != __atomic_load_n(
+                    &lload_cache_generation, __ATOMIC_ACQUIRE ) ) {
+        /* Too big or a write went past while we were collecting */
+        checked_unlock( &lload_cache_mutex );
+        goto drop;
+    }
+
+    /* A concurrent identical request might have beaten us to it */
+    old = ldap_tavl_find( lload_cache_tree, ce, lload_cache_cmp );
+    if ( old ) {
+        lload_cache_remove( old );
+    }
+    ldap_tavl_insert(
+            &lload_cache_tree, ce, lload_cache_cmp, ldap_avl_dup_error );
+    LDAP_TAILQ_INSERT_HEAD( &lload_cache_lru, ce, ce_lru );
+    ce->ce_refcnt = 1;
+    lload_cache_used += size;
+    op->o_cache = NULL;
+
+    while ( lload_cache_used > lload_cache_size ) {
+        old = LDAP_TAILQ_LAST( &lload_cache_lru, CacheLRU );
+        assert( old != ce );
+        lload_cache_remove( old );
+    }
+    checked_unlock( &lload_cache_mutex );
+    return;
+
+drop:
+    op->o_cache = NULL;
+    lload_cache_entry_free( ce );
+}
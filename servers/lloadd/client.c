@@ -177,6 +177,16 @@ request_process( LloadConnection *client, LloadOperation *op )
     }
     CONNECTION_UNLOCK(client);
 
+    if ( lload_cache_size ) {
+        if ( op->o_tag == LDAP_REQ_SEARCH ) {
+            if ( lload_cache_request( client, op ) ) {
+                return rc;
+            }
+        } else if ( op->o_tag != LDAP_REQ_COMPARE ) {
+            lload_cache_invalidate();
+        }
+    }
+
     if ( upstream ) {
         b = upstream->c_backend;
         checked_lock( &b->b_mutex );
@@ -214,7 +224,7 @@ request_process( LloadConnection *client, LloadOperation *op )
         CONNECTION_UNLOCK(upstream);
 
         checked_lock( &b->b_mutex );
-        b->b_n_ops_executing--;
+        __atomic_sub_fetch( &b->b_n_ops_executing, 1, __ATOMIC_RELAXED );
         checked_unlock( &b->b_mutex );
 
         assert( !IS_ALIVE( client, c_live ) );
@@ -235,7 +245,7 @@ request_process( LloadConnection *client, LloadOperation *op )
         checked_unlock( &upstream->c_io_mutex );
 
         checked_lock( &b->b_mutex );
-        b->b_n_ops_executing--;
+        __atomic_sub_fetch( &b->b_n_ops_executing, 1, __ATOMIC_RELAXED );
         operation_update_backend_counters( op, b );
         checked_unlock( &b->b_mutex );
 
@@ -256,8 +266,7 @@ request_process( LloadConnection *client, LloadOperation *op )
     }
 
     op->o_upstream_msgid = msgid = upstream->c_next_msgid++;
-    rc = ldap_tavl_insert(
-            &upstream->c_ops, op, operation_upstream_cmp, ldap_avl_dup_error );
+    rc = operation_upstream_insert( upstream, op );
 
     CONNECTION_UNLOCK(upstream);
 
@@ -432,6 +441,11 @@ handle_one_request( LloadConnection *c )
         return LDAP_SUCCESS;
     }
 
+    /* Leave a bind exchange in progress alone */
+    if ( state != LLOAD_C_BINDING && lload_ratelimit_request( c, op ) ) {
+        return LDAP_SUCCESS;
+    }
+
     return handler( c, op );
 }
 
@@ -459,7 +473,7 @@ client_tls_handshake_cb( evutil_socket_t s, short what, void *arg )
      * permitted to Abandon a StartTLS exop per RFC4511 anyway.
      */
     checked_lock( &c->c_io_mutex );
-    if ( c->c_pendingber ) {
+    if ( c->c_pendingber || c->c_forwardber ) {
         checked_unlock( &c->c_io_mutex );
         connection_write_cb( s, what, arg );
 
@@ -470,7 +484,7 @@ client_tls_handshake_cb( evutil_socket_t s, short what, void *arg )
         /* Do we still have data pending? If so, connection_write_cb would
          * already have arranged the write callback to trigger again */
         checked_lock( &c->c_io_mutex );
-        if ( c->c_pendingber ) {
+        if ( c->c_pendingber || c->c_forwardber ) {
             checked_unlock( &c->c_io_mutex );
             return;
         }
@@ -539,6 +553,7 @@ LloadConnection *
 client_init(
         ber_socket_t s,
         const char *peername,
+        struct berval *listener,
         struct event_base *base,
         int flags )
 {
@@ -557,6 +572,7 @@ client_init(
     }
 
     c->c_state = LLOAD_C_READY;
+    ber_dupbv( &c->c_listener_uri, listener );
 
     if ( flags & CONN_IS_TLS ) {
 #ifdef HAVE_TLS
@@ -118,6 +118,8 @@ static ConfigDriver config_tier;
 static ConfigDriver config_backend;
 static ConfigDriver config_bindconf;
 static ConfigDriver config_restrict_oid;
+static ConfigDriver config_cache_rule;
+static ConfigDriver config_ratelimit;
 #ifdef LDAP_TCP_BUFFER
 static ConfigDriver config_tcp_buffer;
 #endif /* LDAP_TCP_BUFFER */
@@ -180,6 +182,13 @@ enum {
     CFG_RESTRICT_CONTROL,
     CFG_TIER,
     CFG_WEIGHT,
+    CFG_CACHE_SIZE,
+    CFG_CACHE_RULE,
+    CFG_ACCEPTTHREADS,
+    CFG_MAX_NUMCONNS,
+    CFG_MAX_BINDCONNS,
+    CFG_BIND_COALESCE,
+    CFG_RATELIMIT,
 
     CFG_LAST
 };
@@ -193,6 +202,17 @@ static ConfigTable config_back_cf_table[] = {
         &config_fname,
         NULL, NULL, NULL
     },
+    { "accept-threads", "count", 2, 2, 0,
+        ARG_UINT|ARG_MAGIC|CFG_ACCEPTTHREADS,
+        &config_generic,
+        "( OLcfgBkAt:13.43 "
+            "NAME 'olcBkLloadAcceptThreads' "
+            "DESC 'Listener thread count' "
+            "EQUALITY integerMatch "
+            "SYNTAX OMsInteger "
+            "SINGLE-VALUE )",
+        NULL, NULL
+    },
     { "argsfile", "file", 2, 2, 0,
         ARG_STRING,
         &slapd_args_file,
@@ -691,6 +711,50 @@ static ConfigTable config_back_cf_table[] = {
             "SYNTAX OMsDirectoryString )",
         NULL, NULL
     },
+    { "cache_size", "bytes", 2, 2, 0,
+        ARG_BER_LEN_T|ARG_MAGIC|CFG_CACHE_SIZE,
+        &config_generic,
+        "( OLcfgBkAt:13.41 "
+            "NAME 'olcBkLloadCacheSize' "
+            "DESC 'Memory available to cache search responses' "
+            "EQUALITY integerMatch "
+            "SYNTAX OMsInteger "
+            "SINGLE-VALUE )",
+        NULL,
+        { .v_ber_t = 0 }
+    },
+    { "cache_rule", "scope> <seconds", 3, 3, 0,
+        ARG_MAGIC|CFG_CACHE_RULE,
+        &config_cache_rule,
+        "( OLcfgBkAt:13.42 "
+            "NAME 'olcBkLloadCacheRule' "
+            "DESC 'Cache searches with this scope for the given time' "
+            "EQUALITY caseIgnoreMatch "
+            "SYNTAX OMsDirectoryString )",
+        NULL, NULL
+    },
+    { "bind_coalesce", "milliseconds", 2, 2, 0,
+        ARG_UINT|ARG_MAGIC|CFG_BIND_COALESCE,
+        &config_generic,
+        "( OLcfgBkAt:13.46 "
+            "NAME 'olcBkLloadBindCoalesce' "
+            "DESC 'How long identical simple binds can wait on the first one' "
+            "EQUALITY integerMatch "
+            "SYNTAX OMsInteger "
+            "SINGLE-VALUE )",
+        NULL,
+        { .v_uint = 0 }
+    },
+    { "rate_limit", "key> <rate> <burst", 3, 4, 0,
+        ARG_MAGIC|CFG_RATELIMIT,
+        &config_ratelimit,
+        "( OLcfgBkAt:13.47 "
+            "NAME 'olcBkLloadRateLimit' "
+            "DESC 'Limit the rate of operations per client address, identity or listener' "
+            "EQUALITY caseIgnoreMatch "
+            "SYNTAX OMsDirectoryString )",
+        NULL, NULL
+    },
 
     /* cn=config only options */
 #ifdef BALANCER_MODULE
@@ -727,6 +791,28 @@ static ConfigTable config_back_cf_table[] = {
             "SINGLE-VALUE )",
         NULL, NULL
     },
+    { "", NULL, 2, 2, 0,
+        ARG_UINT|ARG_MAGIC|CFG_MAX_NUMCONNS,
+        &backend_cf_gen,
+        "( OLcfgBkAt:13.44 "
+            "NAME 'olcBkLloadMaxNumconns' "
+            "DESC 'Number of regular connections the pool may grow to' "
+            "EQUALITY integerMatch "
+            "SYNTAX OMsInteger "
+            "SINGLE-VALUE )",
+        NULL, NULL
+    },
+    { "", NULL, 2, 2, 0,
+        ARG_UINT|ARG_MAGIC|CFG_MAX_BINDCONNS,
+        &backend_cf_gen,
+        "( OLcfgBkAt:13.45 "
+            "NAME 'olcBkLloadMaxBindconns' "
+            "DESC 'Number of bind connections the pool may grow to' "
+            "EQUALITY integerMatch "
+            "SYNTAX OMsInteger "
+            "SINGLE-VALUE )",
+        NULL, NULL
+    },
     { "", NULL, 2, 2, 0,
         ARG_UINT|ARG_MAGIC|CFG_RETRY,
         &backend_cf_gen,
@@ -829,6 +915,11 @@ static ConfigOCs lloadocs[] = {
             "$ olcBkLloadWriteCoherence "
             "$ olcBkLloadRestrictExop "
             "$ olcBkLloadRestrictControl "
+            "$ olcBkLloadCacheSize "
+            "$ olcBkLloadCacheRule "
+            "$ olcBkLloadAcceptThreads "
+            "$ olcBkLloadBindCoalesce "
+            "$ olcBkLloadRateLimit "
         ") )",
         Cft_Backend, config_back_cf_table,
         NULL,
@@ -846,7 +937,9 @@ static ConfigOCs lloadocs[] = {
             "$ olcBkLloadMaxPendingOps "
             "$ olcBkLloadMaxPendingConns ) "
         "MAY ( olcBkLloadStartTLS "
-            "$ olcBkLloadWeight ) "
+            "$ olcBkLloadWeight "
+            "$ olcBkLloadMaxNumconns "
+            "$ olcBkLloadMaxBindconns ) "
         ") )",
         Cft_Misc, config_back_cf_table,
         lload_backend_ldadd,
@@ -886,6 +979,9 @@ config_generic( ConfigArgs *c )
             case CFG_IOTHREADS:
                 c->value_uint = lload_daemon_threads;
                 break;
+            case CFG_ACCEPTTHREADS:
+                c->value_uint = lload_listener_threads;
+                break;
             case CFG_LISTEN_URI: {
                 LloadListener **ll = lloadd_get_listeners();
                 struct berval bv = BER_BVNULL;
@@ -917,6 +1013,12 @@ config_generic( ConfigArgs *c )
             case CFG_CLIENT_PENDING:
                 c->value_uint = lload_client_max_pending;
                 break;
+            case CFG_CACHE_SIZE:
+                c->value_ber_t = lload_cache_size;
+                break;
+            case CFG_BIND_COALESCE:
+                c->value_uint = lload_bind_coalesce;
+                break;
             default:
                 rc = 1;
                 break;
@@ -925,8 +1027,16 @@ config_generic( ConfigArgs *c )
 
     } else if ( c->op == LDAP_MOD_DELETE ) {
         /* We only need to worry about deletions to multi-value or MAY
-         * attributes that belong to the lloadd module - we don't have any at
-         * the moment */
+         * attributes that belong to the lloadd module */
+        if ( c->type == CFG_CACHE_SIZE ) {
+            lload_cache_size = 0;
+            lload_cache_trim();
+        } else if ( c->type == CFG_BIND_COALESCE ) {
+            lload_bind_coalesce = 0;
+        } else if ( c->type == CFG_ACCEPTTHREADS && !lloadd_inited ) {
+            lload_listener_mask = 0;
+            lload_listener_threads = 1;
+        }
         return rc;
     }
 
@@ -1041,6 +1151,25 @@ config_generic( ConfigArgs *c )
             }
         } break;
 
+        case CFG_ACCEPTTHREADS: {
+            int mask = 0;
+            /* use a power of two, capped to io-threads on startup */
+            while ( c->value_uint > 1 ) {
+                c->value_uint >>= 1;
+                mask <<= 1;
+                mask |= 1;
+            }
+            if ( !lloadd_inited ) {
+                lload_listener_mask = mask;
+                lload_listener_threads = mask + 1;
+            } else {
+                snprintf( c->cr_msg, sizeof(c->cr_msg),
+                        "accept thread changes will not take effect until "
+                        "restart" );
+                Debug( LDAP_DEBUG_ANY, "%s: %s\n", c->log, c->cr_msg );
+            }
+        } break;
+
         case CFG_RESCOUNT:
             lload_conn_max_pdus_per_cycle = c->value_uint;
             break;
@@ -1063,6 +1192,13 @@ config_generic( ConfigArgs *c )
         case CFG_CLIENT_PENDING:
             lload_client_max_pending = c->value_uint;
             break;
+        case CFG_CACHE_SIZE:
+            lload_cache_size = c->value_ber_t;
+            lload_cache_trim();
+            break;
+        case CFG_BIND_COALESCE:
+            lload_bind_coalesce = c->value_uint;
+            break;
         default:
             Debug( LDAP_DEBUG_ANY, "%s: unknown CFG_TYPE %d\n",
                     c->log, c->type );
@@ -1523,6 +1659,163 @@ done:
     return rc;
 }
 
+static int
+config_cache_rule( ConfigArgs *c )
+{
+    unsigned long ttl;
+    int scope;
+
+    if ( c->op == SLAP_CONFIG_EMIT ) {
+        struct berval bv = { .bv_val = c->cr_msg };
+
+        for ( scope = LDAP_SCOPE_BASE; scope <= LDAP_SCOPE_SUBORDINATE;
+                scope++ ) {
+            if ( !lload_cache_ttl[scope] ) continue;
+
+            bv.bv_len = snprintf( bv.bv_val, sizeof(c->cr_msg), "%s %ld",
+                    ldap_pvt_scope2str( scope ),
+                    (long)lload_cache_ttl[scope] );
+            value_add_one( &c->rvalue_vals, &bv );
+        }
+        return LDAP_SUCCESS;
+
+    } else if ( c->op == LDAP_MOD_DELETE ) {
+        char *sep;
+
+        if ( !c->line ) {
+            for ( scope = LDAP_SCOPE_BASE; scope <= LDAP_SCOPE_SUBORDINATE;
+                    scope++ ) {
+                lload_cache_ttl[scope] = 0;
+            }
+            return LDAP_SUCCESS;
+        }
+
+        sep = strchr( c->line, ' ' );
+        if ( !sep ) {
+            return 1;
+        }
+        memcpy( c->cr_msg, c->line, sep - c->line );
+        c->cr_msg[sep - c->line] = '\0';
+
+        scope = ldap_pvt_str2scope( c->cr_msg );
+        if ( scope < 0 ) {
+            return 1;
+        }
+        lload_cache_ttl[scope] = 0;
+        return LDAP_SUCCESS;
+    }
+
+    scope = ldap_pvt_str2scope( c->argv[1] );
+    if ( scope < 0 ) {
+        snprintf( c->cr_msg, sizeof(c->cr_msg), "Could not parse scope %s",
+                c->argv[1] );
+        goto fail;
+    }
+
+    if ( lutil_atoulx( &ttl, c->argv[2], 0 ) != 0 || !ttl ) {
+        snprintf( c->cr_msg, sizeof(c->cr_msg), "Invalid TTL %s",
+                c->argv[2] );
+        goto fail;
+    }
+
+    if ( lload_cache_ttl[scope] ) {
+        snprintf( c->cr_msg, sizeof(c->cr_msg),
+                "Scope %s already has a rule", c->argv[1] );
+        goto fail;
+    }
+    lload_cache_ttl[scope] = ttl;
+
+    return LDAP_SUCCESS;
+
+fail:
+    Debug( LDAP_DEBUG_ANY, "%s: %s\n", c->log, c->cr_msg );
+    return 1;
+}
+
+static int
+config_ratelimit( ConfigArgs *c )
+{
+    unsigned long rate, burst;
+    int type;
+
+    if ( c->op == SLAP_CONFIG_EMIT ) {
+        struct berval bv = { .bv_val = c->cr_msg };
+
+        for ( type = 0; type < LLOAD_RATELIMIT_LAST; type++ ) {
+            if ( !lload_ratelimits[type].rl_rate ) continue;
+
+            bv.bv_len = snprintf( bv.bv_val, sizeof(c->cr_msg), "%s %lu %lu",
+                    lload_ratelimit_keys[type].word.bv_val,
+                    lload_ratelimits[type].rl_rate,
+                    lload_ratelimits[type].rl_burst );
+            value_add_one( &c->rvalue_vals, &bv );
+        }
+        return LDAP_SUCCESS;
+
+    } else if ( c->op == LDAP_MOD_DELETE ) {
+        char *sep;
+
+        if ( !c->line ) {
+            for ( type = 0; type < LLOAD_RATELIMIT_LAST; type++ ) {
+                lload_ratelimits[type].rl_rate = 0;
+                lload_ratelimit_reset( type );
+            }
+            return LDAP_SUCCESS;
+        }
+
+        sep = strchr( c->line, ' ' );
+        if ( !sep ) {
+            return 1;
+        }
+        memcpy( c->cr_msg, c->line, sep - c->line );
+        c->cr_msg[sep - c->line] = '\0';
+
+        type = verb_to_mask( c->cr_msg, lload_ratelimit_keys );
+        if ( type >= LLOAD_RATELIMIT_LAST ) {
+            return 1;
+        }
+        lload_ratelimits[type].rl_rate = 0;
+        lload_ratelimit_reset( type );
+        return LDAP_SUCCESS;
+    }
+
+    type = verb_to_mask( c->argv[1], lload_ratelimit_keys );
+    if ( type >= LLOAD_RATELIMIT_LAST ) {
+        snprintf( c->cr_msg, sizeof(c->cr_msg), "Unknown rate limit key %s",
+                c->argv[1] );
+        goto fail;
+    }
+
+    if ( lutil_atoulx( &rate, c->argv[2], 0 ) != 0 || !rate ) {
+        snprintf( c->cr_msg, sizeof(c->cr_msg), "Invalid rate %s",
+                c->argv[2] );
+        goto fail;
+    }
+
+    burst = rate;
+    if ( c->argc > 3 &&
+            ( lutil_atoulx( &burst, c->argv[3], 0 ) != 0 || !burst ) ) {
+        snprintf( c->cr_msg, sizeof(c->cr_msg), "Invalid burst %s",
+                c->argv[3] );
+        goto fail;
+    }
+
+    if ( lload_ratelimits[type].rl_rate ) {
+        snprintf( c->cr_msg, sizeof(c->cr_msg),
+                "Key %s already has a rate limit", c->argv[1] );
+        goto fail;
+    }
+    lload_ratelimit_reset( type );
+    lload_ratelimits[type].rl_burst = burst;
+    lload_ratelimits[type].rl_rate = rate;
+
+    return LDAP_SUCCESS;
+
+fail:
+    Debug( LDAP_DEBUG_ANY, "%s: %s\n", c->log, c->cr_msg );
+    return 1;
+}
+
 static int
 config_tier( ConfigArgs *c )
 {
@@ -2834,6 +3127,8 @@ static slap_cf_aux_table backendkey[] = {
 
     { BER_BVC("numconns="), offsetof(LloadBackend, b_numconns), 'i', 0, NULL },
     { BER_BVC("bindconns="), offsetof(LloadBackend, b_numbindconns), 'i', 0, NULL },
+    { BER_BVC("max-numconns="), offsetof(LloadBackend, b_max_numconns), 'i', 0, NULL },
+    { BER_BVC("max-bindconns="), offsetof(LloadBackend, b_max_numbindconns), 'i', 0, NULL },
     { BER_BVC("retry="), offsetof(LloadBackend, b_retry_timeout), 'i', 0, NULL },
 
     { BER_BVC("max-pending-ops="), offsetof(LloadBackend, b_max_pending), 'i', 0, NULL },
@@ -3676,6 +3971,12 @@ backend_cf_gen( ConfigArgs *c )
             case CFG_BINDCONNS:
                 c->value_uint = b->b_numbindconns;
                 break;
+            case CFG_MAX_NUMCONNS:
+                c->value_uint = b->b_max_numconns;
+                break;
+            case CFG_MAX_BINDCONNS:
+                c->value_uint = b->b_max_numbindconns;
+                break;
             case CFG_RETRY:
                 c->value_uint = b->b_retry_timeout;
                 break;
@@ -3704,10 +4005,22 @@ backend_cf_gen( ConfigArgs *c )
             case CFG_STARTTLS:
                 b->b_tls_conf = LLOAD_CLEARTEXT;
                 break;
+            case CFG_MAX_NUMCONNS:
+                b->b_max_numconns = 0;
+                flag = LLOAD_BACKEND_MOD_CONNS;
+                break;
+            case CFG_MAX_BINDCONNS:
+                b->b_max_numbindconns = 0;
+                flag = LLOAD_BACKEND_MOD_CONNS;
+                break;
             default:
                 break;
         }
-        return rc;
+        if ( !flag ) {
+            return rc;
+        }
+        /* Connections above the minimum might have to go */
+        goto changed;
     }
 
     switch ( c->type ) {
@@ -3741,6 +4054,14 @@ backend_cf_gen( ConfigArgs *c )
             b->b_numbindconns = c->value_uint;
             flag = LLOAD_BACKEND_MOD_CONNS;
             break;
+        case CFG_MAX_NUMCONNS:
+            b->b_max_numconns = c->value_uint;
+            flag = LLOAD_BACKEND_MOD_CONNS;
+            break;
+        case CFG_MAX_BINDCONNS:
+            b->b_max_numbindconns = c->value_uint;
+            flag = LLOAD_BACKEND_MOD_CONNS;
+            break;
         case CFG_RETRY:
             b->b_retry_timeout = c->value_uint;
             break;
@@ -3780,6 +4101,7 @@ backend_cf_gen( ConfigArgs *c )
             break;
     }
 
+changed:
     /* do not set this if it has already been set by another callback, e.g.
      * lload_backend_ldadd */
     if ( lload_change.type == LLOAD_CHANGE_UNDEFINED ) {
@@ -40,9 +40,18 @@
 
 #include "lutil.h"
 #include "lutil_ldap.h"
+#include "../../libraries/liblber/lber-int.h" /* ber_rwptr */
+
+/*
+ * PDUs smaller than this are copied into c_pendingber, bigger ones are
+ * written out of the buffer they were read into, see connection_forward_pdu
+ */
+#define LLOAD_FORWARD_COPY_MAX 16384
 
 static unsigned long conn_nextid = 0;
 
+static int connection_flush( LloadConnection *c );
+
 static void
 lload_connection_assign_nextid( LloadConnection *conn )
 {
@@ -299,7 +308,8 @@ void
 connection_write_cb( evutil_socket_t s, short what, void *arg )
 {
     LloadConnection *c = arg;
-    epoch_t epoch;
+    /* Only joined (and left) when we are a callback, see below */
+    epoch_t epoch = 0;
 
     Debug( LDAP_DEBUG_CONNS, "connection_write_cb: "
             "considering writing to%s connid=%lu what=%hd\n",
@@ -337,7 +347,7 @@ connection_write_cb( evutil_socket_t s, short what, void *arg )
             c->c_connid );
 
     /* We might have been beaten to flushing the data by another thread */
-    if ( c->c_pendingber && ber_flush( c->c_sb, c->c_pendingber, 1 ) ) {
+    if ( connection_flush( c ) ) {
         int err = sock_errno();
 
         if ( err != EWOULDBLOCK && err != EAGAIN ) {
@@ -381,6 +391,110 @@ done:
     }
 }
 
+/*
+ * Write out whatever is queued in the order it was queued. c_flushber and
+ * c_forwardber are only ever set while connection_forward_pdu has handed a PDU
+ * over, everything queued after that is in c_pendingber.
+ */
+static int
+connection_flush( LloadConnection *c )
+{
+    assert_locked( &c->c_io_mutex );
+
+    if ( c->c_flushber ) {
+        if ( ber_flush( c->c_sb, c->c_flushber, 1 ) ) {
+            return -1;
+        }
+        c->c_flushber = NULL;
+    }
+    if ( c->c_forwardber ) {
+        if ( ber_flush( c->c_sb, c->c_forwardber, 1 ) ) {
+            return -1;
+        }
+        c->c_forwardber = NULL;
+    }
+    if ( c->c_pendingber && ber_flush( c->c_sb, c->c_pendingber, 1 ) ) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Queue a PDU received on another connection to be sent to c with a new
+ * msgid. ber has just been parsed past its last len bytes (the protocol op and
+ * controls), only the envelope is encoded into c_pendingber, the rest is
+ * written straight out of ber's buffer and ber is freed once that is done.
+ *
+ * Small PDUs are cheaper to copy than to write separately, so is anything
+ * arriving while another PDU is still queued this way. If we return -1, the
+ * caller still owns ber and is expected to copy the PDU instead.
+ *
+ * Must be called with c_io_mutex held.
+ */
+int
+connection_forward_pdu(
+        LloadConnection *c,
+        BerElement *ber,
+        ber_len_t len,
+        ber_int_t msgid )
+{
+    BerElement *output;
+    unsigned char header[2 + sizeof(ber_len_t) + 2 + sizeof(ber_int_t) + 1];
+    unsigned char *ptr;
+    ber_len_t total;
+    int i, n;
+
+    assert_locked( &c->c_io_mutex );
+    assert( msgid > 0 );
+
+    if ( len <= LLOAD_FORWARD_COPY_MAX || c->c_forwardber ) {
+        return -1;
+    }
+
+    output = c->c_pendingber;
+    if ( output == NULL && (output = ber_alloc()) == NULL ) {
+        return -1;
+    }
+    c->c_pendingber = output;
+
+    /* Minimal encoding of the message ID, it is always positive */
+    for ( n = 1; n < sizeof(ber_int_t) && ( msgid >> ( 8 * n - 1 ) ); n++ )
+        /* count */;
+    total = 2 + n + len;
+
+    ptr = header;
+    *ptr++ = (unsigned char)LBER_SEQUENCE;
+    if ( total < 0x80 ) {
+        *ptr++ = (unsigned char)total;
+    } else {
+        int lenlen;
+
+        for ( lenlen = 1; lenlen < sizeof(ber_len_t) && ( total >> ( 8 * lenlen ) );
+                lenlen++ )
+            /* count */;
+        *ptr++ = 0x80 | lenlen;
+        for ( i = lenlen - 1; i >= 0; i-- ) {
+            *ptr++ = (unsigned char)( total >> ( 8 * i ) );
+        }
+    }
+    *ptr++ = (unsigned char)LDAP_TAG_MSGID;
+    *ptr++ = (unsigned char)n;
+    for ( i = n - 1; i >= 0; i-- ) {
+        *ptr++ = (unsigned char)( msgid >> ( 8 * i ) );
+    }
+
+    if ( ber_write( output, (char *)header, ptr - header, 0 ) < 0 ) {
+        return -1;
+    }
+
+    ber->ber_rwptr = ber->ber_ptr - len;
+    c->c_flushber = output;
+    c->c_forwardber = ber;
+    c->c_pendingber = NULL;
+
+    return 0;
+}
+
 void
 connection_destroy( LloadConnection *c )
 {
@@ -395,11 +509,21 @@ connection_destroy( LloadConnection *c )
     assert( c->c_state == LLOAD_C_INVALID );
 
     ber_sockbuf_free( c->c_sb );
+    ch_free( c->c_peer_name.bv_val );
+    ch_free( c->c_listener_uri.bv_val );
 
     if ( c->c_currentber ) {
         ber_free( c->c_currentber, 1 );
         c->c_currentber = NULL;
     }
+    if ( c->c_flushber ) {
+        ber_free( c->c_flushber, 1 );
+        c->c_flushber = NULL;
+    }
+    if ( c->c_forwardber ) {
+        ber_free( c->c_forwardber, 1 );
+        c->c_forwardber = NULL;
+    }
     if ( c->c_pendingber ) {
         ber_free( c->c_pendingber, 1 );
         c->c_pendingber = NULL;
@@ -632,6 +756,7 @@ lload_connection_init( ber_socket_t s, const char *peername, int flags )
     ldap_pvt_thread_mutex_init( &c->c_io_mutex );
 
     lload_connection_assign_nextid( c );
+    ber_str2bv( peername, 0, 1, &c->c_peer_name );
 
     Debug( LDAP_DEBUG_CONNS, "lload_connection_init: "
             "connection connid=%lu allocated for socket fd=%d peername=%s\n",
@@ -87,9 +87,25 @@ ldap_pvt_thread_cond_t lload_pause_cond;
 int lload_daemon_threads = 1;
 int lload_daemon_mask;
 
-struct event_base *listener_base = NULL;
+/*
+ * Accept thread i hands connections over to I/O threads whose index equals i
+ * modulo lload_listener_threads.
+ */
+int lload_listener_threads = 1;
+int lload_listener_mask;
+
+/*
+ * Only Linux spreads the connections to a port among all the sockets bound
+ * to it with SO_REUSEPORT, elsewhere one of them gets them all.
+ */
+#if defined(SO_REUSEPORT) && !defined(__FreeBSD__) && !defined(__NetBSD__) && \
+        !defined(__OpenBSD__) && !defined(__DragonFly__) && !defined(__APPLE__)
+#define LLOAD_REUSEPORT 1
+#endif
+
+static struct event_base **listener_bases = NULL;
 LloadListener **lload_listeners = NULL;
-static ldap_pvt_thread_t listener_tid, *daemon_tid;
+static ldap_pvt_thread_t *listener_tid, *daemon_tid;
 
 struct event_base *daemon_base = NULL;
 struct evdns_base *dnsbase;
@@ -362,6 +378,100 @@ errexit:
     return -1;
 }
 
+#ifdef LLOAD_REUSEPORT
+/*
+ * Bind the sockets the other accept threads will use now, bind() fails on
+ * privileged ports once we've dropped root and Linux refuses to join a
+ * SO_REUSEPORT group owned by another user. How many accept threads there
+ * will be is only known once the configuration has been read, so reserve as
+ * many as we could need, lload_listener_activate() closes the rest.
+ */
+static void
+lload_listener_reserve( LloadListener *l, struct sockaddr *sa, int addrlen )
+{
+    ber_socket_t s;
+    int tmp = 1, rc;
+    char ebuf[128];
+
+    l->sl_reserved = ch_malloc(
+            ( SLAPD_MAX_DAEMON_THREADS - 1 ) * sizeof(ber_socket_t) );
+
+    while ( l->sl_nreserved < SLAPD_MAX_DAEMON_THREADS - 1 ) {
+        s = socket( sa->sa_family, SOCK_STREAM, 0 );
+        if ( s == AC_SOCKET_INVALID ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_reserve: "
+                    "socket() failed errno=%d (%s)\n",
+                    err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+            break;
+        }
+        ber_pvt_socket_set_nonblock( s, 1 );
+
+        rc = setsockopt(
+                s, SOL_SOCKET, SO_REUSEADDR, (char *)&tmp, sizeof(tmp) );
+        if ( rc == AC_SOCKET_ERROR ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_reserve(%ld): "
+                    "setsockopt(SO_REUSEADDR) failed errno=%d (%s)\n",
+                    (long)s, err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+        }
+        rc = setsockopt(
+                s, SOL_SOCKET, SO_REUSEPORT, (char *)&tmp, sizeof(tmp) );
+        if ( rc == AC_SOCKET_ERROR ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_reserve(%ld): "
+                    "setsockopt(SO_REUSEPORT) failed errno=%d (%s)\n",
+                    (long)s, err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+            tcp_close( s );
+            break;
+        }
+#if defined(LDAP_PF_INET6) && defined(IPV6_V6ONLY)
+        if ( sa->sa_family == AF_INET6 ) {
+            rc = setsockopt( s, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&tmp,
+                    sizeof(tmp) );
+            if ( rc == AC_SOCKET_ERROR ) {
+                int err = sock_errno();
+                Debug( LDAP_DEBUG_ANY, "lload_listener_reserve(%ld): "
+                        "setsockopt(IPV6_V6ONLY) failed errno=%d (%s)\n",
+                        (long)s, err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+            }
+        }
+#endif /* LDAP_PF_INET6 && IPV6_V6ONLY */
+
+        if ( bind( s, sa, addrlen ) ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_reserve: "
+                    "bind(%ld) failed errno=%d (%s)\n",
+                    (long)s, err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+            tcp_close( s );
+            break;
+        }
+
+        l->sl_reserved[l->sl_nreserved++] = s;
+    }
+}
+
+/* Close the reserved sockets from index first onwards */
+static void
+lload_listener_release( LloadListener *l, int first )
+{
+    int i;
+
+    for ( i = first; i < l->sl_nreserved; i++ ) {
+        if ( l->sl_reserved[i] != AC_SOCKET_INVALID ) {
+            tcp_close( l->sl_reserved[i] );
+        }
+    }
+    if ( first < l->sl_nreserved ) {
+        l->sl_nreserved = first;
+    }
+    if ( !l->sl_nreserved && l->sl_reserved ) {
+        ch_free( l->sl_reserved );
+        l->sl_reserved = NULL;
+    }
+}
+#endif /* LLOAD_REUSEPORT */
+
 static int
 lload_open_listener(
         const char *url,
@@ -519,6 +629,19 @@ lload_open_listener(
                         sock_errstr( err, ebuf, sizeof(ebuf) ) );
             }
 #endif /* SO_REUSEADDR */
+#ifdef LLOAD_REUSEPORT
+            /* Has to be set before we bind() for the others to join in */
+            tmp = 1;
+            rc = setsockopt(
+                    s, SOL_SOCKET, SO_REUSEPORT, (char *)&tmp, sizeof(tmp) );
+            if ( rc == AC_SOCKET_ERROR ) {
+                int err = sock_errno();
+                Debug( LDAP_DEBUG_ANY, "lload_open_listener(%ld): "
+                        "setsockopt(SO_REUSEPORT) failed errno=%d (%s)\n",
+                        (long)l.sl_sd, err,
+                        sock_errstr( err, ebuf, sizeof(ebuf) ) );
+            }
+#endif /* LLOAD_REUSEPORT */
         }
 
         switch ( (*sal)->sa_family ) {
@@ -591,6 +714,18 @@ lload_open_listener(
             continue;
         }
 
+        l.sl_reserved = NULL;
+        l.sl_nreserved = 0;
+#ifdef LLOAD_REUSEPORT
+        if ( (*sal)->sa_family == AF_INET
+#ifdef LDAP_PF_INET6
+                || (*sal)->sa_family == AF_INET6
+#endif /* LDAP_PF_INET6 */
+        ) {
+            lload_listener_reserve( &l, *sal, addrlen );
+        }
+#endif /* LLOAD_REUSEPORT */
+
         switch ( (*sal)->sa_family ) {
 #ifdef LDAP_PF_LOCAL
             case AF_LOCAL: {
@@ -795,10 +930,13 @@ static void
 destroy_listeners( void )
 {
     LloadListener *lr, **ll = lload_listeners;
+    int i;
 
     if ( ll == NULL ) return;
 
-    ldap_pvt_thread_join( listener_tid, (void *)NULL );
+    for ( i = 0; i < lload_listener_threads; i++ ) {
+        ldap_pvt_thread_join( listener_tid[i], (void *)NULL );
+    }
 
     while ( (lr = *ll++) != NULL ) {
         if ( lr->sl_url.bv_val ) {
@@ -815,7 +953,17 @@ destroy_listeners( void )
         }
 #endif /* LDAP_PF_LOCAL */
 
-        evconnlistener_free( lr->listener );
+        if ( lr->sl_listeners ) {
+            for ( i = 0; i < lload_listener_threads; i++ ) {
+                if ( lr->sl_listeners[i] ) {
+                    evconnlistener_free( lr->sl_listeners[i] );
+                }
+            }
+            ch_free( lr->sl_listeners );
+        }
+#ifdef LLOAD_REUSEPORT
+        lload_listener_release( lr, 0 );
+#endif /* LLOAD_REUSEPORT */
 
         free( lr );
     }
@@ -823,9 +971,15 @@ destroy_listeners( void )
     free( lload_listeners );
     lload_listeners = NULL;
 
-    if ( listener_base ) {
-        event_base_free( listener_base );
+    for ( i = 0; listener_bases && i < lload_listener_threads; i++ ) {
+        if ( listener_bases[i] ) {
+            event_base_free( listener_bases[i] );
+        }
     }
+    ch_free( listener_bases );
+    listener_bases = NULL;
+    ch_free( listener_tid );
+    listener_tid = NULL;
 }
 
 static void
@@ -842,7 +996,7 @@ lload_listener(
     char peername[LDAP_IPADDRLEN];
     struct berval peerbv = BER_BVC(peername);
     int cflag;
-    int tid;
+    int tid, i;
     char ebuf[128];
 
     Debug( LDAP_DEBUG_TRACE, ">>> lload_listener(%s)\n", sl->sl_url.bv_val );
@@ -854,7 +1008,16 @@ lload_listener(
      */
     sl->sl_busy = 0;
 
-    tid = DAEMON_ID(s);
+    /* Stay within the I/O threads that belong to this accept thread, unless
+     * some accept threads have no socket for this listener */
+    if ( sl->sl_shared ) {
+        for ( i = 0; sl->sl_listeners[i] != listener; i++ )
+            /* EMPTY */;
+        assert( i < lload_listener_threads );
+        tid = ( DAEMON_ID(s) & ~lload_listener_mask ) | i;
+    } else {
+        tid = DAEMON_ID(s);
+    }
 
     Debug( LDAP_DEBUG_CONNS, "lload_listener: "
             "listen=%ld, new connection fd=%ld\n",
@@ -931,7 +1094,7 @@ lload_listener(
 #ifdef HAVE_TLS
     if ( sl->sl_is_tls ) cflag |= CONN_IS_TLS;
 #endif
-    c = client_init( s, peername, lload_daemon[tid].base, cflag );
+    c = client_init( s, peername, &sl->sl_url, lload_daemon[tid].base, cflag );
 
     if ( !c ) {
         Debug( LDAP_DEBUG_ANY, "lload_listener: "
@@ -946,7 +1109,9 @@ lload_listener(
 static void *
 lload_listener_thread( void *ctx )
 {
-    int rc = event_base_dispatch( listener_base );
+    struct event_base *base = ctx;
+    /* Not every accept thread has a listener to serve */
+    int rc = event_base_loop( base, EVLOOP_NO_EXIT_ON_EMPTY );
     Debug( LDAP_DEBUG_ANY, "lload_listener_thread: "
             "event loop finished: rc=%d\n",
             rc );
@@ -958,9 +1123,12 @@ static void
 listener_error_cb( struct evconnlistener *lev, void *arg )
 {
     LloadListener *l = arg;
-    int err = EVUTIL_SOCKET_ERROR();
+    int i, err = EVUTIL_SOCKET_ERROR();
 
-    assert( l->listener == lev );
+    for ( i = 0; i < lload_listener_threads; i++ ) {
+        if ( l->sl_listeners[i] == lev ) break;
+    }
+    assert( i < lload_listener_threads );
     if (
 #ifdef EMFILE
             err == EMFILE ||
@@ -973,7 +1141,11 @@ listener_error_cb( struct evconnlistener *lev, void *arg )
         emfile++;
         /* Stop listening until an existing session closes */
         l->sl_mute = 1;
-        evconnlistener_disable( lev );
+        for ( i = 0; i < lload_listener_threads; i++ ) {
+            if ( l->sl_listeners[i] ) {
+                evconnlistener_disable( l->sl_listeners[i] );
+            }
+        }
         ldap_pvt_thread_mutex_unlock( &lload_daemon[0].sd_mutex );
         Debug( LDAP_DEBUG_ANY, "listener_error_cb: "
                 "too many open files, cannot accept new connections on "
@@ -984,7 +1156,7 @@ listener_error_cb( struct evconnlistener *lev, void *arg )
         Debug( LDAP_DEBUG_ANY, "listener_error_cb: "
                 "received an error on a listener, shutting down: '%s'\n",
                 sock_errstr( err, ebuf, sizeof(ebuf) ) );
-        event_base_loopexit( l->base, NULL );
+        event_base_loopexit( evconnlistener_get_base( lev ), NULL );
     }
 }
 
@@ -999,8 +1171,14 @@ listeners_reactivate( void )
 
         if ( lr->sl_sd == AC_SOCKET_INVALID ) continue;
         if ( lr->sl_mute ) {
+            int j;
+
             emfile--;
-            evconnlistener_enable( lr->listener );
+            for ( j = 0; j < lload_listener_threads; j++ ) {
+                if ( lr->sl_listeners[j] ) {
+                    evconnlistener_enable( lr->sl_listeners[j] );
+                }
+            }
             lr->sl_mute = 0;
             Debug( LDAP_DEBUG_CONNS, "listeners_reactivate: "
                     "reactivated listener url=%s\n",
@@ -1015,128 +1193,198 @@ listeners_reactivate( void )
     ldap_pvt_thread_mutex_unlock( &lload_daemon[0].sd_mutex );
 }
 
-static int
-lload_listener_activate( void )
+#ifdef LDAP_TCP_BUFFER
+/* FIXME: TCP-only! */
+static void
+lload_listener_tcp_buffer( LloadListener *sl, int l, ber_socket_t sd )
 {
-    struct evconnlistener *listener;
-    int l, rc;
+    int origsize, size, realsize, rc;
+    socklen_t optlen;
     char ebuf[128];
 
-    listener_base = event_base_new();
-    if ( !listener_base ) return -1;
+    size = 0;
+    if ( sl->sl_tcp_rmem > 0 ) {
+        size = sl->sl_tcp_rmem;
+    } else if ( slapd_tcp_rmem > 0 ) {
+        size = slapd_tcp_rmem;
+    }
 
-    for ( l = 0; lload_listeners[l] != NULL; l++ ) {
-        if ( lload_listeners[l]->sl_sd == AC_SOCKET_INVALID ) continue;
+    if ( size > 0 ) {
+        optlen = sizeof(origsize);
+        rc = getsockopt( sd, SOL_SOCKET,
+                SO_RCVBUF, (void *)&origsize, &optlen );
 
-            /* FIXME: TCP-only! */
-#ifdef LDAP_TCP_BUFFER
-        if ( 1 ) {
-            int origsize, size, realsize, rc;
-            socklen_t optlen;
-
-            size = 0;
-            if ( lload_listeners[l]->sl_tcp_rmem > 0 ) {
-                size = lload_listeners[l]->sl_tcp_rmem;
-            } else if ( slapd_tcp_rmem > 0 ) {
-                size = slapd_tcp_rmem;
-            }
+        if ( rc ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_tcp_buffer: "
+                    "getsockopt(SO_RCVBUF) failed errno=%d (%s)\n",
+                    err, AC_STRERROR_R( err, ebuf, sizeof(ebuf) ) );
+        }
 
-            if ( size > 0 ) {
-                optlen = sizeof(origsize);
-                rc = getsockopt( lload_listeners[l]->sl_sd, SOL_SOCKET,
-                        SO_RCVBUF, (void *)&origsize, &optlen );
+        optlen = sizeof(size);
+        rc = setsockopt( sd, SOL_SOCKET,
+                SO_RCVBUF, (const void *)&size, optlen );
 
-                if ( rc ) {
-                    int err = sock_errno();
-                    Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
-                            "getsockopt(SO_RCVBUF) failed errno=%d (%s)\n",
-                            err, AC_STRERROR_R( err, ebuf, sizeof(ebuf) ) );
-                }
+        if ( rc ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_tcp_buffer: "
+                    "setsockopt(SO_RCVBUF) failed errno=%d (%s)\n",
+                    err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+        }
 
-                optlen = sizeof(size);
-                rc = setsockopt( lload_listeners[l]->sl_sd, SOL_SOCKET,
-                        SO_RCVBUF, (const void *)&size, optlen );
+        optlen = sizeof(realsize);
+        rc = getsockopt( sd, SOL_SOCKET,
+                SO_RCVBUF, (void *)&realsize, &optlen );
 
-                if ( rc ) {
-                    int err = sock_errno();
-                    Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
-                            "setsockopt(SO_RCVBUF) failed errno=%d (%s)\n",
-                            err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
-                }
+        if ( rc ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_tcp_buffer: "
+                    "getsockopt(SO_RCVBUF) failed errno=%d (%s)\n",
+                    err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+        }
 
-                optlen = sizeof(realsize);
-                rc = getsockopt( lload_listeners[l]->sl_sd, SOL_SOCKET,
-                        SO_RCVBUF, (void *)&realsize, &optlen );
+        Debug( LDAP_DEBUG_ANY, "lload_listener_tcp_buffer: "
+                "url=%s (#%d) RCVBUF original size=%d requested "
+                "size=%d real size=%d\n",
+                sl->sl_url.bv_val, l, origsize, size,
+                realsize );
+    }
 
-                if ( rc ) {
-                    int err = sock_errno();
-                    Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
-                            "getsockopt(SO_RCVBUF) failed errno=%d (%s)\n",
-                            err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
-                }
+    size = 0;
+    if ( sl->sl_tcp_wmem > 0 ) {
+        size = sl->sl_tcp_wmem;
+    } else if ( slapd_tcp_wmem > 0 ) {
+        size = slapd_tcp_wmem;
+    }
 
-                Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
-                        "url=%s (#%d) RCVBUF original size=%d requested "
-                        "size=%d real size=%d\n",
-                        lload_listeners[l]->sl_url.bv_val, l, origsize, size,
-                        realsize );
-            }
+    if ( size > 0 ) {
+        optlen = sizeof(origsize);
+        rc = getsockopt( sd, SOL_SOCKET,
+                SO_SNDBUF, (void *)&origsize, &optlen );
 
-            size = 0;
-            if ( lload_listeners[l]->sl_tcp_wmem > 0 ) {
-                size = lload_listeners[l]->sl_tcp_wmem;
-            } else if ( slapd_tcp_wmem > 0 ) {
-                size = slapd_tcp_wmem;
-            }
+        if ( rc ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_tcp_buffer: "
+                    "getsockopt(SO_SNDBUF) failed errno=%d (%s)\n",
+                    err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+        }
 
-            if ( size > 0 ) {
-                optlen = sizeof(origsize);
-                rc = getsockopt( lload_listeners[l]->sl_sd, SOL_SOCKET,
-                        SO_SNDBUF, (void *)&origsize, &optlen );
+        optlen = sizeof(size);
+        rc = setsockopt( sd, SOL_SOCKET,
+                SO_SNDBUF, (const void *)&size, optlen );
 
-                if ( rc ) {
-                    int err = sock_errno();
-                    Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
-                            "getsockopt(SO_SNDBUF) failed errno=%d (%s)\n",
-                            err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
-                }
+        if ( rc ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_tcp_buffer: "
+                    "setsockopt(SO_SNDBUF) failed errno=%d (%s)\n",
+                    err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+        }
 
-                optlen = sizeof(size);
-                rc = setsockopt( lload_listeners[l]->sl_sd, SOL_SOCKET,
-                        SO_SNDBUF, (const void *)&size, optlen );
+        optlen = sizeof(realsize);
+        rc = getsockopt( sd, SOL_SOCKET,
+                SO_SNDBUF, (void *)&realsize, &optlen );
 
-                if ( rc ) {
-                    int err = sock_errno();
-                    Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
-                            "setsockopt(SO_SNDBUF) failed errno=%d (%s)\n",
-                            err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
-                }
+        if ( rc ) {
+            int err = sock_errno();
+            Debug( LDAP_DEBUG_ANY, "lload_listener_tcp_buffer: "
+                    "getsockopt(SO_SNDBUF) failed errno=%d (%s)\n",
+                    err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
+        }
 
-                optlen = sizeof(realsize);
-                rc = getsockopt( lload_listeners[l]->sl_sd, SOL_SOCKET,
-                        SO_SNDBUF, (void *)&realsize, &optlen );
+        Debug( LDAP_DEBUG_ANY, "lload_listener_tcp_buffer: "
+                "url=%s (#%d) SNDBUF original size=%d requested "
+                "size=%d real size=%d\n",
+                sl->sl_url.bv_val, l, origsize, size,
+                realsize );
+    }
+}
+#endif /* LDAP_TCP_BUFFER */
 
-                if ( rc ) {
-                    int err = sock_errno();
-                    Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
-                            "getsockopt(SO_SNDBUF) failed errno=%d (%s)\n",
-                            err, sock_errstr( err, ebuf, sizeof(ebuf) ) );
-                }
+#ifdef LLOAD_REUSEPORT
+/*
+ * Give accept thread tid its own queue on sl, using a socket reserved by
+ * lload_listener_reserve(). Only TCP listeners can be shared like this, the
+ * first accept thread takes care of everything else.
+ */
+static struct evconnlistener *
+lload_listener_share( LloadListener *sl, int l, int tid )
+{
+    struct evconnlistener *listener;
+    ber_socket_t s;
+    char ebuf[128];
 
-                Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
-                        "url=%s (#%d) SNDBUF original size=%d requested "
-                        "size=%d real size=%d\n",
-                        lload_listeners[l]->sl_url.bv_val, l, origsize, size,
-                        realsize );
-            }
-        }
+    if ( tid > sl->sl_nreserved ) {
+        return NULL;
+    }
+    s = sl->sl_reserved[tid - 1];
+
+#ifdef LDAP_TCP_BUFFER
+    lload_listener_tcp_buffer( sl, l, s );
 #endif /* LDAP_TCP_BUFFER */
 
-        lload_listeners[l]->sl_busy = 1;
-        listener = evconnlistener_new( listener_base, lload_listener,
-                lload_listeners[l],
+    listener = evconnlistener_new( listener_bases[tid], lload_listener, sl,
+            LEV_OPT_THREADSAFE|LEV_OPT_DEFERRED_ACCEPT|LEV_OPT_CLOSE_ON_FREE,
+            SLAPD_LISTEN_BACKLOG, s );
+    if ( !listener ) {
+        int err = sock_errno();
+        Debug( LDAP_DEBUG_ANY, "lload_listener_share: "
+                "listen(%s) failed errno=%d (%s)\n",
+                sl->sl_url.bv_val, err,
+                sock_errstr( err, ebuf, sizeof(ebuf) ) );
+        return NULL;
+    }
+    evconnlistener_set_error_cb( listener, listener_error_cb );
+    sl->sl_reserved[tid - 1] = AC_SOCKET_INVALID;
+
+    return listener;
+}
+#endif /* LLOAD_REUSEPORT */
+
+static int
+lload_listener_activate( void )
+{
+    struct evconnlistener *listener;
+    int i, l, rc;
+    char ebuf[128];
+
+#ifndef LLOAD_REUSEPORT
+    /* No way to spread a listener across threads */
+    lload_listener_threads = 1;
+    lload_listener_mask = 0;
+#endif /* !LLOAD_REUSEPORT */
+    if ( lload_listener_threads > lload_daemon_threads ) {
+        lload_listener_threads = lload_daemon_threads;
+        lload_listener_mask = lload_daemon_mask;
+    }
+
+    listener_bases =
+            ch_calloc( lload_listener_threads, sizeof(struct event_base *) );
+    listener_tid = ch_calloc( lload_listener_threads, sizeof(ldap_pvt_thread_t) );
+    for ( i = 0; i < lload_listener_threads; i++ ) {
+        listener_bases[i] = event_base_new();
+        if ( !listener_bases[i] ) return -1;
+    }
+
+    for ( l = 0; lload_listeners[l] != NULL; l++ ) {
+        LloadListener *sl = lload_listeners[l];
+
+        sl->sl_listeners = ch_calloc(
+                lload_listener_threads, sizeof(struct evconnlistener *) );
+        if ( sl->sl_sd == AC_SOCKET_INVALID ) continue;
+
+#ifdef LDAP_TCP_BUFFER
+        lload_listener_tcp_buffer( sl, l, sl->sl_sd );
+#endif /* LDAP_TCP_BUFFER */
+
+#ifdef LLOAD_REUSEPORT
+        /* Only keep the sockets we have accept threads for */
+        lload_listener_release( sl, lload_listener_threads - 1 );
+#endif /* LLOAD_REUSEPORT */
+
+        sl->sl_busy = 1;
+        listener = evconnlistener_new( listener_bases[0], lload_listener, sl,
                 LEV_OPT_THREADSAFE|LEV_OPT_DEFERRED_ACCEPT,
-                SLAPD_LISTEN_BACKLOG, lload_listeners[l]->sl_sd );
+                SLAPD_LISTEN_BACKLOG, sl->sl_sd );
         if ( !listener ) {
             int err = sock_errno();
 
@@ -1146,8 +1394,7 @@ lload_listener_activate( void )
              * this and continue.
              */
             if ( err == EADDRINUSE ) {
-                int i;
-                struct sockaddr_in sa = lload_listeners[l]->sl_sa.sa_in_addr;
+                struct sockaddr_in sa = sl->sl_sa.sa_in_addr;
                 struct sockaddr_in6 sa6;
 
                 if ( sa.sin_family == AF_INET &&
@@ -1167,8 +1414,11 @@ lload_listener_activate( void )
                                 "Attempt to listen to 0.0.0.0 failed, "
                                 "already listening on ::, assuming IPv4 "
                                 "included\n" );
-                        lloadd_close( lload_listeners[l]->sl_sd );
-                        lload_listeners[l]->sl_sd = AC_SOCKET_INVALID;
+                        lloadd_close( sl->sl_sd );
+                        sl->sl_sd = AC_SOCKET_INVALID;
+#ifdef LLOAD_REUSEPORT
+                        lload_listener_release( sl, 0 );
+#endif /* LLOAD_REUSEPORT */
                         continue;
                     }
                 }
@@ -1176,25 +1426,37 @@ lload_listener_activate( void )
 #endif /* LDAP_PF_INET6 */
             Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
                     "listen(%s, 5) failed errno=%d (%s)\n",
-                    lload_listeners[l]->sl_url.bv_val, err,
+                    sl->sl_url.bv_val, err,
                     sock_errstr( err, ebuf, sizeof(ebuf) ) );
             return -1;
         }
 
-        lload_listeners[l]->base = listener_base;
-        lload_listeners[l]->listener = listener;
+        sl->sl_listeners[0] = listener;
         evconnlistener_set_error_cb( listener, listener_error_cb );
+
+        sl->sl_shared = 1;
+#ifdef LLOAD_REUSEPORT
+        for ( i = 1; i < lload_listener_threads; i++ ) {
+            sl->sl_listeners[i] = lload_listener_share( sl, l, i );
+            if ( !sl->sl_listeners[i] ) sl->sl_shared = 0;
+        }
+        /* The evconnlisteners own the rest now */
+        lload_listener_release( sl, 0 );
+#endif /* LLOAD_REUSEPORT */
     }
 
-    rc = ldap_pvt_thread_create(
-            &listener_tid, 0, lload_listener_thread, lload_listeners[l] );
+    for ( i = 0; i < lload_listener_threads; i++ ) {
+        rc = ldap_pvt_thread_create( &listener_tid[i], 0,
+                lload_listener_thread, listener_bases[i] );
 
-    if ( rc != 0 ) {
-        Debug( LDAP_DEBUG_ANY, "lload_listener_activate(%d): "
-                "submit failed (%d)\n",
-                lload_listeners[l]->sl_sd, rc );
+        if ( rc != 0 ) {
+            Debug( LDAP_DEBUG_ANY, "lload_listener_activate: "
+                    "accept thread #%d submit failed (%d)\n",
+                    i, rc );
+            return rc;
+        }
     }
-    return rc;
+    return 0;
 }
 
 static void *
@@ -1325,7 +1587,9 @@ lloadd_daemon( struct event_base *daemon_base )
             rc );
 
     /* shutdown */
-    event_base_loopexit( listener_base, 0 );
+    for ( i = 0; i < lload_listener_threads; i++ ) {
+        event_base_loopexit( listener_bases[i], 0 );
+    }
 
     /* wait for the listener threads to complete */
     destroy_listeners();
@@ -1361,6 +1625,9 @@ lloadd_daemon( struct event_base *daemon_base )
 
     lload_tiers_destroy();
     clients_destroy( 0 );
+    lload_cache_destroy();
+    lload_histogram_destroy();
+    lload_ratelimit_destroy();
     lload_bindconf_free( &bindconf );
     evdns_base_free( dnsbase, 0 );
 
@@ -1533,14 +1800,15 @@ lload_handle_backend_invalidation( LloadChange *change )
      *     that at some point
      */
     if ( change->flags.backend & LLOAD_BACKEND_MOD_CONNS ) {
-        int bind_requested = 0, need_close = 0, need_open = 0;
+        int requested, bind_requested = 0, need_close = 0, need_open = 0;
         LloadConnection *c;
 
         bind_requested =
 #ifdef LDAP_API_FEATURE_VERIFY_CREDENTIALS
                 (lload_features & LLOAD_FEATURE_VC) ? 0 :
 #endif /* LDAP_API_FEATURE_VERIFY_CREDENTIALS */
-                b->b_numbindconns;
+                backend_numbindconns( b );
+        requested = backend_numconns( b );
 
         if ( b->b_bindavail > bind_requested ) {
             need_close += b->b_bindavail - bind_requested;
@@ -1548,9 +1816,9 @@ lload_handle_backend_invalidation( LloadChange *change )
             need_open = 1;
         }
 
-        if ( b->b_active > b->b_numconns ) {
-            need_close += b->b_active - b->b_numconns;
-        } else if ( b->b_active < b->b_numconns ) {
+        if ( b->b_active > requested ) {
+            need_close += b->b_active - requested;
+        } else if ( b->b_active < requested ) {
             need_open = 1;
         }
 
@@ -1606,8 +1874,8 @@ lload_handle_backend_invalidation( LloadChange *change )
             assert( diff == 0 );
         }
 
-        if ( b->b_active > b->b_numconns ) {
-            int diff = b->b_active - b->b_numconns;
+        if ( b->b_active > requested ) {
+            int diff = b->b_active - requested;
 
             assert( need_close >= diff );
 
@@ -1850,7 +2118,9 @@ lload_pause_server( void )
     LloadChange ch = { .type = LLOAD_CHANGE_UNDEFINED };
     int i;
 
-    lload_pause_base( listener_base );
+    for ( i = 0; i < lload_listener_threads; i++ ) {
+        lload_pause_base( listener_bases[i] );
+    }
     lload_pause_base( daemon_base );
 
     for ( i = 0; i < lload_daemon_threads; i++ ) {
@@ -1938,11 +2208,16 @@ lloadd_get_listeners( void )
 void
 lload_suspend_listeners( void )
 {
-    int i;
+    int i, j;
     for ( i = 0; lload_listeners[i]; i++ ) {
-        lload_listeners[i]->sl_mute = 1;
-        evconnlistener_disable( lload_listeners[i]->listener );
-        listen( lload_listeners[i]->sl_sd, 0 );
+        LloadListener *sl = lload_listeners[i];
+
+        sl->sl_mute = 1;
+        for ( j = 0; j < lload_listener_threads; j++ ) {
+            if ( !sl->sl_listeners[j] ) continue;
+            evconnlistener_disable( sl->sl_listeners[j] );
+            listen( evconnlistener_get_fd( sl->sl_listeners[j] ), 0 );
+        }
     }
 }
 
@@ -1950,10 +2225,16 @@ lload_suspend_listeners( void )
 void
 lload_resume_listeners( void )
 {
-    int i;
+    int i, j;
     for ( i = 0; lload_listeners[i]; i++ ) {
-        lload_listeners[i]->sl_mute = 0;
-        listen( lload_listeners[i]->sl_sd, SLAPD_LISTEN_BACKLOG );
-        evconnlistener_enable( lload_listeners[i]->listener );
+        LloadListener *sl = lload_listeners[i];
+
+        sl->sl_mute = 0;
+        for ( j = 0; j < lload_listener_threads; j++ ) {
+            if ( !sl->sl_listeners[j] ) continue;
+            listen( evconnlistener_get_fd( sl->sl_listeners[j] ),
+                    SLAPD_LISTEN_BACKLOG );
+            evconnlistener_enable( sl->sl_listeners[j] );
+        }
     }
 }
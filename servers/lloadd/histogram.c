@@ -0,0 +1,170 @@
+/* histogram.c - operation latency histograms */
+/* $OpenLDAP$ */
+/* This work is part of OpenLDAP Software <http://www.openldap.org/>.
+ *
+ * Copyright 1998-2022 The OpenLDAP Foundation.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in the file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+
+#include "portable.h"
+
+#include <ac/time.h>
+
+#include "lload.h"
+
+/*
+ * Latencies are recorded in microseconds into log-linear buckets: values
+ * below LLOAD_HISTOGRAM_SUB get a bucket each, past that every power of two is
+ * split into LLOAD_HISTOGRAM_SUB equal buckets. Whatever a bucket reports is
+ * therefore within 1/LLOAD_HISTOGRAM_SUB of the real value no matter its
+ * magnitude, with a fixed amount of memory.
+ *
+ * Each backend keeps LLOAD_HISTOGRAM_SLOTS blocks of histograms and every
+ * thread that records samples is given one of them the first time it does, so
+ * threads don't keep bouncing the same cache lines between CPUs. Readers sum
+ * the blocks. There can be more threads than blocks (I/O threads plus the
+ * pool), those that share a block still add with relaxed atomic increments.
+ * Readers get a snapshot that might be slightly inconsistent across buckets,
+ * which is fine for statistics.
+ */
+
+static ldap_pvt_thread_key_t lload_histogram_key;
+static uintptr_t lload_histogram_next_slot;
+
+void
+lload_histogram_init( void )
+{
+    ldap_pvt_thread_key_create( &lload_histogram_key );
+}
+
+void
+lload_histogram_destroy( void )
+{
+    ldap_pvt_thread_key_destroy( lload_histogram_key );
+}
+
+/*
+ * Block of histograms the calling thread records into.
+ */
+int
+lload_histogram_slot( void )
+{
+    void *data = NULL;
+
+    ldap_pvt_thread_key_getdata( lload_histogram_key, &data );
+    if ( !data ) {
+        uintptr_t slot = __atomic_fetch_add(
+                &lload_histogram_next_slot, 1, __ATOMIC_RELAXED );
+
+        /* Stored off by one so that NULL means unassigned */
+        data = (void *)( ( slot % LLOAD_HISTOGRAM_SLOTS ) + 1 );
+        ldap_pvt_thread_key_setdata( lload_histogram_key, data );
+    }
+    return (uintptr_t)data - 1;
+}
+
+static int
+lload_histogram_bucket( uint64_t value )
+{
+    int msb;
+
+    if ( value < LLOAD_HISTOGRAM_SUB ) {
+        return value;
+    }
+    if ( value >> 32 ) {
+        return LLOAD_HISTOGRAM_BUCKETS - 1;
+    }
+
+    for ( msb = LLOAD_HISTOGRAM_SUB_BITS; value >> ( msb + 1 ); msb++ )
+        /* find the highest bit set */;
+
+    return ( ( msb - LLOAD_HISTOGRAM_SUB_BITS + 1 )
+                   << LLOAD_HISTOGRAM_SUB_BITS ) +
+            ( ( value >> ( msb - LLOAD_HISTOGRAM_SUB_BITS ) ) &
+                    ( LLOAD_HISTOGRAM_SUB - 1 ) );
+}
+
+/*
+ * Highest value that falls into bucket i.
+ */
+uint64_t
+lload_histogram_bucket_max( int i )
+{
+    int shift = ( i >> LLOAD_HISTOGRAM_SUB_BITS ) - 1;
+    uint64_t base = LLOAD_HISTOGRAM_SUB + ( i & ( LLOAD_HISTOGRAM_SUB - 1 ) );
+
+    if ( shift < 0 ) {
+        return i;
+    }
+    return ( ( base + 1 ) << shift ) - 1;
+}
+
+void
+lload_histogram_add( lload_histogram_t *h, struct timeval *since )
+{
+    struct timeval now, diff;
+
+    gettimeofday( &now, NULL );
+    if ( !timercmp( &now, since, > ) ) {
+        timerclear( &diff );
+    } else {
+        timersub( &now, since, &diff );
+    }
+
+    __atomic_add_fetch( &h->h_buckets[lload_histogram_bucket(
+                                (uint64_t)diff.tv_sec * 1000000 +
+                                diff.tv_usec )],
+            1, __ATOMIC_RELAXED );
+}
+
+/*
+ * Add src to dst, returns the number of samples in src.
+ */
+uintptr_t
+lload_histogram_merge( lload_histogram_t *dst, lload_histogram_t *src )
+{
+    uintptr_t count, total = 0;
+    int i;
+
+    for ( i = 0; i < LLOAD_HISTOGRAM_BUCKETS; i++ ) {
+        count = __atomic_load_n( &src->h_buckets[i], __ATOMIC_RELAXED );
+        dst->h_buckets[i] += count;
+        total += count;
+    }
+    return total;
+}
+
+/*
+ * Smallest bucket bound that at least a fraction p of the samples in h fit
+ * under, h holds total samples.
+ */
+uint64_t
+lload_histogram_percentile( lload_histogram_t *h, uintptr_t total, double p )
+{
+    uintptr_t rank, seen = 0;
+    int i;
+
+    rank = p * total;
+    if ( rank < p * total || !rank ) {
+        rank++;
+    }
+
+    for ( i = 0; i < LLOAD_HISTOGRAM_BUCKETS; i++ ) {
+        seen += h->h_buckets[i];
+        if ( seen >= rank ) {
+            break;
+        }
+    }
+    if ( i == LLOAD_HISTOGRAM_BUCKETS ) {
+        i--;
+    }
+    return lload_histogram_bucket_max( i );
+}
@@ -99,6 +99,11 @@ lload_global_init( void )
     ldap_pvt_thread_mutex_init( &clients_mutex );
     ldap_pvt_thread_mutex_init( &lload_pin_mutex );
 
+    lload_cache_init();
+    lload_histogram_init();
+    bind_flight_init();
+    lload_ratelimit_init();
+
     if ( lload_exop_init() ) {
         return -1;
     }
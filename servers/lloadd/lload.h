@@ -104,6 +104,8 @@ typedef struct LloadPendingConnection LloadPendingConnection;
 typedef struct LloadConnection LloadConnection;
 typedef struct LloadOperation LloadOperation;
 typedef struct LloadChange LloadChange;
+typedef struct LloadCacheEntry LloadCacheEntry;
+typedef struct LloadBindFlight LloadBindFlight;
 /* end of forward declarations */
 
 typedef LDAP_STAILQ_HEAD(TierSt, LloadTier) lload_t_head;
@@ -210,24 +212,78 @@ struct LloadPendingConnection {
     LDAP_LIST_ENTRY(LloadPendingConnection) next;
 };
 
+/*
+ * Open-addressed index of an upstream's pending operations by upstream msgid,
+ * kept next to c_ops so responses can be matched to operations in O(1).
+ */
+typedef struct LloadOpIndex {
+    LloadOperation **oi_ops;
+    unsigned int oi_size; /* power of two, 0 when not allocated */
+    unsigned int oi_count;
+} LloadOpIndex;
+
 typedef struct lload_counters_t {
     ldap_pvt_mp_t lc_ops_completed;
     ldap_pvt_mp_t lc_ops_received;
     ldap_pvt_mp_t lc_ops_forwarded;
     ldap_pvt_mp_t lc_ops_rejected;
     ldap_pvt_mp_t lc_ops_failed;
+    ldap_pvt_mp_t lc_ops_ratelimited;
 } lload_counters_t;
 
+/* What a rate limit is keyed on, see ratelimit.c */
+enum {
+    LLOAD_RATELIMIT_IP = 0,
+    LLOAD_RATELIMIT_DN,
+    LLOAD_RATELIMIT_LISTENER,
+    LLOAD_RATELIMIT_LAST
+};
+
+typedef struct lload_ratelimit_t {
+    unsigned long rl_rate; /* operations a second, 0 if not limited */
+    unsigned long rl_burst;
+} lload_ratelimit_t;
+
+/* Operation classes for latency tracking, see tier_latency.c */
+enum {
+    LLOAD_LATENCY_BIND = 0,
+    LLOAD_LATENCY_READ,
+    LLOAD_LATENCY_WRITE,
+    LLOAD_LATENCY_OTHER,
+    LLOAD_LATENCY_LAST
+};
+
 enum {
     LLOAD_STATS_OPS_BIND = 0,
     LLOAD_STATS_OPS_OTHER,
     LLOAD_STATS_OPS_LAST
 };
 
+/* Log-linear latency histogram in microseconds, see histogram.c */
+#define LLOAD_HISTOGRAM_SUB_BITS 3
+#define LLOAD_HISTOGRAM_SUB ( 1 << LLOAD_HISTOGRAM_SUB_BITS )
+/* Anything from 2^32us (over an hour) up shares the last bucket */
+#define LLOAD_HISTOGRAM_BUCKETS \
+    ( ( 32 - LLOAD_HISTOGRAM_SUB_BITS + 1 ) << LLOAD_HISTOGRAM_SUB_BITS )
+
+enum {
+    LLOAD_HISTOGRAM_TOTAL = 0, /* request received to operation completed */
+    LLOAD_HISTOGRAM_UPSTREAM, /* request forwarded to first response */
+    LLOAD_HISTOGRAM_LAST
+};
+
+typedef struct lload_histogram_t {
+    uintptr_t h_buckets[LLOAD_HISTOGRAM_BUCKETS];
+} lload_histogram_t;
+
+/* Blocks of histograms a backend keeps, threads spread over them */
+#define LLOAD_HISTOGRAM_SLOTS 8
+
 typedef struct lload_global_stats_t {
     ldap_pvt_mp_t global_incoming;
     ldap_pvt_mp_t global_outgoing;
     lload_counters_t counters[LLOAD_STATS_OPS_LAST];
+    lload_histogram_t histograms[LLOAD_STATS_OPS_LAST][LLOAD_HISTOGRAM_LAST];
 } lload_global_stats_t;
 
 typedef LloadTier *(LloadTierInit)( void );
@@ -237,6 +293,10 @@ typedef int (LloadTierCb)( LloadTier *tier );
 typedef int (LloadTierResetCb)( LloadTier *tier, int shutdown );
 typedef int (LloadTierBackendCb)( LloadTier *tier, LloadBackend *b );
 typedef void (LloadTierChange)( LloadTier *tier, LloadChange *change );
+typedef void (LloadTierObserve)( LloadTier *tier,
+        LloadBackend *b,
+        LloadOperation *op,
+        uintptr_t latency );
 typedef int (LloadTierSelect)( LloadTier *tier,
         LloadOperation *op,
         LloadConnection **cp,
@@ -260,6 +320,7 @@ struct lload_tier_type {
     LloadTierBackendCb *tier_remove_backend;
     LloadTierChange *tier_change;
 
+    LloadTierObserve *tier_observe; /* time to first response, in us */
     LloadTierSelect *tier_select;
 };
 
@@ -298,14 +359,24 @@ struct LloadBackend {
 
     int b_numconns, b_numbindconns;
     int b_bindavail, b_active, b_opening;
+
+    /* Adaptive pool sizing, see backend_pool_update() */
+    int b_max_numconns, b_max_numbindconns;
+    int b_conns_target, b_bindconns_target;
+    int b_conns_busy, b_bindconns_busy; /* selections that found no upstream */
+    int b_conns_calm, b_bindconns_calm; /* intervals we could do with less */
+    uintptr_t b_pool_count, b_pool_time, b_pool_latency; /* in us */
     lload_c_head b_conns, b_bindconns, b_preparing;
     LDAP_LIST_HEAD(ConnectingSt, LloadPendingConnection) b_connecting;
     LloadConnection *b_last_conn, *b_last_bindconn;
 
     long b_max_pending, b_max_conn_pending;
-    long b_n_ops_executing;
+    long b_n_ops_executing; /* updated atomically, under b_mutex */
 
     lload_counters_t b_counters[LLOAD_STATS_OPS_LAST];
+    /* One block per lload_histogram_slot(), summed when read */
+    lload_histogram_t b_histograms[LLOAD_HISTOGRAM_SLOTS][LLOAD_STATS_OPS_LAST]
+                                  [LLOAD_HISTOGRAM_LAST];
 
     LloadTier *b_tier;
 
@@ -316,6 +387,9 @@ struct LloadBackend {
     uintptr_t b_operation_count;
     uintptr_t b_operation_time;
 
+    uintptr_t b_latency[LLOAD_LATENCY_LAST];       /* in us */
+    uintptr_t b_latency_stamp[LLOAD_LATENCY_LAST]; /* last update, in ms */
+
 #ifdef BALANCER_MODULE
     monitor_subsys_t *b_monitor;
 #endif /* BALANCER_MODULE */
@@ -442,6 +516,7 @@ struct LloadConnection {
     /* set by connection_init */
     unsigned long c_connid;    /* unique id of this connection */
     struct berval c_peer_name; /* peer name (trans=addr:port) */
+    struct berval c_listener_uri; /* clients only: listener we were accepted on */
     time_t c_starttime;        /* when the connection was opened */
 
     time_t c_activitytime;  /* when the connection was last used */
@@ -476,8 +551,11 @@ struct LloadConnection {
 
     BerElement *c_currentber; /* ber we're attempting to read */
     BerElement *c_pendingber; /* ber we're attempting to write */
+    BerElement *c_flushber; /* what has to go out before c_forwardber */
+    BerElement *c_forwardber; /* PDU forwarded without copying */
 
     TAvlnode *c_ops; /* Operations pending on the connection */
+    LloadOpIndex c_opsidx; /* Upstream only: c_ops indexed by msgid */
 
 #ifdef HAVE_TLS
     enum lload_tls_type c_is_tls; /* true if this LDAP over raw TLS */
@@ -548,11 +626,18 @@ struct LloadOperation {
 
     ber_tag_t o_tag;
     struct timeval o_start;
+    struct timeval o_forwarded; /* last sent upstream */
     unsigned long o_pin_id;
 
     enum op_result o_res;
     BerElement *o_ber;
     BerValue o_request, o_ctrls;
+
+    /* Cache entry being collected from the responses */
+    LloadCacheEntry *o_cache;
+
+    /* Coalesced bind this operation leads or waits on, see bind.c */
+    LloadBindFlight *o_flight;
 };
 
 struct restriction_entry {
@@ -571,11 +656,15 @@ struct LloadListener {
     int sl_is_tls;
 #endif
     int sl_is_proxied;
-    struct event_base *base;
-    struct evconnlistener *listener;
+    /* One per accept thread, NULL where the thread doesn't serve this one */
+    struct evconnlistener **sl_listeners;
+    int sl_shared; /* Every accept thread has its own socket */
     int sl_mute; /* Listener is temporarily disabled due to emfile */
     int sl_busy; /* Listener is busy (accept thread activated) */
     ber_socket_t sl_sd;
+    /* Bound alongside sl_sd for the other accept threads to listen() on */
+    ber_socket_t *sl_reserved;
+    int sl_nreserved;
     Sockaddr sl_sa;
 #define sl_addr sl_sa.sa_in_addr
 #define LDAP_TCP_BUFFER
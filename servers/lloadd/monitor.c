@@ -65,9 +65,10 @@
 
 struct lload_monitor_ops_t {
     struct berval rdn;
+    char *name; /* prefix for per-backend latency values */
 } lload_monitor_op[] = {
-    { BER_BVC("cn=Bind") },
-    { BER_BVC("cn=Other") },
+    { BER_BVC("cn=Bind"), "bind" },
+    { BER_BVC("cn=Other"), "other" },
 
     { BER_BVNULL }
 };
@@ -76,6 +77,7 @@ static ObjectClass *oc_olmBalancer;
 static ObjectClass *oc_olmBalancerServer;
 static ObjectClass *oc_olmBalancerConnection;
 static ObjectClass *oc_olmBalancerOperation;
+static ObjectClass *oc_olmBalancerLatency;
 
 static ObjectClass *oc_monitorContainer;
 static ObjectClass *oc_monitorCounterObject;
@@ -84,6 +86,7 @@ static AttributeDescription *ad_olmServerURI;
 static AttributeDescription *ad_olmReceivedOps;
 static AttributeDescription *ad_olmForwardedOps;
 static AttributeDescription *ad_olmRejectedOps;
+static AttributeDescription *ad_olmRateLimitedOps;
 static AttributeDescription *ad_olmCompletedOps;
 static AttributeDescription *ad_olmFailedOps;
 static AttributeDescription *ad_olmConnectionType;
@@ -93,6 +96,12 @@ static AttributeDescription *ad_olmPendingConnections;
 static AttributeDescription *ad_olmActiveConnections;
 static AttributeDescription *ad_olmIncomingConnections;
 static AttributeDescription *ad_olmOutgoingConnections;
+static AttributeDescription *ad_olmConnectionPoolSize;
+static AttributeDescription *ad_olmBindConnectionPoolSize;
+static AttributeDescription *ad_olmOpLatency;
+static AttributeDescription *ad_olmOpLatencyBuckets;
+static AttributeDescription *ad_olmUpstreamLatency;
+static AttributeDescription *ad_olmUpstreamLatencyBuckets;
 
 monitor_subsys_t *lload_monitor_client_subsys;
 
@@ -208,6 +217,61 @@ static struct {
       "SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 "
       "USAGE dSAOperation )",
         &ad_olmConnectionState },
+    { "( olmBalancerAttributes:14 "
+      "NAME ( 'olmConnectionPoolSize' ) "
+      "DESC 'number of regular connections the pool is currently sized for' "
+      "EQUALITY integerMatch "
+      "SYNTAX 1.3.6.1.4.1.1466.115.121.1.27 "
+      "NO-USER-MODIFICATION "
+      "USAGE dSAOperation )",
+        &ad_olmConnectionPoolSize },
+    { "( olmBalancerAttributes:15 "
+      "NAME ( 'olmBindConnectionPoolSize' ) "
+      "DESC 'number of bind connections the pool is currently sized for' "
+      "EQUALITY integerMatch "
+      "SYNTAX 1.3.6.1.4.1.1466.115.121.1.27 "
+      "NO-USER-MODIFICATION "
+      "USAGE dSAOperation )",
+        &ad_olmBindConnectionPoolSize },
+    { "( olmBalancerAttributes:16 "
+      "NAME ( 'olmRateLimitedOps' ) "
+      "DESC 'monitor operations rejected by a rate limit' "
+      "SUP monitorCounter "
+      "NO-USER-MODIFICATION "
+      "USAGE dSAOperation )",
+        &ad_olmRateLimitedOps },
+    { "( olmBalancerAttributes:17 "
+      "NAME ( 'olmOpLatency' ) "
+      "DESC 'percentiles of the time to complete an operation, in microseconds' "
+      "EQUALITY caseIgnoreMatch "
+      "SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 "
+      "NO-USER-MODIFICATION "
+      "USAGE dSAOperation )",
+        &ad_olmOpLatency },
+    { "( olmBalancerAttributes:18 "
+      "NAME ( 'olmOpLatencyBuckets' ) "
+      "DESC 'histogram of the time to complete an operation, in microseconds' "
+      "EQUALITY caseIgnoreMatch "
+      "SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 "
+      "NO-USER-MODIFICATION "
+      "USAGE dSAOperation )",
+        &ad_olmOpLatencyBuckets },
+    { "( olmBalancerAttributes:19 "
+      "NAME ( 'olmUpstreamLatency' ) "
+      "DESC 'percentiles of the upstream time to first response, in microseconds' "
+      "EQUALITY caseIgnoreMatch "
+      "SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 "
+      "NO-USER-MODIFICATION "
+      "USAGE dSAOperation )",
+        &ad_olmUpstreamLatency },
+    { "( olmBalancerAttributes:20 "
+      "NAME ( 'olmUpstreamLatencyBuckets' ) "
+      "DESC 'histogram of the upstream time to first response, in microseconds' "
+      "EQUALITY caseIgnoreMatch "
+      "SYNTAX 1.3.6.1.4.1.1466.115.121.1.15 "
+      "NO-USER-MODIFICATION "
+      "USAGE dSAOperation )",
+        &ad_olmUpstreamLatencyBuckets },
 
     { NULL }
 };
@@ -245,6 +309,8 @@ static struct {
       "$ olmReceivedOps "
       "$ olmCompletedOps "
       "$ olmFailedOps "
+      "$ olmConnectionPoolSize "
+      "$ olmBindConnectionPoolSize "
       ") )",
         &oc_olmBalancerServer },
 
@@ -255,6 +321,7 @@ static struct {
       "olmReceivedOps "
       "$ olmForwardedOps "
       "$ olmRejectedOps "
+      "$ olmRateLimitedOps "
       "$ olmCompletedOps "
       "$ olmFailedOps "
       ") )",
@@ -271,6 +338,16 @@ static struct {
       "$ olmFailedOps "
       ") )",
         &oc_olmBalancerConnection },
+    { "( olmBalancerObjectClasses:5 "
+      "NAME ( 'olmBalancerLatency' ) "
+      "SUP top AUXILIARY "
+      "MAY ( "
+      "olmOpLatency "
+      "$ olmOpLatencyBuckets "
+      "$ olmUpstreamLatency "
+      "$ olmUpstreamLatencyBuckets "
+      ") )",
+        &oc_olmBalancerLatency },
     { NULL }
 };
 
@@ -354,11 +431,110 @@ lload_monitor_balancer_update(
     return SLAP_CB_CONTINUE;
 }
 
+/*
+ * Append the percentiles and the non-empty buckets of h to the respective
+ * value arrays. Each bucket is listed as its upper bound followed by the
+ * number of samples in it.
+ */
+static void
+lload_monitor_latency_values(
+        lload_histogram_t *h,
+        const char *prefix,
+        BerVarray *percentiles,
+        BerVarray *buckets )
+{
+    static const struct {
+        char *name;
+        double p;
+    } points[] = {
+        { "p50", 0.5 },
+        { "p90", 0.9 },
+        { "p99", 0.99 },
+        { "p99.9", 0.999 },
+        { "max", 1 },
+        { NULL }
+    };
+    lload_histogram_t snapshot = {};
+    uintptr_t total;
+    struct berval bv;
+    char buf[64];
+    int i;
+
+    total = lload_histogram_merge( &snapshot, h );
+    if ( !total ) {
+        return;
+    }
+
+    bv.bv_val = buf;
+    for ( i = 0; points[i].name; i++ ) {
+        bv.bv_len = snprintf( buf, sizeof(buf), "%s%s%s %llu",
+                prefix ? prefix : "", prefix ? " " : "", points[i].name,
+                (unsigned long long)lload_histogram_percentile(
+                        &snapshot, total, points[i].p ) );
+        value_add_one( percentiles, &bv );
+    }
+
+    for ( i = 0; i < LLOAD_HISTOGRAM_BUCKETS; i++ ) {
+        if ( !snapshot.h_buckets[i] ) continue;
+
+        bv.bv_len = snprintf( buf, sizeof(buf), "%s%s%llu %llu",
+                prefix ? prefix : "", prefix ? " " : "",
+                (unsigned long long)lload_histogram_bucket_max( i ),
+                (unsigned long long)snapshot.h_buckets[i] );
+        value_add_one( buckets, &bv );
+    }
+}
+
+static void
+lload_monitor_latency_replace(
+        Entry *e,
+        AttributeDescription *ad,
+        BerVarray vals )
+{
+    attr_delete( &e->e_attrs, ad );
+    if ( vals ) {
+        attr_merge_normalize( e, ad, vals, NULL );
+        ber_bvarray_free( vals );
+    }
+}
+
+/*
+ * Refresh the latency attributes of e from histograms, one set per operation
+ * type, prefixed by its name if prefixed is set.
+ */
+static void
+lload_monitor_latency_update(
+        Entry *e,
+        lload_histogram_t (*histograms)[LLOAD_HISTOGRAM_LAST],
+        int ntypes,
+        int prefixed )
+{
+    BerVarray total = NULL, total_buckets = NULL, upstream = NULL,
+              upstream_buckets = NULL;
+    int i;
+
+    for ( i = 0; i < ntypes; i++ ) {
+        char *prefix = prefixed ? lload_monitor_op[i].name : NULL;
+
+        lload_monitor_latency_values( &histograms[i][LLOAD_HISTOGRAM_TOTAL],
+                prefix, &total, &total_buckets );
+        lload_monitor_latency_values( &histograms[i][LLOAD_HISTOGRAM_UPSTREAM],
+                prefix, &upstream, &upstream_buckets );
+    }
+
+    lload_monitor_latency_replace( e, ad_olmOpLatency, total );
+    lload_monitor_latency_replace( e, ad_olmOpLatencyBuckets, total_buckets );
+    lload_monitor_latency_replace( e, ad_olmUpstreamLatency, upstream );
+    lload_monitor_latency_replace(
+            e, ad_olmUpstreamLatencyBuckets, upstream_buckets );
+}
+
 static int
 lload_monitor_ops_update( Operation *op, SlapReply *rs, Entry *e, void *priv )
 {
     Attribute *a;
     lload_counters_t *counters = (lload_counters_t *)priv;
+    int type = counters - lload_stats.counters;
 
     a = attr_find( e->e_attrs, ad_olmReceivedOps );
     assert( a != NULL );
@@ -372,6 +548,10 @@ lload_monitor_ops_update( Operation *op, SlapReply *rs, Entry *e, void *priv )
     assert( a != NULL );
     UI2BV( &a->a_vals[0], counters->lc_ops_rejected );
 
+    a = attr_find( e->e_attrs, ad_olmRateLimitedOps );
+    assert( a != NULL );
+    UI2BV( &a->a_vals[0], counters->lc_ops_ratelimited );
+
     a = attr_find( e->e_attrs, ad_olmCompletedOps );
     assert( a != NULL );
     UI2BV( &a->a_vals[0], counters->lc_ops_completed );
@@ -380,6 +560,8 @@ lload_monitor_ops_update( Operation *op, SlapReply *rs, Entry *e, void *priv )
     assert( a != NULL );
     UI2BV( &a->a_vals[0], counters->lc_ops_failed );
 
+    lload_monitor_latency_update( e, &lload_stats.histograms[type], 1, 0 );
+
     return SLAP_CB_CONTINUE;
 }
 
@@ -507,9 +689,12 @@ lload_monitor_ops_init( BackendDB *be, monitor_subsys_t *ms )
         cb->mc_dispose = lload_monitor_ops_dispose;
         cb->mc_private = &lload_stats.counters[i];
 
+        attr_merge_normalize_one( e, slap_schema.si_ad_objectClass,
+                &oc_olmBalancerLatency->soc_cname, NULL );
         attr_merge_normalize_one( e, ad_olmReceivedOps, &value, NULL );
         attr_merge_normalize_one( e, ad_olmForwardedOps, &value, NULL );
         attr_merge_normalize_one( e, ad_olmRejectedOps, &value, NULL );
+        attr_merge_normalize_one( e, ad_olmRateLimitedOps, &value, NULL );
         attr_merge_normalize_one( e, ad_olmCompletedOps, &value, NULL );
         attr_merge_normalize_one( e, ad_olmFailedOps, &value, NULL );
 
@@ -820,11 +1005,15 @@ lload_monitor_server_update(
     LloadConnection *c;
     LloadPendingConnection *pc;
     ldap_pvt_mp_t active = 0, pending = 0, received = 0, completed = 0,
-                  failed = 0;
-    int i;
+                  failed = 0, pool, bindpool;
+    lload_histogram_t histograms[LLOAD_STATS_OPS_LAST][LLOAD_HISTOGRAM_LAST] =
+            {};
+    int i, j, k;
 
     checked_lock( &b->b_mutex );
     active = b->b_active + b->b_bindavail;
+    pool = backend_numconns( b );
+    bindpool = backend_numbindconns( b );
 
     LDAP_CIRCLEQ_FOREACH ( c, &b->b_preparing, c_next ) {
         pending++;
@@ -872,6 +1061,25 @@ lload_monitor_server_update(
     assert( a != NULL );
     UI2BV( &a->a_vals[0], failed );
 
+    a = attr_find( e->e_attrs, ad_olmConnectionPoolSize );
+    assert( a != NULL );
+    UI2BV( &a->a_vals[0], pool );
+
+    a = attr_find( e->e_attrs, ad_olmBindConnectionPoolSize );
+    assert( a != NULL );
+    UI2BV( &a->a_vals[0], bindpool );
+
+    for ( k = 0; k < LLOAD_HISTOGRAM_SLOTS; k++ ) {
+        for ( i = 0; i < LLOAD_STATS_OPS_LAST; i++ ) {
+            for ( j = 0; j < LLOAD_HISTOGRAM_LAST; j++ ) {
+                lload_histogram_merge(
+                        &histograms[i][j], &b->b_histograms[k][i][j] );
+            }
+        }
+    }
+    lload_monitor_latency_update(
+            e, histograms, LLOAD_STATS_OPS_LAST, 1 );
+
     return SLAP_CB_CONTINUE;
 }
 
@@ -907,6 +1115,8 @@ lload_monitor_backend_open( BackendDB *be, monitor_subsys_t *ms )
     cb->mc_dispose = NULL;
     cb->mc_private = b;
 
+    attr_merge_normalize_one( e, slap_schema.si_ad_objectClass,
+            &oc_olmBalancerLatency->soc_cname, NULL );
     attr_merge_normalize_one( e, ad_olmServerURI, &b->b_uri, NULL );
     attr_merge_normalize_one( e, ad_olmActiveConnections, &value, NULL );
     attr_merge_normalize_one( e, ad_olmPendingConnections, &value, NULL );
@@ -914,6 +1124,8 @@ lload_monitor_backend_open( BackendDB *be, monitor_subsys_t *ms )
     attr_merge_normalize_one( e, ad_olmReceivedOps, &value, NULL );
     attr_merge_normalize_one( e, ad_olmCompletedOps, &value, NULL );
     attr_merge_normalize_one( e, ad_olmFailedOps, &value, NULL );
+    attr_merge_normalize_one( e, ad_olmConnectionPoolSize, &value, NULL );
+    attr_merge_normalize_one( e, ad_olmBindConnectionPoolSize, &value, NULL );
 
     rc = mbe->register_entry( e, cb, ms, 0 );
 
@@ -1110,7 +1322,7 @@ lload_monitor_update_global_stats( void *ctx, void *arg )
     struct re_s *rtask = arg;
     lload_global_stats_t tmp_stats = {};
     LloadTier *tier;
-    int i;
+    int i, j, k;
 
     Debug( LDAP_DEBUG_TRACE, "lload_monitor_update_global_stats: "
             "updating stats\n" );
@@ -1134,6 +1346,12 @@ lload_monitor_update_global_stats( void *ctx, void *arg )
                         b->b_counters[i].lc_ops_completed;
                 tmp_stats.counters[i].lc_ops_failed +=
                         b->b_counters[i].lc_ops_failed;
+                for ( j = 0; j < LLOAD_HISTOGRAM_LAST; j++ ) {
+                    for ( k = 0; k < LLOAD_HISTOGRAM_SLOTS; k++ ) {
+                        lload_histogram_merge( &tmp_stats.histograms[i][j],
+                                &b->b_histograms[k][i][j] );
+                    }
+                }
             }
             checked_unlock( &b->b_mutex );
         }
@@ -1148,6 +1366,8 @@ lload_monitor_update_global_stats( void *ctx, void *arg )
         lload_stats.counters[i].lc_ops_failed =
                 tmp_stats.counters[i].lc_ops_failed;
     }
+    AC_MEMCPY( lload_stats.histograms, tmp_stats.histograms,
+            sizeof(lload_stats.histograms) );
 
     /* reschedule */
     checked_lock( &slapd_rq.rq_mutex );
@@ -127,6 +127,146 @@ operation_upstream_cmp( const void *left, const void *right )
     }
 }
 
+#define LLOAD_OPINDEX_MIN 16
+
+static unsigned int
+opindex_slot( LloadOpIndex *idx, ber_int_t msgid )
+{
+    /* Fibonacci hashing, msgids are mostly sequential */
+    return ( (uint32_t)msgid * 2654435769U ) & ( idx->oi_size - 1 );
+}
+
+static void
+opindex_resize( LloadOpIndex *idx, unsigned int size )
+{
+    LloadOperation **old = idx->oi_ops;
+    unsigned int i, oldsize = idx->oi_size;
+
+    idx->oi_ops = ch_calloc( size, sizeof(LloadOperation *) );
+    idx->oi_size = size;
+    for ( i = 0; i < oldsize; i++ ) {
+        LloadOperation *op = old[i];
+        unsigned int j;
+
+        if ( !op ) continue;
+        for ( j = opindex_slot( idx, op->o_upstream_msgid ); idx->oi_ops[j];
+                j = ( j + 1 ) & ( size - 1 ) )
+            /* find a free slot */;
+        idx->oi_ops[j] = op;
+    }
+    ch_free( old );
+}
+
+/*
+ * Operations pending on an upstream live in c_ops, ordered by msgid for the
+ * walks in connection_timeout() and lload_connection_close(). Those with a
+ * msgid are also indexed in c_opsidx, which is what response processing uses
+ * to find them. Keep the two in sync by using these helpers, with c_mutex
+ * held.
+ *
+ * Inserting also marks the time the request is sent upstream.
+ */
+int
+operation_upstream_insert( LloadConnection *upstream, LloadOperation *op )
+{
+    LloadOpIndex *idx = &upstream->c_opsidx;
+    unsigned int i;
+    int rc;
+
+    CONNECTION_ASSERT_LOCKED(upstream);
+    gettimeofday( &op->o_forwarded, NULL );
+    rc = ldap_tavl_insert(
+            &upstream->c_ops, op, operation_upstream_cmp, ldap_avl_dup_error );
+    if ( rc || !op->o_upstream_msgid ) {
+        return rc;
+    }
+
+    /* Keep the load factor at or below 1/2 */
+    if ( ( idx->oi_count + 1 ) * 2 > idx->oi_size ) {
+        opindex_resize( idx,
+                idx->oi_size ? idx->oi_size * 2 : LLOAD_OPINDEX_MIN );
+    }
+    for ( i = opindex_slot( idx, op->o_upstream_msgid ); idx->oi_ops[i];
+            i = ( i + 1 ) & ( idx->oi_size - 1 ) ) {
+        assert( idx->oi_ops[i]->o_upstream_msgid != op->o_upstream_msgid );
+    }
+    idx->oi_ops[i] = op;
+    idx->oi_count++;
+    return rc;
+}
+
+LloadOperation *
+operation_upstream_remove( LloadConnection *upstream, LloadOperation *op )
+{
+    LloadOpIndex *idx = &upstream->c_opsidx;
+    LloadOperation *removed;
+    unsigned int i, j, mask = idx->oi_size - 1;
+
+    CONNECTION_ASSERT_LOCKED(upstream);
+    removed = ldap_tavl_delete( &upstream->c_ops, op, operation_upstream_cmp );
+    if ( !removed || !removed->o_upstream_msgid ) {
+        return removed;
+    }
+
+    for ( i = opindex_slot( idx, removed->o_upstream_msgid );
+            idx->oi_ops[i] != removed; i = ( i + 1 ) & mask ) {
+        assert( idx->oi_ops[i] != NULL );
+    }
+
+    /* Backward shift deletion, no tombstones needed with linear probing */
+    for ( j = ( i + 1 ) & mask; idx->oi_ops[j]; j = ( j + 1 ) & mask ) {
+        unsigned int home = opindex_slot( idx, idx->oi_ops[j]->o_upstream_msgid );
+
+        /* Move the entry into the hole unless its home lies in (i, j] */
+        if ( ( ( j - home ) & mask ) >= ( ( j - i ) & mask ) ) {
+            idx->oi_ops[i] = idx->oi_ops[j];
+            i = j;
+        }
+    }
+    idx->oi_ops[i] = NULL;
+    idx->oi_count--;
+
+    if ( idx->oi_size > LLOAD_OPINDEX_MIN &&
+            idx->oi_count * 8 < idx->oi_size ) {
+        opindex_resize( idx, idx->oi_size / 2 );
+    }
+    return removed;
+}
+
+LloadOperation *
+operation_upstream_find( LloadConnection *upstream, ber_int_t msgid )
+{
+    LloadOpIndex *idx = &upstream->c_opsidx;
+    LloadOperation *op;
+    unsigned int i;
+
+    CONNECTION_ASSERT_LOCKED(upstream);
+    if ( !idx->oi_count || !msgid ) {
+        return NULL;
+    }
+
+    for ( i = opindex_slot( idx, msgid ); ( op = idx->oi_ops[i] );
+            i = ( i + 1 ) & ( idx->oi_size - 1 ) ) {
+        if ( op->o_upstream_msgid == msgid ) {
+            return op;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Drop the index once c_ops has been detached from the connection.
+ */
+void
+operation_upstream_index_free( LloadConnection *upstream )
+{
+    LloadOpIndex *idx = &upstream->c_opsidx;
+
+    ch_free( idx->oi_ops );
+    idx->oi_ops = NULL;
+    idx->oi_size = idx->oi_count = 0;
+}
+
 /*
  * Entered holding c_mutex for now.
  */
@@ -221,8 +361,12 @@ operation_destroy( LloadOperation *op )
     assert( op->o_refcnt == 0 );
     assert( op->o_client == NULL );
     assert( op->o_upstream == NULL );
+    assert( op->o_flight == NULL );
 
     ber_free( op->o_ber, 1 );
+    if ( op->o_cache ) {
+        lload_cache_entry_free( op->o_cache );
+    }
     ldap_pvt_thread_mutex_destroy( &op->o_link_mutex );
     ch_free( op );
 }
@@ -247,6 +391,10 @@ operation_unlink( LloadOperation *op )
             "client msgid=%d\n",
             op->o_client_connid, op->o_upstream_connid, op->o_client_msgid );
 
+    if ( op->o_tag == LDAP_REQ_BIND ) {
+        bind_flight_release( op );
+    }
+
     checked_lock( &op->o_link_mutex );
     client = op->o_client;
     upstream = op->o_upstream;
@@ -339,8 +487,7 @@ operation_unlink_upstream( LloadOperation *op, LloadConnection *upstream )
             op, op->o_upstream_msgid, op->o_upstream_connid );
 
     CONNECTION_LOCK(upstream);
-    if ( (removed = ldap_tavl_delete(
-                   &upstream->c_ops, op, operation_upstream_cmp )) ) {
+    if ( (removed = operation_upstream_remove( upstream, op )) ) {
         result |= LLOAD_OP_DETACHING_UPSTREAM;
 
         assert( op == removed );
@@ -365,7 +512,7 @@ operation_unlink_upstream( LloadOperation *op, LloadConnection *upstream )
 
     if ( b ) {
         checked_lock( &b->b_mutex );
-        b->b_n_ops_executing--;
+        __atomic_sub_fetch( &b->b_n_ops_executing, 1, __ATOMIC_RELAXED );
         operation_update_backend_counters( op, b );
         checked_unlock( &b->b_mutex );
     }
@@ -568,7 +715,7 @@ connection_timeout( LloadConnection *upstream, void *arg )
         }
 
         op->o_res = LLOAD_OP_FAILED;
-        found_op = ldap_tavl_delete( &upstream->c_ops, op, operation_upstream_cmp );
+        found_op = operation_upstream_remove( upstream, op );
         assert( op == found_op );
 
         if ( upstream->c_state == LLOAD_C_BINDING ) {
@@ -604,7 +751,7 @@ connection_timeout( LloadConnection *upstream, void *arg )
     CONNECTION_UNLOCK(upstream);
 
     checked_lock( &b->b_mutex );
-    b->b_n_ops_executing -= nops;
+    __atomic_sub_fetch( &b->b_n_ops_executing, nops, __ATOMIC_RELAXED );
     checked_unlock( &b->b_mutex );
 
     for ( node = ldap_tavl_end( ops, TAVL_DIR_LEFT ); node;
@@ -724,6 +871,9 @@ operation_update_backend_counters( LloadOperation *op, LloadBackend *b )
     assert( b != NULL );
     if ( op->o_res == LLOAD_OP_COMPLETED ) {
         b->b_counters[stat_type].lc_ops_completed++;
+        lload_histogram_add( &b->b_histograms[lload_histogram_slot()]
+                                              [stat_type][LLOAD_HISTOGRAM_TOTAL],
+                &op->o_start );
     } else {
         b->b_counters[stat_type].lc_ops_failed++;
     }
@@ -40,6 +40,9 @@ LDAP_BEGIN_DECL
 LDAP_SLAPD_F (void) backend_connect( evutil_socket_t s, short what, void *arg );
 LDAP_SLAPD_F (void *) backend_connect_task( void *ctx, void *arg );
 LDAP_SLAPD_F (void) backend_retry( LloadBackend *b );
+LDAP_SLAPD_F (int) backend_numconns( LloadBackend *b );
+LDAP_SLAPD_F (int) backend_numbindconns( LloadBackend *b );
+LDAP_SLAPD_F (void) backend_pool_update( LloadBackend *b );
 LDAP_SLAPD_F (int) upstream_select( LloadOperation *op, LloadConnection **c, int *res, char **message );
 LDAP_SLAPD_F (int) backend_select( LloadBackend *b, LloadOperation *op, LloadConnection **c, int *res, char **message );
 LDAP_SLAPD_F (int) try_upstream( LloadBackend *b, lload_c_head *head, LloadOperation *op, LloadConnection *c, int *res, char **message );
@@ -54,6 +57,23 @@ LDAP_SLAPD_F (int) request_bind( LloadConnection *c, LloadOperation *op );
 LDAP_SLAPD_F (int) handle_bind_response( LloadConnection *client, LloadOperation *op, BerElement *ber );
 LDAP_SLAPD_F (int) handle_whoami_response( LloadConnection *client, LloadOperation *op, BerElement *ber );
 LDAP_SLAPD_F (int) handle_vc_bind_response( LloadConnection *client, LloadOperation *op, BerElement *ber );
+LDAP_SLAPD_F (void) bind_flight_init( void );
+LDAP_SLAPD_F (void) bind_flight_finish( LloadOperation *op, struct berval *response, struct berval *controls );
+LDAP_SLAPD_F (void) bind_flight_release( LloadOperation *op );
+LDAP_SLAPD_V (unsigned int) lload_bind_coalesce;
+
+/*
+ * cache.c
+ */
+LDAP_SLAPD_F (void) lload_cache_init( void );
+LDAP_SLAPD_F (void) lload_cache_destroy( void );
+LDAP_SLAPD_F (void) lload_cache_trim( void );
+LDAP_SLAPD_F (void) lload_cache_invalidate( void );
+LDAP_SLAPD_F (int) lload_cache_request( LloadConnection *client, LloadOperation *op );
+LDAP_SLAPD_F (void) lload_cache_response( LloadOperation *op, ber_tag_t tag, struct berval *response, struct berval *controls );
+LDAP_SLAPD_F (void) lload_cache_entry_free( LloadCacheEntry *ce );
+LDAP_SLAPD_V (ber_len_t) lload_cache_size;
+LDAP_SLAPD_V (time_t) lload_cache_ttl[];
 
 /*
  * client.c
@@ -62,7 +82,7 @@ LDAP_SLAPD_F (int) request_abandon( LloadConnection *c, LloadOperation *op );
 LDAP_SLAPD_F (int) request_process( LloadConnection *c, LloadOperation *op );
 LDAP_SLAPD_F (int) handle_one_request( LloadConnection *c );
 LDAP_SLAPD_F (void) client_tls_handshake_cb( evutil_socket_t s, short what, void *arg );
-LDAP_SLAPD_F (LloadConnection *) client_init( ber_socket_t s, const char *peername, struct event_base *base, int use_tls );
+LDAP_SLAPD_F (LloadConnection *) client_init( ber_socket_t s, const char *peername, struct berval *listener, struct event_base *base, int use_tls );
 LDAP_SLAPD_F (void) client_reset( LloadConnection *c );
 LDAP_SLAPD_F (void) client_destroy( LloadConnection *c );
 LDAP_SLAPD_F (void) clients_destroy( int gentle );
@@ -91,6 +111,7 @@ LDAP_SLAPD_F (int) lload_back_init_cf( BackendInfo *bi );
 LDAP_SLAPD_V (ldap_pvt_thread_mutex_t) clients_mutex;
 LDAP_SLAPD_F (void *) handle_pdus( void *ctx, void *arg );
 LDAP_SLAPD_F (void) connection_write_cb( evutil_socket_t s, short what, void *arg );
+LDAP_SLAPD_F (int) connection_forward_pdu( LloadConnection *c, BerElement *ber, ber_len_t len, ber_int_t msgid );
 LDAP_SLAPD_F (void) connection_read_cb( evutil_socket_t s, short what, void *arg );
 LDAP_SLAPD_F (int) lload_connection_close( LloadConnection *c, void *arg );
 LDAP_SLAPD_F (LloadConnection *) lload_connection_init( ber_socket_t s, const char *peername, int use_tls );
@@ -114,6 +135,8 @@ LDAP_SLAPD_F (void) listeners_reactivate( void );
 LDAP_SLAPD_F (struct event_base *) lload_get_base( ber_socket_t s );
 LDAP_SLAPD_V (int) lload_daemon_threads;
 LDAP_SLAPD_V (int) lload_daemon_mask;
+LDAP_SLAPD_V (int) lload_listener_threads;
+LDAP_SLAPD_V (int) lload_listener_mask;
 
 LDAP_SLAPD_F (void) lload_sig_shutdown( evutil_socket_t sig, short what, void *arg );
 
@@ -144,6 +167,17 @@ LDAP_SLAPD_F (int) exop_handler_cmp( const void *l, const void *r );
 LDAP_SLAPD_F (int) request_extended( LloadConnection *c, LloadOperation *op );
 LDAP_SLAPD_F (int) lload_exop_init( void );
 
+/*
+ * histogram.c
+ */
+LDAP_SLAPD_F (void) lload_histogram_init( void );
+LDAP_SLAPD_F (void) lload_histogram_destroy( void );
+LDAP_SLAPD_F (int) lload_histogram_slot( void );
+LDAP_SLAPD_F (uint64_t) lload_histogram_bucket_max( int i );
+LDAP_SLAPD_F (void) lload_histogram_add( lload_histogram_t *h, struct timeval *since );
+LDAP_SLAPD_F (uintptr_t) lload_histogram_merge( lload_histogram_t *dst, lload_histogram_t *src );
+LDAP_SLAPD_F (uint64_t) lload_histogram_percentile( lload_histogram_t *h, uintptr_t total, double p );
+
 /*
  * init.c
  */
@@ -183,6 +217,10 @@ LDAP_SLAPD_F (int) lload_restriction_cmp( const void *left, const void *right );
 LDAP_SLAPD_F (const char *) lload_msgtype2str( ber_tag_t tag );
 LDAP_SLAPD_F (int) operation_upstream_cmp( const void *l, const void *r );
 LDAP_SLAPD_F (int) operation_client_cmp( const void *l, const void *r );
+LDAP_SLAPD_F (int) operation_upstream_insert( LloadConnection *upstream, LloadOperation *op );
+LDAP_SLAPD_F (LloadOperation *) operation_upstream_remove( LloadConnection *upstream, LloadOperation *op );
+LDAP_SLAPD_F (LloadOperation *) operation_upstream_find( LloadConnection *upstream, ber_int_t msgid );
+LDAP_SLAPD_F (void) operation_upstream_index_free( LloadConnection *upstream );
 LDAP_SLAPD_F (LloadOperation *) operation_init( LloadConnection *c, BerElement *ber );
 LDAP_SLAPD_F (int) operation_send_abandon( LloadOperation *op, LloadConnection *c );
 LDAP_SLAPD_F (void) operation_abandon( LloadOperation *op );
@@ -198,6 +236,16 @@ LDAP_SLAPD_F (void) operation_update_conn_counters( LloadOperation *op, LloadCon
 LDAP_SLAPD_F (void) operation_update_backend_counters( LloadOperation *op, LloadBackend *b );
 LDAP_SLAPD_F (void) operation_update_global_rejected( LloadOperation *op );
 
+/*
+ * ratelimit.c
+ */
+LDAP_SLAPD_F (void) lload_ratelimit_init( void );
+LDAP_SLAPD_F (void) lload_ratelimit_reset( int type );
+LDAP_SLAPD_F (void) lload_ratelimit_destroy( void );
+LDAP_SLAPD_F (int) lload_ratelimit_request( LloadConnection *c, LloadOperation *op );
+LDAP_SLAPD_V (lload_ratelimit_t) lload_ratelimits[];
+LDAP_SLAPD_V (slap_verbmasks) lload_ratelimit_keys[];
+
 /*
  * tier.c
  */
@@ -0,0 +1,265 @@
+/* ratelimit.c - per client operation rate limits */
+/* $OpenLDAP$ */
+/* This work is part of OpenLDAP Software <http://www.openldap.org/>.
+ *
+ * Copyright 1998-2022 The OpenLDAP Foundation.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in the file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+
+#include "portable.h"
+
+#include <ac/string.h>
+#include <ac/time.h>
+
+#include "lutil.h"
+#include "lload.h"
+
+/*
+ * Each configured limit keeps a token bucket for every distinct value of its
+ * key (client address, bound identity or the listener the client connected
+ * to). A bucket holds up to rl_burst tokens and is refilled at rl_rate tokens
+ * a second, every operation takes one token and is rejected if there is none
+ * left. An operation has to pass all configured limits.
+ *
+ * A bucket that has refilled completely is indistinguishable from one that
+ * doesn't exist, those are dropped every now and then to keep the trees from
+ * growing without bounds.
+ */
+
+typedef struct LloadBucket {
+    struct berval tb_key;
+    double tb_tokens;
+    struct timeval tb_stamp;
+} LloadBucket;
+
+/* How often, in seconds, we look for buckets to drop */
+#define LLOAD_RATELIMIT_PURGE 10
+
+lload_ratelimit_t lload_ratelimits[LLOAD_RATELIMIT_LAST];
+
+/* Indexed by the key type */
+slap_verbmasks lload_ratelimit_keys[] = {
+    { BER_BVC("ip"), LLOAD_RATELIMIT_IP },
+    { BER_BVC("dn"), LLOAD_RATELIMIT_DN },
+    { BER_BVC("listener"), LLOAD_RATELIMIT_LISTENER },
+    { BER_BVNULL, 0 }
+};
+
+static struct {
+    ldap_pvt_thread_mutex_t rb_mutex;
+    TAvlnode *rb_tree;
+    time_t rb_purged;
+} lload_buckets[LLOAD_RATELIMIT_LAST];
+
+static int
+lload_bucket_cmp( const void *left, const void *right )
+{
+    const LloadBucket *l = left, *r = right;
+
+    return ber_bvcmp( &l->tb_key, &r->tb_key );
+}
+
+static void
+lload_bucket_free( void *ptr )
+{
+    LloadBucket *tb = ptr;
+
+    ch_free( tb->tb_key.bv_val );
+    ch_free( tb );
+}
+
+/*
+ * Refill the bucket for the time elapsed since it was last looked at.
+ */
+static void
+lload_bucket_refill(
+        LloadBucket *tb,
+        lload_ratelimit_t *rl,
+        struct timeval *now )
+{
+    double elapsed;
+
+    elapsed = ( now->tv_sec - tb->tb_stamp.tv_sec ) +
+            ( now->tv_usec - tb->tb_stamp.tv_usec ) / 1000000.0;
+    if ( elapsed > 0 ) {
+        tb->tb_tokens += elapsed * rl->rl_rate;
+        if ( tb->tb_tokens > rl->rl_burst ) {
+            tb->tb_tokens = rl->rl_burst;
+        }
+    }
+    tb->tb_stamp = *now;
+}
+
+static void
+lload_buckets_purge( int type, struct timeval *now )
+{
+    lload_ratelimit_t *rl = &lload_ratelimits[type];
+    TAvlnode *node, *next;
+
+    assert_locked( &lload_buckets[type].rb_mutex );
+
+    for ( node = ldap_tavl_end( lload_buckets[type].rb_tree, TAVL_DIR_LEFT );
+            node; node = next ) {
+        LloadBucket *tb = node->avl_data;
+
+        next = ldap_tavl_next( node, TAVL_DIR_RIGHT );
+
+        lload_bucket_refill( tb, rl, now );
+        if ( tb->tb_tokens >= rl->rl_burst ) {
+            ldap_tavl_delete(
+                    &lload_buckets[type].rb_tree, tb, lload_bucket_cmp );
+            lload_bucket_free( tb );
+        }
+    }
+    lload_buckets[type].rb_purged = now->tv_sec;
+}
+
+/*
+ * Take a token from the bucket for key, returns 0 if there was none left.
+ */
+static int
+lload_bucket_take( int type, struct berval *key, struct timeval *now )
+{
+    lload_ratelimit_t *rl = &lload_ratelimits[type];
+    LloadBucket *tb, needle = { .tb_key = *key };
+    int rc = 1;
+
+    checked_lock( &lload_buckets[type].rb_mutex );
+    if ( now->tv_sec - lload_buckets[type].rb_purged >=
+            LLOAD_RATELIMIT_PURGE ) {
+        lload_buckets_purge( type, now );
+    }
+
+    tb = ldap_tavl_find(
+            lload_buckets[type].rb_tree, &needle, lload_bucket_cmp );
+    if ( !tb ) {
+        tb = ch_malloc( sizeof(LloadBucket) );
+        ber_dupbv( &tb->tb_key, key );
+        tb->tb_tokens = rl->rl_burst;
+        tb->tb_stamp = *now;
+        rc = ldap_tavl_insert( &lload_buckets[type].rb_tree, tb,
+                lload_bucket_cmp, ldap_avl_dup_error );
+        assert( rc == LDAP_SUCCESS );
+        rc = 1;
+    } else {
+        lload_bucket_refill( tb, rl, now );
+    }
+
+    if ( tb->tb_tokens >= 1 ) {
+        tb->tb_tokens -= 1;
+    } else {
+        rc = 0;
+    }
+    checked_unlock( &lload_buckets[type].rb_mutex );
+
+    return rc;
+}
+
+void
+lload_ratelimit_init( void )
+{
+    int i;
+
+    for ( i = 0; i < LLOAD_RATELIMIT_LAST; i++ ) {
+        ldap_pvt_thread_mutex_init( &lload_buckets[i].rb_mutex );
+    }
+}
+
+/*
+ * Forget all buckets of this type, used when the limit is reconfigured and on
+ * shutdown.
+ */
+void
+lload_ratelimit_reset( int type )
+{
+    checked_lock( &lload_buckets[type].rb_mutex );
+    ldap_tavl_free( lload_buckets[type].rb_tree, lload_bucket_free );
+    lload_buckets[type].rb_tree = NULL;
+    checked_unlock( &lload_buckets[type].rb_mutex );
+}
+
+void
+lload_ratelimit_destroy( void )
+{
+    int i;
+
+    for ( i = 0; i < LLOAD_RATELIMIT_LAST; i++ ) {
+        lload_ratelimit_reset( i );
+    }
+}
+
+/*
+ * Check op against the configured limits, if it exceeds any of them, it is
+ * rejected and unlinked.
+ *
+ * Returns 1 if op has been rejected.
+ */
+int
+lload_ratelimit_request( LloadConnection *c, LloadOperation *op )
+{
+    struct berval key;
+    struct timeval now;
+    char *sep;
+    int type, stat_type;
+
+    gettimeofday( &now, NULL );
+
+    CONNECTION_LOCK(c);
+    if ( c->c_type == LLOAD_C_PRIVILEGED ) {
+        CONNECTION_UNLOCK(c);
+        return 0;
+    }
+
+    type = LLOAD_RATELIMIT_IP;
+    if ( lload_ratelimits[type].rl_rate ) {
+        /* Strip the port, clients connecting over ldapi:// share a bucket */
+        key = c->c_peer_name;
+        if ( !strncmp( key.bv_val, "IP=", STRLENOF("IP=") ) &&
+                ( sep = strrchr( key.bv_val, ':' ) ) ) {
+            key.bv_len = sep - key.bv_val;
+        }
+        if ( !lload_bucket_take( type, &key, &now ) ) {
+            goto reject;
+        }
+    }
+
+    /* Anonymous clients all share the same bucket */
+    type = LLOAD_RATELIMIT_DN;
+    if ( lload_ratelimits[type].rl_rate &&
+            !lload_bucket_take( type, &c->c_auth, &now ) ) {
+        goto reject;
+    }
+
+    type = LLOAD_RATELIMIT_LISTENER;
+    if ( lload_ratelimits[type].rl_rate &&
+            !lload_bucket_take( type, &c->c_listener_uri, &now ) ) {
+        goto reject;
+    }
+    CONNECTION_UNLOCK(c);
+
+    return 0;
+
+reject:
+    CONNECTION_UNLOCK(c);
+
+    Debug( LDAP_DEBUG_STATS, "lload_ratelimit_request: "
+            "connid=%lu msgid=%d %s rate limit exceeded\n",
+            op->o_client_connid, op->o_client_msgid,
+            lload_ratelimit_keys[type].word.bv_val );
+
+    stat_type = op->o_tag == LDAP_REQ_BIND ? LLOAD_STATS_OPS_BIND :
+                                             LLOAD_STATS_OPS_OTHER;
+    lload_stats.counters[stat_type].lc_ops_ratelimited++;
+
+    operation_send_reject(
+            op, LDAP_BUSY, "operation rate limit exceeded", 0 );
+    return 1;
+}
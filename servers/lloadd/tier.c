@@ -121,17 +121,24 @@ void
 lload_tiers_update( evutil_socket_t s, short what, void *arg )
 {
     LloadTier *tier;
+    LloadBackend *b;
 
     LDAP_STAILQ_FOREACH ( tier, &tiers, t_next ) {
         if ( tier->t_type.tier_update ) {
             tier->t_type.tier_update( tier );
         }
+
+        /* Backends only come and go while we're paused */
+        LDAP_CIRCLEQ_FOREACH ( b, &tier->t_backends, b_next ) {
+            backend_pool_update( b );
+        }
     }
 }
 
 extern struct lload_tier_type roundrobin_tier;
 extern struct lload_tier_type weighted_tier;
 extern struct lload_tier_type bestof_tier;
+extern struct lload_tier_type latency_tier;
 
 struct {
     char *name;
@@ -140,6 +147,7 @@ struct {
         { "roundrobin", &roundrobin_tier },
         { "weighted", &weighted_tier },
         { "bestof", &bestof_tier },
+        { "latency", &latency_tier },
 
         { NULL }
 };
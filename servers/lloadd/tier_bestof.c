@@ -22,6 +22,7 @@
 #include "lutil.h"
 
 static LloadTierInit bestof_init;
+static LloadTierCb bestof_destroy;
 static LloadTierBackendConfigCb bestof_backend_options;
 static LloadTierBackendCb bestof_add_backend;
 static LloadTierBackendCb bestof_remove_backend;
@@ -29,6 +30,22 @@ static LloadTierSelect bestof_select;
 
 struct lload_tier_type bestof_tier;
 
+/*
+ * Snapshot of the tier's backends so bestof_select can pick its candidates
+ * by index. It is replaced wholesale whenever a backend is added or removed
+ * and the old copy is released through the epoch mechanism, readers only need
+ * to observe an epoch while they hold on to it.
+ */
+typedef struct bestof_array {
+    int ba_n;
+    LloadBackend *ba_backends[];
+} bestof_array;
+
+typedef struct bestof_private {
+    LloadBackend *bp_next; /* where the next round-robin pass starts */
+    bestof_array *bp_array;
+} bestof_private;
+
 /*
  * xorshift - we don't need high quality randomness, and we don't want to
  * interfere with anyone else's use of srand() but we still want something with
@@ -94,6 +111,7 @@ bestof_init( void )
     tier->t_type = bestof_tier;
     ldap_pvt_thread_mutex_init( &tier->t_mutex );
     LDAP_CIRCLEQ_INIT( &tier->t_backends );
+    tier->t_private = ch_calloc( 1, sizeof(bestof_private) );
 
     /* Make sure we don't pass 0 as a seed */
     do {
@@ -104,39 +122,93 @@ bestof_init( void )
     return tier;
 }
 
+static int
+bestof_destroy( LloadTier *tier )
+{
+    bestof_private *bp = tier->t_private;
+
+    /* Removing the backends takes care of the array */
+    tier_destroy( tier );
+
+    assert( bp->bp_array == NULL );
+    ch_free( bp );
+    return LDAP_SUCCESS;
+}
+
+/*
+ * Rebuild the backend array from t_backends and publish it. Backends are only
+ * added and removed while the server is paused so the array never points to
+ * a backend that has already been freed.
+ */
+static void
+bestof_publish( LloadTier *tier )
+{
+    bestof_private *bp = tier->t_private;
+    bestof_array *array = NULL, *old;
+    LloadBackend *b;
+    int i = 0;
+
+    if ( tier->t_nbackends ) {
+        array = ch_malloc( sizeof(bestof_array) +
+                tier->t_nbackends * sizeof(LloadBackend *) );
+        LDAP_CIRCLEQ_FOREACH ( b, &tier->t_backends, b_next ) {
+            array->ba_backends[i++] = b;
+        }
+        assert( i == tier->t_nbackends );
+        array->ba_n = i;
+    }
+
+    old = __atomic_exchange_n( &bp->bp_array, array, __ATOMIC_ACQ_REL );
+    if ( !old ) {
+        return;
+    }
+
+    /* Nobody can be selecting yet while we're reading the configuration */
+    if ( lloadd_inited ) {
+        epoch_append( old, ch_free );
+    } else {
+        ch_free( old );
+    }
+}
+
 int
 bestof_add_backend( LloadTier *tier, LloadBackend *b )
 {
+    bestof_private *bp = tier->t_private;
+
     assert( b->b_tier == tier );
 
     LDAP_CIRCLEQ_INSERT_TAIL( &tier->t_backends, b, b_next );
-    if ( !tier->t_private ) {
-        tier->t_private = b;
+    if ( !bp->bp_next ) {
+        bp->bp_next = b;
     }
     tier->t_nbackends++;
+    bestof_publish( tier );
     return LDAP_SUCCESS;
 }
 
 static int
 bestof_remove_backend( LloadTier *tier, LloadBackend *b )
 {
+    bestof_private *bp = tier->t_private;
     LloadBackend *next = LDAP_CIRCLEQ_LOOP_NEXT( &tier->t_backends, b, b_next );
 
     assert_locked( &tier->t_mutex );
     assert_locked( &b->b_mutex );
 
     assert( b->b_tier == tier );
-    assert( tier->t_private );
+    assert( bp->bp_next );
 
     LDAP_CIRCLEQ_REMOVE( &tier->t_backends, b, b_next );
     LDAP_CIRCLEQ_ENTRY_INIT( b, b_next );
 
     if ( b == next ) {
-        tier->t_private = NULL;
+        bp->bp_next = NULL;
     } else {
-        tier->t_private = next;
+        bp->bp_next = next;
     }
     tier->t_nbackends--;
+    bestof_publish( tier );
 
     return LDAP_SUCCESS;
 }
@@ -164,11 +236,12 @@ bestof_backend_options( LloadTier *tier, LloadBackend *b, char *arg )
 static int
 bestof_update( LloadTier *tier )
 {
+    bestof_private *bp = tier->t_private;
     LloadBackend *b, *first, *next;
     time_t now = slap_get_time();
 
     checked_lock( &tier->t_mutex );
-    first = b = tier->t_private;
+    first = b = bp->bp_next;
     checked_unlock( &tier->t_mutex );
 
     if ( !first ) return LDAP_SUCCESS;
@@ -220,70 +293,59 @@ bestof_select(
         int *res,
         char **message )
 {
-    LloadBackend *first, *next, *b, *b0, *b1;
-    int result = 0, rc = 0, n = tier->t_nbackends;
-    int i0, i1, i = 0;
-
-    checked_lock( &tier->t_mutex );
-    first = b0 = b = tier->t_private;
-    checked_unlock( &tier->t_mutex );
-
-    if ( !first ) return rc;
-
-    if ( tier->t_nbackends == 1 ) {
-        goto fallback;
-    }
-
-    /* Pick two backend indices at random */
-    i0 = bestof_rand() % n;
-    i1 = bestof_rand() % ( n - 1 );
-    if ( i1 >= i0 ) {
-        i1 += 1;
-    } else {
-        int tmp = i0;
-        i0 = i1;
-        i1 = tmp;
-    }
-    assert( i0 < i1 );
+    bestof_private *bp = tier->t_private;
+    bestof_array *array;
+    LloadBackend *first, *next, *b, *b0 = NULL, *b1 = NULL;
+    int result = 0, rc = 0, n;
+    int i0, i1;
+    epoch_t epoch;
 
     /*
-     * FIXME: use a static array in t_private so we don't have to do any of
-     * this
+     * Only the fallback needs the round-robin position, the two candidates
+     * come from the array without taking t_mutex
      */
-    for ( i = 0; i < i1; i++ ) {
-        if ( i == i0 ) {
-            b0 = b;
+    epoch = epoch_join();
+    array = __atomic_load_n( &bp->bp_array, __ATOMIC_ACQUIRE );
+    n = array ? array->ba_n : 0;
+
+    if ( n >= 2 ) {
+        /* Pick two distinct backends at random */
+        i0 = bestof_rand() % n;
+        i1 = bestof_rand() % ( n - 1 );
+        if ( i1 >= i0 ) {
+            i1 += 1;
         }
-        checked_lock( &b->b_mutex );
-        next = LDAP_CIRCLEQ_LOOP_NEXT( &tier->t_backends, b, b_next );
-        checked_unlock( &b->b_mutex );
-        b = next;
-    }
-    b1 = b;
-    assert( b0 != b1 );
-
-    if ( bestof_cmp( b0, b1 ) < 0 ) {
-        checked_lock( &b0->b_mutex );
-        result = backend_select( b0, op, cp, res, message );
-        checked_unlock( &b0->b_mutex );
-    } else {
-        checked_lock( &b1->b_mutex );
-        result = backend_select( b1, op, cp, res, message );
-        checked_unlock( &b1->b_mutex );
+        b0 = array->ba_backends[i0];
+        b1 = array->ba_backends[i1];
     }
+    epoch_leave( epoch );
+
+    if ( b0 ) {
+        assert( b0 != b1 );
+
+        if ( bestof_cmp( b0, b1 ) < 0 ) {
+            checked_lock( &b0->b_mutex );
+            result = backend_select( b0, op, cp, res, message );
+            checked_unlock( &b0->b_mutex );
+        } else {
+            checked_lock( &b1->b_mutex );
+            result = backend_select( b1, op, cp, res, message );
+            checked_unlock( &b1->b_mutex );
+        }
 
-    rc |= result;
-    if ( result && *cp ) {
-        checked_lock( &tier->t_mutex );
-        tier->t_private = LDAP_CIRCLEQ_LOOP_NEXT(
-                &tier->t_backends, (*cp)->c_backend, b_next );
-        checked_unlock( &tier->t_mutex );
-        return rc;
+        rc |= result;
+        if ( result && *cp ) {
+            return rc;
+        }
     }
 
     /* Preferred backends deemed unusable, do a round robin from scratch */
-    b = first;
-fallback:
+    checked_lock( &tier->t_mutex );
+    first = b = bp->bp_next;
+    checked_unlock( &tier->t_mutex );
+
+    if ( !first ) return rc;
+
     do {
         checked_lock( &b->b_mutex );
         next = LDAP_CIRCLEQ_LOOP_NEXT( &tier->t_backends, b, b_next );
@@ -298,7 +360,7 @@ fallback:
              * is acceptable.
              */
             checked_lock( &tier->t_mutex );
-            tier->t_private = next;
+            bp->bp_next = next;
             checked_unlock( &tier->t_mutex );
             return rc;
         }
@@ -316,7 +378,7 @@ struct lload_tier_type bestof_tier = {
         .tier_startup = tier_startup,
         .tier_update = bestof_update,
         .tier_reset = tier_reset,
-        .tier_destroy = tier_destroy,
+        .tier_destroy = bestof_destroy,
 
         .tier_oc = BER_BVC("olcBkLloadTierConfig"),
         .tier_backend_oc = BER_BVC("olcBkLloadBackendConfig"),
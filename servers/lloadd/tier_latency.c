@@ -0,0 +1,379 @@
+/* $OpenLDAP$ */
+/* This work is part of OpenLDAP Software <http://www.openldap.org/>.
+ *
+ * Copyright 1998-2022 The OpenLDAP Foundation.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in the file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+
+#include "portable.h"
+
+#include <ac/string.h>
+#include <math.h>
+
+#include "lload.h"
+#include "lutil.h"
+
+/*
+ * Latency-aware tier.
+ *
+ * Every backend keeps a peak-EWMA of the time to first response for each
+ * class of operation: a slower response replaces the average outright, faster
+ * ones pull it down with a weight that depends on how long ago the last
+ * sample was. While no responses come in, the average decays towards the
+ * mean of the sampled backends in the tier, so a backend we stopped using gets
+ * probed again eventually. A backend that is new, or that was down for a
+ * while, starts from that mean instead of looking free.
+ *
+ * A backend's cost for an operation is that average multiplied by the
+ * number of operations it has in flight. The cheapest backend is tried
+ * first, then we fall back to round-robin like the other tiers.
+ *
+ * Both the averages and the in-flight count are kept in atomics, so the costs
+ * are worked out without taking any b_mutex, only the chosen backend is
+ * locked.
+ */
+
+static LloadTierInit latency_init;
+static LloadTierCb latency_destroy;
+static LloadTierBackendCb latency_add_backend;
+static LloadTierBackendCb latency_remove_backend;
+static LloadTierObserve latency_observe;
+static LloadTierSelect latency_select;
+
+struct lload_tier_type latency_tier;
+
+/* Time constant of the decay, in milliseconds */
+#define LATENCY_DECAY 10000.0
+
+/*
+ * Snapshot of the tier's backends for latency_select to walk without locks,
+ * maintained the same way as in tier_bestof.c.
+ */
+typedef struct latency_array {
+    int la_n;
+    LloadBackend *la_backends[];
+} latency_array;
+
+typedef struct latency_private {
+    LloadBackend *lp_next; /* where the next pass starts */
+    latency_array *lp_array;
+} latency_private;
+
+static int
+latency_class( ber_tag_t tag )
+{
+    switch ( tag ) {
+        case LDAP_REQ_BIND:
+            return LLOAD_LATENCY_BIND;
+        case LDAP_REQ_SEARCH:
+        case LDAP_REQ_COMPARE:
+            return LLOAD_LATENCY_READ;
+        case LDAP_REQ_ADD:
+        case LDAP_REQ_DELETE:
+        case LDAP_REQ_MODIFY:
+        case LDAP_REQ_MODRDN:
+            return LLOAD_LATENCY_WRITE;
+    }
+    return LLOAD_LATENCY_OTHER;
+}
+
+static uintptr_t
+latency_now( void )
+{
+    struct timeval now;
+
+    gettimeofday( &now, NULL );
+    return (uintptr_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+/*
+ * Current average for the class, decayed towards the tier mean for the time
+ * since it was last updated. A backend that has never been sampled has a zero
+ * stamp so it gets the mean.
+ */
+static double
+latency_get( LloadBackend *b, int cls, uintptr_t now, double mean )
+{
+    uintptr_t avg, stamp;
+    double w;
+
+    avg = __atomic_load_n( &b->b_latency[cls], __ATOMIC_RELAXED );
+    stamp = __atomic_load_n( &b->b_latency_stamp[cls], __ATOMIC_RELAXED );
+
+    w = exp( -(double)( now - stamp ) / LATENCY_DECAY );
+    return avg * w + mean * ( 1 - w );
+}
+
+/*
+ * Mean of the averages of the backends that have been sampled, without any
+ * decay applied, zero if there are none.
+ */
+static double
+latency_mean( latency_array *array, int cls )
+{
+    LloadBackend *b;
+    double sum = 0;
+    int i, n = 0;
+
+    for ( i = 0; i < array->la_n; i++ ) {
+        b = array->la_backends[i];
+        if ( __atomic_load_n( &b->b_latency_stamp[cls], __ATOMIC_RELAXED ) ) {
+            sum += __atomic_load_n( &b->b_latency[cls], __ATOMIC_RELAXED );
+            n++;
+        }
+    }
+
+    return n ? sum / n : 0;
+}
+
+/*
+ * Called from response processing, concurrent updates to the same backend can
+ * lose a sample, we accept that rather than take b_mutex here.
+ */
+static void
+latency_observe(
+        LloadTier *tier,
+        LloadBackend *b,
+        LloadOperation *op,
+        uintptr_t latency )
+{
+    int cls = latency_class( op->o_tag );
+    uintptr_t avg, stamp, now = latency_now();
+    double w;
+
+    avg = __atomic_load_n( &b->b_latency[cls], __ATOMIC_RELAXED );
+    stamp = __atomic_load_n( &b->b_latency_stamp[cls], __ATOMIC_RELAXED );
+
+    if ( latency < avg ) {
+        w = exp( -(double)( now - stamp ) / LATENCY_DECAY );
+        avg = avg * w + latency * ( 1 - w );
+    } else {
+        avg = latency;
+    }
+
+    __atomic_store_n( &b->b_latency[cls], avg, __ATOMIC_RELAXED );
+    __atomic_store_n( &b->b_latency_stamp[cls], now, __ATOMIC_RELAXED );
+}
+
+LloadTier *
+latency_init( void )
+{
+    LloadTier *tier;
+
+    tier = ch_calloc( 1, sizeof(LloadTier) );
+
+    tier->t_type = latency_tier;
+    ldap_pvt_thread_mutex_init( &tier->t_mutex );
+    LDAP_CIRCLEQ_INIT( &tier->t_backends );
+    tier->t_private = ch_calloc( 1, sizeof(latency_private) );
+
+    return tier;
+}
+
+static int
+latency_destroy( LloadTier *tier )
+{
+    latency_private *lp = tier->t_private;
+
+    /* Removing the backends takes care of the array */
+    tier_destroy( tier );
+
+    assert( lp->lp_array == NULL );
+    ch_free( lp );
+    return LDAP_SUCCESS;
+}
+
+/*
+ * Rebuild the backend array from t_backends and publish it, backends are only
+ * added and removed while the server is paused.
+ */
+static void
+latency_publish( LloadTier *tier )
+{
+    latency_private *lp = tier->t_private;
+    latency_array *array = NULL, *old;
+    LloadBackend *b;
+    int i = 0;
+
+    if ( tier->t_nbackends ) {
+        array = ch_malloc( sizeof(latency_array) +
+                tier->t_nbackends * sizeof(LloadBackend *) );
+        LDAP_CIRCLEQ_FOREACH ( b, &tier->t_backends, b_next ) {
+            array->la_backends[i++] = b;
+        }
+        assert( i == tier->t_nbackends );
+        array->la_n = i;
+    }
+
+    old = __atomic_exchange_n( &lp->lp_array, array, __ATOMIC_ACQ_REL );
+    if ( !old ) {
+        return;
+    }
+
+    if ( lloadd_inited ) {
+        epoch_append( old, ch_free );
+    } else {
+        ch_free( old );
+    }
+}
+
+int
+latency_add_backend( LloadTier *tier, LloadBackend *b )
+{
+    latency_private *lp = tier->t_private;
+
+    assert( b->b_tier == tier );
+
+    LDAP_CIRCLEQ_INSERT_TAIL( &tier->t_backends, b, b_next );
+    if ( !lp->lp_next ) {
+        lp->lp_next = b;
+    }
+    tier->t_nbackends++;
+    latency_publish( tier );
+    return LDAP_SUCCESS;
+}
+
+static int
+latency_remove_backend( LloadTier *tier, LloadBackend *b )
+{
+    latency_private *lp = tier->t_private;
+    LloadBackend *next = LDAP_CIRCLEQ_LOOP_NEXT( &tier->t_backends, b, b_next );
+
+    assert_locked( &tier->t_mutex );
+    assert_locked( &b->b_mutex );
+
+    assert( b->b_tier == tier );
+    assert( lp->lp_next );
+
+    LDAP_CIRCLEQ_REMOVE( &tier->t_backends, b, b_next );
+    LDAP_CIRCLEQ_ENTRY_INIT( b, b_next );
+
+    if ( b == next ) {
+        lp->lp_next = NULL;
+    } else {
+        lp->lp_next = next;
+    }
+    tier->t_nbackends--;
+    latency_publish( tier );
+
+    return LDAP_SUCCESS;
+}
+
+int
+latency_select(
+        LloadTier *tier,
+        LloadOperation *op,
+        LloadConnection **cp,
+        int *res,
+        char **message )
+{
+    latency_private *lp = tier->t_private;
+    latency_array *array;
+    LloadBackend *first, *next, *b, *best = NULL;
+    int cls = latency_class( op->o_tag ), rc = 0, i, start, n;
+    uintptr_t now = latency_now();
+    double mean, cost, best_cost = 0;
+    epoch_t epoch;
+
+    epoch = epoch_join();
+    array = __atomic_load_n( &lp->lp_array, __ATOMIC_ACQUIRE );
+    n = array ? array->la_n : 0;
+
+    if ( n > 1 ) {
+        mean = latency_mean( array, cls );
+
+        /* Starting from the round-robin position makes ties go round-robin */
+        first = __atomic_load_n( &lp->lp_next, __ATOMIC_RELAXED );
+        for ( start = 0; start < n; start++ ) {
+            if ( array->la_backends[start] == first ) break;
+        }
+
+        for ( i = 0; i < n; i++ ) {
+            b = array->la_backends[( start + i ) % n];
+            cost = ( latency_get( b, cls, now, mean ) + 1 ) *
+                    ( __atomic_load_n(
+                              &b->b_n_ops_executing, __ATOMIC_RELAXED ) +
+                            1 );
+
+            if ( !best || cost < best_cost ) {
+                best = b;
+                best_cost = cost;
+            }
+        }
+    }
+    epoch_leave( epoch );
+
+    if ( best ) {
+        checked_lock( &best->b_mutex );
+        next = LDAP_CIRCLEQ_LOOP_NEXT( &tier->t_backends, best, b_next );
+        rc = backend_select( best, op, cp, res, message );
+        checked_unlock( &best->b_mutex );
+
+        if ( rc && *cp ) {
+            checked_lock( &tier->t_mutex );
+            __atomic_store_n( &lp->lp_next, next, __ATOMIC_RELAXED );
+            checked_unlock( &tier->t_mutex );
+            return rc;
+        }
+    }
+
+    /* Preferred backend deemed unusable, do a round robin from scratch */
+    checked_lock( &tier->t_mutex );
+    first = b = lp->lp_next;
+    checked_unlock( &tier->t_mutex );
+
+    if ( !first ) return rc;
+
+    do {
+        int result;
+
+        checked_lock( &b->b_mutex );
+        next = LDAP_CIRCLEQ_LOOP_NEXT( &tier->t_backends, b, b_next );
+
+        if ( b == best ) {
+            checked_unlock( &b->b_mutex );
+            b = next;
+            continue;
+        }
+        result = backend_select( b, op, cp, res, message );
+        checked_unlock( &b->b_mutex );
+
+        rc |= result;
+        if ( result && *cp ) {
+            checked_lock( &tier->t_mutex );
+            __atomic_store_n( &lp->lp_next, next, __ATOMIC_RELAXED );
+            checked_unlock( &tier->t_mutex );
+            return rc;
+        }
+
+        b = next;
+    } while ( b != first );
+
+    return rc;
+}
+
+struct lload_tier_type latency_tier = {
+        .tier_name = "latency",
+
+        .tier_init = latency_init,
+        .tier_startup = tier_startup,
+        .tier_reset = tier_reset,
+        .tier_destroy = latency_destroy,
+
+        .tier_oc = BER_BVC("olcBkLloadTierConfig"),
+        .tier_backend_oc = BER_BVC("olcBkLloadBackendConfig"),
+
+        .tier_add_backend = latency_add_backend,
+        .tier_remove_backend = latency_remove_backend,
+
+        .tier_observe = latency_observe,
+        .tier_select = latency_select,
+};
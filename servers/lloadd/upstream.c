@@ -68,7 +68,7 @@ forward_response( LloadConnection *client, LloadOperation *op, BerElement *ber )
     BerValue response, controls = BER_BVNULL;
     ber_int_t msgid;
     ber_tag_t tag, response_tag;
-    ber_len_t len;
+    ber_len_t len, total, remaining;
 
     CONNECTION_LOCK(client);
     if ( op->o_client_msgid ) {
@@ -80,18 +80,34 @@ forward_response( LloadConnection *client, LloadOperation *op, BerElement *ber )
     }
     CONNECTION_UNLOCK(client);
 
+    ber_get_option( ber, LBER_OPT_BER_REMAINING_BYTES, &total );
     response_tag = ber_skip_element( ber, &response );
 
     tag = ber_peek_tag( ber, &len );
     if ( tag == LDAP_TAG_CONTROLS ) {
         ber_skip_element( ber, &controls );
     }
+    ber_get_option( ber, LBER_OPT_BER_REMAINING_BYTES, &remaining );
+
+    if ( op->o_cache ) {
+        lload_cache_response( op, response_tag, &response, &controls );
+    }
+    if ( op->o_flight ) {
+        bind_flight_finish( op, &response, &controls );
+    }
 
     Debug( LDAP_DEBUG_TRACE, "forward_response: "
             "%s to client connid=%lu request msgid=%d\n",
             lload_msgtype2str( response_tag ), op->o_client_connid, msgid );
 
     checked_lock( &client->c_io_mutex );
+    if ( !connection_forward_pdu( client, ber, total - remaining, msgid ) ) {
+        /* ber is now owned by the client */
+        checked_unlock( &client->c_io_mutex );
+        connection_write_cb( -1, 0, client );
+        return 0;
+    }
+
     output = client->c_pendingber;
     if ( output == NULL && (output = ber_alloc()) == NULL ) {
         ber_free( ber, 1 );
@@ -125,6 +141,14 @@ forward_final_response(
             "client connid=%lu\n",
             op->o_upstream_connid, op->o_upstream_msgid, op->o_client_connid );
 
+    /* A search answered while the write was in progress might have been
+     * cached with the old data, drop it before the client can see the
+     * write has finished */
+    if ( lload_cache_size && op->o_tag != LDAP_REQ_BIND &&
+            op->o_tag != LDAP_REQ_SEARCH && op->o_tag != LDAP_REQ_COMPARE ) {
+        lload_cache_invalidate();
+    }
+
     rc = forward_response( client, op, ber );
 
     op->o_res = LLOAD_OP_COMPLETED;
@@ -185,16 +209,17 @@ static int
 handle_one_response( LloadConnection *c )
 {
     BerElement *ber;
-    LloadOperation *op = NULL, needle = { .o_upstream_connid = c->c_connid };
+    LloadOperation *op = NULL;
     LloadOperationHandler handler = NULL;
     ber_tag_t tag;
     ber_len_t len;
+    ber_int_t msgid;
     int rc = LDAP_SUCCESS;
 
     ber = c->c_currentber;
     c->c_currentber = NULL;
 
-    tag = ber_get_int( ber, &needle.o_upstream_msgid );
+    tag = ber_get_int( ber, &msgid );
     if ( tag != LDAP_TAG_MSGID ) {
         rc = -1;
         ber_free( ber, 1 );
@@ -202,10 +227,9 @@ handle_one_response( LloadConnection *c )
     }
 
     CONNECTION_LOCK(c);
-    if ( needle.o_upstream_msgid == 0 ) {
+    if ( msgid == 0 ) {
         return handle_unsolicited( c, ber );
-    } else if ( !( op = ldap_tavl_find(
-                           c->c_ops, &needle, operation_upstream_cmp ) ) ) {
+    } else if ( !( op = operation_upstream_find( c, msgid ) ) ) {
         /* Already abandoned, do nothing */
         CONNECTION_UNLOCK(c);
         ber_free( ber, 1 );
@@ -255,12 +279,25 @@ handle_one_response( LloadConnection *c )
         gettimeofday( &tv, NULL );
         if ( !timerisset( &op->o_last_response ) ) {
             LloadBackend *b = c->c_backend;
+            int stat_type = op->o_tag == LDAP_REQ_BIND ?
+                    LLOAD_STATS_OPS_BIND :
+                    LLOAD_STATS_OPS_OTHER;
+
+            lload_histogram_add( &b->b_histograms[lload_histogram_slot()]
+                                                  [stat_type]
+                                                  [LLOAD_HISTOGRAM_UPSTREAM],
+                    &op->o_forwarded );
 
             timersub( &tv, &op->o_start, &tvdiff );
             diff = 1000000 * tvdiff.tv_sec + tvdiff.tv_usec;
 
             __atomic_add_fetch( &b->b_operation_count, 1, __ATOMIC_RELAXED );
             __atomic_add_fetch( &b->b_operation_time, diff, __ATOMIC_RELAXED );
+            __atomic_add_fetch( &b->b_pool_count, 1, __ATOMIC_RELAXED );
+            __atomic_add_fetch( &b->b_pool_time, diff, __ATOMIC_RELAXED );
+            if ( b->b_tier->t_type.tier_observe ) {
+                b->b_tier->t_type.tier_observe( b->b_tier, b, op, diff );
+            }
         }
         op->o_last_response = tv;
 
@@ -274,7 +311,7 @@ handle_one_response( LloadConnection *c )
                 "upstream connid=%lu, %s, msgid=%d not for a pending "
                 "operation\n",
                 c->c_connid, lload_msgtype2str( tag ),
-                needle.o_upstream_msgid );
+                msgid );
     }
 
     if ( handler ) {
@@ -663,11 +700,11 @@ upstream_finish( LloadConnection *c )
 #ifdef LDAP_API_FEATURE_VERIFY_CREDENTIALS
             !(lload_features & LLOAD_FEATURE_VC) &&
 #endif /* LDAP_API_FEATURE_VERIFY_CREDENTIALS */
-            b->b_active && b->b_numbindconns ) {
+            b->b_active && backend_numbindconns( b ) ) {
         if ( !b->b_bindavail ) {
             is_bindconn = 1;
-        } else if ( b->b_active >= b->b_numconns &&
-                b->b_bindavail < b->b_numbindconns ) {
+        } else if ( b->b_active >= backend_numconns( b ) &&
+                b->b_bindavail < backend_numbindconns( b ) ) {
             is_bindconn = 1;
         }
     }
@@ -1074,6 +1111,7 @@ upstream_unlink( LloadConnection *c )
 
     root = c->c_ops;
     c->c_ops = NULL;
+    operation_upstream_index_free( c );
     executing = c->c_n_ops_executing;
     c->c_n_ops_executing = 0;
 
@@ -1130,7 +1168,7 @@ upstream_unlink( LloadConnection *c )
         LDAP_CIRCLEQ_REMOVE( &b->b_conns, c, c_next );
         b->b_active--;
     }
-    b->b_n_ops_executing -= executing;
+    __atomic_sub_fetch( &b->b_n_ops_executing, executing, __ATOMIC_RELAXED );
     backend_retry( b );
     checked_unlock( &b->b_mutex );
 
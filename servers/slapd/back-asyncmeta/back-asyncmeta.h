@@ -85,6 +85,38 @@ struct a_metatarget_t;
 #define	META_BINDING			((ber_tag_t)0x2)
 #define	META_RETRYING			((ber_tag_t)0x4)
 
+/* State of a sorted search merged across targets, see merge.c */
+typedef struct a_metamerge_entry_t {
+	LDAP_STAILQ_ENTRY(a_metamerge_entry_t) me_next;
+	Entry			*me_entry;
+	LDAPControl		**me_ctrls;
+	struct berval		me_vals[1];	/* one per key, points into me_entry */
+} a_metamerge_entry_t;
+
+typedef struct a_metamerge_target_t {
+	LDAP_STAILQ_HEAD(, a_metamerge_entry_t) mmt_queue;
+	struct berval		mmt_cookie;	/* set while the next page is due */
+} a_metamerge_target_t;
+
+typedef struct a_metamerge_key_t {
+	AttributeDescription	*mk_ad;
+	MatchingRule		*mk_ordering;
+	int			mk_direction;
+} a_metamerge_key_t;
+
+typedef struct a_metamerge_t {
+	int			mm_ntargets;
+	ber_int_t		mm_pagesize;
+	ber_int_t		mm_sortresult;	/* first failure reported by a target */
+	a_metamerge_target_t	*mm_targets;
+	int			mm_nkeys;
+	a_metamerge_key_t	mm_keys[1];
+} a_metamerge_t;
+
+/* asyncmeta_merge_flush() flags */
+#define META_MERGE_DRAIN	0x01	/* the final result follows */
+#define META_MERGE_LOCKED	0x02	/* mc_om_mutex is held */
+
 typedef struct bm_context_t {
 	LDAP_STAILQ_ENTRY(bm_context_t) bc_next;
 	struct a_metaconn_t *bc_mc;
@@ -106,6 +138,7 @@ typedef struct bm_context_t {
 	int                     *nretries;  /* number of times to retry a failed send on an msc */
 	struct berval	        c_peer_name; /* peer name of original op->o_conn*/
 	SlapReply               *candidates;
+	a_metamerge_t           *bc_merge;  /* sorted search merged across targets */
 } bm_context_t;
 
 typedef struct a_metasingleconn_t {
@@ -337,14 +370,11 @@ typedef struct a_metatarget_t {
 	int			mt_timeout_ops;
 } a_metatarget_t;
 
-typedef struct a_metadncache_t {
-	ldap_pvt_thread_mutex_t mutex;
-	Avlnode			*tree;
+/* the dn cache is shared with back-meta, see back-ldap/dncache.c */
+typedef ldap_dncache_t a_metadncache_t;
 
 #define META_DNCACHE_DISABLED   (0)
 #define META_DNCACHE_FOREVER    ((time_t)(-1))
-	time_t			ttl;  /* seconds; 0: no cache, -1: no expiry */
-} a_metadncache_t;
 
 typedef struct a_metacandidates_t {
 	int			mc_ntargets;
@@ -420,6 +450,7 @@ typedef struct a_metainfo_t {
 	int                    mi_max_timeout_ops;
 	int                    mi_max_pending_ops;
 	int                    mi_max_target_conns;
+	int                    mi_sort_merge; /* page size, 0 disables merging */
 	/* mutex for access to the connection structures */
 	ldap_pvt_thread_mutex_t	mi_mc_mutex;
 	int                    mi_num_conns;
@@ -535,39 +566,8 @@ asyncmeta_clear_unused_candidates(
 	a_metaconn_t            *mc,
 	SlapReply	*candidates);
 
-/*
- * Dn cache stuff (experimental)
- */
-extern int
-asyncmeta_dncache_cmp(
-	const void		*c1,
-	const void		*c2 );
-
-extern int
-asyncmeta_dncache_dup(
-	void			*c1,
-	void			*c2 );
-
 #define META_TARGET_NONE	(-1)
 #define META_TARGET_MULTIPLE	(-2)
-extern int
-asyncmeta_dncache_get_target(
-	a_metadncache_t		*cache,
-	struct berval		*ndn );
-
-extern int
-meta_dncache_update_entry(
-	a_metadncache_t		*cache,
-	struct berval		*ndn,
-	int			target );
-
-extern int
-asyncmeta_dncache_delete_entry(
-	a_metadncache_t		*cache,
-	struct berval		*ndn );
-
-extern void
-asyncmeta_dncache_free( void *entry );
 
 extern int
 asyncmeta_subtree_destroy( a_metasubtree_t *ms );
@@ -746,11 +746,6 @@ void asyncmeta_log_conns(a_metainfo_t *mi);
 
 void asyncmeta_get_timestamp(char *buf);
 
-int
-asyncmeta_dncache_update_entry(a_metadncache_t	*cache,
-			       struct berval	*ndn,
-			       int 		target );
-
 void
 asyncmeta_dnattr_result_rewrite(a_dncookie		*dc,
 				BerVarray		a_vals);
@@ -777,6 +772,30 @@ asyncmeta_db_has_pending_ops(a_metainfo_t *mi);
 int
 asyncmeta_db_has_mscs(a_metainfo_t *mi);
 
+int
+asyncmeta_merge_init(Operation *op, SlapReply *rs, bm_context_t *bc, a_metainfo_t *mi);
+
+void
+asyncmeta_merge_free(bm_context_t *bc);
+
+char **
+asyncmeta_merge_attrs(Operation *op, bm_context_t *bc, char **attrs);
+
+int
+asyncmeta_merge_entry(Operation *op, SlapReply *rs, bm_context_t *bc, int candidate);
+
+void
+asyncmeta_merge_page(bm_context_t *bc, int candidate, struct berval *cookie);
+
+void
+asyncmeta_merge_result(bm_context_t *bc, LDAPControl **ctrls);
+
+int
+asyncmeta_merge_flush(Operation *op, SlapReply *rs, a_metaconn_t *mc, bm_context_t *bc, int flags);
+
+LDAPControl **
+asyncmeta_merge_response(Operation *op, bm_context_t *bc);
+
 /* The the maximum time in seconds after a result has been received on a connection,
  * after which it can be reset if a sender error occurs. Should this be configurable? */
 #define META_BACK_RESULT_INTERVAL (2)
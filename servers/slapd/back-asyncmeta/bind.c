@@ -483,7 +483,7 @@ cache_refresh:;
 	if ( mi->mi_cache.ttl != META_DNCACHE_DISABLED
 			&& !BER_BVISEMPTY( &op->o_req_ndn ) )
 	{
-		( void )asyncmeta_dncache_update_entry( &mi->mi_cache,
+		( void )mi->mi_ldap_extra->dncache_update_entry( &mi->mi_cache,
 				&op->o_req_ndn, candidate );
 	}
 
@@ -52,6 +52,7 @@ static ConfigCfAdd asyncmeta_cfadd;
 /* Base attrs */
 enum {
 	LDAP_BACK_CFG_DNCACHE_TTL = 1,
+	LDAP_BACK_CFG_DNCACHE_SIZE,
 	LDAP_BACK_CFG_IDLE_TIMEOUT,
 	LDAP_BACK_CFG_ONERR,
 	LDAP_BACK_CFG_PSEUDOROOT_BIND_DEFER,
@@ -59,6 +60,7 @@ enum {
 	LDAP_BACK_CFG_MAX_TIMEOUT_OPS,
 	LDAP_BACK_CFG_MAX_PENDING_OPS,
 	LDAP_BACK_CFG_MAX_TARGET_CONNS,
+	LDAP_BACK_CFG_SORT_MERGE,
 	LDAP_BACK_CFG_LAST_BASE,
 };
 
@@ -282,6 +284,15 @@ static ConfigTable a_metacfg[] = {
 			"SYNTAX OMsDirectoryString "
 			"SINGLE-VALUE )",
 		NULL, NULL },
+	{ "dncache-size", "<n>", 2, 2, 0,
+		ARG_MAGIC|ARG_UINT|LDAP_BACK_CFG_DNCACHE_SIZE,
+		asyncmeta_back_cf_gen, "( OLcfgDbAt:3.119 "
+			"NAME 'olcDbDnCacheSize' "
+			"DESC 'Max number of entries in the dncache' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger "
+			"SINGLE-VALUE )",
+		NULL, NULL },
 	{ "bind-timeout", "microseconds", 2, 2, 0,
 		ARG_MAGIC|ARG_ULONG|LDAP_BACK_CFG_BIND_TIMEOUT,
 		asyncmeta_back_cf_gen, "( OLcfgDbAt:3.107 "
@@ -387,6 +398,15 @@ static ConfigTable a_metacfg[] = {
 	  "SINGLE-VALUE )",
 	  NULL, NULL },
 
+	{ "sort-merge", "<size>", 2, 2, 0,
+	  ARG_MAGIC|ARG_INT|LDAP_BACK_CFG_SORT_MERGE,
+	  asyncmeta_back_cf_gen, "( OLcfgDbAt:3.118 "
+	  "NAME 'olcDbSortMerge' "
+	  "DESC 'Page size used to merge sorted results from several targets' "
+	  "SYNTAX OMsInteger "
+	  "SINGLE-VALUE )",
+	  NULL, NULL },
+
 	{ NULL, NULL, 0, 0, 0, ARG_IGNORED,
 		NULL, NULL, NULL, NULL }
 };
@@ -420,6 +440,7 @@ static ConfigOCs a_metaocs[] = {
 		"DESC 'Asyncmeta backend configuration' "
 		"SUP olcDatabaseConfig "
 		"MAY ( olcDbDnCacheTtl "
+			"$ olcDbDnCacheSize "
 			"$ olcDbIdleTimeout "
 			"$ olcDbOnErr "
 			"$ olcDbPseudoRootBindDefer "
@@ -427,6 +448,7 @@ static ConfigOCs a_metaocs[] = {
 	                "$ olcDbMaxTimeoutOps"
 	                "$ olcDbMaxPendingOps "
 	                "$ olcDbMaxTargetConns"
+	                "$ olcDbSortMerge "
 			/* defaults, may be overridden per-target */
 			COMMON_ATTRS
 		") )",
@@ -1078,6 +1100,13 @@ asyncmeta_back_cf_gen( ConfigArgs *c )
 			value_add_one( &c->rvalue_vals, &bv );
 			break;
 
+		case LDAP_BACK_CFG_DNCACHE_SIZE:
+			if ( mi->mi_cache.size == 0 ) {
+				return 1;
+			}
+			c->value_uint = mi->mi_cache.size;
+			break;
+
 		case LDAP_BACK_CFG_IDLE_TIMEOUT:
 			if ( mi->mi_idle_timeout == 0 ) {
 				return 1;
@@ -1533,6 +1562,14 @@ asyncmeta_back_cf_gen( ConfigArgs *c )
 			c->value_int = mi->mi_max_timeout_ops;
 			break;
 
+		case LDAP_BACK_CFG_SORT_MERGE:
+			if ( mi->mi_sort_merge == 0 ) {
+				rc = 1;
+			} else {
+				c->value_int = mi->mi_sort_merge;
+			}
+			break;
+
 		case LDAP_BACK_CFG_KEEPALIVE: {
 				struct berval bv;
 				char buf[AC_LINE_MAX];
@@ -1559,6 +1596,10 @@ asyncmeta_back_cf_gen( ConfigArgs *c )
 			mi->mi_cache.ttl = META_DNCACHE_DISABLED;
 			break;
 
+		case LDAP_BACK_CFG_DNCACHE_SIZE:
+			mi->mi_cache.size = 0;
+			break;
+
 		case LDAP_BACK_CFG_IDLE_TIMEOUT:
 			mi->mi_idle_timeout = 0;
 			break;
@@ -1822,6 +1863,10 @@ asyncmeta_back_cf_gen( ConfigArgs *c )
 			mi->mi_max_timeout_ops = 0;
 			break;
 
+		case LDAP_BACK_CFG_SORT_MERGE:
+			mi->mi_sort_merge = 0;
+			break;
+
 		case LDAP_BACK_CFG_KEEPALIVE:
 			if ( asyncmeta_db_has_mscs ( mi ) > 0 ) {
 				snprintf( c->cr_msg, sizeof( c->cr_msg ),
@@ -2128,6 +2173,15 @@ asyncmeta_back_cf_gen( ConfigArgs *c )
 		}
 		mi->mi_max_timeout_ops = c->value_int;
 		break;
+	case LDAP_BACK_CFG_SORT_MERGE:
+		if (c->value_int < 0) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg ),
+				  "sort-merge invalid value %d",
+				  c->value_int);
+			return 1;
+		}
+		mi->mi_sort_merge = c->value_int;
+		break;
 
 	case LDAP_BACK_CFG_DEFAULT_T:
 	/* default target directive */
@@ -2191,6 +2245,11 @@ asyncmeta_back_cf_gen( ConfigArgs *c )
 		}
 		break;
 
+	case LDAP_BACK_CFG_DNCACHE_SIZE:
+	/* max number of entries in dn cache; 0 means no limit */
+		mi->mi_cache.size = c->value_uint;
+		break;
+
 	case LDAP_BACK_CFG_NETWORK_TIMEOUT: {
 	/* network timeout when connecting to ldap servers */
 		unsigned long t;
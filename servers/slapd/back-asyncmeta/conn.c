@@ -678,7 +678,8 @@ asyncmeta_getconn(
 	 * looks in cache, if any
 	 */
 	if ( mi->mi_cache.ttl != META_DNCACHE_DISABLED ) {
-		cached = i = asyncmeta_dncache_get_target( &mi->mi_cache, &op->o_req_ndn );
+		cached = i = mi->mi_ldap_extra->dncache_get_target( &mi->mi_cache,
+			&op->o_req_ndn );
 	}
 
 	if ( op_type == META_OP_REQUIRE_SINGLE ) {
@@ -143,8 +143,6 @@ asyncmeta_back_db_init(
 	mi->mi_rebind_f = asyncmeta_back_default_rebind;
 	mi->mi_urllist_f = asyncmeta_back_default_urllist;
 
-	ldap_pvt_thread_mutex_init( &mi->mi_cache.mutex );
-
 	/* safe default */
 	mi->mi_nretries = META_RETRY_DEFAULT;
 	mi->mi_version = LDAP_VERSION3;
@@ -160,6 +158,8 @@ asyncmeta_back_db_init(
 	mi->mi_conn_priv_max = LDAP_BACK_CONN_PRIV_DEFAULT;
 
 	mi->mi_ldap_extra = (ldap_extra_t *)bi->bi_extra;
+	mi->mi_ldap_extra->dncache_init( &mi->mi_cache );
+	(void)mi->mi_ldap_extra->dncache_monitor_db_init( be );
 	ldap_pvt_thread_mutex_init( &mi->mi_mc_mutex);
 
 	be->be_private = mi;
@@ -281,6 +281,10 @@ asyncmeta_back_db_open(
 							asyncmeta_timeout_loop, mi, "asyncmeta_timeout_loop", mi->mi_suffix.bv_val );
 		ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
 	}
+
+	/* monitor setup */
+	(void)mi->mi_ldap_extra->dncache_monitor_db_open( be, &mi->mi_cache );
+
 	return 0;
 }
 
@@ -403,6 +407,8 @@ asyncmeta_back_db_close(
 		ldap_pvt_thread_mutex_lock( &mi->mi_mc_mutex );
 		asyncmeta_back_stop_miconns( mi );
 		ldap_pvt_thread_mutex_unlock( &mi->mi_mc_mutex );
+
+		(void)mi->mi_ldap_extra->dncache_monitor_db_close( be, &mi->mi_cache );
 	}
 	return 0;
 }
@@ -441,13 +447,7 @@ asyncmeta_back_db_destroy(
 			free( mi->mi_targets );
 		}
 
-		ldap_pvt_thread_mutex_lock( &mi->mi_cache.mutex );
-		if ( mi->mi_cache.tree ) {
-			ldap_avl_free( mi->mi_cache.tree, asyncmeta_dncache_free );
-		}
-
-		ldap_pvt_thread_mutex_unlock( &mi->mi_cache.mutex );
-		ldap_pvt_thread_mutex_destroy( &mi->mi_cache.mutex );
+		mi->mi_ldap_extra->dncache_destroy( &mi->mi_cache );
 
 		if ( mi->mi_candidates != NULL ) {
 			ber_memfree_x( mi->mi_candidates, NULL );
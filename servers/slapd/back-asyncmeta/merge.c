@@ -0,0 +1,620 @@
+/* merge.c - merging of sorted search results for back-asyncmeta */
+/* $OpenLDAP$ */
+/* This work is part of OpenLDAP Software <http://www.openldap.org/>.
+ *
+ * Copyright 2016-2022 The OpenLDAP Foundation.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in the file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+
+#include "portable.h"
+
+#include <stdio.h>
+#include <ac/string.h>
+
+#include "slap.h"
+#include "../back-ldap/back-ldap.h"
+#include "back-asyncmeta.h"
+
+/*
+ * When a search carrying a server side sort control (RFC 2891) spans more
+ * than one target, each target sorts its own part of the result but simply
+ * relaying the entries as they arrive would interleave them. With sort-merge
+ * configured, the targets are asked for their results in pages of that size
+ * and the entries are kept in a queue per target. The smallest head is sent
+ * whenever every target that may still return entries has one queued, a
+ * target only gets asked for its next page once its queue has been drained.
+ * At most (number of targets * page size) entries are held at any time.
+ */
+
+#define LDAP_MATCHRULE_IDENTIFIER      0x80L
+#define LDAP_REVERSEORDER_IDENTIFIER   0x81L
+
+static int
+asyncmeta_merge_key(
+	BerElement		*ber,
+	a_metamerge_key_t	*key )
+{
+	struct berval	attr, matchrule = BER_BVNULL;
+	ber_int_t	reverse = 0;
+	ber_tag_t	tag;
+	ber_len_t	len;
+	const char	*text;
+
+	if ( ber_scanf( ber, "{m", &attr ) == LBER_ERROR ) {
+		return -1;
+	}
+
+	tag = ber_peek_tag( ber, &len );
+	if ( tag == LDAP_MATCHRULE_IDENTIFIER ) {
+		if ( ber_scanf( ber, "m", &matchrule ) == LBER_ERROR ) {
+			return -1;
+		}
+		tag = ber_peek_tag( ber, &len );
+	}
+
+	if ( tag == LDAP_REVERSEORDER_IDENTIFIER ) {
+		if ( ber_scanf( ber, "b", &reverse ) == LBER_ERROR ) {
+			return -1;
+		}
+	}
+
+	if ( ber_scanf( ber, "}" ) == LBER_ERROR ) {
+		return -1;
+	}
+
+	key->mk_ad = NULL;
+	if ( slap_bv2ad( &attr, &key->mk_ad, &text ) != LDAP_SUCCESS ) {
+		return -1;
+	}
+
+	if ( !BER_BVISNULL( &matchrule ) ) {
+		key->mk_ordering = mr_find( matchrule.bv_val );
+	} else {
+		key->mk_ordering = key->mk_ad->ad_type->sat_ordering;
+	}
+	if ( key->mk_ordering == NULL ) {
+		return -1;
+	}
+	key->mk_direction = reverse ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * Set up the merge if op asks for sorted results and may be answered by
+ * more than one target. If the sort keys are something we cannot compare
+ * ourselves, the results are relayed unmerged as before.
+ *
+ * A merged result is always returned in full, we would have to keep every
+ * target's position across the client's requests to page through it. A
+ * critical pagedResults control makes us refuse the search, rs is set up
+ * for the caller to send in that case.
+ */
+int
+asyncmeta_merge_init(
+	Operation	*op,
+	SlapReply	*rs,
+	bm_context_t	*bc,
+	a_metainfo_t	*mi )
+{
+	a_metamerge_t	*mm;
+	LDAPControl	*ctrl;
+	BerElementBuffer berbuf;
+	BerElement	*ber = (BerElement *)&berbuf;
+	struct berval	value;
+	ber_tag_t	tag;
+	ber_len_t	len;
+	char		*last;
+	int		i, nkeys = 0, ncandidates = 0;
+
+	if ( mi->mi_sort_merge <= 0 || op->o_ctrls == NULL ) {
+		return LDAP_SUCCESS;
+	}
+
+	ctrl = ldap_control_find( LDAP_CONTROL_SORTREQUEST, op->o_ctrls, NULL );
+	if ( ctrl == NULL || BER_BVISNULL( &ctrl->ldctl_value ) ) {
+		return LDAP_SUCCESS;
+	}
+
+	for ( i = 0; i < mi->mi_ntargets; i++ ) {
+		if ( META_IS_CANDIDATE( &bc->candidates[ i ] ) ) {
+			ncandidates++;
+		}
+	}
+	if ( ncandidates < 2 ) {
+		return LDAP_SUCCESS;
+	}
+
+	ber_init2( ber, &ctrl->ldctl_value, 0 );
+	for ( tag = ber_first_element( ber, &len, &last );
+		tag != LBER_DEFAULT;
+		tag = ber_next_element( ber, &len, last ) )
+	{
+		if ( ber_skip_tag( ber, &len ) == LBER_DEFAULT ) {
+			return LDAP_SUCCESS;
+		}
+		ber_skip_data( ber, len );
+		nkeys++;
+	}
+	if ( nkeys == 0 ) {
+		return LDAP_SUCCESS;
+	}
+
+	mm = ch_calloc( 1, sizeof( a_metamerge_t ) +
+		( nkeys - 1 ) * sizeof( a_metamerge_key_t ) );
+	mm->mm_nkeys = nkeys;
+
+	/* Decoding terminates the strings in place, the control still has
+	 * to be sent to the targets intact */
+	ber_dupbv_x( &value, &ctrl->ldctl_value, op->o_tmpmemctx );
+	ber_init2( ber, &value, 0 );
+	if ( ber_scanf( ber, "{" ) == LBER_ERROR ) {
+		goto fail;
+	}
+	for ( i = 0; i < nkeys; i++ ) {
+		if ( asyncmeta_merge_key( ber, &mm->mm_keys[ i ] ) ) {
+			goto fail;
+		}
+	}
+	op->o_tmpfree( value.bv_val, op->o_tmpmemctx );
+
+	if ( get_pagedresults( op ) == SLAP_CONTROL_CRITICAL ) {
+		Debug( LDAP_DEBUG_TRACE, "%s asyncmeta_merge_init: "
+			"critical pagedResults control on a merged search\n",
+			op->o_log_prefix );
+		ch_free( mm );
+		rs->sr_err = LDAP_UNAVAILABLE_CRITICAL_EXTENSION;
+		rs->sr_text = "paged results are not supported on merged sorted searches";
+		return rs->sr_err;
+	}
+
+	mm->mm_ntargets = mi->mi_ntargets;
+	mm->mm_pagesize = mi->mi_sort_merge;
+	mm->mm_sortresult = LDAP_SUCCESS;
+	mm->mm_targets = ch_calloc( mm->mm_ntargets,
+		sizeof( a_metamerge_target_t ) );
+	for ( i = 0; i < mm->mm_ntargets; i++ ) {
+		LDAP_STAILQ_INIT( &mm->mm_targets[ i ].mmt_queue );
+	}
+
+	bc->bc_merge = mm;
+	return LDAP_SUCCESS;
+
+fail:
+	Debug( LDAP_DEBUG_TRACE, "%s asyncmeta_merge_init: "
+		"cannot handle sort keys, results will not be merged\n",
+		op->o_log_prefix );
+	op->o_tmpfree( value.bv_val, op->o_tmpmemctx );
+	ch_free( mm );
+	return LDAP_SUCCESS;
+}
+
+static void
+asyncmeta_merge_entry_free( a_metamerge_entry_t *me )
+{
+	if ( me->me_ctrls ) {
+		ldap_controls_free( me->me_ctrls );
+	}
+	entry_free( me->me_entry );
+	ch_free( me );
+}
+
+void
+asyncmeta_merge_free( bm_context_t *bc )
+{
+	a_metamerge_t	*mm = bc->bc_merge;
+	a_metamerge_entry_t *me;
+	int		i;
+
+	if ( mm == NULL ) {
+		return;
+	}
+
+	for ( i = 0; i < mm->mm_ntargets; i++ ) {
+		a_metamerge_target_t *mmt = &mm->mm_targets[ i ];
+
+		while ( ( me = LDAP_STAILQ_FIRST( &mmt->mmt_queue ) ) ) {
+			LDAP_STAILQ_REMOVE_HEAD( &mmt->mmt_queue, me_next );
+			asyncmeta_merge_entry_free( me );
+		}
+		if ( !BER_BVISNULL( &mmt->mmt_cookie ) ) {
+			ch_free( mmt->mmt_cookie.bv_val );
+		}
+	}
+	ch_free( mm->mm_targets );
+	ch_free( mm );
+	bc->bc_merge = NULL;
+}
+
+/* Whether the entries returned by the target will carry ad */
+static int
+asyncmeta_merge_requested( Operation *op, AttributeDescription *ad )
+{
+	if ( op->ors_attrs == NULL ) {
+		return !is_at_operational( ad->ad_type );
+	}
+
+	if ( is_at_operational( ad->ad_type ) ) {
+		if ( an_find( op->ors_attrs, slap_bv_all_operational_attrs ) ) {
+			return 1;
+		}
+	} else if ( an_find( op->ors_attrs, slap_bv_all_user_attrs ) ) {
+		return 1;
+	}
+
+	return ad_inlist( ad, op->ors_attrs );
+}
+
+/*
+ * The sort keys have to be in the entries we get back even if the client did
+ * not ask for them, send_search_entry() filters them out again.
+ */
+char **
+asyncmeta_merge_attrs( Operation *op, bm_context_t *bc, char **attrs )
+{
+	a_metamerge_t	*mm = bc->bc_merge;
+	char		**nattrs;
+	int		i, n = 0, missing = 0;
+
+	for ( i = 0; i < mm->mm_nkeys; i++ ) {
+		if ( !asyncmeta_merge_requested( op, mm->mm_keys[ i ].mk_ad ) ) {
+			missing++;
+		}
+	}
+	if ( !missing ) {
+		return attrs;
+	}
+
+	if ( attrs ) {
+		for ( ; attrs[ n ]; n++ )
+			/* count */ ;
+	}
+
+	nattrs = op->o_tmpalloc( ( n + missing + 2 ) * sizeof( char * ),
+		op->o_tmpmemctx );
+	if ( attrs ) {
+		AC_MEMCPY( nattrs, attrs, n * sizeof( char * ) );
+		op->o_tmpfree( attrs, op->o_tmpmemctx );
+	} else {
+		/* no list meant all user attributes */
+		nattrs[ n++ ] = LDAP_ALL_USER_ATTRIBUTES;
+	}
+	for ( i = 0; i < mm->mm_nkeys; i++ ) {
+		AttributeDescription *ad = mm->mm_keys[ i ].mk_ad;
+
+		if ( !asyncmeta_merge_requested( op, ad ) ) {
+			nattrs[ n++ ] = ad->ad_cname.bv_val;
+		}
+	}
+	nattrs[ n ] = NULL;
+
+	return nattrs;
+}
+
+/*
+ * Like the server side sort overlay, a multi-valued key is represented by its
+ * least value.
+ */
+static void
+asyncmeta_merge_select( a_metamerge_t *mm, a_metamerge_entry_t *me )
+{
+	Attribute	*a;
+	MatchingRule	*mr;
+	unsigned	j;
+	int		i, cmp;
+
+	for ( i = 0; i < mm->mm_nkeys; i++ ) {
+		a = attr_find( me->me_entry->e_attrs, mm->mm_keys[ i ].mk_ad );
+		if ( a == NULL || a->a_numvals == 0 ) {
+			BER_BVZERO( &me->me_vals[ i ] );
+			continue;
+		}
+
+		mr = mm->mm_keys[ i ].mk_ordering;
+		me->me_vals[ i ] = a->a_nvals[ 0 ];
+		for ( j = 1; j < a->a_numvals; j++ ) {
+			mr->smr_match( &cmp, 0, mr->smr_syntax, mr,
+				&me->me_vals[ i ], &a->a_nvals[ j ] );
+			if ( cmp > 0 ) {
+				me->me_vals[ i ] = a->a_nvals[ j ];
+			}
+		}
+	}
+}
+
+/* Entries without a value for a key sort after all those that have one */
+static int
+asyncmeta_merge_cmp(
+	a_metamerge_t		*mm,
+	a_metamerge_entry_t	*me1,
+	a_metamerge_entry_t	*me2 )
+{
+	MatchingRule	*mr;
+	int		i, cmp = 0;
+
+	for ( i = 0; cmp == 0 && i < mm->mm_nkeys; i++ ) {
+		if ( BER_BVISNULL( &me1->me_vals[ i ] ) ) {
+			if ( !BER_BVISNULL( &me2->me_vals[ i ] ) ) {
+				cmp = mm->mm_keys[ i ].mk_direction;
+			}
+		} else if ( BER_BVISNULL( &me2->me_vals[ i ] ) ) {
+			cmp = -mm->mm_keys[ i ].mk_direction;
+		} else {
+			mr = mm->mm_keys[ i ].mk_ordering;
+			mr->smr_match( &cmp, 0, mr->smr_syntax, mr,
+				&me1->me_vals[ i ], &me2->me_vals[ i ] );
+			cmp *= mm->mm_keys[ i ].mk_direction;
+		}
+	}
+
+	return cmp;
+}
+
+/*
+ * Queue the entry in rs->sr_entry that came from candidate, the entry
+ * itself is only valid until we return, its controls are taken over.
+ */
+int
+asyncmeta_merge_entry(
+	Operation	*op,
+	SlapReply	*rs,
+	bm_context_t	*bc,
+	int		candidate )
+{
+	a_metamerge_t	*mm = bc->bc_merge;
+	a_metamerge_entry_t *me;
+
+	me = ch_malloc( sizeof( a_metamerge_entry_t ) +
+		( mm->mm_nkeys - 1 ) * sizeof( struct berval ) );
+	me->me_entry = entry_dup( rs->sr_entry );
+	me->me_ctrls = rs->sr_ctrls;
+	rs->sr_ctrls = NULL;
+	asyncmeta_merge_select( mm, me );
+
+	LDAP_STAILQ_INSERT_TAIL( &mm->mm_targets[ candidate ].mmt_queue,
+		me, me_next );
+
+	return LDAP_SUCCESS;
+}
+
+/*
+ * Candidate is done with the current page and there are more to come, they
+ * will be asked for once everything we have from it has been sent.
+ */
+void
+asyncmeta_merge_page( bm_context_t *bc, int candidate, struct berval *cookie )
+{
+	a_metamerge_target_t *mmt = &bc->bc_merge->mm_targets[ candidate ];
+
+	assert( BER_BVISNULL( &mmt->mmt_cookie ) );
+	ber_dupbv( &mmt->mmt_cookie, cookie );
+}
+
+/*
+ * Look at the response controls of a target's final result. If it could not
+ * sort, the order we send entries in is only partially correct and the
+ * client is told.
+ */
+void
+asyncmeta_merge_result( bm_context_t *bc, LDAPControl **ctrls )
+{
+	a_metamerge_t	*mm = bc->bc_merge;
+	LDAPControl	*ctrl;
+	BerElementBuffer berbuf;
+	BerElement	*ber = (BerElement *)&berbuf;
+	ber_int_t	result;
+
+	if ( ctrls == NULL || mm->mm_sortresult != LDAP_SUCCESS ) {
+		return;
+	}
+
+	ctrl = ldap_control_find( LDAP_CONTROL_SORTRESPONSE, ctrls, NULL );
+	if ( ctrl == NULL ) {
+		return;
+	}
+
+	ber_init2( ber, &ctrl->ldctl_value, 0 );
+	if ( ber_scanf( ber, "{e", &result ) == LBER_ERROR ) {
+		result = LDAP_OTHER;
+	}
+	mm->mm_sortresult = result;
+}
+
+/*
+ * Ask candidate for its next page, if that fails it's treated like any
+ * other target that stopped returning results.
+ */
+static int
+asyncmeta_merge_next_page(
+	Operation	*op,
+	SlapReply	*rs,
+	a_metaconn_t	*mc,
+	bm_context_t	*bc,
+	int		candidate,
+	int		do_lock )
+{
+	a_metamerge_target_t *mmt = &bc->bc_merge->mm_targets[ candidate ];
+	SlapReply	*candidates = bc->candidates;
+	struct berval	cookie = mmt->mmt_cookie;
+	int		save_err = rs->sr_err;
+	const char	*save_text = rs->sr_text;
+	int		rc = 1;
+
+	BER_BVZERO( &mmt->mmt_cookie );
+	candidates[ candidate ].sr_nentries = 0;
+
+	switch ( asyncmeta_back_search_start( op, rs, mc, bc, candidate,
+		&cookie, 0, do_lock ) )
+	{
+	case META_SEARCH_CANDIDATE:
+		assert( candidates[ candidate ].sr_msgid >= 0 );
+		break;
+
+	default:
+		Debug( LDAP_DEBUG_ANY, "%s asyncmeta_merge_next_page[%d]: "
+			"could not request the next page\n",
+			op->o_log_prefix, candidate );
+		candidates[ candidate ].sr_err = rs->sr_err != LDAP_SUCCESS ?
+			rs->sr_err : LDAP_OTHER;
+		candidates[ candidate ].sr_msgid = META_MSGID_IGNORE;
+		candidates[ candidate ].sr_type = REP_RESULT;
+		rc = 0;
+		break;
+	}
+
+	ch_free( cookie.bv_val );
+	rs->sr_err = save_err;
+	rs->sr_text = save_text;
+	return rc;
+}
+
+/*
+ * Send as many queued entries as the ordering allows, requesting the next
+ * page from targets that have run dry. Returns LDAP_SIZELIMIT_EXCEEDED if the
+ * caller has to finish the operation.
+ *
+ * With META_MERGE_DRAIN the final result is about to be sent, whatever is
+ * still queued goes out in order without waiting for the targets that have
+ * not finished and no more pages are requested. META_MERGE_LOCKED tells us
+ * the caller holds mc_om_mutex.
+ */
+int
+asyncmeta_merge_flush(
+	Operation	*op,
+	SlapReply	*rs,
+	a_metaconn_t	*mc,
+	bm_context_t	*bc,
+	int		flags )
+{
+	a_metamerge_t	*mm = bc->bc_merge;
+	a_metainfo_t	*mi = mc->mc_info;
+	SlapReply	*candidates = bc->candidates;
+	a_metamerge_entry_t *me, *min;
+	int		i, target, blocked, rc;
+
+	/* Nobody left to send them to, asyncmeta_clear_bm_context() will
+	 * release what we have, just don't ask for more */
+	if ( bc->c_peer_name.bv_val != op->o_conn->c_peer_name.bv_val ||
+		bc->op->o_abandon )
+	{
+		for ( i = 0; i < mm->mm_ntargets; i++ ) {
+			a_metamerge_target_t *mmt = &mm->mm_targets[ i ];
+
+			if ( !BER_BVISNULL( &mmt->mmt_cookie ) ) {
+				ch_free( mmt->mmt_cookie.bv_val );
+				BER_BVZERO( &mmt->mmt_cookie );
+				candidates[ i ].sr_type = REP_RESULT;
+			}
+		}
+		return LDAP_SUCCESS;
+	}
+
+	for ( ;; ) {
+		min = NULL;
+		target = -1;
+		blocked = 0;
+
+		for ( i = 0; i < mm->mm_ntargets; i++ ) {
+			a_metamerge_target_t *mmt = &mm->mm_targets[ i ];
+
+			me = LDAP_STAILQ_FIRST( &mmt->mmt_queue );
+			if ( me == NULL ) {
+				if ( flags & META_MERGE_DRAIN ) {
+					continue;
+				}
+				if ( !BER_BVISNULL( &mmt->mmt_cookie ) &&
+					asyncmeta_merge_next_page( op, rs, mc, bc, i,
+						!( flags & META_MERGE_LOCKED ) ) )
+				{
+					blocked = 1;
+
+				} else if ( META_IS_CANDIDATE( &candidates[ i ] ) &&
+					candidates[ i ].sr_msgid != META_MSGID_IGNORE )
+				{
+					/* still searching */
+					blocked = 1;
+				}
+				continue;
+			}
+
+			if ( min == NULL || asyncmeta_merge_cmp( mm, me, min ) < 0 ) {
+				min = me;
+				target = i;
+			}
+		}
+
+		if ( blocked || min == NULL ) {
+			break;
+		}
+
+		LDAP_STAILQ_REMOVE_HEAD( &mm->mm_targets[ target ].mmt_queue, me_next );
+
+		rs->sr_entry = min->me_entry;
+		rs->sr_ctrls = min->me_ctrls;
+		rs->sr_attrs = op->ors_attrs;
+		rs->sr_operational_attrs = NULL;
+		rs->sr_flags = mi->mi_targets[ target ]->mt_rep_flags |
+			REP_ENTRY_MUSTBEFREED;
+		rs->sr_err = LDAP_SUCCESS;
+		rc = send_search_entry( op, rs );
+
+		rs_flush_entry( op, rs, NULL );
+		if ( rs->sr_ctrls != NULL ) {
+			ldap_controls_free( rs->sr_ctrls );
+			rs->sr_ctrls = NULL;
+		}
+		rs->sr_attrs = NULL;
+		ch_free( min );
+
+		if ( rc == LDAP_SIZELIMIT_EXCEEDED ) {
+			return rc;
+		}
+	}
+
+	return LDAP_SUCCESS;
+}
+
+/*
+ * The sort response control for the final result, built in op's memory
+ * context.
+ */
+LDAPControl **
+asyncmeta_merge_response( Operation *op, bm_context_t *bc )
+{
+	LDAPControl	**ctrls, *ctrl;
+	BerElementBuffer berbuf;
+	BerElement	*ber = (BerElement *)&berbuf;
+	struct berval	bv;
+
+	ber_init2( ber, NULL, LBER_USE_DER );
+	ber_set_option( ber, LBER_OPT_BER_MEMCTX, &op->o_tmpmemctx );
+
+	if ( ber_printf( ber, "{e}", bc->bc_merge->mm_sortresult ) == -1 ||
+		ber_flatten2( ber, &bv, 0 ) == -1 )
+	{
+		ber_free_buf( ber );
+		return NULL;
+	}
+
+	ctrls = op->o_tmpalloc( 2 * sizeof( LDAPControl * ) +
+		sizeof( LDAPControl ) + bv.bv_len, op->o_tmpmemctx );
+	ctrl = (LDAPControl *)&ctrls[ 2 ];
+	ctrl->ldctl_oid = LDAP_CONTROL_SORTRESPONSE;
+	ctrl->ldctl_iscritical = 0;
+	ctrl->ldctl_value.bv_val = (char *)&ctrl[ 1 ];
+	ctrl->ldctl_value.bv_len = bv.bv_len;
+	AC_MEMCPY( ctrl->ldctl_value.bv_val, bv.bv_val, bv.bv_len );
+	ctrls[ 0 ] = ctrl;
+	ctrls[ 1 ] = NULL;
+
+	ber_free_buf( ber );
+	return ctrls;
+}
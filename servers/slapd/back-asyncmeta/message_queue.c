@@ -163,6 +163,7 @@ void asyncmeta_clear_bm_context(bm_context_t *bc)
 			}
 		}
 	}
+	asyncmeta_merge_free( bc );
 
 	if (op->o_conn->c_conn_idx == -1)
 		return;
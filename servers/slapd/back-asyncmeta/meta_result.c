@@ -33,10 +33,49 @@
 #include "ldap_rq.h"
 #include "../../../libraries/liblber/lber-int.h"
 
+/*
+ * Send what the ordering of a merged search allows, see
+ * asyncmeta_merge_flush(). The entries go through rs, the result it holds is
+ * preserved.
+ */
+static int
+asyncmeta_merge_send(bm_context_t *bc, SlapReply *rs, int flags)
+{
+	int		save_err = rs->sr_err;
+	const char	*save_text = rs->sr_text;
+	const char	*save_matched = rs->sr_matched;
+	BerVarray	save_ref = rs->sr_ref;
+	LDAPControl	**save_ctrls = rs->sr_ctrls;
+	slap_mask_t	save_flags = rs->sr_flags;
+	slap_reply_t	save_type = rs->sr_type;
+	int		rc;
+
+	rs->sr_ctrls = NULL;
+	rc = asyncmeta_merge_flush( &bc->copy_op, rs, bc->bc_mc, bc, flags );
+
+	rs->sr_err = save_err;
+	rs->sr_text = save_text;
+	rs->sr_matched = save_matched;
+	rs->sr_ref = save_ref;
+	rs->sr_ctrls = save_ctrls;
+	rs->sr_flags = save_flags;
+	rs->sr_type = save_type;
+
+	return rc;
+}
+
 static void
 asyncmeta_send_ldap_result(bm_context_t *bc, Operation *op, SlapReply *rs)
 {
 	if (bc->c_peer_name.bv_val == op->o_conn->c_peer_name.bv_val && !bc->op->o_abandon ) {
+		/* Entries of a merged search that are still queued have to
+		 * go out first, whichever path got us here */
+		if ( bc->bc_merge &&
+			asyncmeta_merge_send( bc, rs, META_MERGE_DRAIN ) == LDAP_SIZELIMIT_EXCEEDED &&
+			rs->sr_err == LDAP_SUCCESS )
+		{
+			rs->sr_err = LDAP_SIZELIMIT_EXCEEDED;
+		}
 		send_ldap_result(&bc->copy_op, rs);
 		bc->op->o_callback = bc->copy_op.o_callback;
 		bc->op->o_extra = bc->copy_op.o_extra;
@@ -44,6 +83,18 @@ asyncmeta_send_ldap_result(bm_context_t *bc, Operation *op, SlapReply *rs)
 	}
 }
 
+/*
+ * A target of a merged search failed for good. Entries the others returned may
+ * have been waiting on it, send them and ask the targets that ran dry for their
+ * next page, the search goes on if there are any. Called with mc_om_mutex
+ * held, returns LDAP_SIZELIMIT_EXCEEDED if the search has to finish.
+ */
+static int
+asyncmeta_merge_resume(a_metaconn_t *mc, bm_context_t *bc)
+{
+	return asyncmeta_merge_send( bc, &bc->rs, META_MERGE_LOCKED );
+}
+
 static int
 asyncmeta_is_last_result(a_metaconn_t *mc, bm_context_t *bc, int candidate)
 {
@@ -151,6 +202,7 @@ asyncmeta_send_entry(
 	Operation 	*op,
 	SlapReply	*rs,
 	a_metaconn_t	*mc,
+	bm_context_t	*bc,
 	int 		target,
 	LDAPMessage 	*e )
 {
@@ -219,7 +271,7 @@ asyncmeta_send_entry(
 	 * cache dn
 	 */
 	if ( mi->mi_cache.ttl != META_DNCACHE_DISABLED ) {
-		( void )asyncmeta_dncache_update_entry( &mi->mi_cache,
+		( void )mi->mi_ldap_extra->dncache_update_entry( &mi->mi_cache,
 				&ent.e_nname, target );
 	}
 
@@ -447,7 +499,14 @@ next_attr:;
 	rs->sr_operational_attrs = NULL;
 	rs->sr_flags = mi->mi_targets[ target ]->mt_rep_flags;
 	rs->sr_err = LDAP_SUCCESS;
-	rc = send_search_entry( op, rs );
+	if ( bc->bc_merge ) {
+		rc = asyncmeta_merge_entry( op, rs, bc, target );
+		if ( rc == LDAP_SUCCESS ) {
+			rc = asyncmeta_merge_flush( op, rs, mc, bc, 0 );
+		}
+	} else {
+		rc = send_search_entry( op, rs );
+	}
 	switch ( rc ) {
 	case LDAP_UNAVAILABLE:
 		rc = LDAP_OTHER;
@@ -592,7 +651,14 @@ asyncmeta_search_last_result(a_metaconn_t *mc, bm_context_t *bc, int candidate,
 	rs->sr_matched = ( sres == LDAP_SUCCESS ? NULL : matched );
 	rs->sr_text =  ( sres == LDAP_SUCCESS ? NULL : candidates[candidate].sr_text );
 	rs->sr_ref = ( sres == LDAP_REFERRAL ? rs->sr_v2ref : NULL );
+	if ( bc->bc_merge ) {
+		rs->sr_ctrls = asyncmeta_merge_response( op, bc );
+	}
 	asyncmeta_send_ldap_result(bc, op, rs);
+	if ( bc->bc_merge && rs->sr_ctrls ) {
+		op->o_tmpfree( rs->sr_ctrls, op->o_tmpmemctx );
+		rs->sr_ctrls = NULL;
+	}
 	rs->sr_text = NULL;
 	rs->sr_matched = NULL;
 	rs->sr_ref = NULL;
@@ -658,6 +724,7 @@ asyncmeta_send_all_pending_ops(a_metaconn_t *mc, int candidate, void *ctx, int d
 			bc->candidates[ candidate ].sr_type = REP_RESULT;
 			bc->candidates[ candidate ].sr_err = bc->rs.sr_err;
 			if (bc->op->o_tag != LDAP_REQ_SEARCH || (META_BACK_ONERR_STOP( mi )) ||
+			    (bc->bc_merge && asyncmeta_merge_resume(mc, bc) == LDAP_SIZELIMIT_EXCEEDED) ||
 			    (asyncmeta_is_last_result(mc, bc, candidate) == 0)) {
 				LDAP_STAILQ_REMOVE(&mc->mc_om_list, bc, bm_context_t, bc_next);
 				mc->pending_ops--;
@@ -694,13 +761,14 @@ asyncmeta_return_bind_errors(a_metaconn_t *mc, int candidate, SlapReply *bind_re
 		bc->candidates[ candidate ].sr_msgid = META_MSGID_IGNORE;
 		bc->candidates[ candidate ].sr_type = REP_RESULT;
 		bc->candidates[ candidate ].sr_err = bind_result->sr_err;
+		bc->op->o_threadctx = ctx;
+		bc->op->o_tid = ldap_pvt_thread_pool_tid( ctx );
+		slap_sl_mem_setctx(ctx, bc->op->o_tmpmemctx);
+		operation_counter_init( bc->op, ctx );
 		if (bc->op->o_tag != LDAP_REQ_SEARCH || (META_BACK_ONERR_STOP( mi )) ||
+		    (bc->bc_merge && asyncmeta_merge_resume(mc, bc) == LDAP_SIZELIMIT_EXCEEDED) ||
 		    (asyncmeta_is_last_result(mc, bc, candidate) == 0)) {
 			LDAP_STAILQ_REMOVE(&mc->mc_om_list, bc, bm_context_t, bc_next);
-			bc->op->o_threadctx = ctx;
-			bc->op->o_tid = ldap_pvt_thread_pool_tid( ctx );
-			slap_sl_mem_setctx(ctx, bc->op->o_tmpmemctx);
-			operation_counter_init( bc->op, ctx );
 			bc->rs.sr_err = bind_result->sr_err;
 			bc->rs.sr_text = bind_result->sr_text;
 			mc->pending_ops--;
@@ -776,7 +844,7 @@ asyncmeta_handle_search_msg(LDAPMessage *res, a_metaconn_t *mc, bm_context_t *bc
 			/* count entries returned by target */
 			candidates[ i ].sr_nentries++;
 			if (bc->c_peer_name.bv_val == op->o_conn->c_peer_name.bv_val && !op->o_abandon) {
-				rs->sr_err = asyncmeta_send_entry( &bc->copy_op, rs, mc, i, msg );
+				rs->sr_err = asyncmeta_send_entry( &bc->copy_op, rs, mc, bc, i, msg );
 			} else {
 				goto err_cleanup;
 			}
@@ -931,6 +999,9 @@ asyncmeta_handle_search_msg(LDAPMessage *res, a_metaconn_t *mc, bm_context_t *bc
 			}
 
 			rs->sr_err = candidates[ i ].sr_err;
+			if ( bc->bc_merge ) {
+				asyncmeta_merge_result( bc, ctrls );
+			}
 
 			/* massage matchedDN if need be */
 			if ( candidates[ i ].sr_matched != NULL ) {
@@ -1056,7 +1127,7 @@ asyncmeta_handle_search_msg(LDAPMessage *res, a_metaconn_t *mc, bm_context_t *bc
 						struct berval prcookie;
 
 						/* unsolicited, do not accept */
-						if ( mt->mt_ps == 0 ) {
+						if ( mt->mt_ps == 0 && !bc->bc_merge ) {
 							rs->sr_err = LDAP_OTHER;
 							goto err_pr;
 						}
@@ -1070,7 +1141,16 @@ asyncmeta_handle_search_msg(LDAPMessage *res, a_metaconn_t *mc, bm_context_t *bc
 						}
 
 						/* more pages? new search request */
-						if ( !BER_BVISNULL( &prcookie ) && !BER_BVISEMPTY( &prcookie ) ) {
+						if ( !BER_BVISNULL( &prcookie ) && !BER_BVISEMPTY( &prcookie ) && bc->bc_merge ) {
+							/* asyncmeta_merge_flush() asks for it
+							 * once this page has been sent */
+							asyncmeta_merge_page( bc, i, &prcookie );
+							candidates[ i ].sr_msgid = META_MSGID_IGNORE;
+							candidates[ i ].sr_type = REP_INTERMEDIATE;
+							ldap_controls_free( ctrls );
+							break;
+
+						} else if ( !BER_BVISNULL( &prcookie ) && !BER_BVISEMPTY( &prcookie ) ) {
 							if ( mt->mt_ps > 0 ) {
 								/* ignore size if specified */
 								prsize = 0;
@@ -1167,6 +1247,18 @@ got_err:
 				}
 				break;
 			}
+			/* targets done with a page may let more entries through */
+			if ( bc->bc_merge ) {
+				int save_err = rs->sr_err;
+
+				if ( asyncmeta_merge_flush( &bc->copy_op, rs, mc, bc, 0 ) == LDAP_SIZELIMIT_EXCEEDED ) {
+					rs->sr_err = LDAP_SIZELIMIT_EXCEEDED;
+					asyncmeta_send_ldap_result(bc, op, rs);
+					rs->sr_err = LDAP_SUCCESS;
+					goto err_cleanup;
+				}
+				rs->sr_err = save_err;
+			}
 			/* if this is the last result we will ever receive, send it back  */
 			rc = rs->sr_err;
 			if (asyncmeta_is_last_result(mc, bc, i) == 0) {
@@ -1446,7 +1538,18 @@ asyncmeta_op_read_error(a_metaconn_t *mc, int candidate, int error, void* ctx)
 			rs->sr_text = "Read error on connection to target";
 			candidates[ candidate ].sr_msgid = META_MSGID_IGNORE;
 			candidates[ candidate ].sr_type = REP_RESULT;
-			if ( (META_BACK_ONERR_STOP( mi ) ||
+			if ( bc->bc_merge && !META_BACK_ONERR_STOP( mi ) ) {
+				/* The other targets may still have entries to
+				 * return, only finish once they are all done */
+				if ( asyncmeta_merge_resume( mc, bc ) != LDAP_SIZELIMIT_EXCEEDED &&
+				     asyncmeta_is_last_result( mc, bc, candidate ) ) {
+					break;
+				}
+				if ( op->o_conn ) {
+					asyncmeta_send_ldap_result( bc, op, rs );
+					cleanup = 1;
+				}
+			} else if ( (META_BACK_ONERR_STOP( mi ) ||
 			      asyncmeta_is_last_result(mc, bc, candidate)) && op->o_conn) {
 				asyncmeta_send_ldap_result( bc, op, rs );
 				cleanup = 1;
@@ -446,6 +446,9 @@ asyncmeta_back_search_start(
 	asyncmeta_dn_massage( &dc, &realbase, &mbase );
 
 	attrs = anlist2charray_x( op->ors_attrs, 0, op->o_tmpmemctx );
+	if ( bc->bc_merge ) {
+		attrs = asyncmeta_merge_attrs( op, bc, attrs );
+	}
 
 	if ( op->ors_tlimit != SLAP_NO_LIMIT ) {
 		timelimit = op->ors_tlimit > 0 ? op->ors_tlimit : 1;
@@ -458,6 +461,12 @@ asyncmeta_back_search_start(
 	{
 		LDAPControl *pr_c = NULL;
 		int i = 0, nc = 0;
+		ber_int_t ps = mt->mt_ps;
+
+		/* merging sorted results always pages through the targets */
+		if ( bc->bc_merge && ps <= 0 ) {
+			ps = bc->bc_merge->mm_pagesize;
+		}
 
 		if ( save_ctrls ) {
 			for ( ; save_ctrls[i] != NULL; i++ );
@@ -466,9 +475,9 @@ asyncmeta_back_search_start(
 		}
 
 		if ( pr_c != NULL ) nc--;
-		if ( mt->mt_ps > 0 || prcookie != NULL ) nc++;
+		if ( ps > 0 || prcookie != NULL ) nc++;
 
-		if ( mt->mt_ps > 0 || prcookie != NULL || pr_c != NULL ) {
+		if ( ps > 0 || prcookie != NULL || pr_c != NULL ) {
 			int src = 0, dst = 0;
 			BerElementBuffer berbuf;
 			BerElement *ber = (BerElement *)&berbuf;
@@ -477,11 +486,11 @@ asyncmeta_back_search_start(
 
 			len = sizeof( LDAPControl * )*( nc + 1 ) + sizeof( LDAPControl );
 
-			if ( mt->mt_ps > 0 || prcookie != NULL ) {
+			if ( ps > 0 || prcookie != NULL ) {
 				struct berval nullcookie = BER_BVNULL;
 				ber_tag_t tag;
 
-				if ( prsize == 0 && mt->mt_ps > 0 ) prsize = mt->mt_ps;
+				if ( prsize == 0 && ps > 0 ) prsize = ps;
 				if ( prcookie == NULL ) prcookie = &nullcookie;
 
 				ber_init2( ber, NULL, LBER_USE_DER );
@@ -512,7 +521,7 @@ asyncmeta_back_search_start(
 				}
 			}
 
-			if ( mt->mt_ps > 0 || prcookie != NULL ) {
+			if ( ps > 0 || prcookie != NULL ) {
 				op->o_ctrls[ dst ] = (LDAPControl *)&op->o_ctrls[ nc + 1 ];
 
 				op->o_ctrls[ dst ]->ldctl_oid = LDAP_CONTROL_PAGEDRESULTS;
@@ -781,6 +790,14 @@ asyncmeta_back_search( Operation *op, SlapReply *rs )
 		goto finish;
 	}
 
+	if ( asyncmeta_merge_init( op, rs, bc, mi ) != LDAP_SUCCESS ) {
+		ldap_pvt_thread_mutex_lock( &mc->mc_om_mutex);
+		asyncmeta_drop_bc(mc, bc);
+		ldap_pvt_thread_mutex_unlock( &mc->mc_om_mutex);
+		send_ldap_result(op, rs);
+		goto finish;
+	}
+
 	for ( i = 0; i < mi->mi_ntargets; i++ ) {
 		if ( !META_IS_CANDIDATE( &candidates[ i ] )
 			|| candidates[ i ].sr_err != LDAP_SUCCESS )
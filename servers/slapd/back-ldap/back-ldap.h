@@ -389,6 +389,8 @@ typedef struct ldapinfo_t {
 	ldap_avl_info_t		li_conninfo;
 	struct {
 		int						lic_num;
+		/* set once the class has been used, see conn-pool-warm */
+		int						lic_used;
 		LDAP_TAILQ_HEAD(lc_conn_priv_q, ldapconn_t)	lic_priv;
 	}			li_conn_priv[ LDAP_BACK_PCONN_LAST ];
 	int			li_conn_priv_max;
@@ -397,6 +399,14 @@ typedef struct ldapinfo_t {
 	/* must be between LDAP_BACK_CONN_PRIV_MIN
 	 * and LDAP_BACK_CONN_PRIV_MAX ! */
 #define	LDAP_BACK_CONN_PRIV_DEFAULT	(16)
+	/* max operations multiplexed over a privileged conn
+	 * before another one is opened; 0: no multiplexing */
+	int			li_conn_pipeline;
+	/* idle bound conns kept ready in each privileged
+	 * class in use; 0: no warm pool */
+	int			li_conn_warm;
+	time_t			li_conn_warm_interval;
+#define	LDAP_BACK_CONN_WARM_INTERVAL_DEFAULT	(30)
 
 	ldap_monitor_info_t	li_monitor_info;
 
@@ -418,6 +428,8 @@ typedef struct ldapinfo_t {
 	ldap_pvt_thread_mutex_t li_counter_mutex;
 	ldap_pvt_mp_t		li_ops_completed[SLAP_OP_LAST];
 	struct re_s*		li_conn_expire_task;
+	struct re_s*		li_conn_warm_task;
+	BackendDB		*li_conn_warm_be;
 } ldapinfo_t;
 
 #define	LDAP_ERR_OK(err) ((err) == LDAP_SUCCESS || (err) == LDAP_COMPARE_FALSE || (err) == LDAP_COMPARE_TRUE)
@@ -459,6 +471,23 @@ typedef enum ldap_back_send_t {
 #define LDAP_BACK_PRINT_CONNTREE 0
 #endif /* !LDAP_BACK_PRINT_CONNTREE */
 
+/*
+ * DN to target cache used by back-meta and back-asyncmeta; the entries are
+ * spread across a fixed number of shards, each with its own lock, hash table
+ * and LRU list, so lookups of unrelated DNs don't contend.
+ */
+typedef struct ldap_dncache_shard_t ldap_dncache_shard_t;
+
+typedef struct ldap_dncache_t {
+	ldap_dncache_shard_t	*shards;
+
+	time_t			ttl;	/* seconds; 0: no cache, -1: no expiry */
+	unsigned		size;	/* max entries; 0: no limit */
+
+	struct berval		monitor_ndn;
+	void			*monitor_cb;
+} ldap_dncache_t;
+
 typedef struct ldap_extra_t {
 	int (*proxy_authz_ctrl)( Operation *op, SlapReply *rs, struct berval *bound_ndn,
 		int version, slap_idassert_t *si, LDAPControl	*ctrl );
@@ -470,6 +499,14 @@ typedef struct ldap_extra_t {
 	int (*retry_info_parse)( char *in, slap_retry_info_t *ri, char *buf, ber_len_t buflen );
 	int (*retry_info_unparse)( slap_retry_info_t *ri, struct berval *bvout );
 	int (*connid2str)( const ldapconn_base_t *lc, char *buf, ber_len_t buflen );
+	int (*dncache_init)( ldap_dncache_t *cache );
+	void (*dncache_destroy)( ldap_dncache_t *cache );
+	int (*dncache_get_target)( ldap_dncache_t *cache, struct berval *ndn );
+	int (*dncache_update_entry)( ldap_dncache_t *cache, struct berval *ndn, int target );
+	int (*dncache_delete_entry)( ldap_dncache_t *cache, struct berval *ndn );
+	int (*dncache_monitor_db_init)( BackendDB *be );
+	int (*dncache_monitor_db_open)( BackendDB *be, ldap_dncache_t *cache );
+	int (*dncache_monitor_db_close)( BackendDB *be, ldap_dncache_t *cache );
 } ldap_extra_t;
 
 LDAP_END_DECL
@@ -890,14 +890,36 @@ ldap_back_getconn(
 retry_lock:
 		ldap_pvt_thread_mutex_lock( &li->li_conninfo.lai_mutex );
 		if ( LDAP_BACK_PCONN_ISPRIV( &lc_curr ) ) {
+			ldapconn_t	*least = NULL;
+
 			/* lookup a conn that's not binding */
 			LDAP_TAILQ_FOREACH( lc,
 				&li->li_conn_priv[ LDAP_BACK_CONN2PRIV( &lc_curr ) ].lic_priv,
 				lc_q )
 			{
-				if ( !LDAP_BACK_CONN_BINDING( lc ) && lc->lc_refcnt == 0 ) {
+				if ( LDAP_BACK_CONN_BINDING( lc ) ) {
+					continue;
+				}
+				if ( lc->lc_refcnt == 0 ) {
 					break;
 				}
+				if ( least == NULL || lc->lc_refcnt < least->lc_refcnt ) {
+					least = lc;
+				}
+			}
+
+			/* with pipelining, rather share a busy conn
+			 * than open a new one, as long as it's not
+			 * carrying too many operations already;
+			 * when the pool is full, pick the least loaded
+			 * unless temporaries are to be used instead */
+			if ( lc == NULL && least != NULL && li->li_conn_pipeline > 0 ) {
+				if ( least->lc_refcnt < li->li_conn_pipeline
+					|| ( !LDAP_BACK_USE_TEMPORARIES( li )
+						&& li->li_conn_priv[ LDAP_BACK_CONN2PRIV( &lc_curr ) ].lic_num == li->li_conn_priv_max ) )
+				{
+					lc = least;
+				}
 			}
 
 			if ( lc != NULL ) {
@@ -1055,6 +1077,7 @@ retry_lock:
 #endif /* LDAP_BACK_PRINT_CONNTREE */
 	
 		if ( LDAP_BACK_PCONN_ISPRIV( lc ) ) {
+			li->li_conn_priv[ LDAP_BACK_CONN2PRIV( lc ) ].lic_used = 1;
 			if ( li->li_conn_priv[ LDAP_BACK_CONN2PRIV( lc ) ].lic_num < li->li_conn_priv_max ) {
 				LDAP_TAILQ_INSERT_TAIL( &li->li_conn_priv[ LDAP_BACK_CONN2PRIV( lc ) ].lic_priv, lc, lc_q );
 				li->li_conn_priv[ LDAP_BACK_CONN2PRIV( lc ) ].lic_num++;
@@ -3221,3 +3244,276 @@ ldap_back_schedule_conn_expiry( ldapinfo_t *li, ldapconn_t *lc ) {
 
 	return;
 }
+
+/*
+ * Warm pool.
+ *
+ * Connections are otherwise set up by the first operation that needs
+ * one, so after the pool has been pruned, or the target has come back
+ * from quarantine, that operation pays for connect, StartTLS and bind.
+ * When "conn-pool-warm" is set, a task keeps that many idle, bound
+ * connections in each privileged class that has been used so far.
+ * Every run also probes the idle connections with a base search of
+ * the rootDSE, dropping those that don't answer, and retires those
+ * that would expire before the next run, so that they get replaced
+ * while nobody is waiting for them.
+ *
+ * The bind classes are not warmed: their connections carry
+ * the credentials of the client that bound.
+ */
+
+/* seconds to wait for the rootDSE when no search timeout is set */
+#define	LDAP_BACK_CONN_PROBE_TIMEOUT	(5)
+
+static ldapconn_t *
+ldap_back_conn_warm_new( Operation *op, SlapReply *rs, int c )
+{
+	ldapinfo_t	*li = (ldapinfo_t *)op->o_bd->be_private;
+	ldapconn_t	*lc;
+
+	lc = (ldapconn_t *)ch_calloc( 1, sizeof( ldapconn_t ) );
+	lc->lc_flags = li->li_flags;
+	lc->lc_ldapinfo = li;
+	lc->lc_conn = (void *)(unsigned long)c;
+	if ( LDAP_BACK_PCONN_ISROOTDN( lc ) ) {
+		LDAP_BACK_CONN_ISPRIV_SET( lc );
+	}
+
+#ifdef HAVE_TLS
+	op->o_conn->c_is_tls = ( c & LDAP_BACK_PCONN_TLS ) ? 1 : 0;
+#endif /* HAVE_TLS */
+
+	if ( ldap_back_prepare_conn( lc, op, rs, LDAP_BACK_DONTSEND ) != LDAP_SUCCESS ) {
+		ch_free( lc );
+		return NULL;
+	}
+
+	/* same identities ldap_back_getconn() would use */
+	if ( LDAP_BACK_CONN_ISPRIV( lc ) ) {
+		ber_dupbv( &lc->lc_local_ndn, &op->o_bd->be_rootndn );
+		if ( li->li_acl_authmethod == LDAP_AUTH_NONE &&
+			 li->li_idassert_authmethod != LDAP_AUTH_NONE ) {
+			ber_dupbv( &lc->lc_bound_ndn, &li->li_idassert_authcDN );
+			ber_dupbv( &lc->lc_cred, &li->li_idassert_passwd );
+
+		} else {
+			ber_dupbv( &lc->lc_bound_ndn, &li->li_acl_authcDN );
+			ber_dupbv( &lc->lc_cred, &li->li_acl_passwd );
+		}
+
+	} else {
+		ber_str2bv( "", 0, 1, &lc->lc_local_ndn );
+	}
+
+	ldap_pvt_thread_mutex_lock( &li->li_conninfo.lai_mutex );
+	if ( li->li_conn_priv[ c ].lic_num >= li->li_conn_priv_max ) {
+		ldap_pvt_thread_mutex_unlock( &li->li_conninfo.lai_mutex );
+		ldap_back_conn_free( lc );
+		return NULL;
+	}
+
+	lc->lc_connid = li->li_conn_nextid++;
+	LDAP_TAILQ_INSERT_TAIL( &li->li_conn_priv[ c ].lic_priv, lc, lc_q );
+	li->li_conn_priv[ c ].lic_num++;
+	LDAP_BACK_CONN_CACHED_SET( lc );
+	ldap_pvt_thread_mutex_unlock( &li->li_conninfo.lai_mutex );
+
+	ldap_back_schedule_conn_expiry( li, lc );
+
+	return lc;
+}
+
+/*
+ * Any answer, even an error, means the connection is alive;
+ * only API errors (timeout, server down, ...) count as failures.
+ */
+static int
+ldap_back_conn_probe( ldapinfo_t *li, ldapconn_t *lc )
+{
+	char		*attrs[] = { LDAP_NO_ATTRS, NULL };
+	struct timeval	tv;
+	LDAPMessage	*res = NULL;
+	int		rc;
+
+	tv.tv_sec = li->li_timeout[ SLAP_OP_SEARCH ] ?
+		li->li_timeout[ SLAP_OP_SEARCH ] : LDAP_BACK_CONN_PROBE_TIMEOUT;
+	tv.tv_usec = 0;
+
+	rc = ldap_search_ext_s( lc->lc_ld, "", LDAP_SCOPE_BASE,
+		"(objectClass=*)", attrs, 0, NULL, NULL, &tv, 1, &res );
+	if ( res != NULL ) {
+		ldap_msgfree( res );
+	}
+
+	return rc < 0 ? rc : LDAP_SUCCESS;
+}
+
+static void *
+ldap_back_conn_warm_fn( void *ctx, void *arg )
+{
+	struct re_s	*rtask = arg;
+	ldapinfo_t	*li = (ldapinfo_t *)rtask->arg;
+	Connection	conn = { 0 };
+	OperationBuffer	opbuf;
+	Operation	*op;
+	BackendDB	db;
+	ldapconn_t	*lc, *probe[ LDAP_BACK_CONN_PRIV_MAX ];
+	time_t		horizon;
+	int		c;
+
+	connection_fake_init2( &conn, &opbuf, ctx, 0 );
+	op = &opbuf.ob_op;
+
+	/* the pool is paused while cn=config is modified, so the
+	 * live database can't change under us while the task runs */
+	db = *li->li_conn_warm_be;
+	db.be_private = li;
+	op->o_bd = &db;
+	op->o_tag = LDAP_REQ_SEARCH;
+	op->o_dn = db.be_rootdn;
+	op->o_ndn = db.be_rootndn;
+	op->o_do_not_cache = 1;
+
+	/* connections expiring before the next run are retired now */
+	horizon = op->o_time + li->li_conn_warm_interval;
+
+	for ( c = LDAP_BACK_PCONN_FIRST; c < LDAP_BACK_PCONN_BIND; c++ ) {
+		int	nprobe = 0, nready = 0, nnew, i;
+
+		ldap_pvt_thread_mutex_lock( &li->li_conninfo.lai_mutex );
+		if ( !li->li_conn_priv[ c ].lic_used ) {
+			ldap_pvt_thread_mutex_unlock( &li->li_conninfo.lai_mutex );
+			continue;
+		}
+
+		lc = LDAP_TAILQ_FIRST( &li->li_conn_priv[ c ].lic_priv );
+		while ( lc ) {
+			ldapconn_t	*next = LDAP_TAILQ_NEXT( lc, lc_q );
+			time_t		conn_expires;
+
+			if ( lc->lc_refcnt != 0 || LDAP_BACK_CONN_BINDING( lc )
+				|| LDAP_BACK_CONN_TAINTED( lc ) )
+			{
+				lc = next;
+				continue;
+			}
+
+			conn_expires = ldap_back_conn_expire_time( li, lc );
+			if ( !LDAP_BACK_CONN_ISBOUND( lc )
+				|| ( conn_expires != -1 && conn_expires <= horizon ) )
+			{
+				Debug( LDAP_DEBUG_TRACE,
+					"ldap_back_conn_warm: retiring connection lc=%p\n",
+					lc );
+				ldap_back_freeconn( li, lc, 0 );
+
+			} else {
+				/* hold it, so it's not pruned while probing */
+				lc->lc_refcnt++;
+				probe[ nprobe++ ] = lc;
+			}
+
+			lc = next;
+		}
+		ldap_pvt_thread_mutex_unlock( &li->li_conninfo.lai_mutex );
+
+		for ( i = 0; i < nprobe; i++ ) {
+			int	rc;
+
+			lc = probe[ i ];
+			rc = ldap_back_conn_probe( li, lc );
+
+			ldap_pvt_thread_mutex_lock( &li->li_conninfo.lai_mutex );
+			if ( rc == LDAP_SUCCESS ) {
+				nready++;
+
+			} else {
+				Debug( LDAP_DEBUG_ANY,
+					"ldap_back_conn_warm: probe of \"%s\" "
+					"failed (%d), dropping connection lc=%p\n",
+					li->li_uri, rc, lc );
+				LDAP_BACK_CONN_TAINTED_SET( lc );
+			}
+			ldap_back_release_conn_lock( li, &lc, 0 );
+			ldap_pvt_thread_mutex_unlock( &li->li_conninfo.lai_mutex );
+		}
+
+		/* don't fight the quarantine, the first operation
+		 * after the interval will try the target again */
+		if ( LDAP_BACK_QUARANTINE( li ) ) {
+			int	isquarantined;
+
+			ldap_pvt_thread_mutex_lock( &li->li_quarantine_mutex );
+			isquarantined = li->li_isquarantined;
+			ldap_pvt_thread_mutex_unlock( &li->li_quarantine_mutex );
+			if ( isquarantined != LDAP_BACK_FQ_NO ) {
+				continue;
+			}
+		}
+
+		ldap_pvt_thread_mutex_lock( &li->li_conninfo.lai_mutex );
+		nnew = li->li_conn_priv_max - li->li_conn_priv[ c ].lic_num;
+		ldap_pvt_thread_mutex_unlock( &li->li_conninfo.lai_mutex );
+		if ( nnew > li->li_conn_warm - nready ) {
+			nnew = li->li_conn_warm - nready;
+		}
+
+		for ( ; nnew > 0; nnew-- ) {
+			SlapReply	rs = { REP_RESULT };
+
+			lc = ldap_back_conn_warm_new( op, &rs, c );
+			if ( lc == NULL ) {
+				break;
+			}
+
+			/* releases lc on failure */
+			if ( !ldap_back_dobind_int( &lc, op, &rs,
+				LDAP_BACK_DONTSEND, li->li_nretries, 1 ) )
+			{
+				Debug( LDAP_DEBUG_ANY,
+					"ldap_back_conn_warm: unable to bind "
+					"to \"%s\" (%d)\n",
+					li->li_uri, rs.sr_err );
+				break;
+			}
+			ldap_back_release_conn( li, lc );
+		}
+	}
+
+	ldap_pvt_thread_mutex_lock( &slapd_rq.rq_mutex );
+	if ( ldap_pvt_runqueue_isrunning( &slapd_rq, rtask ) ) {
+		ldap_pvt_runqueue_stoptask( &slapd_rq, rtask );
+	}
+	rtask->interval.tv_sec = li->li_conn_warm_interval;
+	ldap_pvt_runqueue_resched( &slapd_rq, rtask, 0 );
+	ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
+
+	return NULL;
+}
+
+void
+ldap_back_schedule_conn_warm( ldapinfo_t *li )
+{
+	ldap_pvt_thread_mutex_lock( &slapd_rq.rq_mutex );
+	if ( li->li_conn_warm_task == NULL ) {
+		li->li_conn_warm_task = ldap_pvt_runqueue_insert( &slapd_rq,
+			li->li_conn_warm_interval,
+			ldap_back_conn_warm_fn, li, "ldap_back_conn_warm_fn",
+			"ldap_back_conn_warm_timer" );
+	}
+	ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
+}
+
+void
+ldap_back_stop_conn_warm( ldapinfo_t *li )
+{
+	ldap_pvt_thread_mutex_lock( &slapd_rq.rq_mutex );
+	if ( li->li_conn_warm_task != NULL ) {
+		if ( ldap_pvt_runqueue_isrunning( &slapd_rq, li->li_conn_warm_task ) ) {
+			ldap_pvt_runqueue_stoptask( &slapd_rq, li->li_conn_warm_task );
+		}
+		ldap_pvt_runqueue_remove( &slapd_rq, li->li_conn_warm_task );
+		li->li_conn_warm_task = NULL;
+	}
+	ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
+}
@@ -59,6 +59,9 @@ enum {
 	LDAP_BACK_CFG_SINGLECONN,
 	LDAP_BACK_CFG_USETEMP,
 	LDAP_BACK_CFG_CONNPOOLMAX,
+	LDAP_BACK_CFG_CONNPIPELINE,
+	LDAP_BACK_CFG_CONNWARM,
+	LDAP_BACK_CFG_CONNWARM_INTERVAL,
 	LDAP_BACK_CFG_CANCEL,
 	LDAP_BACK_CFG_QUARANTINE,
 	LDAP_BACK_CFG_ST_REQUEST,
@@ -246,6 +249,33 @@ static ConfigTable ldapcfg[] = {
 			"SYNTAX OMsInteger "
 			"SINGLE-VALUE )",
 		NULL, NULL },
+	{ "conn-pool-pipeline", "<n>", 2, 2, 0,
+		ARG_MAGIC|ARG_INT|LDAP_BACK_CFG_CONNPIPELINE,
+		ldap_back_cf_gen, "( OLcfgDbAt:3.120 "
+			"NAME 'olcDbConnectionPoolPipeline' "
+			"DESC 'Max operations multiplexed over a privileged connection' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger "
+			"SINGLE-VALUE )",
+		NULL, NULL },
+	{ "conn-pool-warm", "<n>", 2, 2, 0,
+		ARG_MAGIC|ARG_INT|LDAP_BACK_CFG_CONNWARM,
+		ldap_back_cf_gen, "( OLcfgDbAt:3.121 "
+			"NAME 'olcDbConnectionPoolWarm' "
+			"DESC 'Number of idle connections kept ready in each privileged pool' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger "
+			"SINGLE-VALUE )",
+		NULL, NULL },
+	{ "conn-pool-warm-interval", "interval", 2, 2, 0,
+		ARG_MAGIC|LDAP_BACK_CFG_CONNWARM_INTERVAL,
+		ldap_back_cf_gen, "( OLcfgDbAt:3.122 "
+			"NAME 'olcDbConnectionPoolWarmInterval' "
+			"DESC 'Interval between warm pool checks' "
+			"EQUALITY caseIgnoreMatch "
+			"SYNTAX OMsDirectoryString "
+			"SINGLE-VALUE )",
+		NULL, NULL },
 #ifdef SLAP_CONTROL_X_SESSION_TRACKING
 	{ "session-tracking-request", "true|FALSE", 2, 2, 0,
 		ARG_MAGIC|ARG_ON_OFF|LDAP_BACK_CFG_ST_REQUEST,
@@ -348,6 +378,9 @@ static ConfigOCs ldapocs[] = {
 			"$ olcDbQuarantine "
 			"$ olcDbUseTemporaryConn "
 			"$ olcDbConnectionPoolMax "
+			"$ olcDbConnectionPoolPipeline "
+			"$ olcDbConnectionPoolWarm "
+			"$ olcDbConnectionPoolWarmInterval "
 #ifdef SLAP_CONTROL_X_SESSION_TRACKING
 			"$ olcDbSessionTrackingRequest "
 #endif /* SLAP_CONTROL_X_SESSION_TRACKING */
@@ -1307,6 +1340,32 @@ ldap_back_cf_gen( ConfigArgs *c )
 			c->value_int = li->li_conn_priv_max;
 			break;
 
+		case LDAP_BACK_CFG_CONNPIPELINE:
+			if ( li->li_conn_pipeline == 0 ) {
+				return 1;
+			}
+			c->value_int = li->li_conn_pipeline;
+			break;
+
+		case LDAP_BACK_CFG_CONNWARM:
+			if ( li->li_conn_warm == 0 ) {
+				return 1;
+			}
+			c->value_int = li->li_conn_warm;
+			break;
+
+		case LDAP_BACK_CFG_CONNWARM_INTERVAL: {
+			char	buf[ SLAP_TEXT_BUFLEN ];
+
+			if ( li->li_conn_warm_interval == LDAP_BACK_CONN_WARM_INTERVAL_DEFAULT ) {
+				return 1;
+			}
+
+			lutil_unparse_time( buf, sizeof( buf ), li->li_conn_warm_interval );
+			ber_str2bv( buf, 0, 0, &bv );
+			value_add_one( &c->rvalue_vals, &bv );
+			} break;
+
 		case LDAP_BACK_CFG_CANCEL: {
 			slap_mask_t	mask = LDAP_BACK_F_CANCEL_MASK2;
 
@@ -1500,6 +1559,19 @@ ldap_back_cf_gen( ConfigArgs *c )
 			li->li_conn_priv_max = LDAP_BACK_CONN_PRIV_MIN;
 			break;
 
+		case LDAP_BACK_CFG_CONNPIPELINE:
+			li->li_conn_pipeline = 0;
+			break;
+
+		case LDAP_BACK_CFG_CONNWARM:
+			li->li_conn_warm = 0;
+			ldap_back_stop_conn_warm( li );
+			break;
+
+		case LDAP_BACK_CFG_CONNWARM_INTERVAL:
+			li->li_conn_warm_interval = LDAP_BACK_CONN_WARM_INTERVAL_DEFAULT;
+			break;
+
 		case LDAP_BACK_CFG_QUARANTINE:
 			if ( !LDAP_BACK_QUARANTINE( li ) ) {
 				break;
@@ -1936,6 +2008,52 @@ done_url:;
 		li->li_conn_priv_max = c->value_int;
 		break;
 
+	case LDAP_BACK_CFG_CONNPIPELINE:
+		if ( c->value_int < 0 ) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg ),
+				"invalid number of operations \"%s\" "
+				"in \"conn-pool-pipeline <n>\" "
+				"(must be 0 or more)",
+				c->argv[ 1 ] );
+			Debug( LDAP_DEBUG_ANY, "%s: %s.\n", c->log, c->cr_msg );
+			return 1;
+		}
+		li->li_conn_pipeline = c->value_int;
+		break;
+
+	case LDAP_BACK_CFG_CONNWARM:
+		if ( c->value_int < 0 ) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg ),
+				"invalid number of connections \"%s\" "
+				"in \"conn-pool-warm <n>\" "
+				"(must be 0 or more)",
+				c->argv[ 1 ] );
+			Debug( LDAP_DEBUG_ANY, "%s: %s.\n", c->log, c->cr_msg );
+			return 1;
+		}
+		li->li_conn_warm = c->value_int;
+		if ( LDAP_BACK_ISOPEN( li ) ) {
+			if ( li->li_conn_warm > 0 ) {
+				ldap_back_schedule_conn_warm( li );
+			} else {
+				ldap_back_stop_conn_warm( li );
+			}
+		}
+		break;
+
+	case LDAP_BACK_CFG_CONNWARM_INTERVAL: {
+		unsigned long	t;
+
+		if ( lutil_parse_time( c->argv[ 1 ], &t ) != 0 || t == 0 ) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg),
+				"unable to parse warm pool interval \"%s\"",
+				c->argv[ 1 ] );
+			Debug( LDAP_DEBUG_ANY, "%s: %s.\n", c->log, c->cr_msg );
+			return 1;
+		}
+		li->li_conn_warm_interval = (time_t)t;
+		} break;
+
 	case LDAP_BACK_CFG_CANCEL: {
 		slap_mask_t		mask;
 
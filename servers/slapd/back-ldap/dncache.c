@@ -0,0 +1,398 @@
+/* dncache.c - dn to target cache shared by back-meta and back-asyncmeta */
+/* $OpenLDAP$ */
+/* This work is part of OpenLDAP Software <http://www.openldap.org/>.
+ *
+ * Copyright 1999-2022 The OpenLDAP Foundation.
+ * Portions Copyright 2001-2003 Pierangelo Masarati.
+ * Portions Copyright 1999-2003 Howard Chu.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted only as authorized by the OpenLDAP
+ * Public License.
+ *
+ * A copy of this license is available in the file LICENSE in the
+ * top-level directory of the distribution or, alternatively, at
+ * <http://www.OpenLDAP.org/license.html>.
+ */
+/* ACKNOWLEDGEMENTS:
+ * This work was initially developed by the Howard Chu for inclusion
+ * in OpenLDAP Software and subsequently enhanced by Pierangelo
+ * Masarati.
+ */
+
+#include "portable.h"
+
+#include <stdio.h>
+#include <ac/string.h>
+
+#include "lutil.h"
+#include "lutil_hash.h"
+#include "slap.h"
+#include "back-ldap.h"
+
+/*
+ * The dncache maps an entry to the target that holds it.
+ *
+ * The normalized DN is hashed once; the low bits select the shard, the
+ * remaining ones the bucket within the shard's hash table. Each shard keeps
+ * its entries on an LRU list and, when the cache is bounded, evicts the least
+ * recently used ones once it holds more than its share of the configured
+ * size. Expired entries are dropped as soon as a lookup finds them.
+ */
+
+#define LDAP_DNCACHE_SHARD_BITS	4
+#define LDAP_DNCACHE_SHARDS	(1U << LDAP_DNCACHE_SHARD_BITS)
+
+/* initial number of buckets per shard, must be a power of 2 */
+#define LDAP_DNCACHE_BUCKETS	64
+
+typedef struct ldap_dncache_entry_t {
+	struct berval		dn;
+	int 			target;
+	time_t 			lastupdated;
+
+	ber_uint_t		hash;
+	struct ldap_dncache_entry_t	*next;
+	LDAP_TAILQ_ENTRY(ldap_dncache_entry_t)	lru;
+} ldap_dncache_entry_t;
+
+struct ldap_dncache_shard_t {
+	ldap_pvt_thread_mutex_t	mutex;
+
+	ldap_dncache_entry_t	**buckets;
+	unsigned		nbuckets;
+	unsigned		count;
+	LDAP_TAILQ_HEAD(dncache_lru, ldap_dncache_entry_t)	lru;
+
+	/* protected by mutex as well */
+	unsigned long		hits;
+	unsigned long		misses;
+	unsigned long		evictions;
+};
+
+static ber_uint_t
+ldap_back_dncache_hash( struct berval *ndn )
+{
+	lutil_HASH_CTX	ctx;
+
+	lutil_HASHInit( &ctx );
+	lutil_HASHUpdate( &ctx, (unsigned char *)ndn->bv_val, ndn->bv_len );
+	return lutil_HASHValue( &ctx );
+}
+
+#define DNCACHE_SHARD(cache, hash) \
+	(&(cache)->shards[ (hash) & ( LDAP_DNCACHE_SHARDS - 1 ) ])
+#define DNCACHE_BUCKET(shard, hash) \
+	(&(shard)->buckets[ ( (hash) >> LDAP_DNCACHE_SHARD_BITS ) & \
+		( (shard)->nbuckets - 1 ) ])
+
+/*
+ * look ndn up in its bucket; the link is returned rather than the
+ * entry so that the caller can unlink it, or insert a new entry there
+ * when ndn isn't cached yet
+ */
+static ldap_dncache_entry_t **
+ldap_back_dncache_find(
+	ldap_dncache_shard_t	*shard,
+	struct berval		*ndn,
+	ber_uint_t		hash )
+{
+	ldap_dncache_entry_t	**ep;
+
+	for ( ep = DNCACHE_BUCKET( shard, hash ); *ep; ep = &(*ep)->next ) {
+		/*
+		 * case sensitive, because the dn MUST be normalized
+		 */
+		if ( (*ep)->hash == hash && bvmatch( &(*ep)->dn, ndn ) ) {
+			break;
+		}
+	}
+
+	return ep;
+}
+
+static void
+ldap_back_dncache_remove(
+	ldap_dncache_shard_t	*shard,
+	ldap_dncache_entry_t	**ep )
+{
+	ldap_dncache_entry_t	*entry = *ep;
+
+	*ep = entry->next;
+	LDAP_TAILQ_REMOVE( &shard->lru, entry, lru );
+	shard->count--;
+
+	ch_free( entry );
+}
+
+/*
+ * keep about one DN per bucket as the shard fills up to its
+ * share of the cache size
+ */
+static void
+ldap_back_dncache_grow( ldap_dncache_shard_t *shard )
+{
+	ldap_dncache_entry_t	**old = shard->buckets, *entry, *next;
+	unsigned		i, n = shard->nbuckets;
+
+	shard->buckets = ch_calloc( 2 * n, sizeof( ldap_dncache_entry_t * ) );
+	shard->nbuckets = 2 * n;
+
+	for ( i = 0; i < n; i++ ) {
+		for ( entry = old[ i ]; entry; entry = next ) {
+			ldap_dncache_entry_t	**ep;
+
+			next = entry->next;
+			ep = DNCACHE_BUCKET( shard, entry->hash );
+			entry->next = *ep;
+			*ep = entry;
+		}
+	}
+
+	ch_free( old );
+}
+
+int
+ldap_back_dncache_init( ldap_dncache_t *cache )
+{
+	unsigned	i;
+
+	cache->shards = ch_calloc( LDAP_DNCACHE_SHARDS,
+		sizeof( ldap_dncache_shard_t ) );
+
+	for ( i = 0; i < LDAP_DNCACHE_SHARDS; i++ ) {
+		ldap_dncache_shard_t	*shard = &cache->shards[ i ];
+
+		ldap_pvt_thread_mutex_init( &shard->mutex );
+		shard->nbuckets = LDAP_DNCACHE_BUCKETS;
+		shard->buckets = ch_calloc( shard->nbuckets,
+			sizeof( ldap_dncache_entry_t * ) );
+		LDAP_TAILQ_INIT( &shard->lru );
+	}
+
+	return 0;
+}
+
+void
+ldap_back_dncache_destroy( ldap_dncache_t *cache )
+{
+	unsigned	i;
+
+	if ( cache->shards == NULL ) {
+		return;
+	}
+
+	for ( i = 0; i < LDAP_DNCACHE_SHARDS; i++ ) {
+		ldap_dncache_shard_t	*shard = &cache->shards[ i ];
+		ldap_dncache_entry_t	*entry;
+
+		while ( ( entry = LDAP_TAILQ_FIRST( &shard->lru ) ) != NULL ) {
+			LDAP_TAILQ_REMOVE( &shard->lru, entry, lru );
+			ch_free( entry );
+		}
+		ch_free( shard->buckets );
+		ldap_pvt_thread_mutex_destroy( &shard->mutex );
+	}
+
+	ch_free( cache->shards );
+	cache->shards = NULL;
+}
+
+/*
+ * ldap_back_dncache_get_target
+ *
+ * returns the target a dn belongs to, or -1 in case the dn is not
+ * in the cache
+ */
+int
+ldap_back_dncache_get_target(
+	ldap_dncache_t	*cache,
+	struct berval	*ndn )
+{
+	ldap_dncache_shard_t	*shard;
+	ldap_dncache_entry_t	**ep, *entry;
+	ber_uint_t		hash;
+	int			target = -1;
+
+	assert( cache != NULL );
+	assert( ndn != NULL );
+
+	hash = ldap_back_dncache_hash( ndn );
+	shard = DNCACHE_SHARD( cache, hash );
+
+	ldap_pvt_thread_mutex_lock( &shard->mutex );
+	ep = ldap_back_dncache_find( shard, ndn, hash );
+	entry = *ep;
+
+	/*
+	 * if cache->ttl < 0, cache never expires;
+	 * if cache->ttl = 0 no cache is used; shouldn't get here
+	 * else, cache is used with ttl
+	 */
+	if ( entry != NULL && cache->ttl > 0
+		&& entry->lastupdated + cache->ttl <= slap_get_time() )
+	{
+		ldap_back_dncache_remove( shard, ep );
+		entry = NULL;
+	}
+
+	if ( entry != NULL ) {
+		target = entry->target;
+		if ( entry != LDAP_TAILQ_FIRST( &shard->lru ) ) {
+			LDAP_TAILQ_REMOVE( &shard->lru, entry, lru );
+			LDAP_TAILQ_INSERT_HEAD( &shard->lru, entry, lru );
+		}
+		shard->hits++;
+
+	} else {
+		shard->misses++;
+	}
+	ldap_pvt_thread_mutex_unlock( &shard->mutex );
+
+	return target;
+}
+
+/*
+ * ldap_back_dncache_update_entry
+ *
+ * updates target and lastupdated of an entry if exists,
+ * otherwise it gets created; returns -1 in case of error
+ */
+int
+ldap_back_dncache_update_entry(
+	ldap_dncache_t	*cache,
+	struct berval	*ndn,
+	int 		target )
+{
+	ldap_dncache_shard_t	*shard;
+	ldap_dncache_entry_t	**ep, *entry;
+	ber_uint_t		hash;
+	time_t			curr_time = 0L;
+	unsigned		max = 0;
+
+	assert( cache != NULL );
+	assert( ndn != NULL );
+
+	/*
+	 * if cache->ttl < 0, cache never expires;
+	 * if cache->ttl = 0 no cache is used; shouldn't get here
+	 * else, cache is used with ttl
+	 */
+	if ( cache->ttl > 0 ) {
+		curr_time = slap_get_time();
+	}
+
+	/* the bound is enforced per shard */
+	if ( cache->size ) {
+		max = ( cache->size + LDAP_DNCACHE_SHARDS - 1 ) / LDAP_DNCACHE_SHARDS;
+	}
+
+	hash = ldap_back_dncache_hash( ndn );
+	shard = DNCACHE_SHARD( cache, hash );
+
+	ldap_pvt_thread_mutex_lock( &shard->mutex );
+	ep = ldap_back_dncache_find( shard, ndn, hash );
+	entry = *ep;
+
+	if ( entry != NULL ) {
+		entry->target = target;
+		entry->lastupdated = curr_time;
+		LDAP_TAILQ_REMOVE( &shard->lru, entry, lru );
+		LDAP_TAILQ_INSERT_HEAD( &shard->lru, entry, lru );
+
+	} else {
+		entry = ch_malloc( sizeof( ldap_dncache_entry_t ) + ndn->bv_len + 1 );
+
+		entry->dn.bv_len = ndn->bv_len;
+		entry->dn.bv_val = (char *)&entry[ 1 ];
+		AC_MEMCPY( entry->dn.bv_val, ndn->bv_val, ndn->bv_len );
+		entry->dn.bv_val[ ndn->bv_len ] = '\0';
+
+		entry->target = target;
+		entry->lastupdated = curr_time;
+		entry->hash = hash;
+
+		entry->next = NULL;
+		*ep = entry;
+		LDAP_TAILQ_INSERT_HEAD( &shard->lru, entry, lru );
+		shard->count++;
+
+		while ( max && shard->count > max ) {
+			ldap_dncache_entry_t	*last;
+
+			last = LDAP_TAILQ_LAST( &shard->lru, dncache_lru );
+			ldap_back_dncache_remove( shard,
+				ldap_back_dncache_find( shard, &last->dn, last->hash ) );
+			shard->evictions++;
+		}
+
+		if ( shard->count > shard->nbuckets ) {
+			ldap_back_dncache_grow( shard );
+		}
+	}
+	ldap_pvt_thread_mutex_unlock( &shard->mutex );
+
+	return 0;
+}
+
+/*
+ * ldap_back_dncache_delete_entry
+ *
+ * removes the entry for ndn, if any
+ */
+int
+ldap_back_dncache_delete_entry(
+	ldap_dncache_t	*cache,
+	struct berval	*ndn )
+{
+	ldap_dncache_shard_t	*shard;
+	ldap_dncache_entry_t	**ep;
+	ber_uint_t		hash;
+
+	assert( cache != NULL );
+	assert( ndn != NULL );
+
+	hash = ldap_back_dncache_hash( ndn );
+	shard = DNCACHE_SHARD( cache, hash );
+
+	ldap_pvt_thread_mutex_lock( &shard->mutex );
+	ep = ldap_back_dncache_find( shard, ndn, hash );
+	if ( *ep != NULL ) {
+		ldap_back_dncache_remove( shard, ep );
+	}
+	ldap_pvt_thread_mutex_unlock( &shard->mutex );
+
+	return 0;
+}
+
+/*
+ * sums up the per shard counters, for back-monitor
+ */
+void
+ldap_back_dncache_stats(
+	ldap_dncache_t	*cache,
+	unsigned long	*entries,
+	unsigned long	*hits,
+	unsigned long	*misses,
+	unsigned long	*evictions )
+{
+	unsigned	i;
+
+	*entries = *hits = *misses = *evictions = 0;
+
+	if ( cache->shards == NULL ) {
+		return;
+	}
+
+	for ( i = 0; i < LDAP_DNCACHE_SHARDS; i++ ) {
+		ldap_dncache_shard_t	*shard = &cache->shards[ i ];
+
+		ldap_pvt_thread_mutex_lock( &shard->mutex );
+		*entries += shard->count;
+		*hits += shard->hits;
+		*misses += shard->misses;
+		*evictions += shard->evictions;
+		ldap_pvt_thread_mutex_unlock( &shard->mutex );
+	}
+}
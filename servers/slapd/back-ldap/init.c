@@ -42,7 +42,15 @@ static const ldap_extra_t ldap_extra = {
 	slap_retry_info_destroy,
 	slap_retry_info_parse,
 	slap_retry_info_unparse,
-	ldap_back_connid2str
+	ldap_back_connid2str,
+	ldap_back_dncache_init,
+	ldap_back_dncache_destroy,
+	ldap_back_dncache_get_target,
+	ldap_back_dncache_update_entry,
+	ldap_back_dncache_delete_entry,
+	ldap_back_dncache_monitor_db_init,
+	ldap_back_dncache_monitor_db_open,
+	ldap_back_dncache_monitor_db_close
 };
 
 int
@@ -188,6 +196,10 @@ ldap_back_db_init( Backend *be, ConfigReply *cr )
 
 	li->li_conn_expire_task = NULL;
 
+	li->li_conn_warm_interval = LDAP_BACK_CONN_WARM_INTERVAL_DEFAULT;
+	li->li_conn_warm_task = NULL;
+	li->li_conn_warm_be = NULL;
+
 	be->be_private = li;
 	SLAP_DBFLAGS( be ) |= SLAP_DBFLAG_NOLASTMOD;
 
@@ -257,6 +269,15 @@ ldap_back_db_open( BackendDB *be, ConfigReply *cr )
 		rc = 0;
 	}
 
+	/* the warm pool task needs a database to run operations
+	 * against; be may well be a temporary copy, so keep the real
+	 * one, whose rootdn follows any change made through cn=config */
+	li->li_conn_warm_be = be->bd_self;
+
+	if ( li->li_conn_warm > 0 ) {
+		ldap_back_schedule_conn_warm( li );
+	}
+
 	li->li_flags |= LDAP_BACK_F_ISOPEN;
 
 	return rc;
@@ -291,6 +312,7 @@ ldap_back_db_close( Backend *be, ConfigReply *cr )
 	int		rc = 0;
 
 	if ( be->be_private ) {
+		ldap_back_stop_conn_warm( (ldapinfo_t *)be->be_private );
 		rc = ldap_back_monitor_db_close( be );
 	}
 
@@ -316,6 +338,8 @@ ldap_back_db_destroy( Backend *be, ConfigReply *cr )
 			ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
 		}
 
+		ldap_back_stop_conn_warm( li );
+
 		ldap_pvt_thread_mutex_lock( &li->li_conninfo.lai_mutex );
 
 		if ( li->li_uri != NULL ) {
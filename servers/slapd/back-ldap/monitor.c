@@ -36,6 +36,7 @@
 
 static ObjectClass		*oc_olmLDAPDatabase;
 static ObjectClass		*oc_olmLDAPConnection;
+static ObjectClass		*oc_olmLDAPDNCache;
 
 static ObjectClass		*oc_monitorContainer;
 static ObjectClass		*oc_monitorCounterObject;
@@ -46,6 +47,10 @@ static AttributeDescription	*ad_olmDbBoundDN;
 static AttributeDescription	*ad_olmDbConnFlags;
 static AttributeDescription	*ad_olmDbConnURI;
 static AttributeDescription	*ad_olmDbPeerAddress;
+static AttributeDescription	*ad_olmDbDNCacheEntries;
+static AttributeDescription	*ad_olmDbDNCacheHits;
+static AttributeDescription	*ad_olmDbDNCacheMisses;
+static AttributeDescription	*ad_olmDbDNCacheEvictions;
 
 /*
  * Stolen from back-monitor/operations.c
@@ -154,6 +159,34 @@ static struct {
 		"NO-USER-MODIFICATION "
 		"USAGE dSAOperation )",
 		&ad_olmDbPeerAddress },
+	{ "( olmLDAPAttributes:7 "
+		"NAME ( 'olmDbDNCacheEntries' ) "
+		"DESC 'number of entries in the dn cache' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmDbDNCacheEntries },
+	{ "( olmLDAPAttributes:8 "
+		"NAME ( 'olmDbDNCacheHits' ) "
+		"DESC 'number of dn cache lookups that found a target' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmDbDNCacheHits },
+	{ "( olmLDAPAttributes:9 "
+		"NAME ( 'olmDbDNCacheMisses' ) "
+		"DESC 'number of dn cache lookups that found nothing' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmDbDNCacheMisses },
+	{ "( olmLDAPAttributes:10 "
+		"NAME ( 'olmDbDNCacheEvictions' ) "
+		"DESC 'number of entries evicted from the dn cache' "
+		"SUP monitorCounter "
+		"NO-USER-MODIFICATION "
+		"USAGE dSAOperation )",
+		&ad_olmDbDNCacheEvictions },
 
 	{ NULL }
 };
@@ -191,6 +224,16 @@ static struct {
 			"$ olmDbConnPeerAddress "
 			") )",
 		&oc_olmLDAPConnection },
+	{ "( olmLDAPObjectClasses:3 "
+		"NAME ( 'olmLDAPDNCache' ) "
+		"SUP top AUXILIARY "
+		"MAY ( "
+			"olmDbDNCacheEntries "
+			"$ olmDbDNCacheHits "
+			"$ olmDbDNCacheMisses "
+			"$ olmDbDNCacheEvictions "
+			") )",
+		&oc_olmLDAPDNCache },
 
 	{ NULL }
 };
@@ -1072,3 +1115,208 @@ ldap_back_monitor_db_destroy( BackendDB *be )
 	return 0;
 }
 
+
+static int
+ldap_back_dncache_monitor_update(
+	Operation	*op,
+	SlapReply	*rs,
+	Entry		*e,
+	void		*priv )
+{
+	ldap_dncache_t		*cache = (ldap_dncache_t *)priv;
+	unsigned long		counters[ 4 ];
+	AttributeDescription	**ads[] = {
+		&ad_olmDbDNCacheEntries,
+		&ad_olmDbDNCacheHits,
+		&ad_olmDbDNCacheMisses,
+		&ad_olmDbDNCacheEvictions,
+		NULL
+	};
+	Attribute		*a;
+	ldap_pvt_mp_t		mp;
+	int			i;
+
+	ldap_back_dncache_stats( cache, &counters[ 0 ], &counters[ 1 ],
+		&counters[ 2 ], &counters[ 3 ] );
+
+	for ( i = 0; ads[ i ] != NULL; i++ ) {
+		a = attr_find( e->e_attrs, *ads[ i ] );
+		if ( a != NULL ) {
+			ldap_pvt_mp_init( mp );
+			ldap_pvt_mp_add_ulong( mp, counters[ i ] );
+			UI2BV( &a->a_vals[ 0 ], mp );
+			ldap_pvt_mp_clear( mp );
+		}
+	}
+
+	return SLAP_CB_CONTINUE;
+}
+
+static int
+ldap_back_dncache_monitor_free(
+	Entry		*e,
+	void		**priv )
+{
+	struct berval	values[ 2 ];
+	Modification	mod = { 0 };
+
+	const char	*text;
+	char		textbuf[ SLAP_TEXT_BUFLEN ];
+
+	AttributeDescription	**ads[] = {
+		&ad_olmDbDNCacheEntries,
+		&ad_olmDbDNCacheHits,
+		&ad_olmDbDNCacheMisses,
+		&ad_olmDbDNCacheEvictions,
+		NULL
+	};
+	int		i;
+
+	/* NOTE: if slap_shutdown != 0, priv might have already been freed */
+	*priv = NULL;
+
+	/* Remove objectClass */
+	mod.sm_op = LDAP_MOD_DELETE;
+	mod.sm_desc = slap_schema.si_ad_objectClass;
+	mod.sm_values = values;
+	mod.sm_numvals = 1;
+	values[ 0 ] = oc_olmLDAPDNCache->soc_cname;
+	BER_BVZERO( &values[ 1 ] );
+
+	(void)modify_delete_values( e, &mod, 1, &text,
+		textbuf, sizeof( textbuf ) );
+
+	/* remove attrs */
+	mod.sm_values = NULL;
+	mod.sm_numvals = 0;
+	for ( i = 0; ads[ i ] != NULL; i++ ) {
+		mod.sm_desc = *ads[ i ];
+		(void)modify_delete_values( e, &mod, 1, &text,
+			textbuf, sizeof( textbuf ) );
+	}
+
+	return SLAP_CB_CONTINUE;
+}
+
+/*
+ * call from within the db_init() of back-meta and back-asyncmeta
+ */
+int
+ldap_back_dncache_monitor_db_init( BackendDB *be )
+{
+	return ldap_back_monitor_initialize();
+}
+
+/*
+ * call from within the db_open() of back-meta and back-asyncmeta;
+ * adds the dn cache counters to the database's monitor entry
+ */
+int
+ldap_back_dncache_monitor_db_open( BackendDB *be, ldap_dncache_t *cache )
+{
+	Attribute		*a, *next;
+	monitor_callback_t	*cb;
+	BackendInfo		*mi;
+	monitor_extra_t		*mbe;
+	struct berval		bv = BER_BVC( "0" );
+	int			rc;
+
+	if ( !SLAP_DBMONITORING( be ) ) {
+		return 0;
+	}
+
+	/* check if monitor is configured and usable */
+	mi = backend_info( "monitor" );
+	if ( !mi || !mi->bi_extra ) {
+		SLAP_DBFLAGS( be ) ^= SLAP_DBFLAG_MONITORING;
+		return 0;
+	}
+	mbe = mi->bi_extra;
+
+	/* don't bother if monitor is not configured */
+	if ( !mbe->is_configured() ) {
+		return 0;
+	}
+
+	if ( oc_olmLDAPDNCache == NULL ) {
+		Debug( LDAP_DEBUG_ANY, "ldap_back_dncache_monitor_db_open: "
+			"monitor schema not available\n" );
+		return 0;
+	}
+
+	a = attrs_alloc( 1 + 4 );
+	if ( a == NULL ) {
+		return 1;
+	}
+
+	a->a_desc = slap_schema.si_ad_objectClass;
+	attr_valadd( a, &oc_olmLDAPDNCache->soc_cname, NULL, 1 );
+	next = a->a_next;
+
+	next->a_desc = ad_olmDbDNCacheEntries;
+	attr_valadd( next, &bv, NULL, 1 );
+	next = next->a_next;
+
+	next->a_desc = ad_olmDbDNCacheHits;
+	attr_valadd( next, &bv, NULL, 1 );
+	next = next->a_next;
+
+	next->a_desc = ad_olmDbDNCacheMisses;
+	attr_valadd( next, &bv, NULL, 1 );
+	next = next->a_next;
+
+	next->a_desc = ad_olmDbDNCacheEvictions;
+	attr_valadd( next, &bv, NULL, 1 );
+
+	cb = ch_calloc( sizeof( monitor_callback_t ), 1 );
+	cb->mc_update = ldap_back_dncache_monitor_update;
+	cb->mc_free = ldap_back_dncache_monitor_free;
+	cb->mc_private = (void *)cache;
+
+	/* make sure the database is registered; then add monitor attributes */
+	rc = mbe->register_database( be, &cache->monitor_ndn );
+	if ( rc == 0 ) {
+		rc = mbe->register_entry_attrs( &cache->monitor_ndn, a, cb,
+			NULL, -1, NULL );
+	}
+
+	if ( rc != 0 ) {
+		Debug( LDAP_DEBUG_ANY, "ldap_back_dncache_monitor_db_open: "
+			"failed to register the dn cache with back-monitor\n" );
+		ch_free( cb );
+		cb = NULL;
+	}
+
+	/* store for cleanup */
+	cache->monitor_cb = (void *)cb;
+
+	/* ldap_back_dncache_monitor_free() takes care of the attributes */
+	attrs_free( a );
+
+	return rc;
+}
+
+/*
+ * call from within the db_close() of back-meta and back-asyncmeta
+ */
+int
+ldap_back_dncache_monitor_db_close( BackendDB *be, ldap_dncache_t *cache )
+{
+	if ( !BER_BVISNULL( &cache->monitor_ndn ) ) {
+		BackendInfo		*mi = backend_info( "monitor" );
+		monitor_extra_t		*mbe;
+
+		if ( mi && mi->bi_extra && cache->monitor_cb ) {
+			struct berval dummy = BER_BVNULL;
+			mbe = mi->bi_extra;
+			mbe->unregister_entry_callback( &cache->monitor_ndn,
+				(monitor_callback_t *)cache->monitor_cb,
+				&dummy, 0, &dummy );
+		}
+
+		BER_BVZERO( &cache->monitor_ndn );
+		cache->monitor_cb = NULL;
+	}
+
+	return 0;
+}
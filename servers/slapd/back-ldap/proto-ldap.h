@@ -53,6 +53,8 @@ int ldap_back_map_result( SlapReply *rs );
 int ldap_back_op_result( ldapconn_t *lc, Operation *op, SlapReply *rs,
 	ber_int_t msgid, time_t timeout, ldap_back_send_t sendok );
 int ldap_back_cancel( ldapconn_t *lc, Operation *op, SlapReply *rs, ber_int_t msgid, ldap_back_send_t sendok );
+void ldap_back_schedule_conn_warm( ldapinfo_t *li );
+void ldap_back_stop_conn_warm( ldapinfo_t *li );
 
 int ldap_back_init_cf( BackendInfo *bi );
 int ldap_pbind_init_cf( BackendInfo *bi );
@@ -116,6 +118,24 @@ extern int ldap_back_monitor_db_open( BackendDB *be );
 extern int ldap_back_monitor_db_close( BackendDB *be );
 extern int ldap_back_monitor_db_destroy( BackendDB *be );
 
+extern int ldap_back_dncache_init( ldap_dncache_t *cache );
+extern void ldap_back_dncache_destroy( ldap_dncache_t *cache );
+extern int ldap_back_dncache_get_target( ldap_dncache_t *cache,
+	struct berval *ndn );
+extern int ldap_back_dncache_update_entry( ldap_dncache_t *cache,
+	struct berval *ndn, int target );
+extern int ldap_back_dncache_delete_entry( ldap_dncache_t *cache,
+	struct berval *ndn );
+extern void ldap_back_dncache_stats( ldap_dncache_t *cache,
+	unsigned long *entries, unsigned long *hits,
+	unsigned long *misses, unsigned long *evictions );
+
+extern int ldap_back_dncache_monitor_db_init( BackendDB *be );
+extern int ldap_back_dncache_monitor_db_open( BackendDB *be,
+	ldap_dncache_t *cache );
+extern int ldap_back_dncache_monitor_db_close( BackendDB *be,
+	ldap_dncache_t *cache );
+
 extern LDAP_REBIND_PROC		ldap_back_default_rebind;
 extern LDAP_URLLIST_PROC	ldap_back_default_urllist;
 
@@ -73,6 +73,7 @@ struct mdb_info {
 	int			mi_dbenv_mode;
 
 	size_t		mi_mapsize;
+	unsigned	mi_pagesize;
 	ID			mi_nextid;
 	size_t		mi_maxentrysize;
 
@@ -45,6 +45,7 @@ enum {
 	MDB_SSTACK,
 	MDB_MULTIVAL,
 	MDB_IDLEXP,
+	MDB_PAGESIZE,
 };
 
 static ConfigTable mdbcfg[] = {
@@ -105,6 +106,11 @@ static ConfigTable mdbcfg[] = {
 		"DESC 'Hi/Lo thresholds for splitting multivalued attr out of main blob' "
 		"EQUALITY caseIgnoreMatch "
 		"SYNTAX OMsDirectoryString )", NULL, NULL },
+	{ "pagesize", "bytes", 2, 2, 0, ARG_UINT|ARG_MAGIC|MDB_PAGESIZE,
+		mdb_cf_gen, "( OLcfgDbAt:12.7 NAME 'olcDbPageSize' "
+		"DESC 'Page size of a newly created DB in bytes' "
+		"EQUALITY integerMatch "
+		"SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
 	{ "rtxnsize", "entries", 2, 2, 0, ARG_UINT|ARG_OFFSET,
 		(void *)offsetof(struct mdb_info, mi_rtxn_size),
 		"( OLcfgDbAt:12.5 NAME 'olcDbRtxnSize' "
@@ -138,7 +144,7 @@ static ConfigOCs mdbocs[] = {
 		"MAY ( olcDbCheckpoint $ olcDbEnvFlags $ "
 		"olcDbNoSync $ olcDbIndex $ olcDbMaxReaders $ olcDbMaxSize $ "
 		"olcDbMode $ olcDbSearchStack $ olcDbMaxEntrySize $ olcDbRtxnSize $ "
-		"olcDbMultival ) )",
+		"olcDbMultival $ olcDbPageSize ) )",
 			Cft_Database, mdbcfg+1 },
 	{ NULL, 0, NULL }
 };
@@ -550,6 +556,13 @@ mdb_cf_gen( ConfigArgs *c )
 			c->value_ulong = mdb->mi_mapsize;
 			break;
 
+		case MDB_PAGESIZE:
+			if ( mdb->mi_pagesize )
+				c->value_uint = mdb->mi_pagesize;
+			else
+				rc = 1;
+			break;
+
 		case MDB_MULTIVAL:
 			mdb_attr_multi_unparse( mdb, &c->rvalue_vals );
 			if ( !c->rvalue_vals ) rc = 1;
@@ -573,6 +586,10 @@ mdb_cf_gen( ConfigArgs *c )
 		case MDB_MAXSIZE:
 			break;
 
+		case MDB_PAGESIZE:
+			mdb->mi_pagesize = 0;
+			break;
+
 		case MDB_CHKPT:
 			if ( mdb->mi_txn_cp_task ) {
 				struct re_s *re = mdb->mi_txn_cp_task;
@@ -949,6 +966,19 @@ mdb_cf_gen( ConfigArgs *c )
 		}
 		break;
 
+	case MDB_PAGESIZE:
+		/* Only used when the DB gets created, no reopen needed */
+		if ( c->value_uint < 512 || c->value_uint > 32768 ||
+			( c->value_uint & ( c->value_uint - 1 ))) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg ),
+				"%s: page size must be a power of 2 between 512 and 32768",
+				c->argv[0] );
+			Debug( LDAP_DEBUG_ANY, "%s: %s\n", c->log, c->cr_msg );
+			return 1;
+		}
+		mdb->mi_pagesize = c->value_uint;
+		break;
+
 	case MDB_MULTIVAL:
 		rc = mdb_attr_multi_config( mdb, c->fname, c->lineno,
 			c->argc - 1, &c->argv[1], &c->reply);
@@ -665,6 +665,159 @@ return_results:
 	return(rc);
 }
 
+typedef struct mdb_entry_ref {
+	struct berval *ndn;
+	struct berval name;
+	ID id;
+	int i;
+} mdb_entry_ref;
+
+/* siblings are next to each other in dn2id */
+static int
+mdb_entry_ref_dncmp( const void *v1, const void *v2 )
+{
+	const mdb_entry_ref *r1 = v1, *r2 = v2;
+	struct berval p1, p2;
+	int rc;
+
+	dnParent( r1->ndn, &p1 );
+	dnParent( r2->ndn, &p2 );
+	rc = ber_bvcmp( &p1, &p2 );
+	if ( rc == 0 )
+		rc = ber_bvcmp( r1->ndn, r2->ndn );
+	return rc;
+}
+
+static int
+mdb_entry_ref_idcmp( const void *v1, const void *v2 )
+{
+	const mdb_entry_ref *r1 = v1, *r2 = v2;
+
+	return r1->id < r2->id ? -1 : r1->id > r2->id;
+}
+
+/* Fetch a list of entries within a single read txn: the DNs are looked
+ * up in DN order with one dn2id cursor, then the entries are read in
+ * ID order with one id2entry cursor.
+ */
+int mdb_entry_get_list(
+	Operation *op,
+	BerVarray ndns,
+	ObjectClass *oc,
+	AttributeDescription *at,
+	slap_entry_list_cb *cb,
+	void *arg )
+{
+	struct mdb_info *mdb = (struct mdb_info *) op->o_bd->be_private;
+	struct mdb_op_info *moi = NULL;
+	MDB_txn *txn = NULL;
+	MDB_cursor *mc = NULL;
+	mdb_entry_ref *refs;
+	Entry *e;
+	int i, n, rc;
+
+	for ( n = 0; !BER_BVISNULL( &ndns[n] ); n++ )
+		;
+
+	Debug( LDAP_DEBUG_ARGS,
+		"=> mdb_entry_get_list: %d DNs\n", n );
+
+	if ( n == 0 )
+		return LDAP_SUCCESS;
+
+	rc = mdb_opinfo_get( op, mdb, 1, &moi );
+	if ( rc )
+		return LDAP_OTHER;
+	txn = moi->moi_txn;
+
+	refs = op->o_tmpalloc( n * sizeof(mdb_entry_ref), op->o_tmpmemctx );
+	for ( i = 0; i < n; i++ ) {
+		refs[i].ndn = &ndns[i];
+		BER_BVZERO( &refs[i].name );
+		refs[i].id = NOID;
+		refs[i].i = i;
+	}
+	qsort( refs, n, sizeof(mdb_entry_ref), mdb_entry_ref_dncmp );
+
+	rc = mdb_cursor_open( txn, mdb->mi_dn2id, &mc );
+	if ( rc ) {
+		rc = LDAP_OTHER;
+		goto done;
+	}
+	for ( i = 0; i < n; i++ ) {
+		if ( !dnIsSuffix( refs[i].ndn, &op->o_bd->be_nsuffix[0] ))
+			continue;
+		rc = mdb_dn2id( op, txn, mc, refs[i].ndn, &refs[i].id, NULL,
+			&refs[i].name, NULL );
+		if ( rc ) {
+			/* keep the pretty DN of found entries only */
+			op->o_tmpfree( refs[i].name.bv_val, op->o_tmpmemctx );
+			BER_BVZERO( &refs[i].name );
+			refs[i].id = NOID;
+			if ( rc != MDB_NOTFOUND ) {
+				rc = ( rc != LDAP_BUSY ) ? LDAP_OTHER : LDAP_BUSY;
+				goto done;
+			}
+		}
+	}
+	mdb_cursor_close( mc );
+
+	/* missing ones sort last */
+	qsort( refs, n, sizeof(mdb_entry_ref), mdb_entry_ref_idcmp );
+
+	rc = mdb_cursor_open( txn, mdb->mi_id2entry, &mc );
+	if ( rc ) {
+		mc = NULL;
+		rc = LDAP_OTHER;
+		goto done;
+	}
+	rc = LDAP_SUCCESS;
+	for ( i = 0; i < n && refs[i].id != NOID; i++ ) {
+		if ( mdb_id2entry( op, mc, refs[i].id, &e ) != MDB_SUCCESS )
+			continue;
+		e->e_name = refs[i].name;
+		BER_BVZERO( &refs[i].name );
+		ber_dupbv_x( &e->e_nname, refs[i].ndn, op->o_tmpmemctx );
+
+		if (( !oc || is_entry_objectclass( e, oc, 0 )) &&
+			/* NOTE: attr_find() or attrs_find()? */
+			( !at || attr_find( e->e_attrs, at ) != NULL ))
+		{
+			rc = cb( op, refs[i].i, e, arg );
+		}
+		mdb_entry_return( op, e );
+		if ( rc != LDAP_SUCCESS )
+			break;
+	}
+
+done:
+	if ( mc )
+		mdb_cursor_close( mc );
+	for ( i = 0; i < n; i++ ) {
+		if ( refs[i].name.bv_val )
+			op->o_tmpfree( refs[i].name.bv_val, op->o_tmpmemctx );
+	}
+	op->o_tmpfree( refs, op->o_tmpmemctx );
+
+	/* release the txn the way mdb_entry_release() would */
+	if (( slapMode & SLAP_SERVER_MODE ) &&
+		( moi->moi_flag & (MOI_FREEIT|MOI_KEEPER)) == MOI_FREEIT )
+	{
+		moi->moi_ref--;
+		if ( moi->moi_ref < 1 ) {
+			mdb_txn_reset( moi->moi_txn );
+			moi->moi_ref = 0;
+			LDAP_SLIST_REMOVE( &op->o_extra, &moi->moi_oe, OpExtra, oe_next );
+			op->o_tmpfree( moi, op->o_tmpmemctx );
+		}
+	}
+
+	Debug( LDAP_DEBUG_TRACE,
+		"mdb_entry_get_list: rc=%d\n",
+		rc );
+	return rc;
+}
+
 static void
 mdb_reader_free( void *key, void *data )
 {
@@ -136,6 +136,17 @@ mdb_db_open( BackendDB *be, ConfigReply *cr )
 		}
 	}
 
+	if ( mdb->mi_pagesize ) {
+		rc = mdb_env_set_pagesize( mdb->mi_dbenv, mdb->mi_pagesize );
+		if( rc != 0 ) {
+			Debug( LDAP_DEBUG_ANY,
+				LDAP_XSTRING(mdb_db_open) ": database \"%s\": "
+				"mdb_env_set_pagesize failed: %s (%d).\n",
+				be->be_suffix[0].bv_val, mdb_strerror(rc), rc );
+			goto fail;
+		}
+	}
+
 	rc = mdb_env_set_mapsize( mdb->mi_dbenv, mdb->mi_mapsize );
 	if( rc != 0 ) {
 		Debug( LDAP_DEBUG_ANY,
@@ -493,6 +504,7 @@ mdb_back_initialize(
 	bi->bi_has_subordinates = mdb_hasSubordinates;
 	bi->bi_entry_release_rw = mdb_entry_release;
 	bi->bi_entry_get_rw = mdb_entry_get;
+	bi->bi_entry_get_list = mdb_entry_get_list;
 
 	/*
 	 * hooks for slap tools
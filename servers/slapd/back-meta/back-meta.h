@@ -392,14 +392,11 @@ typedef struct metatarget_t {
 
 } metatarget_t;
 
-typedef struct metadncache_t {
-	ldap_pvt_thread_mutex_t mutex;
-	Avlnode			*tree;
+/* the dn cache is shared with back-asyncmeta, see back-ldap/dncache.c */
+typedef ldap_dncache_t metadncache_t;
 
 #define META_DNCACHE_DISABLED   (0)
 #define META_DNCACHE_FOREVER    ((time_t)(-1))
-	time_t			ttl;  /* seconds; 0: no cache, -1: no expiry */
-} metadncache_t;
 
 typedef struct metacandidates_t {
 	int			mc_ntargets;
@@ -633,39 +630,8 @@ meta_clear_one_candidate(
 	metaconn_t		*mc,
 	int			candidate );
 
-/*
- * Dn cache stuff (experimental)
- */
-extern int
-meta_dncache_cmp(
-	const void		*c1,
-	const void		*c2 );
-
-extern int
-meta_dncache_dup(
-	void			*c1,
-	void			*c2 );
-
 #define META_TARGET_NONE	(-1)
 #define META_TARGET_MULTIPLE	(-2)
-extern int
-meta_dncache_get_target(
-	metadncache_t		*cache,
-	struct berval		*ndn );
-
-extern int
-meta_dncache_update_entry(
-	metadncache_t		*cache,
-	struct berval		*ndn,
-	int			target );
-
-extern int
-meta_dncache_delete_entry(
-	metadncache_t		*cache,
-	struct berval		*ndn );
-
-extern void
-meta_dncache_free( void *entry );
 
 extern void
 meta_back_map_free( struct ldapmap *lm );
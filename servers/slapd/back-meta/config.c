@@ -58,6 +58,7 @@ static int ldap_back_map_config(
 enum {
 	LDAP_BACK_CFG_CONN_TTL = 1,
 	LDAP_BACK_CFG_DNCACHE_TTL,
+	LDAP_BACK_CFG_DNCACHE_SIZE,
 	LDAP_BACK_CFG_IDLE_TIMEOUT,
 	LDAP_BACK_CFG_ONERR,
 	LDAP_BACK_CFG_PSEUDOROOT_BIND_DEFER,
@@ -347,6 +348,15 @@ static ConfigTable metacfg[] = {
 			"SYNTAX OMsDirectoryString "
 			"SINGLE-VALUE )",
 		NULL, NULL },
+	{ "dncache-size", "<n>", 2, 2, 0,
+		ARG_MAGIC|ARG_UINT|LDAP_BACK_CFG_DNCACHE_SIZE,
+		meta_back_cf_gen, "( OLcfgDbAt:3.119 "
+			"NAME 'olcDbDnCacheSize' "
+			"DESC 'Max number of entries in the dncache' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger "
+			"SINGLE-VALUE )",
+		NULL, NULL },
 	{ "bind-timeout", "microseconds", 2, 2, 0,
 		ARG_MAGIC|ARG_ULONG|LDAP_BACK_CFG_BIND_TIMEOUT,
 		meta_back_cf_gen, "( OLcfgDbAt:3.107 "
@@ -471,6 +481,7 @@ static ConfigOCs metaocs[] = {
 		"SUP olcDatabaseConfig "
 		"MAY ( olcDbConnTtl "
 			"$ olcDbDnCacheTtl "
+			"$ olcDbDnCacheSize "
 			"$ olcDbIdleTimeout "
 			"$ olcDbOnErr "
 			"$ olcDbPseudoRootBindDefer "
@@ -1148,6 +1159,13 @@ meta_back_cf_gen( ConfigArgs *c )
 			value_add_one( &c->rvalue_vals, &bv );
 			break;
 
+		case LDAP_BACK_CFG_DNCACHE_SIZE:
+			if ( mi->mi_cache.size == 0 ) {
+				return 1;
+			}
+			c->value_uint = mi->mi_cache.size;
+			break;
+
 		case LDAP_BACK_CFG_IDLE_TIMEOUT:
 			if ( mi->mi_idle_timeout == 0 ) {
 				return 1;
@@ -1636,6 +1654,10 @@ meta_back_cf_gen( ConfigArgs *c )
 			mi->mi_cache.ttl = META_DNCACHE_DISABLED;
 			break;
 
+		case LDAP_BACK_CFG_DNCACHE_SIZE:
+			mi->mi_cache.size = 0;
+			break;
+
 		case LDAP_BACK_CFG_IDLE_TIMEOUT:
 			mi->mi_idle_timeout = 0;
 			break;
@@ -2238,6 +2260,11 @@ meta_back_cf_gen( ConfigArgs *c )
 		}
 		break;
 
+	case LDAP_BACK_CFG_DNCACHE_SIZE:
+	/* max number of entries in dn cache; 0 means no limit */
+		mi->mi_cache.size = c->value_uint;
+		break;
+
 	case LDAP_BACK_CFG_NETWORK_TIMEOUT: {
 	/* network timeout when connecting to ldap servers */
 		unsigned long t;
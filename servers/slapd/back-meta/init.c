@@ -66,7 +66,7 @@ meta_back_initialize(
 	bi->bi_db_init = meta_back_db_init;
 	bi->bi_db_config = config_generic_wrapper;
 	bi->bi_db_open = meta_back_db_open;
-	bi->bi_db_close = 0;
+	bi->bi_db_close = meta_back_db_close;
 	bi->bi_db_destroy = meta_back_db_destroy;
 
 	bi->bi_op_bind = meta_back_bind;
@@ -129,7 +129,6 @@ meta_back_db_init(
 	mi->mi_urllist_f = meta_back_default_urllist;
 
 	ldap_pvt_thread_mutex_init( &mi->mi_conninfo.lai_mutex );
-	ldap_pvt_thread_mutex_init( &mi->mi_cache.mutex );
 
 	/* safe default */
 	mi->mi_nretries = META_RETRY_DEFAULT;
@@ -142,6 +141,8 @@ meta_back_db_init(
 	mi->mi_conn_priv_max = LDAP_BACK_CONN_PRIV_DEFAULT;
 	
 	mi->mi_ldap_extra = (ldap_extra_t *)bi->bi_extra;
+	mi->mi_ldap_extra->dncache_init( &mi->mi_cache );
+	(void)mi->mi_ldap_extra->dncache_monitor_db_init( be );
 
 	be->be_private = mi;
 	be->be_cf_ocs = be->bd_info->bi_cf_ocs;
@@ -262,6 +263,23 @@ meta_back_db_open(
 			return 1;
 	}
 
+	/* monitor setup */
+	(void)mi->mi_ldap_extra->dncache_monitor_db_open( be, &mi->mi_cache );
+
+	return 0;
+}
+
+int
+meta_back_db_close(
+	Backend		*be,
+	ConfigReply	*cr )
+{
+	metainfo_t	*mi = (metainfo_t *)be->be_private;
+
+	if ( mi ) {
+		(void)mi->mi_ldap_extra->dncache_monitor_db_close( be, &mi->mi_cache );
+	}
+
 	return 0;
 }
 
@@ -439,13 +457,7 @@ meta_back_db_destroy(
 			free( mi->mi_targets );
 		}
 
-		ldap_pvt_thread_mutex_lock( &mi->mi_cache.mutex );
-		if ( mi->mi_cache.tree ) {
-			ldap_avl_free( mi->mi_cache.tree, meta_dncache_free );
-		}
-		
-		ldap_pvt_thread_mutex_unlock( &mi->mi_cache.mutex );
-		ldap_pvt_thread_mutex_destroy( &mi->mi_cache.mutex );
+		mi->mi_ldap_extra->dncache_destroy( &mi->mi_cache );
 
 		ldap_pvt_thread_mutex_unlock( &mi->mi_conninfo.lai_mutex );
 		ldap_pvt_thread_mutex_destroy( &mi->mi_conninfo.lai_mutex );
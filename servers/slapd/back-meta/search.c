@@ -2075,7 +2075,7 @@ meta_send_entry(
 	 * cache dn
 	 */
 	if ( mi->mi_cache.ttl != META_DNCACHE_DISABLED ) {
-		( void )meta_dncache_update_entry( &mi->mi_cache,
+		( void )mi->mi_ldap_extra->dncache_update_entry( &mi->mi_cache,
 				&ent.e_nname, target );
 	}
 
@@ -252,6 +252,11 @@ enum {
 #define SLAPD_MONITOR_RWW_DN	\
 	SLAPD_MONITOR_RWW_RDN "," SLAPD_MONITOR_DN
 
+/* called for each dynamic subentry by mss_create_each(); it takes over
+ * the entry, a non-zero return stops the walk */
+typedef int (monitor_create_cb)( Operation *op, SlapReply *rs, Entry *e,
+	void *arg );
+
 typedef struct monitor_subsys_t {
 	char		*mss_name;
 	struct berval	mss_rdn;
@@ -279,6 +284,13 @@ typedef struct monitor_subsys_t {
 	int		( *mss_modify )( Operation *, SlapReply *, Entry * );
 
 	void		*mss_private;
+
+	/* create all dynamic subentries one at a time, passing each to
+	 * the callback; if set, used by searches instead of building
+	 * the whole list with mss_create() */
+	int		( *mss_create_each )( Operation *, SlapReply *,
+				struct monitor_subsys_t *ms,
+				monitor_create_cb *cb, void *arg );
 } monitor_subsys_t;
 
 extern BackendDB *be_monitor;
@@ -42,6 +42,14 @@ monitor_subsys_conn_create(
 	Entry 			*e_parent,
 	Entry			**ep );
 
+static int
+monitor_subsys_conn_create_each(
+	Operation		*op,
+	SlapReply		*rs,
+	monitor_subsys_t	*ms,
+	monitor_create_cb	*cb,
+	void			*arg );
+
 int
 monitor_subsys_conn_init(
 	BackendDB		*be,
@@ -57,6 +65,7 @@ monitor_subsys_conn_init(
 
 	ms->mss_update = monitor_subsys_conn_update;
 	ms->mss_create = monitor_subsys_conn_create;
+	ms->mss_create_each = monitor_subsys_conn_create_each;
 
 	mi = ( monitor_info_t * )be->be_private;
 
@@ -211,18 +220,7 @@ monitor_subsys_conn_update(
 		n = connections_nextid() - SLAPD_SYNC_SYNCCONN_OFFSET;
 
 	} else if ( dn_match( &rdn, &current_bv ) ) {
-		Connection	*c;
-		ber_socket_t	connindex;
-
-		for ( n = 0, c = connection_first( &connindex );
-				c != NULL;
-				n++, c = connection_next( c, &connindex ) )
-		{
-			/* Ignore outbound connections */
-			if ( c->c_conn_state == SLAP_C_CLIENT )
-				n--;
-		}
-		connection_done( c );
+		n = connections_current();
 	}
 
 	if ( n != -1 ) {
@@ -524,3 +522,49 @@ monitor_subsys_conn_create(
 	return rc;
 }
 
+
+static int
+monitor_subsys_conn_create_each(
+	Operation		*op,
+	SlapReply		*rs,
+	monitor_subsys_t	*ms,
+	monitor_create_cb	*cb,
+	void			*arg )
+{
+	monitor_info_t	*mi = ( monitor_info_t * )op->o_bd->be_private;
+	Connection	*c;
+	ber_socket_t	connindex;
+	int		rc = LDAP_SUCCESS;
+
+	assert( mi != NULL );
+	assert( ms != NULL );
+
+	/* build one entry at a time, and don't keep the connection
+	 * locked while it is being sent */
+	for ( c = connection_first( &connindex );
+			c != NULL;
+			c = connection_next( NULL, &connindex ) )
+	{
+		Entry	*e = NULL;
+
+		/* ignore outbound for now, nothing to show */
+		if ( c->c_conn_state == SLAP_C_CLIENT ) {
+			connection_done( c );
+			continue;
+		}
+
+		rc = conn_create( mi, c, &e, ms );
+		connection_done( c );
+		if ( rc != SLAP_CB_CONTINUE || e == NULL ) {
+			rc = rs->sr_err = LDAP_OTHER;
+			break;
+		}
+
+		rc = cb( op, rs, e, arg );
+		if ( rc != LDAP_SUCCESS ) {
+			break;
+		}
+	}
+
+	return rc;
+}
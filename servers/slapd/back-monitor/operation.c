@@ -182,13 +182,13 @@ monitor_subsys_ops_update(
 		ldap_pvt_mp_init( nCompleted );
 
 		ldap_pvt_thread_mutex_lock( &slap_counters.sc_mutex );
-		ldap_pvt_mp_add( nInitiated, slap_counters.sc_ops_initiated );
-		ldap_pvt_mp_add( nCompleted, slap_counters.sc_ops_completed );
+		ldap_pvt_mp_add( nInitiated, SLAP_COUNTER_GET( slap_counters.sc_ops_initiated ) );
+		ldap_pvt_mp_add( nCompleted, SLAP_COUNTER_GET( slap_counters.sc_ops_completed ) );
 		for ( sc = slap_counters.sc_next; sc; sc = sc->sc_next ) {
-			ldap_pvt_thread_mutex_lock( &sc->sc_mutex );
-			ldap_pvt_mp_add( nInitiated, sc->sc_ops_initiated );
-			ldap_pvt_mp_add( nCompleted, sc->sc_ops_completed );
-			ldap_pvt_thread_mutex_unlock( &sc->sc_mutex );
+			SLAP_COUNTERS_LOCK( sc );
+			ldap_pvt_mp_add( nInitiated, SLAP_COUNTER_GET( sc->sc_ops_initiated ) );
+			ldap_pvt_mp_add( nCompleted, SLAP_COUNTER_GET( sc->sc_ops_completed ) );
+			SLAP_COUNTERS_UNLOCK( sc );
 		}
 		ldap_pvt_thread_mutex_unlock( &slap_counters.sc_mutex );
 		
@@ -197,13 +197,13 @@ monitor_subsys_ops_update(
 			if ( dn_match( &rdn, &monitor_op[ i ].nrdn ) )
 			{
 				ldap_pvt_thread_mutex_lock( &slap_counters.sc_mutex );
-				ldap_pvt_mp_init_set( nInitiated, slap_counters.sc_ops_initiated_[ i ] );
-				ldap_pvt_mp_init_set( nCompleted, slap_counters.sc_ops_completed_[ i ] );
+				ldap_pvt_mp_init_set( nInitiated, SLAP_COUNTER_GET( slap_counters.sc_ops_initiated_[ i ] ) );
+				ldap_pvt_mp_init_set( nCompleted, SLAP_COUNTER_GET( slap_counters.sc_ops_completed_[ i ] ) );
 				for ( sc = slap_counters.sc_next; sc; sc = sc->sc_next ) {
-					ldap_pvt_thread_mutex_lock( &sc->sc_mutex );
-					ldap_pvt_mp_add( nInitiated, sc->sc_ops_initiated_[ i ] );
-					ldap_pvt_mp_add( nCompleted, sc->sc_ops_completed_[ i ] );
-					ldap_pvt_thread_mutex_unlock( &sc->sc_mutex );
+					SLAP_COUNTERS_LOCK( sc );
+					ldap_pvt_mp_add( nInitiated, SLAP_COUNTER_GET( sc->sc_ops_initiated_[ i ] ) );
+					ldap_pvt_mp_add( nCompleted, SLAP_COUNTER_GET( sc->sc_ops_completed_[ i ] ) );
+					SLAP_COUNTERS_UNLOCK( sc );
 				}
 				ldap_pvt_thread_mutex_unlock( &slap_counters.sc_mutex );
 				break;
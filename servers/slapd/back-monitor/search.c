@@ -30,22 +30,34 @@
 #include "back-monitor.h"
 #include "proto-back-monitor.h"
 
+/*
+ * volatile children are either returned as a list in vol, or,
+ * if the subsystem can create them one at a time, left to be
+ * streamed by monitor_send_children() through ms_vol
+ */
 static void
 monitor_find_children(
 	Operation *op,
 	SlapReply *rs,
 	Entry *e_parent,
 	Entry **nonv,
-	Entry **vol
+	Entry **vol,
+	monitor_subsys_t **ms_vol
 )
 {
 	monitor_entry_t *mp;
 
 	mp = ( monitor_entry_t * )e_parent->e_private;
 	*nonv = mp->mp_children;
+	*ms_vol = NULL;
 
 	if ( MONITOR_HAS_VOLATILE_CH( mp ) ) {
-		monitor_entry_create( op, rs, NULL, e_parent, vol );
+		if ( mp->mp_info && mp->mp_info->mss_create_each ) {
+			*ms_vol = mp->mp_info;
+
+		} else {
+			monitor_entry_create( op, rs, NULL, e_parent, vol );
+		}
 	}
 }
 
@@ -55,6 +67,25 @@ monitor_send_children(
 	SlapReply	*rs,
 	Entry		*e_nonvolatile,
 	Entry		*e_ch,
+	monitor_subsys_t *ms_vol,
+	int		sub );
+
+static int
+monitor_send_volatile( Operation *op, SlapReply *rs, Entry *e, void *arg )
+{
+	int	sub = *(int *)arg;
+
+	/* a list of one, released once sent */
+	return monitor_send_children( op, rs, NULL, e, NULL, sub );
+}
+
+static int
+monitor_send_children(
+	Operation	*op,
+	SlapReply	*rs,
+	Entry		*e_nonvolatile,
+	Entry		*e_ch,
+	monitor_subsys_t *ms_vol,
 	int		sub )
 {
 	monitor_info_t	*mi = ( monitor_info_t * )op->o_bd->be_private;
@@ -64,6 +95,15 @@ monitor_send_children(
 	int			rc,
 				nonvolatile = 0;
 
+	/* stream the volatile entries; nothing is locked yet */
+	if ( ms_vol != NULL ) {
+		rc = ms_vol->mss_create_each( op, rs, ms_vol,
+			monitor_send_volatile, &sub );
+		if ( rc != LDAP_SUCCESS ) {
+			return rc;
+		}
+	}
+
 	e = e_nonvolatile;
 
 	/* no volatile entries? */
@@ -98,6 +138,7 @@ monitor_send_children(
 	/* return entries */
 	for ( ; e != NULL; e = e_tmp ) {
 		Entry *sub_nv = NULL, *sub_ch = NULL;
+		monitor_subsys_t *sub_ms = NULL;
 
 		monitor_cache_lock( e );
 		monitor_entry_update( op, rs, e );
@@ -115,7 +156,7 @@ monitor_send_children(
 		}
 
 		if ( sub )
-			monitor_find_children( op, rs, e, &sub_nv, &sub_ch );
+			monitor_find_children( op, rs, e, &sub_nv, &sub_ch, &sub_ms );
 
 		rc = test_filter( op, e, op->oq_search.rs_filter );
 		if ( rc == LDAP_COMPARE_TRUE ) {
@@ -136,7 +177,7 @@ monitor_send_children(
 		}
 
 		if ( sub ) {
-			rc = monitor_send_children( op, rs, sub_nv, sub_ch, sub );
+			rc = monitor_send_children( op, rs, sub_nv, sub_ch, sub_ms, sub );
 			if ( rc ) {
 freeout:
 				monitor_cache_release( mi, e );
@@ -172,6 +213,7 @@ monitor_back_search( Operation *op, SlapReply *rs )
 	int		rc = LDAP_SUCCESS;
 	Entry		*e = NULL, *matched = NULL;
 	Entry		*e_nv = NULL, *e_ch = NULL;
+	monitor_subsys_t *ms_vol = NULL;
 	slap_mask_t	mask;
 
 	Debug( LDAP_DEBUG_TRACE, "=> monitor_back_search\n" );
@@ -237,15 +279,15 @@ monitor_back_search( Operation *op, SlapReply *rs )
 
 	case LDAP_SCOPE_ONELEVEL:
 	case LDAP_SCOPE_SUBORDINATE:
-		monitor_find_children( op, rs, e, &e_nv, &e_ch );
-		rc = monitor_send_children( op, rs, e_nv, e_ch,
+		monitor_find_children( op, rs, e, &e_nv, &e_ch, &ms_vol );
+		rc = monitor_send_children( op, rs, e_nv, e_ch, ms_vol,
 			op->oq_search.rs_scope == LDAP_SCOPE_SUBORDINATE );
 		monitor_cache_release( mi, e );
 		break;
 
 	case LDAP_SCOPE_SUBTREE:
 		monitor_entry_update( op, rs, e );
-		monitor_find_children( op, rs, e, &e_nv, &e_ch );
+		monitor_find_children( op, rs, e, &e_nv, &e_ch, &ms_vol );
 		rc = test_filter( op, e, op->oq_search.rs_filter );
 		if ( rc == LDAP_COMPARE_TRUE ) {
 			rs->sr_entry = e;
@@ -253,7 +295,7 @@ monitor_back_search( Operation *op, SlapReply *rs )
 			rs->sr_entry = NULL;
 		}
 
-		rc = monitor_send_children( op, rs, e_nv, e_ch, 1 );
+		rc = monitor_send_children( op, rs, e_nv, e_ch, ms_vol, 1 );
 		monitor_cache_release( mi, e );
 		break;
 
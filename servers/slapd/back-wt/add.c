@@ -38,7 +38,7 @@ wt_add( Operation *op, SlapReply *rs )
 	LDAPControl **postread_ctrl = NULL;
 	LDAPControl *ctrls[SLAP_MAX_RESPONSE_CONTROLS];
 	int num_ctrls = 0;
-	wt_ctx *wc;
+	wt_ctx *wc = NULL;
 	Entry *e = NULL;
 	Entry *p = NULL;
 	ID pid = NOID;
@@ -317,7 +317,7 @@ wt_add( Operation *op, SlapReply *rs )
 		goto return_results;
 	}
 
-	rc = wc->session->commit_transaction(wc->session, NULL);
+	rc = wc->session->commit_transaction(wc->session, WT_COMMIT_CONFIG(wi));
 	if( rc ) {
 		Debug( LDAP_DEBUG_TRACE,
 			   "<== wt_add: commit_transaction failed: %s (%d)\n",
@@ -353,6 +353,10 @@ wt_add( Operation *op, SlapReply *rs )
 		  op->ora_e->e_id, op->ora_e->e_dn );
 
 return_results:
+	if ( wc ) {
+		wt_idlcache_release( wi, wc );
+	}
+
 	send_ldap_result( op, rs );
 
 	slap_graduate_commit_csn( op );
@@ -35,9 +35,26 @@
 
 #define WT_CONFIG_MAX 2048
 
+/* Keep cursors open in the per-thread context between operations,
+ * only resetting them after use */
+#ifndef WT_NO_CURSOR_CACHE
+#define WT_CURSOR_CACHE
+#endif
+
+/* Number of entries per transaction in quick tool mode */
+#ifndef WT_WRITES_PER_COMMIT
+#define WT_WRITES_PER_COMMIT	500
+#endif
+
+/* The default number of IDs kept in the idlcache */
+#ifndef DEFAULT_IDLCACHE_SIZE
+#define DEFAULT_IDLCACHE_SIZE	(1<<20)
+#endif
+
+typedef struct wt_idlcache_shard wt_idlcache_shard;
+
 struct wt_info {
 	WT_CONNECTION *wi_conn;
-	WT_CONNECTION *wi_cache;
 	char *wi_home;
 	char *wi_config;
 	ID	wi_lastid;
@@ -50,6 +67,12 @@ struct wt_info {
 
 	struct re_s *wi_index_task;
 
+	wt_idlcache_shard *wi_idlcache;
+	unsigned long wi_idlcache_size;	/* in IDs */
+
+	time_t wi_logsync;		/* interval between log flushes */
+	struct re_s *wi_logsync_task;
+
 	int wi_flags;
 #define WT_IS_OPEN      0x01
 #define WT_OPEN_INDEX   0x02
@@ -68,8 +91,8 @@ struct wt_info {
 /* Currently, revdn is primary key, the revdn index is obsolete. */
 #define WT_INDEX_REVDN "index:dn2id:revdn"
 
-/* table for cache */
-#define WT_TABLE_IDLCACHE "table:idlcache"
+/* Unless updates are flushed to the log periodically, commit as configured */
+#define WT_COMMIT_CONFIG(wi) ((wi)->wi_logsync ? "sync=off" : NULL)
 
 #define ITEMzero(item) (memset((item), 0, sizeof(WT_ITEM)))
 #define ITEM2bv(item,bv) ((bv)->bv_val = (item)->data, \
@@ -89,10 +112,16 @@ typedef struct {
 	WT_CURSOR *id2entry;
 	WT_CURSOR *id2entry_add;
 	WT_CURSOR *id2entry_update;
-	WT_SESSION *idlcache_session;
+	BerVarray idlcache_dirty;	/* idlcache keys to clear after commit */
 	WT_CURSOR *index_pid;
+	TAvlnode *index_cursors;	/* cached index cursors, by attribute */
 } wt_ctx;
 
+typedef struct wt_index_cursor {
+	struct berval name;
+	WT_CURSOR *cursor;
+} wt_index_cursor;
+
 /* for the cache of attribute information (which are indexed, etc.) */
 typedef struct wt_attrinfo {
 	AttributeDescription *ai_desc; /* attribute description cn;lang-en */
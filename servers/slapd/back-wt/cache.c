@@ -26,202 +26,457 @@
 #include "back-wt.h"
 #include "slap-config.h"
 #include "idl.h"
+#include "lutil_hash.h"
 
-int wt_idlcache_get(wt_ctx *wc, struct berval *ndn, int scope, ID *ids)
+/*
+ * The idlcache keeps candidate lists in memory, so that repeated scopes
+ * and filter components are answered without calling WiredTiger.
+ *
+ * It holds the scope candidates of dn2idl, keyed by normalized DN and
+ * scope, and the ids of index keys, keyed by index name and key.
+ *
+ * As the IDL cache of back-bdb did, the lists are kept in an AVL tree
+ * under a reader/writer lock, so that hits only need the read lock.
+ * A hit just marks the list as referenced; once the cache holds more
+ * than idlcachesize IDs, lists are evicted from the oldest on, those
+ * referenced since they were last looked at getting another round.
+ * To keep writers from serializing all readers, the cache is split in
+ * a few shards, each with its own tree, lock and share of idlcachesize.
+ *
+ * A reader that misses leaves a loading entry behind and gets a ticket
+ * for it; the list it reads is only kept if the entry was not removed
+ * meanwhile. Writers remove the entries they touch at once, and again
+ * when their transaction is over, so that a list read from a snapshot
+ * older than the commit is never kept.
+ */
+
+#define WT_IDLCACHE_SHARDS	16
+
+/* cache keys: type, name, NUL, key */
+#define WT_IDLCACHE_SCOPE	'd'
+#define WT_IDLCACHE_INDEX	'i'
+#define WT_IDLCACHE_KEYBUF	256
+
+typedef struct wt_idlcache_entry {
+	struct berval key;
+	ID *ids;				/* NULL while the list is being read */
+	unsigned long nids;
+	unsigned long ticket;
+	int referenced;			/* hit since the last eviction pass */
+	LDAP_TAILQ_ENTRY(wt_idlcache_entry) lru;
+} wt_idlcache_entry;
+
+struct wt_idlcache_shard {
+	ldap_pvt_thread_rdwr_t rwlock;
+	TAvlnode *tree;
+	/* the rest is only changed with the write lock held */
+	LDAP_TAILQ_HEAD(wt_idlcache_lru, wt_idlcache_entry) lru;
+	unsigned long nids;
+	unsigned long ticket;
+};
+
+static int
+wt_idlcache_cmp( const void *v1, const void *v2 )
 {
-	int rc = 0;
-	WT_ITEM item;
-	WT_SESSION *session = wc->idlcache_session;
-	WT_CURSOR *cursor = NULL;
+	const wt_idlcache_entry *e1 = v1, *e2 = v2;
 
-	Debug( LDAP_DEBUG_TRACE,
-		   "=> wt_idlcache_get(\"%s\", %d)\n",
-		   ndn->bv_val, scope );
+	return ber_bvcmp( &e1->key, &e2->key );
+}
 
-	rc = session->open_cursor(session, WT_TABLE_IDLCACHE, NULL,
-							  NULL, &cursor);
-	if(rc){
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_idlcache_get: open_cursor failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		return rc;
-	}
-	cursor->set_key(cursor, ndn->bv_val, (int8_t)scope);
-	rc = cursor->search(cursor);
-	switch( rc ){
-	case 0:
-		break;
-	case WT_NOTFOUND:
-		Debug(LDAP_DEBUG_TRACE, "<= wt_idlcache_get: miss\n" );
-		goto done;
-	default:
-		Debug( LDAP_DEBUG_ANY, "<= wt_idlcache_get: search failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		rc = 0;
-		goto done;
+static wt_idlcache_shard *
+wt_idlcache_shard_of( struct wt_info *wi, struct berval *key )
+{
+	lutil_HASH_CTX ctx;
+
+	lutil_HASHInit( &ctx );
+	lutil_HASHUpdate( &ctx, (unsigned char *)key->bv_val, key->bv_len );
+	return &wi->wi_idlcache[ lutil_HASHValue( &ctx ) % WT_IDLCACHE_SHARDS ];
+}
+
+static void
+wt_idlcache_mkkey( struct berval *ck, char *buf, char type,
+				   struct berval *name, struct berval *key )
+{
+	ck->bv_len = 1 + name->bv_len + 1 + key->bv_len;
+	ck->bv_val = ck->bv_len <= WT_IDLCACHE_KEYBUF ? buf
+		: ch_malloc( ck->bv_len );
+	ck->bv_val[0] = type;
+	AC_MEMCPY( ck->bv_val + 1, name->bv_val, name->bv_len );
+	ck->bv_val[1 + name->bv_len] = '\0';
+	AC_MEMCPY( ck->bv_val + 2 + name->bv_len, key->bv_val, key->bv_len );
+}
+
+#define wt_idlcache_freekey(ck, buf) \
+	do { if ( (ck)->bv_val != (buf) ) ch_free( (ck)->bv_val ); } while (0)
+
+/* call with the write lock held */
+static void
+wt_idlcache_remove( wt_idlcache_shard *shard, wt_idlcache_entry *e )
+{
+	ldap_tavl_delete( &shard->tree, e, wt_idlcache_cmp );
+	LDAP_TAILQ_REMOVE( &shard->lru, e, lru );
+	shard->nids -= e->nids;
+
+	ch_free( e->ids );
+	ch_free( e );
+}
+
+/*
+ * Copy the cached list for key into ids and return 0. On a miss return
+ * WT_NOTFOUND and set *ticket to the one wt_idlcache_store() expects,
+ * or to 0 if the list must not be stored.
+ */
+static int
+wt_idlcache_lookup( struct wt_info *wi, struct berval *key, ID *ids,
+					unsigned long *ticket )
+{
+	wt_idlcache_shard *shard;
+	wt_idlcache_entry needle, *e;
+
+	*ticket = 0;
+	if ( !wi->wi_idlcache || !( wi->wi_flags & WT_USE_IDLCACHE ) ) {
+		return WT_NOTFOUND;
 	}
-	rc = cursor->get_value(cursor, &item);
-	if (rc) {
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_idlcache_get: get_value failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
+
+	shard = wt_idlcache_shard_of( wi, key );
+	needle.key = *key;
+
+	ldap_pvt_thread_rdwr_rlock( &shard->rwlock );
+	e = ldap_tavl_find( shard->tree, &needle, wt_idlcache_cmp );
+	if ( e && e->ids ) {
+		WT_IDL_CPY( ids, e->ids );
+		/* readers share the lock, evictions hold it exclusively */
+		__atomic_store_n( &e->referenced, 1, __ATOMIC_RELAXED );
+		ldap_pvt_thread_rdwr_runlock( &shard->rwlock );
+		return 0;
+	}
+	ldap_pvt_thread_rdwr_runlock( &shard->rwlock );
+
+	ldap_pvt_thread_rdwr_wlock( &shard->rwlock );
+	e = ldap_tavl_find( shard->tree, &needle, wt_idlcache_cmp );
+	if ( e && e->ids ) {
+		/* stored while we weren't looking */
+		WT_IDL_CPY( ids, e->ids );
+		e->referenced = 1;
+		ldap_pvt_thread_rdwr_wunlock( &shard->rwlock );
+		return 0;
+	}
+	if ( !e ) {
+		e = ch_calloc( 1, sizeof( wt_idlcache_entry ) + key->bv_len );
+		e->key.bv_val = (char *)(e + 1);
+		e->key.bv_len = key->bv_len;
+		AC_MEMCPY( e->key.bv_val, key->bv_val, key->bv_len );
+		if ( ++shard->ticket == 0 ) {
+			shard->ticket++;
+		}
+		e->ticket = shard->ticket;
+		ldap_tavl_insert( &shard->tree, e, wt_idlcache_cmp,
+						  ldap_avl_dup_error );
+		LDAP_TAILQ_INSERT_HEAD( &shard->lru, e, lru );
+	}
+	/* another reader loading the same list stores the same result */
+	*ticket = e->ticket;
+	ldap_pvt_thread_rdwr_wunlock( &shard->rwlock );
+
+	return WT_NOTFOUND;
+}
+
+static void
+wt_idlcache_store( struct wt_info *wi, struct berval *key,
+				   unsigned long ticket, ID *ids )
+{
+	wt_idlcache_shard *shard;
+	wt_idlcache_entry needle, *e;
+	unsigned long nids, limit;
+
+	if ( !ticket || !wi->wi_idlcache ) {
+		return;
+	}
+
+	nids = WT_IDL_SIZEOF( ids ) / sizeof( ID );
+	limit = wi->wi_idlcache_size / WT_IDLCACHE_SHARDS;
+	shard = wt_idlcache_shard_of( wi, key );
+	needle.key = *key;
+
+	ldap_pvt_thread_rdwr_wlock( &shard->rwlock );
+	e = ldap_tavl_find( shard->tree, &needle, wt_idlcache_cmp );
+	if ( !e || e->ticket != ticket ) {
+		/* changed by a writer meanwhile, or stored already */
 		goto done;
 	}
-	if (item.size == 0) {
-		Debug(LDAP_DEBUG_TRACE, "<= wt_idlcache_get: updating\n");
-		rc = WT_NOTFOUND;
+	if ( nids > limit ) {
+		wt_idlcache_remove( shard, e );
 		goto done;
 	}
-	memcpy(ids, item.data, item.size);
 
-	Debug(LDAP_DEBUG_TRACE,
-		  "<= wt_idlcache_get: hit id=%ld first=%ld last=%ld\n",
-		  (long)ids[0],
-		  (long)WT_IDL_FIRST(ids),
-		  (long)WT_IDL_LAST(ids));
+	e->ids = ch_malloc( nids * sizeof( ID ) );
+	WT_IDL_CPY( e->ids, ids );
+	e->nids = nids;
+	e->ticket = 0;
+	shard->nids += nids;
+
+	/* second chance: referenced lists go back to the head once */
+	while ( shard->nids > limit ) {
+		e = LDAP_TAILQ_LAST( &shard->lru, wt_idlcache_lru );
+		if ( e->referenced ) {
+			e->referenced = 0;
+			LDAP_TAILQ_REMOVE( &shard->lru, e, lru );
+			LDAP_TAILQ_INSERT_HEAD( &shard->lru, e, lru );
+			continue;
+		}
+		wt_idlcache_remove( shard, e );
+	}
+
 done:
-	if(cursor) {
-		cursor->close(cursor);
+	ldap_pvt_thread_rdwr_wunlock( &shard->rwlock );
+}
+
+static void
+wt_idlcache_drop( struct wt_info *wi, struct berval *key )
+{
+	wt_idlcache_shard *shard;
+	wt_idlcache_entry needle, *e;
+
+	shard = wt_idlcache_shard_of( wi, key );
+	needle.key = *key;
+
+	ldap_pvt_thread_rdwr_wlock( &shard->rwlock );
+	e = ldap_tavl_find( shard->tree, &needle, wt_idlcache_cmp );
+	if ( e ) {
+		wt_idlcache_remove( shard, e );
 	}
-	return rc;
+	ldap_pvt_thread_rdwr_wunlock( &shard->rwlock );
 }
 
-int wt_idlcache_set(wt_ctx *wc, struct berval *ndn, int scope, ID *ids)
+/* drop key now, and once more from wt_idlcache_release() */
+static void
+wt_idlcache_dirty( struct wt_info *wi, wt_ctx *wc, struct berval *key )
 {
-	int rc = 0;
-	WT_ITEM item;
-	WT_SESSION *session = wc->idlcache_session;
-	WT_CURSOR *cursor = NULL;
+	struct berval bv;
 
-	Debug( LDAP_DEBUG_TRACE,
-		   "=> wt_idlcache_set(\"%s\", %d)\n",
-		   ndn->bv_val, scope );
+	wt_idlcache_drop( wi, key );
+	ber_dupbv( &bv, key );
+	ber_bvarray_add( &wc->idlcache_dirty, &bv );
+}
 
-	item.size = WT_IDL_SIZEOF(ids);
-	item.data = ids;
-
-	rc = session->open_cursor(session, WT_TABLE_IDLCACHE, NULL,
-							  "overwrite=false", &cursor);
-	if(rc){
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_idlcache_set: open_cursor failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		return rc;
-	}
-	cursor->set_key(cursor, ndn->bv_val, (int8_t)scope);
-	cursor->set_value(cursor, &item);
-	rc = cursor->update(cursor);
-	switch( rc ){
-	case 0:
-		break;
-	case WT_NOTFOUND:
-		// updating cache by another thread
-		goto done;
-	default:
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_idlcache_set: update failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		goto done;
+int
+wt_idlcache_init( struct wt_info *wi )
+{
+	unsigned i;
+
+	wi->wi_idlcache = ch_calloc( WT_IDLCACHE_SHARDS,
+								 sizeof( wt_idlcache_shard ) );
+	for ( i = 0; i < WT_IDLCACHE_SHARDS; i++ ) {
+		wt_idlcache_shard *shard = &wi->wi_idlcache[i];
+
+		ldap_pvt_thread_rdwr_init( &shard->rwlock );
+		LDAP_TAILQ_INIT( &shard->lru );
 	}
+	return 0;
+}
 
-	Debug(LDAP_DEBUG_TRACE,
-		  "<= wt_idlcache_set: set idl size=%ld\n",
-		  (long)ids[0]);
-done:
-	if(cursor) {
-		cursor->close(cursor);
+/* remove all entries, lists being read included */
+void
+wt_idlcache_flush( struct wt_info *wi )
+{
+	unsigned i;
+
+	if ( !wi->wi_idlcache ) {
+		return;
+	}
+
+	for ( i = 0; i < WT_IDLCACHE_SHARDS; i++ ) {
+		wt_idlcache_shard *shard = &wi->wi_idlcache[i];
+		wt_idlcache_entry *e;
+
+		ldap_pvt_thread_rdwr_wlock( &shard->rwlock );
+		ldap_tavl_free( shard->tree, NULL );
+		shard->tree = NULL;
+		while ( ( e = LDAP_TAILQ_FIRST( &shard->lru ) ) != NULL ) {
+			LDAP_TAILQ_REMOVE( &shard->lru, e, lru );
+			ch_free( e->ids );
+			ch_free( e );
+		}
+		shard->nids = 0;
+		ldap_pvt_thread_rdwr_wunlock( &shard->rwlock );
 	}
-	return rc;
 }
 
-int wt_idlcache_begin(wt_ctx *wc, struct berval *ndn, int scope)
+void
+wt_idlcache_destroy( struct wt_info *wi )
 {
-	int rc = 0;
-	WT_ITEM item;
-	WT_SESSION *session = wc->idlcache_session;
-	WT_CURSOR *cursor = NULL;
+	unsigned i;
+
+	if ( !wi->wi_idlcache ) {
+		return;
+	}
+
+	wt_idlcache_flush( wi );
+	for ( i = 0; i < WT_IDLCACHE_SHARDS; i++ ) {
+		ldap_pvt_thread_rdwr_destroy( &wi->wi_idlcache[i].rwlock );
+	}
+	ch_free( wi->wi_idlcache );
+	wi->wi_idlcache = NULL;
+}
+
+int
+wt_idlcache_get( struct wt_info *wi, struct berval *ndn, int scope,
+				 ID *ids, unsigned long *ticket )
+{
+	char buf[WT_IDLCACHE_KEYBUF], s = scope;
+	struct berval ck, key = { 1, &s };
+	int rc;
 
 	Debug( LDAP_DEBUG_TRACE,
-		   "=> wt_idlcache_begin(\"%s\", %d)\n",
+		   "=> wt_idlcache_get(\"%s\", %d)\n",
 		   ndn->bv_val, scope );
 
-	item.size = 0;
-	item.data = "";
-
-	rc = session->open_cursor(session, WT_TABLE_IDLCACHE, NULL,
-							  "overwrite=true", &cursor);
-	if(rc){
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_idlcache_begin: open_cursor failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		return rc;
-	}
-	cursor->set_key(cursor, ndn->bv_val, (int8_t)scope);
-	cursor->set_value(cursor, &item);
-	rc = cursor->update(cursor);
-	if(rc){
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_idlcache_begin: update failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		goto done;
+	wt_idlcache_mkkey( &ck, buf, WT_IDLCACHE_SCOPE, ndn, &key );
+	rc = wt_idlcache_lookup( wi, &ck, ids, ticket );
+	wt_idlcache_freekey( &ck, buf );
+
+	if ( rc ) {
+		Debug( LDAP_DEBUG_TRACE, "<= wt_idlcache_get: miss\n" );
+	} else {
+		Debug( LDAP_DEBUG_TRACE,
+			   "<= wt_idlcache_get: hit id=%ld first=%ld last=%ld\n",
+			   (long)ids[0],
+			   (long)WT_IDL_FIRST(ids),
+			   (long)WT_IDL_LAST(ids) );
 	}
+	return rc;
+}
 
-	Debug(LDAP_DEBUG_TRACE,
-		  "<= wt_idlcache_begin: set updating\n" );
+void
+wt_idlcache_set( struct wt_info *wi, struct berval *ndn, int scope,
+				 unsigned long ticket, ID *ids )
+{
+	char buf[WT_IDLCACHE_KEYBUF], s = scope;
+	struct berval ck, key = { 1, &s };
 
-done:
-	if(cursor) {
-		cursor->close(cursor);
+	if ( !ticket ) {
+		return;
 	}
-	return rc;
+
+	Debug( LDAP_DEBUG_TRACE,
+		   "=> wt_idlcache_set(\"%s\", %d) size=%ld\n",
+		   ndn->bv_val, scope, (long)ids[0] );
+
+	wt_idlcache_mkkey( &ck, buf, WT_IDLCACHE_SCOPE, ndn, &key );
+	wt_idlcache_store( wi, &ck, ticket, ids );
+	wt_idlcache_freekey( &ck, buf );
 }
 
-int wt_idlcache_clear(Operation *op, wt_ctx *wc, struct berval *ndn)
+/* forget the scopes an entry added under or deleted from ndn belongs to */
+int
+wt_idlcache_clear( Operation *op, wt_ctx *wc, struct berval *ndn )
 {
 	BackendDB *be = op->o_bd;
-	int rc = 0;
+	struct wt_info *wi = (struct wt_info *) be->be_private;
 	struct berval pdn = *ndn;
-	WT_SESSION *session = wc->idlcache_session;
-	WT_CURSOR *cursor = NULL;
+	char buf[WT_IDLCACHE_KEYBUF], s;
+	struct berval ck, key = { 1, &s };
 	int level = 0;
 
 	Debug( LDAP_DEBUG_TRACE,
 		   "=> wt_idlcache_clear(\"%s\")\n",
 		   ndn->bv_val );
 
-	if (be_issuffix( be, ndn )) {
+	if ( !wi->wi_idlcache || be_issuffix( be, ndn ) ) {
 		return 0;
 	}
 
-	rc = session->open_cursor(session, WT_TABLE_IDLCACHE, NULL,
-							  NULL, &cursor);
-	if(rc){
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_idlcache_clear: open_cursor failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		return rc;
-	}
-
 	do {
 		dnParent( &pdn, &pdn );
-		if (level == 0) {
+		if ( level == 0 ) {
 			/* clear only parent level cache */
-			cursor->set_key(cursor, pdn.bv_val, (int8_t)LDAP_SCOPE_ONE);
-			cursor->remove(cursor);
+			s = LDAP_SCOPE_ONE;
+			wt_idlcache_mkkey( &ck, buf, WT_IDLCACHE_SCOPE, &pdn, &key );
+			wt_idlcache_dirty( wi, wc, &ck );
+			wt_idlcache_freekey( &ck, buf );
 		}
-		cursor->set_key(cursor, pdn.bv_val, (int8_t)LDAP_SCOPE_SUB);
-		cursor->remove(cursor);
-		cursor->set_key(cursor, pdn.bv_val, (int8_t)LDAP_SCOPE_CHILDREN);
-		cursor->remove(cursor);
+		s = LDAP_SCOPE_SUB;
+		wt_idlcache_mkkey( &ck, buf, WT_IDLCACHE_SCOPE, &pdn, &key );
+		wt_idlcache_dirty( wi, wc, &ck );
+		ck.bv_val[ck.bv_len - 1] = LDAP_SCOPE_CHILDREN;
+		wt_idlcache_dirty( wi, wc, &ck );
+		wt_idlcache_freekey( &ck, buf );
 		level++;
-	}while(!be_issuffix( be, &pdn ));
+	} while ( !be_issuffix( be, &pdn ) );
 
-	if(cursor) {
-		cursor->close(cursor);
-	}
 	return 0;
 }
 
+int
+wt_idlcache_key_get( struct wt_info *wi, struct berval *name,
+					 struct berval *key, ID *ids, unsigned long *ticket )
+{
+	char buf[WT_IDLCACHE_KEYBUF];
+	struct berval ck;
+	int rc;
+
+	wt_idlcache_mkkey( &ck, buf, WT_IDLCACHE_INDEX, name, key );
+	rc = wt_idlcache_lookup( wi, &ck, ids, ticket );
+	wt_idlcache_freekey( &ck, buf );
+
+	Debug( LDAP_DEBUG_TRACE, "<= wt_idlcache_key_get(%s): %s\n",
+		   name->bv_val, rc ? "miss" : "hit" );
+	return rc;
+}
+
+void
+wt_idlcache_key_set( struct wt_info *wi, struct berval *name,
+					 struct berval *key, unsigned long ticket, ID *ids )
+{
+	char buf[WT_IDLCACHE_KEYBUF];
+	struct berval ck;
+
+	if ( !ticket ) {
+		return;
+	}
+
+	wt_idlcache_mkkey( &ck, buf, WT_IDLCACHE_INDEX, name, key );
+	wt_idlcache_store( wi, &ck, ticket, ids );
+	wt_idlcache_freekey( &ck, buf );
+}
+
+/* forget an index key that is being changed */
+void
+wt_idlcache_key_clear( struct wt_info *wi, wt_ctx *wc,
+					   struct berval *name, struct berval *key )
+{
+	char buf[WT_IDLCACHE_KEYBUF];
+	struct berval ck;
+
+	if ( !wi->wi_idlcache ) {
+		return;
+	}
+
+	wt_idlcache_mkkey( &ck, buf, WT_IDLCACHE_INDEX, name, key );
+	wt_idlcache_dirty( wi, wc, &ck );
+	wt_idlcache_freekey( &ck, buf );
+}
+
+/*
+ * Called once the transaction of an update is over: readers may have
+ * cached what they saw before the commit since the entries were cleared.
+ */
+void
+wt_idlcache_release( struct wt_info *wi, wt_ctx *wc )
+{
+	int i;
+
+	if ( !wc->idlcache_dirty ) {
+		return;
+	}
+
+	for ( i = 0; !BER_BVISNULL( &wc->idlcache_dirty[i] ); i++ ) {
+		wt_idlcache_drop( wi, &wc->idlcache_dirty[i] );
+	}
+	ber_bvarray_free( wc->idlcache_dirty );
+	wc->idlcache_dirty = NULL;
+}
+
 /*
  * Local variables:
  * indent-tabs-mode: t
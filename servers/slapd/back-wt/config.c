@@ -37,6 +37,8 @@ enum {
 	WT_INDEX,
 	WT_MODE,
 	WT_IDLCACHE,
+	WT_LOGSYNC,
+	WT_IDLCACHE_SIZE,
 };
 
 static ConfigTable wtcfg[] = {
@@ -63,6 +65,16 @@ static ConfigTable wtcfg[] = {
 	  wt_cf_gen, "( OLcfgDbAt:13.2 NAME 'olcIDLcache' "
 	  "DESC 'enable IDL cache' "
 	  "SYNTAX OMsBoolean SINGLE-VALUE )", NULL, NULL },
+	{ "logsync", "seconds", 2, 2, 0, ARG_INT|ARG_MAGIC|WT_LOGSYNC,
+	  wt_cf_gen, "( OLcfgDbAt:13.3 NAME 'olcWtLogSync' "
+	  "DESC 'Commit without waiting for the log, flush it this often' "
+	  "EQUALITY integerMatch "
+	  "SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
+	{ "idlcachesize", "size", 2, 2, 0, ARG_ULONG|ARG_MAGIC|WT_IDLCACHE_SIZE,
+	  wt_cf_gen, "( OLcfgDbAt:13.4 NAME 'olcWtIDLcacheSize' "
+	  "DESC 'Number of IDs kept in the IDL cache' "
+	  "EQUALITY integerMatch "
+	  "SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
 	{ NULL, NULL, 0, 0, 0, ARG_IGNORED,
 		NULL, NULL, NULL, NULL }
 };
@@ -73,11 +85,81 @@ static ConfigOCs wtocs[] = {
 	  "DESC 'Wt backend configuration' "
 	  "SUP olcDatabaseConfig "
 	  "MUST olcDbDirectory "
-	  "MAY ( olcWtConfig $ olcDbIndex $ olcDbMode $ olcIDLcache) )",
+	  "MAY ( olcWtConfig $ olcDbIndex $ olcDbMode $ olcIDLcache $ "
+	  "olcWtLogSync $ olcWtIDLcacheSize ) )",
 	  Cft_Database, wtcfg },
 	{ NULL, 0, NULL }
 };
 
+/* flush the log that updates were committed to without syncing */
+static void *
+wt_logsync( void *ctx, void *arg )
+{
+	struct re_s *rtask = arg;
+	struct wt_info *wi = rtask->arg;
+	WT_SESSION *session;
+	int rc;
+
+	if ( wi->wi_flags & WT_IS_OPEN ) {
+		rc = wi->wi_conn->open_session(wi->wi_conn, NULL, NULL, &session);
+		if ( rc ) {
+			Debug( LDAP_DEBUG_ANY,
+				   "wt_logsync: open_session failed: %s (%d)\n",
+				   wiredtiger_strerror(rc), rc );
+		} else {
+			rc = session->log_flush(session, "sync=on");
+			if ( rc ) {
+				Debug( LDAP_DEBUG_ANY,
+					   "wt_logsync: log_flush failed: %s (%d)\n",
+					   wiredtiger_strerror(rc), rc );
+			}
+			session->close(session, NULL);
+		}
+	}
+
+	ldap_pvt_thread_mutex_lock( &slapd_rq.rq_mutex );
+	ldap_pvt_runqueue_stoptask( &slapd_rq, rtask );
+	ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
+	return NULL;
+}
+
+/* Start the log flushing task, or update its interval */
+void
+wt_logsync_start( BackendDB *be )
+{
+	struct wt_info *wi = (struct wt_info *) be->be_private;
+
+	if ( !( slapMode & SLAP_SERVER_MODE ) || !wi->wi_logsync )
+		return;
+
+	ldap_pvt_thread_mutex_lock( &slapd_rq.rq_mutex );
+	if ( wi->wi_logsync_task ) {
+		wi->wi_logsync_task->interval.tv_sec = wi->wi_logsync;
+	} else {
+		wi->wi_logsync_task = ldap_pvt_runqueue_insert( &slapd_rq,
+			wi->wi_logsync, wt_logsync, wi,
+			LDAP_XSTRING(wt_logsync), be->be_suffix[0].bv_val );
+	}
+	ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
+}
+
+void
+wt_logsync_stop( BackendDB *be )
+{
+	struct wt_info *wi = (struct wt_info *) be->be_private;
+	struct re_s *re = wi->wi_logsync_task;
+
+	if ( !re )
+		return;
+
+	wi->wi_logsync_task = NULL;
+	ldap_pvt_thread_mutex_lock( &slapd_rq.rq_mutex );
+	if ( ldap_pvt_runqueue_isrunning( &slapd_rq, re ) )
+		ldap_pvt_runqueue_stoptask( &slapd_rq, re );
+	ldap_pvt_runqueue_remove( &slapd_rq, re );
+	ldap_pvt_thread_mutex_unlock( &slapd_rq.rq_mutex );
+}
+
 /* reindex entries on the fly */
 static void *
 wt_online_index( void *ctx, void *arg )
@@ -119,10 +201,25 @@ wt_cf_gen( ConfigArgs *c )
 				c->value_int = 1;
 			}
 			break;
+		case WT_LOGSYNC:
+			c->value_int = wi->wi_logsync;
+			break;
+		case WT_IDLCACHE_SIZE:
+			c->value_ulong = wi->wi_idlcache_size;
+			break;
 		}
 		return rc;
 	} else if ( c->op == LDAP_MOD_DELETE ) {
 		rc = 0;
+		switch( c->type ) {
+		case WT_LOGSYNC:
+			wt_logsync_stop( c->be );
+			wi->wi_logsync = 0;
+			break;
+		case WT_IDLCACHE_SIZE:
+			wi->wi_idlcache_size = DEFAULT_IDLCACHE_SIZE;
+			break;
+		}
 		return rc;
 	}
 
@@ -149,6 +246,8 @@ wt_cf_gen( ConfigArgs *c )
 
 		if( rc != LDAP_SUCCESS ) return 1;
 		wi->wi_flags |= WT_OPEN_INDEX;
+		/* cached keys may belong to indexes that changed */
+		wt_idlcache_flush( wi );
 
 		if ( wi->wi_flags & WT_IS_OPEN ) {
 			config_push_cleanup( c, wt_cf_cleanup );
@@ -184,7 +283,34 @@ wt_cf_gen( ConfigArgs *c )
 			wi->wi_flags |= WT_USE_IDLCACHE;
 		} else {
 			wi->wi_flags &= ~WT_USE_IDLCACHE;
+			wt_idlcache_flush( wi );
+		}
+		break;
+
+	case WT_LOGSYNC:
+		if ( c->value_int < 0 ) {
+			fprintf( stderr, "%s: "
+					 "invalid interval \"%s\" in \"logsync\".\n",
+					 c->log, c->argv[1] );
+			return 1;
+		}
+		if ( !c->value_int ) {
+			wt_logsync_stop( c->be );
+		}
+		wi->wi_logsync = c->value_int;
+		if ( wi->wi_flags & WT_IS_OPEN ) {
+			wt_logsync_start( c->be );
+		}
+		break;
+
+	case WT_IDLCACHE_SIZE:
+		if ( !c->value_ulong ) {
+			fprintf( stderr, "%s: "
+					 "invalid size \"%s\" in \"idlcachesize\".\n",
+					 c->log, c->argv[1] );
+			return 1;
 		}
+		wi->wi_idlcache_size = c->value_ulong;
 		break;
 	}
 	return LDAP_SUCCESS;
@@ -43,19 +43,6 @@ wt_ctx_init(struct wt_info *wi)
 		return NULL;
 	}
 
-	/* readonly mode */
-	if (!wi->wi_cache) {
-		return wc;
-	}
-
-	rc = wi->wi_cache->open_session(wi->wi_cache, NULL, NULL, &wc->idlcache_session);
-	if( rc ) {
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_ctx_init: cannot open idlcache session %s(%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		return NULL;
-	}
-
 	return wc;
 }
 
@@ -78,6 +65,10 @@ wt_ctx_free( void *key, void *data )
 		wc->session = NULL;
 	}
 
+	/* the cursors go away with the session */
+	ldap_tavl_free(wc->index_cursors, ch_free);
+	ber_bvarray_free(wc->idlcache_dirty);
+
 	ch_free(wc);
 }
 
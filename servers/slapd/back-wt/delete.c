@@ -42,7 +42,7 @@ wt_delete( Operation *op, SlapReply *rs )
 	LDAPControl *ctrls[SLAP_MAX_RESPONSE_CONTROLS];
 	int num_ctrls = 0;
 
-	wt_ctx *wc;
+	wt_ctx *wc = NULL;
 	int rc;
 
 	int parent_is_glue = 0;
@@ -363,7 +363,7 @@ wt_delete( Operation *op, SlapReply *rs )
 		// TODO: glue entry
 	}
 
-	rc = wc->session->commit_transaction(wc->session, NULL);
+	rc = wc->session->commit_transaction(wc->session, WT_COMMIT_CONFIG(wi));
 	if( rc ) {
 		Debug( LDAP_DEBUG_TRACE,
 			   "<== wt_delete: commit_transaction failed: %s (%d)\n",
@@ -384,6 +384,10 @@ wt_delete( Operation *op, SlapReply *rs )
 	}
 
 return_results:
+	if ( wc ) {
+		wt_idlcache_release( wi, wc );
+	}
+
 	if ( rs->sr_err == LDAP_SUCCESS && parent_is_glue && parent_is_leaf ) {
 		op->o_delete_glue_parent = 1;
 	}
@@ -61,7 +61,6 @@ wt_dn2id_add(
 	ID pid,
 	Entry *e)
 {
-	struct wt_info *wi = (struct wt_info *) op->o_bd->be_private;
 	int rc;
 	WT_SESSION *session = wc->session;
 	WT_CURSOR *cursor = wc->dn2id_w;
@@ -95,9 +94,7 @@ wt_dn2id_add(
 		goto done;
     }
 
-	if (wi->wi_flags & WT_USE_IDLCACHE) {
-		wt_idlcache_clear(op, wc, &e->e_nname);
-	}
+	wt_idlcache_clear(op, wc, &e->e_nname);
 
 done:
 	if(revdn){
@@ -125,7 +122,6 @@ wt_dn2id_delete(
 	wt_ctx *wc,
 	struct berval *ndn)
 {
-	struct wt_info *wi = (struct wt_info *) op->o_bd->be_private;
 	int rc = 0;
 	WT_SESSION *session = wc->session;
 	WT_CURSOR *cursor = wc->dn2id_w;
@@ -157,9 +153,7 @@ wt_dn2id_delete(
 		goto done;
 	}
 
-	if (wi->wi_flags & WT_USE_IDLCACHE) {
-		wt_idlcache_clear(op, wc, ndn);
-	}
+	wt_idlcache_clear(op, wc, ndn);
 
 	Debug( LDAP_DEBUG_TRACE,
 		   "<= wt_dn2id_delete %s: %d\n", ndn->bv_val, rc );
@@ -414,6 +408,7 @@ wt_dn2idl(
 {
 	struct wt_info *wi = (struct wt_info *) op->o_bd->be_private;
 	int rc;
+	unsigned long ticket;
 
 	Debug( LDAP_DEBUG_TRACE,
 		   "=> wt_dn2idl(\"%s\")\n", ndn->bv_val );
@@ -424,21 +419,15 @@ wt_dn2idl(
 		return 0;
 	}
 
-	if (wi->wi_flags & WT_USE_IDLCACHE) {
-		rc = wt_idlcache_get(wc, ndn, op->ors_scope, ids);
-		if (rc == 0) {
-			/* cache hit */
-			return rc;
-		}
-		/* cache miss */
+	rc = wt_idlcache_get(wi, ndn, op->ors_scope, ids, &ticket);
+	if (rc == 0) {
+		/* cache hit */
+		return rc;
 	}
 
-	if ( wi->wi_flags & WT_USE_IDLCACHE ) {
-		wt_idlcache_begin(wc, ndn, op->ors_scope);
-	}
 	rc = wt_dn2idl_db(op, wc, ndn, e, ids, stack);
-	if ( rc == 0 && wi->wi_flags & WT_USE_IDLCACHE ) {
-		wt_idlcache_set(wc, ndn, op->ors_scope, ids);
+	if ( rc == 0 ) {
+		wt_idlcache_set(wi, ndn, op->ors_scope, ticket, ids);
 	}
 
 	return rc;
@@ -83,9 +83,10 @@ presence_candidates(
 		return 0;
 	}
 
-	rc = wt_key_read( op->o_bd, cursor, &prefix, ids, NULL, 0 );
+	rc = wt_key_read( op->o_bd, cursor, &desc->ad_type->sat_cname,
+					  &prefix, ids, NULL, 0 );
 
-	cursor->close(cursor);
+	wt_index_close(wc, cursor);
 	Debug(LDAP_DEBUG_TRACE,
 		  "<= wt_presence_candidates: id=%ld first=%ld last=%ld\n",
 		  (long) ids[0],
@@ -189,7 +190,8 @@ equality_candidates(
 	}
 
 	for ( i= 0; keys[i].bv_val != NULL; i++ ) {
-		rc = wt_key_read( op->o_bd, cursor, &keys[i], tmp, NULL, 0 );
+		rc = wt_key_read( op->o_bd, cursor, &ava->aa_desc->ad_type->sat_cname,
+						  &keys[i], tmp, NULL, 0 );
 		if( rc == WT_NOTFOUND ) {
 			WT_IDL_ZERO( ids );
 			rc = 0;
@@ -212,7 +214,7 @@ equality_candidates(
 
 	ber_bvarray_free_x( keys, op->o_tmpmemctx );
 
-	cursor->close(cursor);
+	wt_index_close(wc, cursor);
 
 	Debug( LDAP_DEBUG_TRACE,
 		   "<= wt_equality_candidates: id=%ld, first=%ld, last=%ld\n",
@@ -309,7 +311,8 @@ approx_candidates(
 	}
 
 	for ( i= 0; keys[i].bv_val != NULL; i++ ) {
-		rc = wt_key_read( op->o_bd, cursor, &keys[i], tmp, NULL, 0 );
+		rc = wt_key_read( op->o_bd, cursor, &ava->aa_desc->ad_type->sat_cname,
+						  &keys[i], tmp, NULL, 0 );
 		if( rc == WT_NOTFOUND ) {
 			WT_IDL_ZERO( ids );
 			rc = 0;
@@ -341,7 +344,7 @@ approx_candidates(
 
 	ber_bvarray_free_x( keys, op->o_tmpmemctx );
 
-	cursor->close(cursor);
+	wt_index_close(wc, cursor);
 
 	Debug( LDAP_DEBUG_TRACE,
 		   "<= wt_approx_candidates %ld, first=%ld, last=%ld\n",
@@ -434,7 +437,8 @@ substring_candidates(
 	}
 
 	for ( i= 0; keys[i].bv_val != NULL; i++ ) {
-		rc = wt_key_read( op->o_bd, cursor, &keys[i], tmp, NULL, 0 );
+		rc = wt_key_read( op->o_bd, cursor, &sub->sa_desc->ad_cname,
+						  &keys[i], tmp, NULL, 0 );
 
 		if( rc == WT_NOTFOUND ) {
 			WT_IDL_ZERO( ids );
@@ -467,7 +471,7 @@ substring_candidates(
 
 	ber_bvarray_free_x( keys, op->o_tmpmemctx );
 
-	cursor->close(cursor);
+	wt_index_close(wc, cursor);
 
 	Debug( LDAP_DEBUG_TRACE,
 		   "<= wt_substring_candidates: %ld, first=%ld, last=%ld\n",
@@ -134,15 +134,18 @@ int wt_id2entry_delete(
 {
 	int rc;
 	WT_SESSION *session = wc->session;
-	WT_CURSOR *cursor = NULL;
+	WT_CURSOR *cursor = wc->id2entry_update;
 
-	rc = session->open_cursor(session, WT_TABLE_ID2ENTRY, NULL,
-							  NULL, &cursor);
-	if ( rc ) {
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_id2entry_delete: open_cursor failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		goto done;
+	if(!cursor){
+		rc = session->open_cursor(session, WT_TABLE_ID2ENTRY, NULL,
+								  "overwrite=true", &cursor);
+		if ( rc ) {
+			Debug( LDAP_DEBUG_ANY,
+				   "wt_id2entry_delete: open_cursor failed: %s (%d)\n",
+				   wiredtiger_strerror(rc), rc );
+			return rc;
+		}
+		wc->id2entry_update = cursor;
 	}
 	cursor->set_key(cursor, e->e_id);
 	rc = cursor->remove(cursor);
@@ -154,9 +157,16 @@ int wt_id2entry_delete(
 	}
 
 done:
+#ifdef WT_CURSOR_CACHE
+	if(cursor){
+		cursor->reset(cursor);
+	}
+#else
 	if(cursor){
 		cursor->close(cursor);
+		wc->id2entry_update = NULL;
 	}
+#endif
 	return rc;
 }
 
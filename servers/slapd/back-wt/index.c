@@ -162,7 +162,8 @@ static int indexer(
 	}
 
 	if( IS_SLAP_INDEX( mask, SLAP_INDEX_PRESENT ) ) {
-		rc = wt_key_change( op->o_bd, cursor, &presence_key, id, opid );
+		rc = wt_key_change( op->o_bd, wc, cursor, atname,
+							&presence_key, id, opid );
 		if( rc ) {
 			goto done;
 		}
@@ -178,7 +179,8 @@ static int indexer(
 
 		if( rc == LDAP_SUCCESS && keys != NULL ) {
 			for( i=0; keys[i].bv_val != NULL; i++ ) {
-				rc = wt_key_change( op->o_bd, cursor, &keys[i], id, opid );
+				rc = wt_key_change( op->o_bd, wc, cursor, atname,
+									&keys[i], id, opid );
 				if( rc ) {
 					ber_bvarray_free_x( keys, op->o_tmpmemctx );
 					goto done;
@@ -199,7 +201,8 @@ static int indexer(
 
 		if( rc == LDAP_SUCCESS && keys != NULL ) {
 			for( i=0; keys[i].bv_val != NULL; i++ ) {
-				rc = wt_key_change( op->o_bd, cursor, &keys[i], id, opid );
+				rc = wt_key_change( op->o_bd, wc, cursor, atname,
+									&keys[i], id, opid );
 				if( rc ) {
 					ber_bvarray_free_x( keys, op->o_tmpmemctx );
 					goto done;
@@ -221,7 +224,8 @@ static int indexer(
 
 		if( rc == LDAP_SUCCESS && keys != NULL ) {
 			for( i=0; keys[i].bv_val != NULL; i++ ) {
-				rc = wt_key_change( op->o_bd, cursor, &keys[i], id, opid );
+				rc = wt_key_change( op->o_bd, wc, cursor, atname,
+									&keys[i], id, opid );
 				if( rc ) {
 					ber_bvarray_free_x( keys, op->o_tmpmemctx );
 					goto done;
@@ -234,7 +238,9 @@ static int indexer(
 	}
 
 done:
-	cursor->close(cursor);
+	if( cursor ) {
+		wt_index_close(wc, cursor);
+	}
 	return rc;
 }
 
@@ -378,6 +384,16 @@ wt_index_entry( Operation *op, wt_ctx *wc, int opid, Entry *e )
 	return 0;
 }
 
+#ifdef WT_CURSOR_CACHE
+static int
+wt_index_cursor_cmp( const void *v1, const void *v2 )
+{
+	const wt_index_cursor *ic1 = v1, *ic2 = v2;
+
+	return ber_bvcmp( &ic1->name, &ic2->name );
+}
+#endif
+
 WT_CURSOR *
 wt_index_open(wt_ctx *wc, struct berval *name, int create)
 {
@@ -385,6 +401,15 @@ wt_index_open(wt_ctx *wc, struct berval *name, int create)
 	WT_SESSION *session = wc->session;
 	char uri[1024];
 	int rc;
+#ifdef WT_CURSOR_CACHE
+	wt_index_cursor *ic, needle;
+
+	needle.name = *name;
+	ic = ldap_tavl_find( wc->index_cursors, &needle, wt_index_cursor_cmp );
+	if ( ic ) {
+		return ic->cursor;
+	}
+#endif
 
 	snprintf(uri, sizeof(uri), "table:%s", name->bv_val);
 
@@ -411,9 +436,30 @@ wt_index_open(wt_ctx *wc, struct berval *name, int create)
 			   uri, wiredtiger_strerror(rc), rc);
 		return NULL;
 	}
+
+#ifdef WT_CURSOR_CACHE
+	ic = ch_malloc( sizeof( wt_index_cursor ) + name->bv_len + 1 );
+	ic->name.bv_val = (char *)(ic + 1);
+	ic->name.bv_len = name->bv_len;
+	AC_MEMCPY( ic->name.bv_val, name->bv_val, name->bv_len + 1 );
+	ic->cursor = cursor;
+	ldap_tavl_insert( &wc->index_cursors, ic, wt_index_cursor_cmp,
+					  ldap_avl_dup_error );
+#endif
 	return cursor;
 }
 
+/* Done with a cursor from wt_index_open */
+void
+wt_index_close(wt_ctx *wc, WT_CURSOR *cursor)
+{
+#ifdef WT_CURSOR_CACHE
+	cursor->reset(cursor);
+#else
+	cursor->close(cursor);
+#endif
+}
+
 /*
  * Local variables:
  * indent-tabs-mode: t
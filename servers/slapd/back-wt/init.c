@@ -46,6 +46,7 @@ wt_db_init( BackendDB *be, ConfigReply *cr )
 	wi->wi_search_stack_depth = DEFAULT_SEARCH_STACK_DEPTH;
 	wi->wi_search_stack = NULL;
 	wi->wi_flags = WT_USE_IDLCACHE;
+	wi->wi_idlcache_size = DEFAULT_IDLCACHE_SIZE;
 
 	be->be_private = wi;
 	be->be_cf_ocs = be->bd_info->bi_cf_ocs;
@@ -60,7 +61,6 @@ wt_db_open( BackendDB *be, ConfigReply *cr )
 	int rc;
 	struct stat st;
 	WT_SESSION *session = NULL;
-	WT_SESSION *cache_session = NULL;
 
 	if ( be->be_suffix == NULL ) {
 		Debug( LDAP_DEBUG_ANY, "wt_db_open: need suffix.\n" );
@@ -175,39 +175,6 @@ wt_db_open( BackendDB *be, ConfigReply *cr )
 		return -1;
 	}
 
-	/* open in-memory database for idlcache */
-	rc = wiredtiger_open(be->be_suffix[0].bv_val, NULL,
-						 "in_memory=true", &wi->wi_cache);
-	if( rc ) {
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_db_open: database \"%s\": "
-			   "cannot open database for cache (%s).\n",
-			   be->be_suffix[0].bv_val, wiredtiger_strerror(rc) );
-		return -1;
-	}
-
-	rc = wi->wi_cache->open_session(wi->wi_cache, NULL, NULL, &cache_session);
-	if( rc ) {
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_db_open: database \"%s\": "
-			   "cannot open session for cache: \"%s\"\n",
-			   be->be_suffix[0].bv_val, wiredtiger_strerror(rc) );
-		return -1;
-	}
-
-	rc = cache_session->create(cache_session,
-							   WT_TABLE_IDLCACHE,
-							   "key_format=Sb,"
-							   "value_format=u,"
-							   "columns=(ndn,scope,idl)");
-	if( rc ) {
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_db_open: database \"%s\": "
-			   "cannot create idlcache table: \"%s\"\n",
-			   be->be_suffix[0].bv_val, wiredtiger_strerror(rc) );
-		return -1;
-	}
-
 readonly:
 	rc = wt_last_id( be, session, &wi->wi_lastid);
 	if (rc) {
@@ -221,11 +188,14 @@ readonly:
 	if (session) {
 		session->close(session, NULL);
 	}
-	if (cache_session) {
-		cache_session->close(cache_session, NULL);
+
+	if ( slapMode & SLAP_SERVER_MODE ) {
+		wt_idlcache_init( wi );
 	}
 
 	wi->wi_flags |= WT_IS_OPEN;
+
+	wt_logsync_start( be );
     return LDAP_SUCCESS;
 }
 
@@ -235,14 +205,12 @@ wt_db_close( BackendDB *be, ConfigReply *cr )
 	struct wt_info *wi = (struct wt_info *) be->be_private;
 	int rc;
 
-	if ( wi->wi_cache ) {
-		rc = wi->wi_cache->close(wi->wi_cache, NULL);
-		if( rc ) {
-			Debug( LDAP_DEBUG_ANY,
-				   "wt_db_close: cannot close cache database (%d).\n", rc );
-			return -1;
-		}
-	}
+	wt_logsync_stop( be );
+
+	/* cached cursors would outlive the connection */
+	ldap_pvt_thread_pool_purgekey( wi );
+
+	wt_idlcache_destroy( wi );
 
 	if ( wi->wi_conn ) {
 		rc = wi->wi_conn->close(wi->wi_conn, NULL);
@@ -27,17 +27,19 @@
 #include "slap-config.h"
 #include "idl.h"
 
-/* read a key */
+/* read a key of the index table name, through the idlcache */
 int
 wt_key_read(
 	Backend *be,
 	WT_CURSOR *cursor,
+	struct berval *name,
 	struct berval *bkey,
 	ID *ids,
 	WT_CURSOR **saved_cursor,
 	int get_flag
 	)
 {
+	struct wt_info *wi = (struct wt_info *) be->be_private;
 	int rc;
 	WT_ITEM key;
 	int exact;
@@ -45,9 +47,14 @@ wt_key_read(
 	ID id;
 	int comp;
 	long scanned = 0;
+	unsigned long ticket;
 
 	Debug( LDAP_DEBUG_TRACE, "=> key_read\n" );
 
+	if ( wt_idlcache_key_get( wi, name, bkey, ids, &ticket ) == 0 ) {
+		return LDAP_SUCCESS;
+	}
+
 	WT_IDL_ZERO(ids);
 	bv2ITEM(bkey, &key);
 	cursor->set_key(cursor, &key, 0);
@@ -105,6 +112,7 @@ done:
 	} else {
 		Debug( LDAP_DEBUG_TRACE, "<= wt_key_read %ld candidates %ld scanned\n",
 			   (long) WT_IDL_N(ids), scanned );
+		wt_idlcache_key_set( wi, name, bkey, ticket, ids );
 	}
 
 	return rc;
@@ -114,12 +122,15 @@ done:
 int
 wt_key_change(
 	Backend *be,
+	wt_ctx *wc,
 	WT_CURSOR *cursor,
+	struct berval *name,
 	struct berval *k,
 	ID id,
 	int op
 )
 {
+	struct wt_info *wi = (struct wt_info *) be->be_private;
 	int	rc;
 	WT_ITEM item;
 
@@ -148,6 +159,8 @@ wt_key_change(
 		return rc;
 	}
 
+	wt_idlcache_key_clear( wi, wc, name, k );
+
 	Debug( LDAP_DEBUG_TRACE, "<= key_change %d\n", rc );
 
 	return rc;
@@ -654,7 +654,7 @@ retry:
 	/* Only free attrs if they were dup'd.  */
 	if ( dummy.e_attrs == e->e_attrs ) dummy.e_attrs = NULL;
 
-	rc = wc->session->commit_transaction(wc->session, NULL);
+	rc = wc->session->commit_transaction(wc->session, WT_COMMIT_CONFIG(wi));
 	wc->is_begin_transaction = 0;
 	if( rc ) {
 		Debug( LDAP_DEBUG_TRACE,
@@ -675,6 +675,9 @@ retry:
 	if( num_ctrls ) rs->sr_ctrls = ctrls;
 
 return_results:
+	if ( wc ) {
+		wt_idlcache_release( wi, wc );
+	}
 	if( dummy.e_attrs ) {
 		attrs_free( dummy.e_attrs );
 	}
@@ -473,7 +473,7 @@ wt_modrdn( Operation *op, SlapReply *rs )
 		goto return_results;
 	}
 
-	rc = wc->session->commit_transaction(wc->session, NULL);
+	rc = wc->session->commit_transaction(wc->session, WT_COMMIT_CONFIG(wi));
 	wc->is_begin_transaction = 0;
 	if( rc ) {
 		Debug( LDAP_DEBUG_TRACE,
@@ -494,6 +494,9 @@ wt_modrdn( Operation *op, SlapReply *rs )
 	if( num_ctrls ) rs->sr_ctrls = ctrls;
 
 return_results:
+	if ( wc ) {
+		wt_idlcache_release( wi, wc );
+	}
 	if ( dummy.e_attrs ) {
 		attrs_free( dummy.e_attrs );
 	}
@@ -105,6 +105,7 @@ int wt_index_param(
 	struct berval *prefixp );
 
 WT_CURSOR *wt_index_open(wt_ctx *wc, struct berval *name, int create);
+void wt_index_close(wt_ctx *wc, WT_CURSOR *cursor);
 
 #define wt_index_entry_add(op,t,e) \
 	wt_index_entry((op),(t),SLAP_INDEX_ADD_OP,(e))
@@ -117,6 +118,7 @@ WT_CURSOR *wt_index_open(wt_ctx *wc, struct berval *name, int create);
 int
 wt_key_read( Backend *be,
 			 WT_CURSOR *cursor,
+			 struct berval *name,
 			 struct berval *k,
 			 ID *ids,
 			 WT_CURSOR **saved_cursor,
@@ -124,7 +126,9 @@ wt_key_read( Backend *be,
 
 int
 wt_key_change( Backend *be,
+			   wt_ctx *wc,
 			   WT_CURSOR *cursor,
+			   struct berval *name,
 			   struct berval *k,
 			   ID id,
 			   int op);
@@ -151,6 +155,8 @@ int wt_modify_internal(
  * config.c
  */
 int wt_back_init_cf( BackendInfo *bi );
+void wt_logsync_start( BackendDB *be );
+void wt_logsync_stop( BackendDB *be );
 
 /*
  * dn2id.c
@@ -218,10 +224,21 @@ wt_ctx *wt_ctx_get(Operation *op, struct wt_info *wi);
 /*
  * former cache.c
  */
-int wt_idlcache_get(wt_ctx *wc, struct berval *ndn, int scope, ID *ids);
-int wt_idlcache_set(wt_ctx *wc, struct berval *ndn, int scope, ID *ids);
-int wt_idlcache_begin(wt_ctx *wc, struct berval *ndn, int scope);
+int wt_idlcache_init(struct wt_info *wi);
+void wt_idlcache_flush(struct wt_info *wi);
+void wt_idlcache_destroy(struct wt_info *wi);
+int wt_idlcache_get(struct wt_info *wi, struct berval *ndn, int scope,
+					ID *ids, unsigned long *ticket);
+void wt_idlcache_set(struct wt_info *wi, struct berval *ndn, int scope,
+					 unsigned long ticket, ID *ids);
 int wt_idlcache_clear(Operation *op, wt_ctx *wc, struct berval *ndn);
+int wt_idlcache_key_get(struct wt_info *wi, struct berval *name,
+						struct berval *key, ID *ids, unsigned long *ticket);
+void wt_idlcache_key_set(struct wt_info *wi, struct berval *name,
+						 struct berval *key, unsigned long ticket, ID *ids);
+void wt_idlcache_key_clear(struct wt_info *wi, wt_ctx *wc,
+						   struct berval *name, struct berval *key);
+void wt_idlcache_release(struct wt_info *wi, wt_ctx *wc);
 
 /*
  * former external.h
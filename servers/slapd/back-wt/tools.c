@@ -43,6 +43,23 @@ static wt_ctx *wc;
 static WT_CURSOR *reader;
 static WT_ITEM item;
 
+static int	wt_writes, wt_writes_per_commit;
+
+/* Commit the entries written since the last commit */
+static int
+wt_tool_txn_commit( void )
+{
+	int rc;
+
+	if ( !wc->is_begin_transaction )
+		return 0;
+
+	rc = wc->session->commit_transaction(wc->session, NULL);
+	wc->is_begin_transaction = 0;
+	wt_writes = 0;
+	return rc;
+}
+
 int
 wt_tool_entry_open( BackendDB *be, int mode )
 {
@@ -52,6 +69,13 @@ wt_tool_entry_open( BackendDB *be, int mode )
 	if ( slapMode & SLAP_TOOL_DRYRUN )
 		return 0;
 
+	/* In Quick mode, commit once per WT_WRITES_PER_COMMIT entries */
+	wt_writes = 0;
+	if ( slapMode & SLAP_TOOL_QUICK )
+		wt_writes_per_commit = WT_WRITES_PER_COMMIT;
+	else
+		wt_writes_per_commit = 1;
+
 	wc = wt_ctx_init(wi);
     if( !wc ){
 		Debug( LDAP_DEBUG_ANY,
@@ -74,9 +98,18 @@ wt_tool_entry_open( BackendDB *be, int mode )
 int
 wt_tool_entry_close( BackendDB *be )
 {
+	int rc;
+
 	if ( slapMode & SLAP_TOOL_DRYRUN )
 		return 0;
 
+	rc = wt_tool_txn_commit();
+	if( rc ) {
+		Debug( LDAP_DEBUG_ANY,
+			   "wt_tool_entry_close: commit_transaction failed: %s (%d)\n",
+			   wiredtiger_strerror(rc), rc );
+	}
+
 	if( reader ) {
 		reader->close(reader);
 		reader = NULL;
@@ -94,7 +127,7 @@ wt_tool_entry_close( BackendDB *be )
         return -1;
     }
 
-	return 0;
+	return rc ? -1 : 0;
 }
 
 ID
@@ -317,12 +350,15 @@ wt_tool_entry_put( BackendDB *be, Entry *e, struct berval *text )
     Debug( LDAP_DEBUG_TRACE,
 		   "=> wt_tool_entry_put: ( \"%s\" )\n", e->e_dn );
 
-    rc = wc->session->begin_transaction(wc->session, NULL);
-	if( rc ){
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_dn2id_add: begin_transaction failed: %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		return NOID;
+	if( !wc->is_begin_transaction ) {
+		rc = wc->session->begin_transaction(wc->session, NULL);
+		if( rc ){
+			Debug( LDAP_DEBUG_ANY,
+				   "wt_dn2id_add: begin_transaction failed: %s (%d)\n",
+				   wiredtiger_strerror(rc), rc );
+			return NOID;
+		}
+		wc->is_begin_transaction = 1;
 	}
 
 	op.o_hdr = &ohdr;
@@ -364,7 +400,9 @@ wt_tool_entry_put( BackendDB *be, Entry *e, struct berval *text )
 
 done:
 	if ( rc == 0 ){
-		rc = wc->session->commit_transaction(wc->session, NULL);
+		if ( ++wt_writes >= wt_writes_per_commit ) {
+			rc = wt_tool_txn_commit();
+		}
 		if( rc != 0 ) {
 			snprintf( text->bv_val, text->bv_len,
 					  "txn_commit failed: %s (%d)",
@@ -375,6 +413,8 @@ done:
 		}
 	}else{
 		rc = wc->session->rollback_transaction(wc->session, NULL);
+		wc->is_begin_transaction = 0;
+		wt_writes = 0;
 		snprintf( text->bv_val, text->bv_len,
 				  "txn_aborted! %s (%d)",
 				  rc == LDAP_OTHER ? "Internal error" :
@@ -464,12 +504,15 @@ int wt_tool_entry_reindex(
 	op.o_tmpmemctx = NULL;
 	op.o_tmpmfuncs = &ch_mfuncs;
 
-	rc = wc->session->begin_transaction(wc->session, NULL);
-	if( rc ){
-		Debug( LDAP_DEBUG_ANY,
-			   "wt_tool_entry_reindex: begin_transaction failed %s (%d)\n",
-			   wiredtiger_strerror(rc), rc );
-		goto done;
+	if( !wc->is_begin_transaction ) {
+		rc = wc->session->begin_transaction(wc->session, NULL);
+		if( rc ){
+			Debug( LDAP_DEBUG_ANY,
+				   "wt_tool_entry_reindex: begin_transaction failed %s (%d)\n",
+				   wiredtiger_strerror(rc), rc );
+			goto done;
+		}
+		wc->is_begin_transaction = 1;
 	}
 	Debug( LDAP_DEBUG_TRACE,
 		   "=> wt_tool_entry_reindex( %ld, \"%s\" )\n",
@@ -479,14 +522,18 @@ int wt_tool_entry_reindex(
 
 done:
 	if ( rc == 0 ){
-		rc = wc->session->commit_transaction(wc->session, NULL);
+		if ( ++wt_writes >= wt_writes_per_commit ) {
+			rc = wt_tool_txn_commit();
+		}
 		if( rc ) {
 			Debug( LDAP_DEBUG_ANY,
 				   "=> wt_tool_entry_reindex: commit_transaction failed %s (%d)\n",
 				   wiredtiger_strerror(rc), rc );
 		}
-	}else{
+	}else if ( wc->is_begin_transaction ){
 		rc = wc->session->rollback_transaction(wc->session, NULL);
+		wc->is_begin_transaction = 0;
+		wt_writes = 0;
 		Debug( LDAP_DEBUG_ANY,
 			   "=> wt_tool_entry_reindex: rollback transaction %s (%d)\n",
 			   wiredtiger_strerror(rc), rc );
@@ -552,6 +599,15 @@ ID wt_tool_entry_modify(
 		   "=> wt_tool_entry_modify( %ld, \"%s\" )\n",
 		   (long) e->e_id, e->e_dn );
 
+	/* Modifications aren't batched, finish any pending adds first */
+	rc = wt_tool_txn_commit();
+	if( rc ){
+		Debug( LDAP_DEBUG_ANY, "=> wt_tool_entry_modify"
+			   ": commit_transaction failed: %s (%d)\n",
+			   wiredtiger_strerror(rc), rc );
+		return NOID;
+	}
+
     rc = wc->session->begin_transaction(wc->session, NULL);
 	if( rc ){
 		Debug( LDAP_DEBUG_ANY, "=> wt_tool_entry_modify"
@@ -625,6 +681,15 @@ int wt_tool_entry_delete(
 		   "=> wt_tool_entry_delete( %s )\n",
 		   ndn->bv_val );
 
+	/* Deletes aren't batched, finish any pending adds first */
+	rc = wt_tool_txn_commit();
+	if( rc ){
+		Debug( LDAP_DEBUG_ANY,
+			   "wt_tool_entry_delete: commit_transaction failed: %s (%d)\n",
+			   wiredtiger_strerror(rc), rc );
+		return rc;
+	}
+
 	op.o_hdr = &ohdr;
 	op.o_bd = be;
 	op.o_tmpmemctx = NULL;
@@ -1446,6 +1446,67 @@ be_entry_get_rw(
 	return LDAP_UNWILLING_TO_PERFORM;
 }
 
+/*
+ * Fetch the entries named by the NULL-terminated list ndns for reading,
+ * calling cb for each one that exists and matches oc and at (as for
+ * be_entry_get_rw), with the index of its DN in ndns. The entry is only
+ * valid until cb returns; the order of the calls is unspecified.
+ * DNs outside of the database are skipped.
+ * A non-zero return from cb stops the walk and is returned.
+ *
+ * Backends may fetch the whole list at once; for the others, each DN
+ * is looked up on its own by backend_entry_get_list().
+ */
+int
+be_entry_get_list(
+	Operation *op,
+	BerVarray ndns,
+	ObjectClass *oc,
+	AttributeDescription *at,
+	slap_entry_list_cb *cb,
+	void *arg )
+{
+	if ( op->o_bd == NULL ) {
+		return LDAP_NO_SUCH_OBJECT;
+	}
+
+	if ( op->o_bd->bd_info->bi_entry_get_list ) {
+		return op->o_bd->bd_info->bi_entry_get_list( op, ndns, oc, at,
+			cb, arg );
+	}
+
+	return backend_entry_get_list( op, ndns, oc, at, cb, arg );
+}
+
+int
+backend_entry_get_list(
+	Operation *op,
+	BerVarray ndns,
+	ObjectClass *oc,
+	AttributeDescription *at,
+	slap_entry_list_cb *cb,
+	void *arg )
+{
+	int i, rc = LDAP_SUCCESS;
+
+	for ( i = 0; rc == LDAP_SUCCESS && !BER_BVISNULL( &ndns[ i ] ); i++ ) {
+		Entry *e = NULL;
+
+		/* not all backends cope with a DN outside of their suffix */
+		if ( !be_issubordinate( op->o_bd, &ndns[ i ] ) )
+			continue;
+		if ( be_entry_get_rw( op, &ndns[ i ], oc, at, 0, &e ) !=
+				LDAP_SUCCESS || e == NULL )
+		{
+			continue;
+		}
+		rc = cb( op, i, e, arg );
+		be_entry_release_r( op, e );
+	}
+
+	return rc;
+}
+
 int 
 fe_acl_group(
 	Operation *op,
@@ -483,6 +483,85 @@ over_entry_release_rw(
 	return overlay_entry_release_ov( op, e, rw, on );
 }
 
+/*
+ * Overlays that supply or rewrite entries get to see each DN on its own,
+ * otherwise the whole list is handed to the backend.
+ */
+int
+overlay_entry_get_list_ov(
+	Operation		*op,
+	BerVarray		ndns,
+	ObjectClass		*oc,
+	AttributeDescription	*ad,
+	slap_entry_list_cb	*cb,
+	void			*arg,
+	slap_overinst	*on )
+{
+	slap_overinfo *oi = on->on_info;
+	BackendDB *be = op->o_bd, db;
+	BackendInfo *bi = op->o_bd->bd_info;
+	slap_overinst *ov;
+	int i, rc = LDAP_SUCCESS;
+
+	for ( ov = on; ov; ov = ov->on_next ) {
+		if ( ov->on_bi.bi_flags & SLAPO_BFLAG_DISABLED )
+			continue;
+		if ( ov->on_bi.bi_entry_get_rw || ov->on_bi.bi_entry_release_rw )
+			break;
+	}
+
+	if ( ov || !oi->oi_orig->bi_entry_get_list ) {
+		for ( i = 0; rc == LDAP_SUCCESS && !BER_BVISNULL( &ndns[ i ] ); i++ ) {
+			Entry *e = NULL;
+
+			if ( !be_issubordinate( op->o_bd, &ndns[ i ] ) )
+				continue;
+			if ( overlay_entry_get_ov( op, &ndns[ i ], oc, ad, 0, &e, on )
+					!= LDAP_SUCCESS || e == NULL )
+				continue;
+			rc = cb( op, i, e, arg );
+			overlay_entry_release_ov( op, e, 0, on );
+		}
+		return rc;
+	}
+
+	/* NOTE: do not copy the structure until required */
+	if ( !SLAP_ISOVERLAY( op->o_bd ) ) {
+		db = *op->o_bd;
+		db.be_flags |= SLAP_DBFLAG_OVERLAY;
+		op->o_bd = &db;
+	}
+	op->o_bd->bd_info = oi->oi_orig;
+	rc = oi->oi_orig->bi_entry_get_list( op, ndns, oc, ad, cb, arg );
+
+	op->o_bd = be;
+	if ( SLAP_ISOVERLAY( op->o_bd ) ) {
+		op->o_bd->bd_info = bi;
+	}
+
+	return rc;
+}
+
+static int
+over_entry_get_list(
+	Operation		*op,
+	BerVarray		ndns,
+	ObjectClass		*oc,
+	AttributeDescription	*ad,
+	slap_entry_list_cb	*cb,
+	void			*arg )
+{
+	slap_overinfo *oi;
+	slap_overinst *on;
+
+	assert( op->o_bd != NULL );
+
+	oi = op->o_bd->bd_info->bi_private;
+	on = oi->oi_list;
+
+	return overlay_entry_get_list_ov( op, ndns, oc, ad, cb, arg, on );
+}
+
 static int
 over_acl_group(
 	Operation		*op,
@@ -1420,6 +1499,7 @@ overlay_config( BackendDB *be, const char *ov, int idx, BackendInfo **res, Confi
 		/* these have specific arglists */
 		bi->bi_entry_get_rw = over_entry_get_rw;
 		bi->bi_entry_release_rw = over_entry_release_rw;
+		bi->bi_entry_get_list = over_entry_get_list;
 		bi->bi_access_allowed = over_access_allowed;
 		bi->bi_acl_group = over_acl_group;
 		bi->bi_acl_attribute = over_acl_attribute;
@@ -51,6 +51,7 @@ static Connection *connections = NULL;
 
 static ldap_pvt_thread_mutex_t conn_nextid_mutex;
 static unsigned long conn_nextid = SLAPD_SYNC_SYNCCONN_OFFSET;
+static unsigned long conn_current;	/* protected by conn_nextid_mutex */
 
 static const char conn_lost_str[] = "connection lost";
 
@@ -513,6 +514,9 @@ Connection * connection_init(
 
 	ldap_pvt_thread_mutex_lock( &conn_nextid_mutex );
 	id = c->c_connid = conn_nextid++;
+	/* outbound connections are not counted */
+	if ( !( flags & CONN_IS_CLIENT ) )
+		conn_current++;
 	ldap_pvt_thread_mutex_unlock( &conn_nextid_mutex );
 
 	c->c_conn_state = SLAP_C_INACTIVE;
@@ -605,6 +609,13 @@ connection_destroy( Connection *c )
 
 	backend_connection_destroy(c);
 
+	/* outbound connections are not counted */
+	if ( c->c_conn_state != SLAP_C_CLIENT ) {
+		ldap_pvt_thread_mutex_lock( &conn_nextid_mutex );
+		conn_current--;
+		ldap_pvt_thread_mutex_unlock( &conn_nextid_mutex );
+	}
+
 	c->c_protocol = 0;
 	c->c_connid = -1;
 
@@ -833,6 +844,21 @@ unsigned long connections_nextid(void)
 	return id;
 }
 
+/* Number of inbound connections currently open */
+unsigned long connections_current(void)
+{
+	unsigned long n;
+	assert( connections != NULL );
+
+	ldap_pvt_thread_mutex_lock( &conn_nextid_mutex );
+
+	n = conn_current;
+
+	ldap_pvt_thread_mutex_unlock( &conn_nextid_mutex );
+
+	return n;
+}
+
 /*
  * Loop through the connections:
  *
@@ -902,16 +928,16 @@ void connection_done( Connection *c )
 /* FIXME: returns 0 in case of failure */
 #define INCR_OP_INITIATED(index) \
 	do { \
-		ldap_pvt_thread_mutex_lock( &op->o_counters->sc_mutex ); \
-		ldap_pvt_mp_add_ulong(op->o_counters->sc_ops_initiated_[(index)], 1); \
-		ldap_pvt_thread_mutex_unlock( &op->o_counters->sc_mutex ); \
+		SLAP_COUNTERS_LOCK( op->o_counters ); \
+		SLAP_COUNTER_ADD(op->o_counters->sc_ops_initiated_[(index)], 1); \
+		SLAP_COUNTERS_UNLOCK( op->o_counters ); \
 	} while (0)
 #define INCR_OP_COMPLETED(index) \
 	do { \
-		ldap_pvt_thread_mutex_lock( &op->o_counters->sc_mutex ); \
-		ldap_pvt_mp_add_ulong(op->o_counters->sc_ops_completed, 1); \
-		ldap_pvt_mp_add_ulong(op->o_counters->sc_ops_completed_[(index)], 1); \
-		ldap_pvt_thread_mutex_unlock( &op->o_counters->sc_mutex ); \
+		SLAP_COUNTERS_LOCK( op->o_counters ); \
+		SLAP_COUNTER_ADD(op->o_counters->sc_ops_completed, 1); \
+		SLAP_COUNTER_ADD(op->o_counters->sc_ops_completed_[(index)], 1); \
+		SLAP_COUNTERS_UNLOCK( op->o_counters ); \
 	} while (0)
 
 /*
@@ -946,15 +972,15 @@ conn_counter_destroy( void *key, void *data )
 
 			*prev = sc->sc_next;
 			/* Copy data to main counter */
-			ldap_pvt_mp_add( slap_counters.sc_bytes, sc->sc_bytes );
-			ldap_pvt_mp_add( slap_counters.sc_pdu, sc->sc_pdu );
-			ldap_pvt_mp_add( slap_counters.sc_entries, sc->sc_entries );
-			ldap_pvt_mp_add( slap_counters.sc_refs, sc->sc_refs );
-			ldap_pvt_mp_add( slap_counters.sc_ops_initiated, sc->sc_ops_initiated );
-			ldap_pvt_mp_add( slap_counters.sc_ops_completed, sc->sc_ops_completed );
+			SLAP_COUNTER_MERGE( slap_counters.sc_bytes, sc->sc_bytes );
+			SLAP_COUNTER_MERGE( slap_counters.sc_pdu, sc->sc_pdu );
+			SLAP_COUNTER_MERGE( slap_counters.sc_entries, sc->sc_entries );
+			SLAP_COUNTER_MERGE( slap_counters.sc_refs, sc->sc_refs );
+			SLAP_COUNTER_MERGE( slap_counters.sc_ops_initiated, sc->sc_ops_initiated );
+			SLAP_COUNTER_MERGE( slap_counters.sc_ops_completed, sc->sc_ops_completed );
 			for ( i = 0; i < SLAP_OP_LAST; i++ ) {
-				ldap_pvt_mp_add( slap_counters.sc_ops_initiated_[ i ], sc->sc_ops_initiated_[ i ] );
-				ldap_pvt_mp_add( slap_counters.sc_ops_initiated_[ i ], sc->sc_ops_completed_[ i ] );
+				SLAP_COUNTER_MERGE( slap_counters.sc_ops_initiated_[ i ], sc->sc_ops_initiated_[ i ] );
+				SLAP_COUNTER_MERGE( slap_counters.sc_ops_completed_[ i ], sc->sc_ops_completed_[ i ] );
 			}
 			slap_counters_destroy( sc );
 			ber_memfree_x( data, NULL );
@@ -1034,10 +1060,10 @@ connection_operation( void *ctx, void *arg_v )
 	}
 	op->o_qtime.tv_sec -= op->o_time;
 	operation_counter_init( op, ctx );
-	ldap_pvt_thread_mutex_lock( &op->o_counters->sc_mutex );
+	SLAP_COUNTERS_LOCK( op->o_counters );
 	/* FIXME: returns 0 in case of failure */
-	ldap_pvt_mp_add_ulong(op->o_counters->sc_ops_initiated, 1);
-	ldap_pvt_thread_mutex_unlock( &op->o_counters->sc_mutex );
+	SLAP_COUNTER_ADD(op->o_counters->sc_ops_initiated, 1);
+	SLAP_COUNTERS_UNLOCK( op->o_counters );
 
 	op->o_threadctx = ctx;
 	op->o_tid = ldap_pvt_thread_pool_tid( ctx );
@@ -278,6 +278,76 @@ deref_cleanup( Operation *op, SlapReply *rs )
 	return SLAP_CB_CONTINUE;
 }
 
+typedef struct deref_fetch_t {
+	DerefSpec *df_ds;
+	DerefVal *df_dv;
+	AccessControlState *df_acl_state;
+	char *df_dummy;
+	ber_len_t df_len;
+	int df_nAttrs;
+	int df_nVals;
+} deref_fetch_t;
+
+static int
+deref_fetch_cb( Operation *op, int i, Entry *e, void *arg )
+{
+	deref_fetch_t *df = (deref_fetch_t *)arg;
+	DerefSpec *ds = df->df_ds;
+	DerefVal *dv = df->df_dv;
+	int j;
+
+	/* the DN itself was not readable */
+	if ( dv[ i ].dv_derefSpecVal.bv_val == df->df_dummy ) {
+		return LDAP_SUCCESS;
+	}
+
+	if ( !access_allowed( op, e, slap_schema.si_ad_entry,
+		NULL, ACL_READ, NULL ) )
+	{
+		return LDAP_SUCCESS;
+	}
+
+	for ( j = 0; j < ds->ds_nattrs; j++ ) {
+		Attribute *aa;
+
+		if ( !access_allowed( op, e, ds->ds_attributes[ j ], NULL,
+			ACL_READ, df->df_acl_state ) )
+		{
+			continue;
+		}
+
+		aa = attr_find( e->e_attrs, ds->ds_attributes[ j ] );
+		if ( aa != NULL ) {
+			unsigned k, h, last = aa->a_numvals;
+
+			ber_bvarray_dup_x( &dv[ i ].dv_attrVals[ j ],
+				aa->a_vals, op->o_tmpmemctx );
+
+			df->df_len += ds->ds_attributes[ j ]->ad_cname.bv_len;
+
+			for ( k = 0, h = 0; k < aa->a_numvals; k++ ) {
+				if ( !access_allowed( op, e,
+					aa->a_desc,
+					&aa->a_nvals[ k ],
+					ACL_READ, df->df_acl_state ) )
+				{
+					op->o_tmpfree( dv[ i ].dv_attrVals[ j ][ h ].bv_val,
+						op->o_tmpmemctx );
+					dv[ i ].dv_attrVals[ j ][ h ] = dv[ i ].dv_attrVals[ j ][ --last ];
+					BER_BVZERO( &dv[ i ].dv_attrVals[ j ][ last ] );
+					continue;
+				}
+				df->df_len += dv[ i ].dv_attrVals[ j ][ h ].bv_len;
+				df->df_nVals++;
+				h++;
+			}
+			df->df_nAttrs++;
+		}
+	}
+
+	return LDAP_SUCCESS;
+}
+
 static int
 deref_response( Operation *op, SlapReply *rs )
 {
@@ -295,6 +365,7 @@ deref_response( Operation *op, SlapReply *rs )
 		LDAPControl *ctrl, *ctrlsp[2];
 		AccessControlState acl_state = ACL_STATE_INIT;
 		static char dummy = '\0';
+		deref_fetch_t df = { 0 };
 		Entry *ebase;
 		int i;
 
@@ -303,6 +374,9 @@ deref_response( Operation *op, SlapReply *rs )
 			return SLAP_CB_CONTINUE;
 		}
 
+		df.df_acl_state = &acl_state;
+		df.df_dummy = &dummy;
+
 		for ( ds = dc->dc_ds; ds; ds = ds->ds_next ) {
 			Attribute *a = attr_find( ebase->e_attrs, ds->ds_derefAttr );
 
@@ -328,12 +402,9 @@ deref_response( Operation *op, SlapReply *rs )
 				nDerefRes++;
 
 				for ( i = 0; !BER_BVISNULL( &a->a_nvals[ i ] ); i++ ) {
-					Entry *e = NULL;
-
 					dv[ i ].dv_attrVals = bva;
 					bva += ds->ds_nattrs;
 
-
 					if ( !access_allowed( op, rs->sr_entry, a->a_desc,
 							&a->a_nvals[ i ], ACL_READ, &acl_state ) )
 					{
@@ -345,57 +416,13 @@ deref_response( Operation *op, SlapReply *rs )
 					bv.bv_len += dv[ i ].dv_derefSpecVal.bv_len;
 					nVals++;
 					nDerefVals++;
-
-					rc = overlay_entry_get_ov( op, &a->a_nvals[ i ], NULL, NULL, 0, &e, dc->dc_on );
-					if ( rc == LDAP_SUCCESS && e != NULL ) {
-						int j;
-
-						if ( access_allowed( op, e, slap_schema.si_ad_entry,
-							NULL, ACL_READ, NULL ) )
-						{
-							for ( j = 0; j < ds->ds_nattrs; j++ ) {
-								Attribute *aa;
-
-								if ( !access_allowed( op, e, ds->ds_attributes[ j ], NULL,
-									ACL_READ, &acl_state ) )
-								{
-									continue;
-								}
-
-								aa = attr_find( e->e_attrs, ds->ds_attributes[ j ] );
-								if ( aa != NULL ) {
-									unsigned k, h, last = aa->a_numvals;
-
-									ber_bvarray_dup_x( &dv[ i ].dv_attrVals[ j ],
-										aa->a_vals, op->o_tmpmemctx );
-
-									bv.bv_len += ds->ds_attributes[ j ]->ad_cname.bv_len;
-
-									for ( k = 0, h = 0; k < aa->a_numvals; k++ ) {
-										if ( !access_allowed( op, e,
-											aa->a_desc,
-											&aa->a_nvals[ k ],
-											ACL_READ, &acl_state ) )
-										{
-											op->o_tmpfree( dv[ i ].dv_attrVals[ j ][ h ].bv_val,
-												op->o_tmpmemctx );
-											dv[ i ].dv_attrVals[ j ][ h ] = dv[ i ].dv_attrVals[ j ][ --last ];
-											BER_BVZERO( &dv[ i ].dv_attrVals[ j ][ last ] );
-											continue;
-										}
-										bv.bv_len += dv[ i ].dv_attrVals[ j ][ h ].bv_len;
-										nVals++;
-										h++;
-									}
-									nAttrs++;
-								}
-							}
-						}
-
-						overlay_entry_release_ov( op, e, 0, dc->dc_on );
-					}
 				}
 
+				df.df_ds = ds;
+				df.df_dv = dv;
+				(void)overlay_entry_get_list_ov( op, a->a_nvals, NULL, NULL,
+					deref_fetch_cb, &df, dc->dc_on );
+
 				*drp = dr;
 				drp = &dr->dr_next;
 			}
@@ -407,6 +434,9 @@ deref_response( Operation *op, SlapReply *rs )
 		}
 
 		/* cook the control value */
+		bv.bv_len += df.df_len;
+		nAttrs += df.df_nAttrs;
+		nVals += df.df_nVals;
 		bv.bv_len += nVals * sizeof(struct berval)
 			+ nAttrs * sizeof(struct berval)
 			+ nDerefVals * sizeof(DerefVal)
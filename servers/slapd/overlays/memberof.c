@@ -516,6 +516,33 @@ memberof_cleanup( Operation *op, SlapReply *rs )
 	return 0;
 }
 
+static int
+memberof_exists_cb( Operation *op, int i, Entry *e, void *arg )
+{
+	char	*found = arg;
+
+	found[ i ] = 1;
+	return LDAP_SUCCESS;
+}
+
+/*
+ * Look all the DNs in vals up at once; found[ i ] is set
+ * if vals[ i ] exists. Free the result with op->o_tmpfree().
+ */
+static char *
+memberof_exists( Operation *op, BerVarray vals )
+{
+	char	*found;
+	int	n;
+
+	for ( n = 0; !BER_BVISNULL( &vals[ n ] ); n++ )
+		;
+	found = op->o_tmpcalloc( n + 1, sizeof( char ), op->o_tmpmemctx );
+	(void)be_entry_get_list( op, vals, NULL, NULL, memberof_exists_cb, found );
+
+	return found;
+}
+
 static int memberof_res_add( Operation *op, SlapReply *rs );
 static int memberof_res_delete( Operation *op, SlapReply *rs );
 static int memberof_res_modify( Operation *op, SlapReply *rs );
@@ -530,6 +557,7 @@ memberof_op_add( Operation *op, SlapReply *rs )
 	Attribute	**ap, **map = NULL;
 	int		rc = SLAP_CB_CONTINUE;
 	int		i;
+	char		*found;
 	struct berval	save_dn, save_ndn;
 	slap_callback *sc;
 	memberof_cbinfo_t *mci;
@@ -581,21 +609,19 @@ memberof_op_add( Operation *op, SlapReply *rs )
 
 			assert( a->a_nvals != NULL );
 
-			for ( i = 0; !BER_BVISNULL( &a->a_nvals[ i ] ); i++ ) {
-				Entry		*e = NULL;
+			found = memberof_exists( op, a->a_nvals );
 
+			for ( i = 0; !BER_BVISNULL( &a->a_nvals[ i ] ); i++ ) {
 				/* ITS#6670 Ignore member pointing to this entry */
 				if ( dn_match( &a->a_nvals[i], &save_ndn ))
 					continue;
 
-				rc = be_entry_get_rw( op, &a->a_nvals[ i ],
-						NULL, NULL, 0, &e );
-				if ( rc == LDAP_SUCCESS ) {
-					be_entry_release_r( op, e );
+				if ( found[ i ] ) {
 					continue;
 				}
 
 				if ( MEMBEROF_DANGLING_ERROR( mo ) ) {
+					op->o_tmpfree( found, op->o_tmpmemctx );
 					rc = rs->sr_err = mo->mo_dangling_err;
 					rs->sr_text = "adding non-existing object "
 						"as group member";
@@ -629,10 +655,13 @@ memberof_op_add( Operation *op, SlapReply *rs )
 						AC_MEMCPY( &a->a_nvals[ i ], &a->a_nvals[ i + 1 ],
 							sizeof( struct berval ) * ( j - i ) );
 					}
+					AC_MEMCPY( &found[ i ], &found[ i + 1 ], j - i - 1 );
 					i--;
 				}
 			}
 
+			op->o_tmpfree( found, op->o_tmpmemctx );
+
 			/* If all values have been removed,
 			 * remove the attribute itself. */
 			if ( BER_BVISNULL( &a->a_nvals[ 0 ] ) ) {
@@ -861,6 +890,7 @@ memberof_op_modify( Operation *op, SlapReply *rs )
 			for ( mlp = &op->orm_modlist; *mlp; ) {
 				Modifications	*ml = *mlp;
 				int		i;
+				char		*found;
 		
 				if ( !is_ad_subtype( ml->sml_desc, mo->mo_ad_member ) ) {
 					mlp = &ml->sml_next;
@@ -890,21 +920,19 @@ memberof_op_modify( Operation *op, SlapReply *rs )
 					 * for member must have a normalized value */
 					assert( ml->sml_nvalues != NULL );
 		
+					found = memberof_exists( op, ml->sml_nvalues );
+
 					for ( i = 0; !BER_BVISNULL( &ml->sml_nvalues[ i ] ); i++ ) {
-						Entry		*e;
-		
 						/* ITS#6670 Ignore member pointing to this entry */
 						if ( dn_match( &ml->sml_nvalues[i], &save_ndn ))
 							continue;
 
-						if ( be_entry_get_rw( op, &ml->sml_nvalues[ i ],
-								NULL, NULL, 0, &e ) == LDAP_SUCCESS )
-						{
-							be_entry_release_r( op, e );
+						if ( found[ i ] ) {
 							continue;
 						}
 		
 						if ( MEMBEROF_DANGLING_ERROR( mo ) ) {
+							op->o_tmpfree( found, op->o_tmpmemctx );
 							rc = rs->sr_err = mo->mo_dangling_err;
 							rs->sr_text = "adding non-existing object "
 								"as group member";
@@ -934,9 +962,11 @@ memberof_op_modify( Operation *op, SlapReply *rs )
 								sizeof( struct berval ) * ( j - i ) );
 							AC_MEMCPY( &ml->sml_nvalues[ i ], &ml->sml_nvalues[ i + 1 ],
 								sizeof( struct berval ) * ( j - i ) );
+							AC_MEMCPY( &found[ i ], &found[ i + 1 ], j - i - 1 );
 							i--;
 						}
 					}
+					op->o_tmpfree( found, op->o_tmpmemctx );
 		
 					if ( BER_BVISNULL( &ml->sml_nvalues[ 0 ] ) ) {
 						*mlp = ml->sml_next;
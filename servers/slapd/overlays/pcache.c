@@ -30,6 +30,7 @@
 
 #include "slap.h"
 #include "lutil.h"
+#include "lutil_hash.h"
 #include "ldap_rq.h"
 #include "ldap_avl.h"
 
@@ -86,11 +87,14 @@ typedef struct cached_query_s {
 	unsigned long			answerable_cnt; /* how many times it was answerable */
 	int						refcnt;	/* references since last refresh */
 	int						in_lru;	/* query is in LRU list */
+	int						q_refreshing;	/* a refresh is queued or running */
 	ldap_pvt_thread_mutex_t		answerable_cnt_mutex;
 	struct cached_query_s  		*next;  	/* next query in the template */
 	struct cached_query_s  		*prev;  	/* previous query in the template */
 	struct cached_query_s		*lru_up;	/* previous query in the LRU list */
 	struct cached_query_s		*lru_down;	/* next query in the LRU list */
+	struct cached_query_s		*q_hnext;	/* next query in the hash bucket */
+	ber_uint_t				q_hash;		/* hash of base, scope and filter */
 	ldap_pvt_thread_rdwr_t		rwlock;
 } CachedQuery;
 
@@ -137,6 +141,8 @@ typedef struct query_template_s {
 	Avlnode*		qbase;
 	CachedQuery* 	query;	        /* most recent query cached for the template */
 	CachedQuery* 	query_last;     /* oldest query cached for the template */
+	CachedQuery**	qhash;		/* queries by base, scope and filter */
+	int		qhash_size;	/* number of buckets, a power of 2 */
 	ldap_pvt_thread_rdwr_t t_rwlock; /* Rd/wr lock for accessing queries in the template */
 	struct berval	querystr;	/* Filter string corresponding to the QT */
 	struct berval	bindbase;	/* base DN for Bind request */
@@ -225,6 +231,12 @@ typedef struct cache_manager_s {
 	int 	cc_paused;
 	void	*cc_arg;
 
+	time_t	refresh_ahead;		/* refresh queries this long before they expire */
+#define PCACHE_REFRESH_MAX_DEFAULT	4
+	int	refresh_max;		/* max concurrent background refreshes */
+	int	refresh_active;		/* background refreshes queued or running */
+	struct pc_refresh_s	*refresh_pending;	/* refreshes not started yet */
+
 	ldap_pvt_thread_mutex_t		cache_mutex;
 
 	query_manager*   qm;	/* query cache managed by the cache manager */
@@ -968,7 +980,33 @@ static int pcache_filter_cmp( Filter *f1, Filter *f2 )
 		case 1:
 			break;
 		case 2:
-			rc = lex_bvcmp( &f1->f_av_value, &f2->f_av_value );
+			/* the tree needs one total order: group by assertion
+			 * and attribute first, then every range of an attribute
+			 * with an ordering rule is kept in the order of its
+			 * values, so that find_filter() gets to a containing one
+			 * right away. All other values compare byte-wise. */
+			rc = f1->f_choice - f2->f_choice;
+			if ( rc )
+				break;
+			if ( f1->f_av_desc != f2->f_av_desc ) {
+				rc = ber_bvcmp( &f1->f_av_desc->ad_cname,
+					&f2->f_av_desc->ad_cname );
+				break;
+			}
+			if ( f1->f_choice != LDAP_FILTER_EQUALITY &&
+				f1->f_av_desc->ad_type->sat_ordering &&
+				f1->f_av_desc->ad_type->sat_ordering->smr_match )
+			{
+				const char *text;
+
+				/* ordering rules don't fail on normalized values */
+				(void)value_match( &rc, f1->f_av_desc,
+					f1->f_av_desc->ad_type->sat_ordering,
+					SLAP_MR_VALUE_OF_ASSERTION_SYNTAX,
+					&f1->f_av_value, &f2->f_av_value, &text );
+			} else {
+				rc = lex_bvcmp( &f1->f_av_value, &f2->f_av_value );
+			}
 			break;
 		case 3:
 			if ( f1->f_choice == LDAP_FILTER_SUBSTRINGS ) {
@@ -1037,6 +1075,220 @@ static int pcache_query_cmp( const void *v1, const void *v2 )
 	return pcache_filter_cmp( q1->filter, q2->filter );
 }
 
+/*
+ * Exact match index: the queries of a template hashed on their base,
+ * scope and (normalized) filter, the attrset being the template's.
+ * A query that has been cached as is doesn't need to go through the
+ * containment checks of find_filter(), which can't help walking many
+ * cached queries for substring filters.
+ */
+#define PCACHE_QHASH_MIN	64
+
+static void
+pcache_filter_hash( lutil_HASH_CTX *ctx, Filter *f )
+{
+	unsigned char	c;
+	int		i;
+
+	for ( ; f; f = f->f_next ) {
+		c = f->f_choice;
+		lutil_HASHUpdate( ctx, &c, 1 );
+		switch ( f->f_choice ) {
+		case LDAP_FILTER_AND:
+		case LDAP_FILTER_OR:
+		case LDAP_FILTER_NOT:
+			pcache_filter_hash( ctx, f->f_and );
+			c = ')';
+			lutil_HASHUpdate( ctx, &c, 1 );
+			break;
+		case LDAP_FILTER_EQUALITY:
+		case LDAP_FILTER_GE:
+		case LDAP_FILTER_LE:
+		case LDAP_FILTER_APPROX:
+			lutil_HASHUpdate( ctx, (unsigned char *)f->f_av_value.bv_val,
+				f->f_av_value.bv_len );
+			break;
+		case LDAP_FILTER_SUBSTRINGS:
+			if ( !BER_BVISNULL( &f->f_sub_initial ) ) {
+				lutil_HASHUpdate( ctx, (unsigned char *)f->f_sub_initial.bv_val,
+					f->f_sub_initial.bv_len );
+			}
+			for ( i = 0; f->f_sub_any && !BER_BVISNULL( &f->f_sub_any[i] ); i++ ) {
+				c = '*';
+				lutil_HASHUpdate( ctx, &c, 1 );
+				lutil_HASHUpdate( ctx, (unsigned char *)f->f_sub_any[i].bv_val,
+					f->f_sub_any[i].bv_len );
+			}
+			c = '*';
+			lutil_HASHUpdate( ctx, &c, 1 );
+			if ( !BER_BVISNULL( &f->f_sub_final ) ) {
+				lutil_HASHUpdate( ctx, (unsigned char *)f->f_sub_final.bv_val,
+					f->f_sub_final.bv_len );
+			}
+			break;
+		case LDAP_FILTER_EXT:
+			lutil_HASHUpdate( ctx, (unsigned char *)f->f_mr_value.bv_val,
+				f->f_mr_value.bv_len );
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static ber_uint_t
+pcache_query_hash( struct berval *base, int scope, Filter *f )
+{
+	lutil_HASH_CTX	ctx;
+	unsigned char	c = scope;
+
+	lutil_HASHInit( &ctx );
+	lutil_HASHUpdate( &ctx, (unsigned char *)base->bv_val, base->bv_len );
+	lutil_HASHUpdate( &ctx, &c, 1 );
+	pcache_filter_hash( &ctx, f );
+	return lutil_HASHValue( &ctx );
+}
+
+static int
+pcache_bv_equal( struct berval *bv1, struct berval *bv2 )
+{
+	if ( BER_BVISNULL( bv1 ) || BER_BVISNULL( bv2 ) )
+		return BER_BVISNULL( bv1 ) && BER_BVISNULL( bv2 );
+	return bvmatch( bv1, bv2 );
+}
+
+/* unlike pcache_filter_cmp(), all of the values count */
+static int
+pcache_filter_equal( Filter *f1, Filter *f2 )
+{
+	int i;
+
+	for ( ; f1 && f2; f1 = f1->f_next, f2 = f2->f_next ) {
+		if ( f1->f_choice != f2->f_choice )
+			return 0;
+
+		switch ( f1->f_choice ) {
+		case LDAP_FILTER_AND:
+		case LDAP_FILTER_OR:
+		case LDAP_FILTER_NOT:
+			if ( !pcache_filter_equal( f1->f_and, f2->f_and ) )
+				return 0;
+			break;
+		case LDAP_FILTER_PRESENT:
+			if ( f1->f_desc != f2->f_desc )
+				return 0;
+			break;
+		case LDAP_FILTER_EQUALITY:
+		case LDAP_FILTER_GE:
+		case LDAP_FILTER_LE:
+		case LDAP_FILTER_APPROX:
+			if ( f1->f_av_desc != f2->f_av_desc ||
+				!bvmatch( &f1->f_av_value, &f2->f_av_value ) )
+				return 0;
+			break;
+		case LDAP_FILTER_SUBSTRINGS:
+			if ( f1->f_sub_desc != f2->f_sub_desc ||
+				!pcache_bv_equal( &f1->f_sub_initial, &f2->f_sub_initial ) ||
+				!pcache_bv_equal( &f1->f_sub_final, &f2->f_sub_final ) )
+				return 0;
+			if ( !f1->f_sub_any || !f2->f_sub_any ) {
+				if ( f1->f_sub_any != f2->f_sub_any )
+					return 0;
+				break;
+			}
+			for ( i = 0; !BER_BVISNULL( &f1->f_sub_any[i] ); i++ ) {
+				if ( !pcache_bv_equal( &f1->f_sub_any[i], &f2->f_sub_any[i] ) )
+					return 0;
+			}
+			if ( !BER_BVISNULL( &f2->f_sub_any[i] ) )
+				return 0;
+			break;
+		case LDAP_FILTER_EXT:
+			if ( f1->f_mr_rule != f2->f_mr_rule ||
+				f1->f_mr_desc != f2->f_mr_desc ||
+				f1->f_mr_dnattrs != f2->f_mr_dnattrs ||
+				!bvmatch( &f1->f_mr_value, &f2->f_mr_value ) )
+				return 0;
+			break;
+		default:
+			if ( f1->f_result != f2->f_result )
+				return 0;
+			break;
+		}
+	}
+	return f1 == f2;
+}
+
+/* call with templ->t_rwlock write locked */
+static void
+pcache_qhash_insert( QueryTemplate *templ, CachedQuery *qc )
+{
+	CachedQuery **bucket;
+
+	if ( templ->no_of_queries >= templ->qhash_size ) {
+		CachedQuery **qhash, *q, *qnext;
+		int i, size;
+
+		size = templ->qhash_size ? templ->qhash_size * 2 : PCACHE_QHASH_MIN;
+		qhash = ch_calloc( size, sizeof( CachedQuery * ) );
+		for ( i = 0; i < templ->qhash_size; i++ ) {
+			for ( q = templ->qhash[i]; q; q = qnext ) {
+				qnext = q->q_hnext;
+				bucket = &qhash[ q->q_hash & ( size - 1 ) ];
+				q->q_hnext = *bucket;
+				*bucket = q;
+			}
+		}
+		ch_free( templ->qhash );
+		templ->qhash = qhash;
+		templ->qhash_size = size;
+	}
+
+	bucket = &templ->qhash[ qc->q_hash & ( templ->qhash_size - 1 ) ];
+	qc->q_hnext = *bucket;
+	*bucket = qc;
+}
+
+/* call with templ->t_rwlock write locked */
+static void
+pcache_qhash_delete( QueryTemplate *templ, CachedQuery *qc )
+{
+	CachedQuery **qp;
+
+	if ( !templ->qhash_size )
+		return;
+
+	for ( qp = &templ->qhash[ qc->q_hash & ( templ->qhash_size - 1 ) ];
+		*qp; qp = &(*qp)->q_hnext )
+	{
+		if ( *qp == qc ) {
+			*qp = qc->q_hnext;
+			qc->q_hnext = NULL;
+			break;
+		}
+	}
+}
+
+/* call with templ->t_rwlock locked */
+static CachedQuery *
+pcache_qhash_find( QueryTemplate *templ, Query *query, ber_uint_t hash )
+{
+	CachedQuery *qc;
+
+	if ( !templ->qhash_size )
+		return NULL;
+
+	for ( qc = templ->qhash[ hash & ( templ->qhash_size - 1 ) ];
+		qc; qc = qc->q_hnext )
+	{
+		if ( qc->q_hash == hash && qc->scope == query->scope &&
+			bvmatch( &qc->qbase->base, &query->base ) &&
+			pcache_filter_equal( qc->filter, query->filter ) )
+			break;
+	}
+	return qc;
+}
+
 /* add query on top of LRU list */
 static void
 add_query_on_top (query_manager* qm, CachedQuery* qc)
@@ -1296,6 +1548,9 @@ find_filter( Operation *op, TAvlnode *root, Filter *inputf, Filter *first )
 		ptr = ldap_tavl_end( root, 1 );
 		dir = TAVL_DIR_LEFT;
 	} else {
+		/* ranges are sorted by value (see pcache_filter_cmp()),
+		 * so walking in dir from here the first range of inputf
+		 * is contained by every query but possibly the first */
 		ptr = ldap_tavl_find3( root, &cq, pcache_query_cmp, &ret );
 		dir = (first->f_choice == LDAP_FILTER_GE) ? TAVL_DIR_LEFT :
 			TAVL_DIR_RIGHT;
@@ -1449,14 +1704,23 @@ query_containment(Operation *op, query_manager *qm,
 
 	if (query->filter != NULL) {
 		Filter *first;
+		ber_uint_t hash;
 
 		Debug( pcache_debug, "Lock QC index = %p\n",
 				(void *) templa );
 		qbase.base = query->base;
 
 		first = filter_first( query->filter );
+		hash = pcache_query_hash( &query->base, query->scope, query->filter );
 
 		ldap_pvt_thread_rdwr_rlock(&templa->t_rwlock);
+
+		/* the same query may be cached already; if it exceeded
+		 * the sizelimit, a broader one might still answer */
+		qc = pcache_qhash_find( templa, query, hash );
+		if ( qc && !qc->q_sizelimit )
+			goto found;
+
 		for( ;; ) {
 			/* Find the base */
 			qbptr = ldap_avl_find( templa->qbase, &qbase, pcache_dn_cmp );
@@ -1506,19 +1770,8 @@ query_containment(Operation *op, query_manager *qm,
 					/* Find filter */
 					qc = find_filter( op, qbptr->scopes[tscope],
 							query->filter, first );
-					if ( qc ) {
-						if ( qc->q_sizelimit ) {
-							ldap_pvt_thread_rdwr_runlock(&templa->t_rwlock);
-							return NULL;
-						}
-						ldap_pvt_thread_mutex_lock(&qm->lru_mutex);
-						if (qm->lru_top != qc) {
-							remove_query(qm, qc);
-							add_query_on_top(qm, qc);
-						}
-						ldap_pvt_thread_mutex_unlock(&qm->lru_mutex);
-						return qc;
-					}
+					if ( qc )
+						goto found;
 				}
 			}
 			if ( be_issuffix( op->o_bd, &qbase.base ))
@@ -1535,6 +1788,19 @@ query_containment(Operation *op, query_manager *qm,
 		ldap_pvt_thread_rdwr_runlock(&templa->t_rwlock);
 	}
 	return NULL;
+
+found:
+	if ( qc->q_sizelimit ) {
+		ldap_pvt_thread_rdwr_runlock(&templa->t_rwlock);
+		return NULL;
+	}
+	ldap_pvt_thread_mutex_lock(&qm->lru_mutex);
+	if (qm->lru_top != qc) {
+		remove_query(qm, qc);
+		add_query_on_top(qm, qc);
+	}
+	ldap_pvt_thread_mutex_unlock(&qm->lru_mutex);
+	return qc;
 }
 
 static void
@@ -1597,6 +1863,7 @@ add_query(
 	new_cached_query->bind_refcnt = 0;
 	new_cached_query->answerable_cnt = 0;
 	new_cached_query->refcnt = 1;
+	new_cached_query->q_refreshing = 0;
 	ldap_pvt_thread_mutex_init(&new_cached_query->answerable_cnt_mutex);
 
 	new_cached_query->lru_up = NULL;
@@ -1608,6 +1875,9 @@ add_query(
 	new_cached_query->scope = query->scope;
 	new_cached_query->filter = query->filter;
 	new_cached_query->first = first = filter_first( query->filter );
+	new_cached_query->q_hnext = NULL;
+	new_cached_query->q_hash = pcache_query_hash( &query->base,
+		query->scope, query->filter );
 	
 	ldap_pvt_thread_rdwr_init(&new_cached_query->rwlock);
 	if (wlock)
@@ -1634,6 +1904,7 @@ add_query(
 	rc = ldap_tavl_insert( &qbase->scopes[query->scope], new_cached_query,
 		pcache_query_cmp, ldap_avl_dup_error );
 	if ( rc == 0 ) {
+		pcache_qhash_insert( templ, new_cached_query );
 		qbase->queries++;
 		if (templ->query == NULL)
 			templ->query_last = new_cached_query;
@@ -1668,6 +1939,24 @@ add_query(
 	return rc == 0 ? new_cached_query : NULL;
 }
 
+/* call with templ->t_rwlock write locked */
+static void
+pcache_query_to_head( QueryTemplate *templ, CachedQuery *qc )
+{
+	if ( !qc->prev )
+		return;
+
+	qc->prev->next = qc->next;
+	if ( qc->next )
+		qc->next->prev = qc->prev;
+	else
+		templ->query_last = qc->prev;
+	qc->prev = NULL;
+	qc->next = templ->query;
+	templ->query->prev = qc;
+	templ->query = qc;
+}
+
 static void
 remove_from_template (CachedQuery* qc, QueryTemplate* template)
 {
@@ -1684,6 +1973,7 @@ remove_from_template (CachedQuery* qc, QueryTemplate* template)
 		qc->prev->next = qc->next;
 	}
 	ldap_tavl_delete( &qc->qbase->scopes[qc->scope], qc, pcache_query_cmp );
+	pcache_qhash_delete( template, qc );
 	qc->qbase->queries--;
 	if ( qc->qbase->queries == 0 ) {
 		ldap_avl_delete( &template->qbase, qc->qbase, pcache_dn_cmp );
@@ -2947,6 +3237,9 @@ pcache_op_bind(
 }
 
 static slap_response refresh_merge;
+static int pcache_refresh_start( slap_overinst *on, CachedQuery *query,
+	int extend );
+static void pcache_refresh_done( CachedQuery *query );
 
 static int
 pcache_op_search(
@@ -3079,6 +3372,13 @@ pcache_op_search(
 				pbi->bi_cq = answerable;
 			}
 
+			/* Close to expiring, revalidate it in the background
+			 * and answer from the cache meanwhile */
+			if ( cm->refresh_ahead &&
+				answerable->expiry_time - op->o_time < cm->refresh_ahead &&
+				pcache_refresh_start( on, answerable, 1 ) )
+				pcache_refresh_done( answerable );
+
 			op->o_bd = &cm->db;
 			if ( cm->response_cb == PCACHE_RESPONSE_CB_TAIL ) {
 				slap_callback cb;
@@ -3500,6 +3800,195 @@ leave:
 	return rc;
 }
 
+/*
+ * Background refreshes run in the connection pool, at most cm->refresh_max
+ * at a time. The CachedQuery may be expired or replaced before the task gets
+ * to run, so the task carries its own copy of the query and looks it up
+ * again, the uuid tells whether it's still the same one.
+ */
+typedef struct pc_refresh_s {
+	struct pc_refresh_s	*next;
+	slap_overinst	*on;
+	QueryTemplate	*qtemp;
+	Query		query;
+	ber_uint_t	hash;
+	struct berval	uuid;
+	int		extend;		/* push the expiry out on success */
+	void		*cookie;	/* to retract the task */
+} pc_refresh;
+
+static void
+pcache_refresh_free( pc_refresh *pr )
+{
+	filter_free( pr->query.filter );
+	ch_free( pr->query.base.bv_val );
+	ch_free( pr->uuid.bv_val );
+	ch_free( pr );
+}
+
+static void
+pcache_refresh_done( CachedQuery *query )
+{
+	ldap_pvt_thread_mutex_lock( &query->answerable_cnt_mutex );
+	query->q_refreshing = 0;
+	ldap_pvt_thread_mutex_unlock( &query->answerable_cnt_mutex );
+}
+
+static void *
+pcache_refresh_task( void *ctx, void *arg )
+{
+	pc_refresh *pr = arg, **prp;
+	slap_overinst *on = pr->on;
+	cache_manager *cm = on->on_bi.bi_private;
+	QueryTemplate *templ = pr->qtemp;
+	CachedQuery *query;
+	Connection conn = {0};
+	OperationBuffer opbuf;
+	Operation *op;
+	int rc;
+
+	ldap_pvt_thread_mutex_lock( &cm->cache_mutex );
+	for ( prp = &cm->refresh_pending; *prp; prp = &(*prp)->next ) {
+		if ( *prp == pr ) {
+			*prp = pr->next;
+			break;
+		}
+	}
+	ldap_pvt_thread_mutex_unlock( &cm->cache_mutex );
+
+	connection_fake_init( &conn, &opbuf, ctx );
+	op = &opbuf.ob_op;
+
+	op->o_bd = &cm->db;
+	op->o_dn = cm->db.be_rootdn;
+	op->o_ndn = cm->db.be_rootndn;
+
+	ldap_pvt_thread_rdwr_rlock( &templ->t_rwlock );
+	query = pcache_qhash_find( templ, &pr->query, pr->hash );
+	if ( query && bvmatch( &query->q_uuid, &pr->uuid ) ) {
+		rc = refresh_query( op, query, on );
+		ldap_pvt_thread_rdwr_runlock( &templ->t_rwlock );
+
+		/* the query may have gone while the template was unlocked */
+		ldap_pvt_thread_rdwr_wlock( &templ->t_rwlock );
+		query = pcache_qhash_find( templ, &pr->query, pr->hash );
+		if ( query && bvmatch( &query->q_uuid, &pr->uuid ) ) {
+			op->o_time = slap_get_time();
+			if ( rc == LDAP_SUCCESS && pr->extend ) {
+				/* consistency_check() expects the queries ordered
+				 * by age, so it goes back to the head like a new one */
+				query->expiry_time = op->o_time + templ->ttl;
+				pcache_query_to_head( templ, query );
+			}
+			if ( templ->ttr )
+				query->refresh_time = op->o_time + templ->ttr;
+			Debug( pcache_debug, "pcache_refresh_task: "
+				"refreshed query %s (%d)\n", pr->uuid.bv_val, rc );
+			pcache_refresh_done( query );
+		}
+		ldap_pvt_thread_rdwr_wunlock( &templ->t_rwlock );
+	} else {
+		ldap_pvt_thread_rdwr_runlock( &templ->t_rwlock );
+	}
+
+	ldap_pvt_thread_mutex_lock( &cm->cache_mutex );
+	cm->refresh_active--;
+	ldap_pvt_thread_mutex_unlock( &cm->cache_mutex );
+
+	pcache_refresh_free( pr );
+	return NULL;
+}
+
+/*
+ * Hand the refresh of query to the connection pool, call with
+ * templ->t_rwlock locked. Returns 0 if the refresh was queued or one is
+ * already pending. If all refreshers are busy, returns 1 and the caller
+ * must either refresh the query itself or give up, and then call
+ * pcache_refresh_done().
+ */
+static int
+pcache_refresh_start( slap_overinst *on, CachedQuery *query, int extend )
+{
+	cache_manager *cm = on->on_bi.bi_private;
+	pc_refresh *pr;
+	int busy;
+
+	ldap_pvt_thread_mutex_lock( &query->answerable_cnt_mutex );
+	busy = query->q_refreshing;
+	query->q_refreshing = 1;
+	ldap_pvt_thread_mutex_unlock( &query->answerable_cnt_mutex );
+	if ( busy )
+		return 0;
+
+	ldap_pvt_thread_mutex_lock( &cm->cache_mutex );
+	if ( cm->refresh_active >= cm->refresh_max ) {
+		ldap_pvt_thread_mutex_unlock( &cm->cache_mutex );
+		return 1;
+	}
+
+	pr = ch_calloc( 1, sizeof( pc_refresh ) );
+	pr->on = on;
+	pr->qtemp = query->qtemp;
+	pr->query.filter = filter_dup( query->filter, NULL );
+	ber_dupbv( &pr->query.base, &query->qbase->base );
+	pr->query.scope = query->scope;
+	pr->hash = query->q_hash;
+	ber_dupbv( &pr->uuid, &query->q_uuid );
+	pr->extend = extend;
+
+	/* the task can't unlink itself before we release cache_mutex */
+	if ( ldap_pvt_thread_pool_submit2( &connection_pool,
+			pcache_refresh_task, pr, &pr->cookie ) ) {
+		ldap_pvt_thread_mutex_unlock( &cm->cache_mutex );
+		pcache_refresh_free( pr );
+		return 1;
+	}
+	pr->next = cm->refresh_pending;
+	cm->refresh_pending = pr;
+	cm->refresh_active++;
+	ldap_pvt_thread_mutex_unlock( &cm->cache_mutex );
+
+	return 0;
+}
+
+/*
+ * Drop the refreshes that haven't started yet and wait for the rest. Running
+ * ones can't be blocked on a paused pool, if it's paused they're done already.
+ */
+static void
+pcache_refresh_stop( slap_overinst *on )
+{
+	cache_manager *cm = on->on_bi.bi_private;
+	pc_refresh *pr, *retracted = NULL;
+	CachedQuery *query;
+
+	ldap_pvt_thread_mutex_lock( &cm->cache_mutex );
+	while ( ( pr = cm->refresh_pending ) != NULL ) {
+		cm->refresh_pending = pr->next;
+		if ( ldap_pvt_thread_pool_retract( pr->cookie ) > 0 ) {
+			cm->refresh_active--;
+			pr->next = retracted;
+			retracted = pr;
+		}
+	}
+	while ( cm->refresh_active ) {
+		ldap_pvt_thread_mutex_unlock( &cm->cache_mutex );
+		ldap_pvt_thread_yield();
+		ldap_pvt_thread_mutex_lock( &cm->cache_mutex );
+	}
+	ldap_pvt_thread_mutex_unlock( &cm->cache_mutex );
+
+	while ( ( pr = retracted ) != NULL ) {
+		retracted = pr->next;
+		ldap_pvt_thread_rdwr_rlock( &pr->qtemp->t_rwlock );
+		query = pcache_qhash_find( pr->qtemp, &pr->query, pr->hash );
+		if ( query && bvmatch( &query->q_uuid, &pr->uuid ) )
+			pcache_refresh_done( query );
+		ldap_pvt_thread_rdwr_runlock( &pr->qtemp->t_rwlock );
+		pcache_refresh_free( pr );
+	}
+}
+
 static void*
 consistency_check(
 	void *ctx,
@@ -3568,9 +4057,16 @@ consistency_check(
 			}
 
 			if (query->expiry_time < op->o_time) {
-				int rem = 0;
+				int rem = 0, refreshing;
 				if ( query != templ->query_last )
 					continue;
+				/* keep serving it while it's being revalidated, a
+				 * successful refresh moves it to the head */
+				ldap_pvt_thread_mutex_lock( &query->answerable_cnt_mutex );
+				refreshing = query->q_refreshing;
+				ldap_pvt_thread_mutex_unlock( &query->answerable_cnt_mutex );
+				if ( refreshing )
+					continue;
 				ldap_pvt_thread_mutex_lock(&qm->lru_mutex);
 				if (query->in_lru) {
 					remove_query(qm, query);
@@ -3627,6 +4123,8 @@ consistency_check(
 			ldap_pvt_thread_rdwr_wunlock( &query->rwlock );
 			if ( rem ) free_query(query);
 		}
+		/* the next template starts its own list */
+		expires = NULL;
 
 		/* handle refreshes that we skipped earlier */
 		if ( templ->ttr ) {
@@ -3639,9 +4137,12 @@ consistency_check(
 					 * expiration has been hit, then skip the refresh since
 					 * we're just going to discard the result anyway.
 					 */
-					if ( query->expiry_time > op->o_time ) {
+					if ( query->expiry_time > op->o_time &&
+						pcache_refresh_start( on, query, 0 ) ) {
+						/* all refreshers are busy, do it ourselves */
 						refresh_query( op, query, on );
 						query->refresh_time = op->o_time + templ->ttr;
+						pcache_refresh_done( query );
 					}
 				}
 			}
@@ -3674,7 +4175,9 @@ enum {
 	PC_QUERIES,
 	PC_OFFLINE,
 	PC_BIND,
-	PC_PRIVATE_DB
+	PC_PRIVATE_DB,
+	PC_REFRESH_AHEAD,
+	PC_REFRESH_MAX
 };
 
 static ConfigDriver pc_cf_gen;
@@ -3740,6 +4243,18 @@ static ConfigTable pccfg[] = {
 			"DESC 'Parameters for caching Binds' "
 			"EQUALITY caseIgnoreMatch "
 			"SYNTAX OMsDirectoryString )", NULL, NULL },
+	{ "pcacheRefreshAhead", "time",
+		2, 2, 0, ARG_MAGIC|PC_REFRESH_AHEAD, pc_cf_gen,
+		"( OLcfgOvAt:2.10 NAME 'olcPcacheRefreshAhead' "
+			"DESC 'Refresh queries in the background this long before they expire' "
+			"EQUALITY caseIgnoreMatch "
+			"SYNTAX OMsDirectoryString SINGLE-VALUE )", NULL, NULL },
+	{ "pcacheMaxRefresh", "refreshes",
+		2, 2, 0, ARG_INT|ARG_MAGIC|PC_REFRESH_MAX, pc_cf_gen,
+		"( OLcfgOvAt:2.11 NAME 'olcPcacheMaxRefresh' "
+			"DESC 'Maximum number of concurrent background refreshes' "
+			"EQUALITY integerMatch "
+			"SYNTAX OMsInteger SINGLE-VALUE )", NULL, NULL },
 	{ "pcache-", "private database args",
 		1, 0, STRLENOF("pcache-"), ARG_MAGIC|PC_PRIVATE_DB, pc_cf_gen,
 		NULL, NULL, NULL },
@@ -3778,7 +4293,8 @@ static ConfigOCs pcocs[] = {
 		"SUP olcOverlayConfig "
 		"MUST ( olcPcache $ olcPcacheAttrset $ olcPcacheTemplate ) "
 		"MAY ( olcPcachePosition $ olcPcacheMaxQueries $ olcPcachePersist $ "
-			"olcPcacheValidate $ olcPcacheOffline $ olcPcacheBind ) )",
+			"olcPcacheValidate $ olcPcacheOffline $ olcPcacheBind $ "
+			"olcPcacheRefreshAhead $ olcPcacheMaxRefresh ) )",
 		Cft_Overlay, pccfg, NULL, pc_cfadd },
 	{ "( OLcfgOvOc:2.2 "
 		"NAME 'olcPcacheDatabase' "
@@ -3965,6 +4481,23 @@ pc_cf_gen( ConfigArgs *c )
 		case PC_OFFLINE:
 			c->value_int = (cm->cc_paused & PCACHE_CC_OFFLINE) != 0;
 			break;
+		case PC_REFRESH_AHEAD:
+			if ( !cm->refresh_ahead ) {
+				rc = 1;
+				break;
+			}
+			bv.bv_len = snprintf( c->cr_msg, sizeof( c->cr_msg ), "%ld",
+				(long)cm->refresh_ahead );
+			bv.bv_val = c->cr_msg;
+			value_add_one( &c->rvalue_vals, &bv );
+			break;
+		case PC_REFRESH_MAX:
+			if ( cm->refresh_max == PCACHE_REFRESH_MAX_DEFAULT ) {
+				rc = 1;
+				break;
+			}
+			c->value_int = cm->refresh_max;
+			break;
 		}
 		return rc;
 	} else if ( c->op == LDAP_MOD_DELETE ) {
@@ -3987,6 +4520,14 @@ pc_cf_gen( ConfigArgs *c )
 			}
 			rc = 0;
 			break;
+		case PC_REFRESH_AHEAD:
+			cm->refresh_ahead = 0;
+			rc = 0;
+			break;
+		case PC_REFRESH_MAX:
+			cm->refresh_max = PCACHE_REFRESH_MAX_DEFAULT;
+			rc = 0;
+			break;
 		}
 		return rc;
 	}
@@ -4443,6 +4984,23 @@ pc_bind_fail:
 		else
 			cm->cc_paused &= ~PCACHE_CC_OFFLINE;
 		break;
+	case PC_REFRESH_AHEAD:
+		if ( lutil_parse_time( c->argv[1], &t ) != 0 ) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg ),
+				"unable to parse refresh ahead time=\"%s\"", c->argv[1] );
+			Debug( LDAP_DEBUG_CONFIG, "%s: %s.\n", c->log, c->cr_msg );
+			return( 1 );
+		}
+		cm->refresh_ahead = (time_t)t;
+		break;
+	case PC_REFRESH_MAX:
+		if ( c->value_int <= 0 ) {
+			snprintf( c->cr_msg, sizeof( c->cr_msg ), "max refreshes must be positive" );
+			Debug( LDAP_DEBUG_CONFIG, "%s: %s.\n", c->log, c->cr_msg );
+			return( 1 );
+		}
+		cm->refresh_max = c->value_int;
+		break;
 	case PC_PRIVATE_DB:
 		if ( cm->db.be_private == NULL ) {
 			snprintf( c->cr_msg, sizeof( c->cr_msg ),
@@ -4556,6 +5114,10 @@ pcache_db_init(
 	cm->cc_period = 1000;
 	cm->cc_paused = 0;
 	cm->cc_arg = NULL;
+	cm->refresh_ahead = 0;
+	cm->refresh_max = PCACHE_REFRESH_MAX_DEFAULT;
+	cm->refresh_active = 0;
+	cm->refresh_pending = NULL;
 #ifdef PCACHE_MONITOR
 	cm->monitor_cb = NULL;
 #endif /* PCACHE_MONITOR */
@@ -4836,6 +5398,9 @@ pcache_db_close(
 		cm->cc_arg = NULL;
 	}
 
+	/* ... and the background refreshes */
+	pcache_refresh_stop( on );
+
 	if ( cm->save_queries ) {
 		CachedQuery	*qc;
 		BerVarray	vals = NULL;
@@ -4942,6 +5507,7 @@ pcache_db_destroy(
 			free_query( qc );
 		}
 		ldap_avl_free( tm->qbase, pcache_free_qbase );
+		ch_free( tm->qhash );
 		free( tm->querystr.bv_val );
 		free( tm->bindfattrs );
 		free( tm->bindftemp.bv_val );
@@ -376,6 +376,12 @@ LDAP_SLAPD_F (struct berval *) be_root_dn LDAP_P(( Backend *be ));
 LDAP_SLAPD_F (int) be_entry_get_rw LDAP_P(( Operation *o,
 		struct berval *ndn, ObjectClass *oc,
 		AttributeDescription *at, int rw, Entry **e ));
+LDAP_SLAPD_F (int) be_entry_get_list LDAP_P(( Operation *o,
+		BerVarray ndns, ObjectClass *oc, AttributeDescription *at,
+		slap_entry_list_cb *cb, void *arg ));
+LDAP_SLAPD_F (int) backend_entry_get_list LDAP_P(( Operation *o,
+		BerVarray ndns, ObjectClass *oc, AttributeDescription *at,
+		slap_entry_list_cb *cb, void *arg ));
 
 /* "backend->ophandler(op,rs)" wrappers, applied by contrib:wrap_slap_ops */
 #define SLAP_OP(which, op, rs)  slap_bi_op((op)->o_bd->bd_info, which, op, rs)
@@ -487,6 +493,14 @@ LDAP_SLAPD_F (int) overlay_entry_release_ov LDAP_P((
 	Entry *e,
 	int rw,
 	slap_overinst *ov ));
+LDAP_SLAPD_F (int) overlay_entry_get_list_ov LDAP_P((
+	Operation *op,
+	BerVarray ndns,
+	ObjectClass *oc,
+	AttributeDescription *ad,
+	slap_entry_list_cb *cb,
+	void *arg,
+	slap_overinst *ov ));
 LDAP_SLAPD_F (void) overlay_insert LDAP_P((
 	BackendDB *be, slap_overinst *on, slap_overinst ***prev, int idx ));
 LDAP_SLAPD_F (void) overlay_move LDAP_P((
@@ -791,6 +805,7 @@ LDAP_SLAPD_F (void) connection_op_finish LDAP_P((
 	Operation *op, int lock ));
 
 LDAP_SLAPD_F (unsigned long) connections_nextid(void);
+LDAP_SLAPD_F (unsigned long) connections_current(void);
 
 LDAP_SLAPD_F (Connection *) connection_first LDAP_P(( ber_socket_t * ));
 LDAP_SLAPD_F (Connection *) connection_next LDAP_P((
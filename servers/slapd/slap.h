@@ -2211,6 +2211,11 @@ typedef int (BI_entry_release_rw)
 	LDAP_P(( Operation *op, Entry *e, int rw ));
 typedef int (BI_entry_get_rw) LDAP_P(( Operation *op, struct berval *ndn,
 	ObjectClass *oc, AttributeDescription *at, int rw, Entry **e ));
+typedef int (slap_entry_list_cb) LDAP_P(( Operation *op, int i, Entry *e,
+	void *arg ));
+typedef int (BI_entry_get_list) LDAP_P(( Operation *op, BerVarray ndns,
+	ObjectClass *oc, AttributeDescription *at,
+	slap_entry_list_cb *cb, void *arg ));
 typedef int (BI_operational) LDAP_P(( Operation *op, SlapReply *rs ));
 typedef int (BI_has_subordinates) LDAP_P(( Operation *op,
 	Entry *e, int *hasSubs ));
@@ -2403,6 +2408,9 @@ struct BackendInfo {
 	void	*bi_extra;		/* backend type-specific APIs */
 	void	*bi_private;	/* backend type-specific config data */
 	LDAP_STAILQ_ENTRY(BackendInfo) bi_next ;
+
+	/* appended to keep the layout of the members above */
+	BI_entry_get_list	*bi_entry_get_list;
 };
 
 #define c_authtype	c_authz.sai_method
@@ -2562,9 +2570,26 @@ typedef enum {
 	SLAP_OP_LAST
 } slap_op_t;
 
+#ifndef SLAP_CACHELINE
+#define SLAP_CACHELINE	64
+#endif
+
+/*
+ * Counters are kept per thread and summed up when read. When the
+ * counter type is a plain integer they are updated with atomic adds
+ * and sc_mutex only protects the list; with bignums, sc_mutex also
+ * guards the values.
+ */
+#if !defined(USE_MP_BIGNUM) && !defined(USE_MP_GMP) && defined(__ATOMIC_RELAXED)
+#define SLAP_COUNTERS_ATOMIC
+#endif
+
 typedef struct slap_counters_t {
 	struct slap_counters_t	*sc_next;
 	ldap_pvt_thread_mutex_t	sc_mutex;
+	/* keep other threads' data off our cache lines */
+	char			sc_pad1[SLAP_CACHELINE];
+
 	ldap_pvt_mp_t		sc_bytes;
 	ldap_pvt_mp_t		sc_pdu;
 	ldap_pvt_mp_t		sc_entries;
@@ -2574,8 +2599,26 @@ typedef struct slap_counters_t {
 	ldap_pvt_mp_t		sc_ops_initiated;
 	ldap_pvt_mp_t		sc_ops_completed_[SLAP_OP_LAST];
 	ldap_pvt_mp_t		sc_ops_initiated_[SLAP_OP_LAST];
+	char			sc_pad2[SLAP_CACHELINE];
 } slap_counters_t;
 
+#ifdef SLAP_COUNTERS_ATOMIC
+#define SLAP_COUNTERS_LOCK(sc)
+#define SLAP_COUNTERS_UNLOCK(sc)
+#define SLAP_COUNTER_ADD(mp,v) \
+	((void)__atomic_fetch_add( &(mp), (v), __ATOMIC_RELAXED ))
+#define SLAP_COUNTER_GET(mp) \
+	__atomic_load_n( &(mp), __ATOMIC_RELAXED )
+#define SLAP_COUNTER_MERGE(mpr,mpv) \
+	SLAP_COUNTER_ADD( (mpr), SLAP_COUNTER_GET( (mpv) ) )
+#else
+#define SLAP_COUNTERS_LOCK(sc)	ldap_pvt_thread_mutex_lock( &(sc)->sc_mutex )
+#define SLAP_COUNTERS_UNLOCK(sc)	ldap_pvt_thread_mutex_unlock( &(sc)->sc_mutex )
+#define SLAP_COUNTER_ADD(mp,v)	ldap_pvt_mp_add_ulong( (mp), (v) )
+#define SLAP_COUNTER_GET(mp)	(mp)
+#define SLAP_COUNTER_MERGE(mpr,mpv)	ldap_pvt_mp_add( (mpr), (mpv) )
+#endif
+
 /*
  * represents an operation pending from an ldap client
  */
@@ -52,6 +52,7 @@ REFINT=${AC_refint-refintno}
 REMOTEAUTH=${AC_remoteauth-remoteauthno}
 RETCODE=${AC_retcode-retcodeno}
 RWM=${AC_rwm-rwmno}
+SSSVLV=${AC_sssvlv-sssvlvno}
 SYNCPROV=${AC_syncprov-syncprovno}
 TRANSLUCENT=${AC_translucent-translucentno}
 UNIQUE=${AC_unique-uniqueno}
@@ -179,6 +180,12 @@ LLOADDANONCONF=$DATADIR/lloadd-anon.conf
 LLOADDUNREACHABLECONF=$DATADIR/lloadd-backend-issues.conf
 LLOADDTLSCONF=$DATADIR/lloadd-tls.conf
 LLOADDSASLCONF=$DATADIR/lloadd-sasl.conf
+LLOADDCACHECONF=$DATADIR/lloadd-cache.conf
+LLOADDACCEPTCONF=$DATADIR/lloadd-accept-threads.conf
+LLOADDPOOLCONF=$DATADIR/lloadd-pool.conf
+LLOADDCOALESCECONF=$DATADIR/lloadd-bind-coalesce.conf
+LLOADDRATELIMITCONF=$DATADIR/lloadd-ratelimit.conf
+LLOADDPIPELINECONF=$DATADIR/lloadd-pipeline.conf
 
 # generated files
 CONF1=$TESTDIR/slapd.1.conf
@@ -259,6 +266,7 @@ LDAPEXOP="$CLIENTDIR/ldapexop $TOOLARGS"
 SLAPDTESTER=$PROGDIR/slapd-tester
 LDIFFILTER=$PROGDIR/ldif-filter
 SLAPDMTREAD=$PROGDIR/slapd-mtread
+SLAPDREAD=$PROGDIR/slapd-read
 LVL=${SLAPD_DEBUG-0x4105}
 LOCALHOST=localhost
 LOCALIP=127.0.0.1